@@ -0,0 +1,28 @@
+// generated by tools/pbm2blob.py from logo.pbm
+// 128x32, 1 frame, 251 bytes (512 raw)
+
+#ifndef LOGO_BLOB_H__
+#define LOGO_BLOB_H__
+
+#include <stdint.h>
+
+static const uint8_t logo_blob[251] = {
+    0x80, 0x04, 0x01, 0x00, 0x80, 0x00, 0x7f, 0x00, 0xff, 0x83, 0x01, 0x81, 0xf1, 0x81, 0x81, 0x81,
+    0x01, 0x81, 0x81, 0x81, 0xf1, 0x81, 0x01, 0x81, 0xf1, 0x8a, 0x71, 0x87, 0x01, 0x81, 0x81, 0x81,
+    0xf1, 0x84, 0x01, 0x87, 0x71, 0x81, 0xf1, 0x81, 0x71, 0x81, 0x01, 0x87, 0x71, 0x81, 0xf1, 0x81,
+    0x71, 0x89, 0x01, 0x06, 0xf1, 0x81, 0x41, 0x41, 0x81, 0x01, 0xc1, 0x81, 0x01, 0x00, 0xc1, 0x8a,
+    0x01, 0x00, 0xff, 0x81, 0x00, 0x7f, 0x00, 0xff, 0x83, 0x00, 0x81, 0xff, 0x81, 0x03, 0x81, 0xfc,
+    0x81, 0x03, 0x81, 0xff, 0x81, 0x00, 0x81, 0xff, 0x87, 0xe0, 0x84, 0x00, 0x81, 0xe0, 0x81, 0x1c,
+    0x81, 0x03, 0x81, 0xff, 0x8a, 0x00, 0x81, 0x1c, 0x81, 0xe3, 0x8a, 0x00, 0x81, 0x1c, 0x81, 0xe3,
+    0x8c, 0x00, 0x0a, 0x07, 0x80, 0xc0, 0x00, 0x07, 0x00, 0x43, 0x44, 0x43, 0xc4, 0x43, 0x8a, 0x00,
+    0x00, 0xff, 0x82, 0x00, 0x7f, 0x00, 0xff, 0x83, 0x00, 0x81, 0xff, 0x87, 0x00, 0x81, 0xff, 0x81,
+    0x00, 0x81, 0xff, 0x8a, 0xc0, 0x81, 0x00, 0x87, 0x07, 0x81, 0xff, 0x81, 0x07, 0x81, 0x00, 0x81,
+    0x38, 0x87, 0xc0, 0x81, 0x3f, 0x81, 0x00, 0x81, 0x38, 0x87, 0xc0, 0x81, 0x3f, 0x82, 0x00, 0x11,
+    0x40, 0xc0, 0x40, 0x00, 0x00, 0xc0, 0x80, 0x00, 0x90, 0xdf, 0x10, 0xc0, 0x00, 0x08, 0x10, 0xd1,
+    0x12, 0x0c, 0x8a, 0x00, 0x00, 0xff, 0x83, 0x00, 0x7f, 0x00, 0xff, 0x83, 0x80, 0x81, 0x81, 0x87,
+    0x80, 0x81, 0x81, 0x81, 0x80, 0x8d, 0x81, 0x8a, 0x80, 0x81, 0x81, 0x87, 0x80, 0x87, 0x81, 0x87,
+    0x80, 0x87, 0x81, 0x85, 0x80, 0x0b, 0x90, 0x9f, 0x90, 0x80, 0x80, 0x9f, 0x80, 0x83, 0x80, 0x9f,
+    0x80, 0x8f, 0x81, 0x90, 0x00, 0x8f, 0x8c, 0x80, 0x00, 0xff, 0xff,
+};
+
+#endif
@@ -0,0 +1,44 @@
+// generated by tools/pbm2blob.py from spin00.pbm spin01.pbm spin02.pbm spin03.pbm spin04.pbm spin05.pbm spin06.pbm spin07.pbm spin08.pbm spin09.pbm spin10.pbm spin11.pbm
+// 32x32, 12 frames, 510 bytes (1536 raw)
+
+#ifndef SPINNER_BLOB_H__
+#define SPINNER_BLOB_H__
+
+#include <stdint.h>
+
+static const uint8_t spinner_blob[510] = {
+    0x20, 0x04, 0x0c, 0x00, 0x80, 0x00, 0x1f, 0x82, 0x00, 0x06, 0x80, 0xc0, 0x60, 0x30, 0x18, 0x08,
+    0x0c, 0x88, 0x04, 0x06, 0x0c, 0x08, 0x18, 0x30, 0x60, 0xc0, 0x80, 0x82, 0x00, 0x81, 0x00, 0x1f,
+    0x80, 0x00, 0x03, 0xfc, 0x07, 0x01, 0x80, 0x81, 0xc0, 0x00, 0x80, 0x8f, 0x00, 0x04, 0x01, 0x07,
+    0xfc, 0x00, 0x00, 0x82, 0x00, 0x1f, 0x80, 0x00, 0x03, 0x3f, 0xe0, 0x80, 0x03, 0x81, 0x07, 0x00,
+    0x03, 0x84, 0x00, 0x89, 0x01, 0x04, 0x81, 0xe0, 0x3f, 0x01, 0x00, 0x83, 0x00, 0x1f, 0x82, 0x00,
+    0x06, 0x01, 0x03, 0x06, 0x0c, 0x18, 0x10, 0x30, 0x83, 0x20, 0x00, 0x60, 0x82, 0x20, 0x06, 0x30,
+    0x10, 0x18, 0x0c, 0x06, 0x03, 0x01, 0x82, 0x00, 0xff, 0x81, 0x05, 0x05, 0x01, 0x00, 0x18, 0x82,
+    0x3c, 0x82, 0x05, 0x16, 0x89, 0x00, 0x0b, 0x01, 0x03, 0x02, 0x06, 0x04, 0x08, 0x18, 0x10, 0x30,
+    0x20, 0x20, 0x80, 0xff, 0x00, 0x0a, 0x03, 0x8c, 0xc4, 0xc4, 0x84, 0x81, 0x06, 0x07, 0x82, 0x00,
+    0x82, 0x07, 0x82, 0x10, 0x0a, 0x04, 0x03, 0x0e, 0x18, 0x60, 0xc0, 0x84, 0x00, 0x03, 0x14, 0x01,
+    0x21, 0x37, 0xff, 0x00, 0x0a, 0x08, 0x0c, 0x04, 0x04, 0x04, 0xc4, 0xe4, 0xe4, 0xe4, 0xc4, 0x81,
+    0x0a, 0x08, 0x82, 0x00, 0x00, 0x01, 0x81, 0x03, 0x00, 0x01, 0x82, 0x10, 0x04, 0x00, 0xff, 0x82,
+    0x00, 0x03, 0x10, 0x05, 0x6f, 0x20, 0x20, 0x20, 0x20, 0x30, 0xff, 0x80, 0x0e, 0x08, 0x83, 0x04,
+    0x03, 0x84, 0xc4, 0xcc, 0x88, 0x81, 0x0e, 0x08, 0x83, 0x00, 0x82, 0x07, 0x02, 0x0b, 0x05, 0x80,
+    0x60, 0x38, 0x0e, 0x03, 0x01, 0x03, 0x0a, 0x06, 0x37, 0x21, 0x20, 0x20, 0x20, 0x20, 0x60, 0xff,
+    0x00, 0x13, 0x03, 0x04, 0x04, 0x0c, 0x08, 0x81, 0x13, 0x07, 0x81, 0x00, 0x82, 0x3c, 0x00, 0x18,
+    0x02, 0x05, 0x0a, 0x20, 0x20, 0x30, 0x10, 0x18, 0x08, 0x04, 0x06, 0x02, 0x03, 0x01, 0x03, 0x0a,
+    0x01, 0x30, 0x20, 0xff, 0x01, 0x16, 0x05, 0x00, 0x80, 0xc0, 0xc0, 0xc0, 0x81, 0x82, 0x04, 0x17,
+    0x00, 0x81, 0x8a, 0x01, 0x84, 0x00, 0x00, 0x03, 0x81, 0x07, 0x00, 0x83, 0xff, 0x81, 0x05, 0x16,
+    0x80, 0x04, 0x08, 0x0c, 0x08, 0x10, 0x30, 0x20, 0x60, 0x40, 0xc0, 0x80, 0x89, 0x00, 0x00, 0x01,
+    0x82, 0x04, 0x17, 0x00, 0x80, 0x89, 0x00, 0x00, 0x01, 0x83, 0x00, 0x82, 0x78, 0x01, 0x30, 0x80,
+    0xff, 0x00, 0x0a, 0x01, 0xec, 0x84, 0x81, 0x05, 0x0a, 0x84, 0x00, 0x04, 0x03, 0x06, 0x18, 0x70,
+    0xc0, 0x82, 0x13, 0x07, 0x82, 0xc0, 0x82, 0x00, 0x03, 0x13, 0x03, 0x23, 0x27, 0x37, 0x13, 0xff,
+    0x00, 0x0a, 0x05, 0x0c, 0x04, 0x04, 0x04, 0x04, 0xf4, 0x81, 0x0b, 0x05, 0x82, 0x00, 0x01, 0x0f,
+    0xf8, 0x82, 0x0f, 0x07, 0x02, 0x80, 0x81, 0x80, 0x83, 0x00, 0x03, 0x0e, 0x08, 0x27, 0x2f, 0x6f,
+    0x2f, 0x27, 0x20, 0x20, 0x30, 0x10, 0xff, 0x80, 0x0f, 0x06, 0x83, 0x04, 0x01, 0x84, 0xec, 0x01,
+    0x0f, 0x05, 0x00, 0xc0, 0x70, 0x18, 0x06, 0x03, 0x82, 0x0a, 0x07, 0x82, 0xc0, 0x80, 0x00, 0x01,
+    0x01, 0x00, 0x03, 0x0a, 0x08, 0x33, 0x27, 0x27, 0x23, 0x20, 0x20, 0x60, 0x20, 0x20, 0xff, 0x00,
+    0x14, 0x01, 0x04, 0x0c, 0x01, 0x10, 0x0a, 0x80, 0xc0, 0x40, 0x60, 0x20, 0x10, 0x18, 0x08, 0x0c,
+    0x04, 0x04, 0x82, 0x06, 0x07, 0x00, 0x30, 0x82, 0x78, 0x81, 0x00, 0x03, 0x0a, 0x03, 0x30, 0x20,
+    0x20, 0x20, 0xff, 0x81, 0x05, 0x15, 0x00, 0x80, 0x81, 0xc0, 0x00, 0x80, 0x8f, 0x00, 0x82, 0x05,
+    0x16, 0x00, 0x03, 0x81, 0x07, 0x00, 0x03, 0x84, 0x00, 0x89, 0x01, 0x00, 0x81, 0xff,
+};
+
+#endif
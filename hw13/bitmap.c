@@ -0,0 +1,98 @@
+// compressed bitmaps and animations, see bitmap.h
+
+#include <string.h>
+#include "bitmap.h"
+
+#define RLE 0x80
+#define FRAME_END 0xFF
+
+// write n copies of v (run) or n bytes of src into the page row, columns
+// x.. clipped to the display
+static void put(ssd1306_t *d, unsigned char *row, int x, int n, const uint8_t *src, int v) {
+    int skip = x < 0 ? -x : 0;
+    if (x + n > d->width) {
+        n = d->width - x;
+    }
+    if (n <= skip) {
+        return;
+    }
+    if (src) {
+        memcpy(row + x + skip, src + skip, n - skip);
+    } else {
+        memset(row + x + skip, v, n - skip);
+    }
+}
+
+const uint8_t *bitmap_decode_frame(ssd1306_t *d, const uint8_t *frame, int x, int page) {
+    const uint8_t *s = frame;
+    while (*s != FRAME_END) {
+        int p = page + (s[0] & 0x7F);
+        bool coded = s[0] & RLE;
+        int col = x + s[1];
+        int n = s[2] + 1;
+        s += 3;
+        // a page off the display is still walked to find the next record
+        unsigned char *row = p >= 0 && p < d->pages ? d->buffer + 1 + p * d->width : NULL;
+        if (row) {
+            ssd1306_mark_dirty(d, col, p * 8, n, 8);
+        }
+        if (!coded) {
+            if (row) {
+                put(d, row, col, n, s, 0);
+            }
+            s += n;
+            continue;
+        }
+        while (n > 0) {
+            int k;
+            if (*s & RLE) {
+                k = *s - RLE + 2;
+                if (row) {
+                    put(d, row, col, k, NULL, s[1]);
+                }
+                s += 2;
+            } else {
+                k = *s + 1;
+                if (row) {
+                    put(d, row, col, k, s + 1, 0);
+                }
+                s += 1 + k;
+            }
+            col += k;
+            n -= k;
+        }
+    }
+    return s + 1;
+}
+
+void bitmap_draw(ssd1306_t *d, const uint8_t *blob, int x, int page) {
+    bitmap_decode_frame(d, blob + BITMAP_HEADER_SIZE, x, page);
+}
+
+void anim_init(anim_t *a, ssd1306_t *d, const uint8_t *blob, int x, int page, uint32_t period_ms) {
+    a->d = d;
+    a->blob = blob;
+    a->x = x;
+    a->page = page;
+    a->period_ms = period_ms;
+    a->due_ms = 0;
+    a->frame = 0;
+    a->loop = bitmap_decode_frame(d, blob + BITMAP_HEADER_SIZE, x, page);
+    a->next = a->loop;
+}
+
+bool anim_task(anim_t *a, uint32_t now_ms) {
+    int frames = bitmap_frames(a->blob);
+    if (frames < 2 || (int32_t)(now_ms - a->due_ms) < 0) {
+        return false;
+    }
+    a->due_ms = now_ms + a->period_ms;
+    a->next = bitmap_decode_frame(a->d, a->next, a->x, a->page);
+    a->frame++;
+    if (a->frame == frames) {
+        // that was the wrap frame, back on the first one
+        a->frame = 0;
+        a->next = a->loop;
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+#ifndef BITMAP_H__
+#define BITMAP_H__
+
+// Compressed bitmaps and animations played from flash.
+//
+// tools/pbm2blob.py turns PBM images into const byte blobs that are decoded
+// straight into the frame buffer, so an image costs no RAM beyond the
+// buffer it ends up in. Decoding only marks the columns it wrote as dirty,
+// so ssd1306_update_dirty() sends just those.
+//
+// Blob layout:
+//   header  width, pages, frame count (2 bytes, little endian)
+//   frame   page records, then 0xFF
+//   record  page | 0x80 if run-length coded, first column, column count - 1,
+//           then the column bytes, raw or coded
+//   coded   c < 0x80: c+1 literal bytes follow
+//           c >= 0x80: the next byte repeats c-0x80+2 times
+// The first frame covers the whole image. Each later frame holds only the
+// columns that changed from the frame before, and an animation ends with a
+// wrap frame that goes from the last frame back to the first, so looping
+// never needs the whole image again.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ssd1306.h"
+
+#define BITMAP_HEADER_SIZE 4
+
+static inline int bitmap_width(const uint8_t *blob) { return blob[0]; }
+static inline int bitmap_pages(const uint8_t *blob) { return blob[1]; }
+static inline int bitmap_frames(const uint8_t *blob) { return blob[2] | blob[3] << 8; }
+
+// decode one frame record with its top left corner at column x of the
+// given page, clipped to the display. Returns the record after it.
+const uint8_t *bitmap_decode_frame(ssd1306_t *d, const uint8_t *frame, int x, int page);
+// draw the first frame of a blob, a still image or the start of an animation
+void bitmap_draw(ssd1306_t *d, const uint8_t *blob, int x, int page);
+
+typedef struct {
+    ssd1306_t *d;
+    const uint8_t *blob;
+    const uint8_t *next;     // next frame record to decode
+    const uint8_t *loop;     // the second frame, where playback continues after the wrap
+    int16_t x;
+    uint8_t page;
+    uint16_t frame;          // frame in the buffer
+    uint32_t period_ms;      // 0 for as fast as anim_task() is called
+    uint32_t due_ms;
+} anim_t;
+
+// draws the first frame
+void anim_init(anim_t *a, ssd1306_t *d, const uint8_t *blob, int x, int page, uint32_t period_ms);
+// decode the next frame into the buffer if it is due. Returns true if it
+// did; the changed columns are marked dirty for ssd1306_update_dirty().
+bool anim_task(anim_t *a, uint32_t now_ms);
+
+#endif
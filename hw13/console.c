@@ -0,0 +1,192 @@
+// ssd1306 text console, see console.h
+
+#include <string.h>
+#include "console.h"
+#include "font.h"
+#include "pico/stdio.h"
+#include "pico/stdio/driver.h"
+
+#define GDDRAM_PAGES 8
+#define CHAR_W 6
+#define MAX_COLS (128 / CHAR_W)
+
+_Static_assert((CONSOLE_RING_SIZE & (CONSOLE_RING_SIZE - 1)) == 0,
+               "CONSOLE_RING_SIZE must be a power of two");
+
+static ssd1306_t *con;
+static int cols;
+
+// single producer (console_write) / single consumer (console_task) ring,
+// the indices only ever grow and wrap through the mask
+static char ring[CONSOLE_RING_SIZE];
+static volatile uint32_t ring_head, ring_tail;
+static volatile uint32_t dropped;
+
+// the bottom row, the only one that is ever written
+static char line[MAX_COLS];
+static int cursor;
+static int dirty_lo, dirty_hi;   // characters dirty_lo..dirty_hi-1 changed
+static bool row_fresh;           // row not sent since it was started, send all of it
+static uint8_t top;              // GDDRAM page at the top of the screen
+static uint8_t row;              // GDDRAM page of the bottom row
+static uint32_t last_ms;
+static int scrolls;              // rows started in this console_task()
+
+void console_write(const char *s, int len) {
+    uint32_t head = ring_head;
+    // all or nothing, so a full ring never leaves half a line behind
+    if (len > (int)(CONSOLE_RING_SIZE - (head - ring_tail))) {
+        dropped += len;
+        return;
+    }
+    for (int i = 0; i < len; i++) {
+        ring[(head + i) & (CONSOLE_RING_SIZE - 1)] = s[i];
+    }
+    ring_head = head + len;
+}
+
+uint32_t console_dropped(void) {
+    return dropped;
+}
+
+uint32_t console_pending(void) {
+    return ring_head - ring_tail;
+}
+
+static void console_out_chars(const char *buf, int len) {
+    console_write(buf, len);
+}
+
+static stdio_driver_t console_driver = {
+    .out_chars = console_out_chars,
+#if PICO_STDIO_ENABLE_CRLF_SUPPORT
+    .crlf_enabled = false, // '\r' is handled, but only '\n' starts a line
+#endif
+};
+
+void console_stdio_enable(bool enable) {
+    stdio_set_driver_enabled(&console_driver, enable);
+}
+
+// send the changed part of the bottom row, and scroll it into view if it is new
+static void flush_row(void) {
+    static uint8_t out[1 + 128];
+    int lo = dirty_lo, hi = dirty_hi;
+    int x0 = lo * CHAR_W, x1 = hi * CHAR_W - 1;
+    if (row_fresh) {
+        // covers whatever the page held when it scrolled off the top
+        lo = 0;
+        hi = cols;
+        x0 = 0;
+        x1 = con->width - 1;
+    } else if (lo >= hi) {
+        return;
+    }
+    // with every page on screen the new row's page is the top one: scroll
+    // first, so it shows the line that just left the top for a moment at
+    // the bottom, instead of the new line at the top
+    bool scroll = row_fresh;
+    if (scroll && con->pages == GDDRAM_PAGES) {
+        ssd1306_set_start_line(con, top * 8);
+        scroll = false;
+    }
+
+    int n = 0;
+    out[n++] = 0x40;
+    for (int c = lo; c < hi; c++) {
+        unsigned char ch = (unsigned char)line[c];
+        const char *glyph = ASCII[(ch >= 0x20 && ch <= 0x7F ? ch : ' ') - 0x20];
+        memcpy(out + n, glyph, 5);
+        out[n + 5] = 0;
+        n += CHAR_W;
+    }
+    while (n < x1 - x0 + 2) {
+        out[n++] = 0; // the columns right of the last whole character
+    }
+    ssd1306_write_gddram(con, x0, x1, row, row, out, n);
+
+    if (scroll) {
+        ssd1306_set_start_line(con, top * 8);
+    }
+    row_fresh = false;
+    dirty_lo = cols;
+    dirty_hi = 0;
+}
+
+static void new_row(void) {
+    flush_row();
+    row = (row + 1) % GDDRAM_PAGES;
+    top = (top + 1) % GDDRAM_PAGES;
+    memset(line, ' ', sizeof(line));
+    cursor = 0;
+    row_fresh = true;
+    scrolls++;
+}
+
+static bool starts_row(char c) {
+    return c == '\n' || (cursor == cols && c != '\r');
+}
+
+static void put(char c) {
+    if (c == '\n') {
+        new_row();
+        return;
+    }
+    if (c == '\r') {
+        cursor = 0;
+        return;
+    }
+    if (cursor == cols) {
+        new_row(); // wrap long lines
+    }
+    line[cursor] = c == '\t' ? ' ' : c;
+    if (cursor < dirty_lo) dirty_lo = cursor;
+    if (cursor + 1 > dirty_hi) dirty_hi = cursor + 1;
+    cursor++;
+}
+
+void console_task(uint32_t now_ms) {
+    if (now_ms - last_ms < CONSOLE_PERIOD_MS) {
+        return;
+    }
+    last_ms = now_ms;
+
+    scrolls = 0;
+    uint32_t tail = ring_tail;
+    while (tail != ring_head) {
+        char c = ring[tail & (CONSOLE_RING_SIZE - 1)];
+        if (scrolls == CONSOLE_LINES_PER_TASK && starts_row(c)) {
+            break; // next time
+        }
+        tail++;
+        put(c);
+    }
+    ring_tail = tail;
+    // a row that was only just started waits for its first character, so
+    // the last line stays on the bottom row instead of a blank one
+    if (!row_fresh || dirty_hi > 0) {
+        flush_row();
+    }
+}
+
+void console_init(ssd1306_t *d) {
+    static uint8_t blank[1 + 128];
+    con = d;
+    cols = d->width / CHAR_W;
+
+    // blank all of GDDRAM, the hidden pages scroll into view later
+    blank[0] = 0x40;
+    for (int p = 0; p < GDDRAM_PAGES; p++) {
+        ssd1306_write_gddram(d, 0, d->width - 1, p, p, blank, 1 + d->width);
+    }
+    top = 0;
+    row = d->pages - 1; // text starts on the bottom row and moves up
+    ssd1306_set_start_line(d, 0);
+
+    memset(line, ' ', sizeof(line));
+    cursor = 0;
+    dirty_lo = cols;
+    dirty_hi = 0;
+    row_fresh = false;
+    ring_tail = ring_head;
+}
@@ -0,0 +1,39 @@
+#ifndef CONSOLE_H__
+#define CONSOLE_H__
+
+// Text console on an ssd1306, optionally fed by printf.
+//
+// Writing only copies into a ring buffer, so printf never waits on the
+// display. console_task() drains the ring from the main loop, at most
+// every CONSOLE_PERIOD_MS, and sends only the characters of the bottom
+// row that changed. A new line is written into a GDDRAM page the panel
+// isn't showing and brought in by moving the start line up one text row,
+// so scrolling never resends the rows that are already on screen. A 64
+// tall panel shows all 8 pages, so there the start line moves first and
+// the new row is written after it, over the line that scrolled off the
+// top and came back in at the bottom.
+//
+// The console owns its display: don't mix it with ssd1306_update() or
+// the gfx/widget drawing on the same panel.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ssd1306.h"
+
+#define CONSOLE_RING_SIZE      512 // bytes of pending output, a power of two
+#define CONSOLE_PERIOD_MS      20  // minimum time between display refreshes
+#define CONSOLE_LINES_PER_TASK 2   // new lines per refresh, the rest stays queued
+
+void console_init(ssd1306_t *d);
+// add/remove the console as a stdio output next to USB/UART
+void console_stdio_enable(bool enable);
+// queue text for the display, never blocks. A write that doesn't fit in
+// the ring is dropped whole and counted.
+void console_write(const char *s, int len);
+// refresh the display if CONSOLE_PERIOD_MS has passed since the last time
+void console_task(uint32_t now_ms);
+uint32_t console_dropped(void);
+// bytes queued but not on the display yet
+uint32_t console_pending(void);
+
+#endif
@@ -0,0 +1,90 @@
+// fixed-point FFT, see fft.h
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <math.h>
+#include "fft.h"
+
+// e^(-2 pi i k / FFT_MAX) = cos - i sin, for k < FFT_MAX / 2
+static int16_t cos_table[FFT_MAX / 2], sin_table[FFT_MAX / 2];
+static bool ready;
+
+void fft_init(void) {
+    if (ready) {
+        return;
+    }
+    for (int k = 0; k < FFT_MAX / 2; k++) {
+        double a = 2 * M_PI * k / FFT_MAX;
+        cos_table[k] = (int16_t)lrint(32767 * cos(a));
+        sin_table[k] = (int16_t)lrint(32767 * sin(a));
+    }
+    ready = true;
+}
+
+static inline int bigger(int m, int v) {
+    return abs(v) > m ? abs(v) : m;
+}
+
+static int max_abs(const int16_t *re, const int16_t *im, int n) {
+    int m = 0;
+    for (int i = 0; i < n; i++) {
+        m = bigger(bigger(m, re[i]), im[i]);
+    }
+    return m;
+}
+
+int fft_q15(int16_t *re, int16_t *im, int log2n) {
+    int n = 1 << log2n;
+
+    // bit reversed order, so the butterflies can work in place
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j |= bit;
+        if (i < j) {
+            int16_t t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    // up to 4096..8191, where the first stage needs no scaling
+    int exponent = 0;
+    int m = max_abs(re, im, n);
+    if (m == 0) {
+        return 0;
+    }
+    int up = 0;
+    while (m << up < 4096) up++;
+    if (up) {
+        for (int i = 0; i < n; i++) {
+            re[i] = (int16_t)(re[i] << up);
+            im[i] = (int16_t)(im[i] << up);
+        }
+        exponent -= up;
+        m <<= up;
+    }
+
+    for (int half = 1, stride = FFT_MAX / 2; half < n; half <<= 1, stride >>= 1) {
+        // a butterfly output is at most |a| + sqrt(2) |b|: under 8192 fits
+        // as it is, under 16384 after halving, anything else after quartering
+        int shift = m < 8192 ? 0 : m < 16384 ? 1 : 2;
+        exponent += shift;
+        m = 0;
+        for (int k = 0; k < half; k++) {
+            int32_t wr = cos_table[k * stride], wi = -sin_table[k * stride];
+            for (int i = k; i < n; i += 2 * half) {
+                int j = i + half;
+                int32_t tr = (wr * re[j] - wi * im[j] + (1 << 14)) >> 15;
+                int32_t ti = (wr * im[j] + wi * re[j] + (1 << 14)) >> 15;
+                int32_t ar = re[i], ai = im[i];
+                re[i] = (int16_t)((ar + tr) >> shift);
+                im[i] = (int16_t)((ai + ti) >> shift);
+                re[j] = (int16_t)((ar - tr) >> shift);
+                im[j] = (int16_t)((ai - ti) >> shift);
+                m = bigger(bigger(m, re[i]), im[i]);
+                m = bigger(bigger(m, re[j]), im[j]);
+            }
+        }
+    }
+    return exponent;
+}
@@ -0,0 +1,24 @@
+#ifndef FFT_H__
+#define FFT_H__
+
+// Fixed-point radix-2 FFT on Q15 data, in place, up to FFT_MAX points.
+//
+// Block floating point: the input is first shifted up until it uses most
+// of the 16 bits, then each stage halves the data (or quarters it) only
+// when its largest value could overflow in the butterflies. The returned
+// exponent says how far the output is from the true transform, so small
+// signals keep their bits instead of losing one per stage.
+
+#include <stdint.h>
+
+#define FFT_MAX_LOG2 9
+#define FFT_MAX      (1 << FFT_MAX_LOG2)
+
+// sine and cosine tables for FFT_MAX points, 1 KB. Only the first call
+// does anything.
+void fft_init(void);
+// forward transform of 2^log2n points. The true transform is the output
+// times 2^exponent, which is returned.
+int fft_q15(int16_t *re, int16_t *im, int log2n);
+
+#endif
@@ -0,0 +1,263 @@
+// clipped raster primitives for the ssd1306 page buffer
+//
+// The buffer is page ordered: byte (x, page) holds rows page*8 .. page*8+7,
+// LSB on top. Spans along x are a single bit mask OR'd into consecutive
+// bytes, spans along y are at most two partial page masks plus whole bytes.
+
+#include <string.h> // for memset
+#include "gfx.h"
+#include "ssd1306.h"
+#include "font.h"
+
+#define W (d->width)
+#define H (d->height)
+#define FB (d->buffer + 1) // skip the 0x40 control byte
+
+// Cohen-Sutherland outcodes
+#define OUT_LEFT   1
+#define OUT_RIGHT  2
+#define OUT_TOP    4
+#define OUT_BOTTOM 8
+
+// fill columns x0..x0+n-1, rows y0..y1. Arguments must already be on screen.
+static void fill_block(ssd1306_t *d, int x0, int n, int y0, int y1, unsigned char color) {
+    int p0 = y0 >> 3;
+    int p1 = y1 >> 3;
+    for (int p = p0; p <= p1; p++) {
+        unsigned char mask = 0xFF;
+        if (p == p0) mask &= (unsigned char)(0xFF << (y0 & 7));
+        if (p == p1) mask &= (unsigned char)(0xFF >> (7 - (y1 & 7)));
+
+        unsigned char *row = FB + p * W + x0;
+        if (mask == 0xFF) {
+            memset(row, color ? 0xFF : 0x00, n);
+        } else if (color) {
+            for (int i = 0; i < n; i++) row[i] |= mask;
+        } else {
+            mask = ~mask;
+            for (int i = 0; i < n; i++) row[i] &= mask;
+        }
+    }
+}
+
+void gfx_hline(ssd1306_t *d, int x0, int x1, int y, unsigned char color) {
+    if (x0 > x1) { int t = x0; x0 = x1; x1 = t; }
+    if (y < 0 || y >= H || x1 < 0 || x0 >= W) return;
+    if (x0 < 0) x0 = 0;
+    if (x1 >= W) x1 = W - 1;
+    fill_block(d, x0, x1 - x0 + 1, y, y, color);
+}
+
+void gfx_vline(ssd1306_t *d, int x, int y0, int y1, unsigned char color) {
+    if (y0 > y1) { int t = y0; y0 = y1; y1 = t; }
+    if (x < 0 || x >= W || y1 < 0 || y0 >= H) return;
+    if (y0 < 0) y0 = 0;
+    if (y1 >= H) y1 = H - 1;
+    fill_block(d, x, 1, y0, y1, color);
+}
+
+void gfx_fill_rect(ssd1306_t *d, int x, int y, int w, int h, unsigned char color) {
+    if (w <= 0 || h <= 0) return;
+    int x0 = x, x1 = x + w - 1;
+    int y0 = y, y1 = y + h - 1;
+    if (x1 < 0 || x0 >= W || y1 < 0 || y0 >= H) return;
+    if (x0 < 0) x0 = 0;
+    if (x1 >= W) x1 = W - 1;
+    if (y0 < 0) y0 = 0;
+    if (y1 >= H) y1 = H - 1;
+    fill_block(d, x0, x1 - x0 + 1, y0, y1, color);
+}
+
+void gfx_rect(ssd1306_t *d, int x, int y, int w, int h, unsigned char color) {
+    if (w <= 0 || h <= 0) return;
+    gfx_hline(d, x, x + w - 1, y, color);
+    gfx_hline(d, x, x + w - 1, y + h - 1, color);
+    gfx_vline(d, x, y, y + h - 1, color);
+    gfx_vline(d, x + w - 1, y, y + h - 1, color);
+}
+
+static int outcode(ssd1306_t *d, int x, int y) {
+    int code = 0;
+    if (x < 0) code |= OUT_LEFT;
+    else if (x >= W) code |= OUT_RIGHT;
+    if (y < 0) code |= OUT_TOP;
+    else if (y >= H) code |= OUT_BOTTOM;
+    return code;
+}
+
+// clip the segment to the screen, returns 0 if nothing is left to draw
+static int clip_line(ssd1306_t *d, int *x0, int *y0, int *x1, int *y1) {
+    int c0 = outcode(d, *x0, *y0);
+    int c1 = outcode(d, *x1, *y1);
+    while (c0 | c1) {
+        if (c0 & c1) return 0;
+        int c = c0 ? c0 : c1;
+        int x, y;
+        int dx = *x1 - *x0;
+        int dy = *y1 - *y0;
+        if (c & OUT_TOP) {
+            x = *x0 + dx * (0 - *y0) / dy;
+            y = 0;
+        } else if (c & OUT_BOTTOM) {
+            x = *x0 + dx * (H - 1 - *y0) / dy;
+            y = H - 1;
+        } else if (c & OUT_LEFT) {
+            y = *y0 + dy * (0 - *x0) / dx;
+            x = 0;
+        } else {
+            y = *y0 + dy * (W - 1 - *x0) / dx;
+            x = W - 1;
+        }
+        if (c == c0) {
+            *x0 = x; *y0 = y;
+            c0 = outcode(d, x, y);
+        } else {
+            *x1 = x; *y1 = y;
+            c1 = outcode(d, x, y);
+        }
+    }
+    return 1;
+}
+
+// Same Bresenham as the old draw_line() in hw13.c, but the pixel is tracked
+// as a byte pointer and a bit mask so each step is an add or a shift.
+void gfx_line(ssd1306_t *d, int x0, int y0, int x1, int y1, unsigned char color) {
+    if (!clip_line(d, &x0, &y0, &x1, &y1)) return;
+    if (y0 == y1) { gfx_hline(d, x0, x1, y0, color); return; }
+    if (x0 == x1) { gfx_vline(d, x0, y0, y1, color); return; }
+
+    int dx = x1 > x0 ? x1 - x0 : x0 - x1;
+    int dy = y1 > y0 ? y0 - y1 : y1 - y0; // -abs(y1 - y0)
+    int sx = x0 < x1 ? 1 : -1;
+    int sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    int xsteps = dx;  // remaining steps instead of comparing coordinates
+    int ysteps = -dy;
+
+    const int stride = W; // one page down; p aliases *d, so keep it in a local
+    unsigned char *p = FB + (y0 >> 3) * stride + x0;
+    unsigned char mask = 1 << (y0 & 7);
+
+    while (1) {
+        if (color) *p |= mask; else *p &= ~mask;
+        int e2 = 2 * err;
+        if (e2 >= dy) {
+            if (xsteps == 0) break;
+            xsteps--;
+            err += dy;
+            p += sx;
+        }
+        if (e2 <= dx) {
+            if (ysteps == 0) break;
+            ysteps--;
+            err += dx;
+            if (sy > 0) {
+                mask <<= 1;
+                if (!mask) { mask = 0x01; p += stride; }
+            } else {
+                mask >>= 1;
+                if (!mask) { mask = 0x80; p -= stride; }
+            }
+        }
+    }
+}
+
+static inline void plot(ssd1306_t *d, int x, int y, unsigned char color) {
+    unsigned char *p = FB + (y >> 3) * W + x;
+    if (color) *p |= 1 << (y & 7); else *p &= ~(1 << (y & 7));
+}
+
+static inline void plot_clipped(ssd1306_t *d, int x, int y, unsigned char color) {
+    if (x >= 0 && x < W && y >= 0 && y < H) plot(d, x, y, color);
+}
+
+// midpoint circle. The bounds test is decided once for the whole circle,
+// only circles that straddle an edge pay for a per-point check.
+void gfx_circle(ssd1306_t *d, int xc, int yc, int r, unsigned char color) {
+    if (r < 0) return;
+    if (xc + r < 0 || xc - r >= W || yc + r < 0 || yc - r >= H) return;
+    int inside = xc - r >= 0 && xc + r < W && yc - r >= 0 && yc + r < H;
+
+    int x = r, y = 0, err = 1 - r;
+    while (x >= y) {
+        if (inside) {
+            plot(d, xc + x, yc + y, color); plot(d, xc - x, yc + y, color);
+            plot(d, xc + x, yc - y, color); plot(d, xc - x, yc - y, color);
+            plot(d, xc + y, yc + x, color); plot(d, xc - y, yc + x, color);
+            plot(d, xc + y, yc - x, color); plot(d, xc - y, yc - x, color);
+        } else {
+            plot_clipped(d, xc + x, yc + y, color); plot_clipped(d, xc - x, yc + y, color);
+            plot_clipped(d, xc + x, yc - y, color); plot_clipped(d, xc - x, yc - y, color);
+            plot_clipped(d, xc + y, yc + x, color); plot_clipped(d, xc - y, yc + x, color);
+            plot_clipped(d, xc + y, yc - x, color); plot_clipped(d, xc - y, yc - x, color);
+        }
+        y++;
+        if (err < 0) {
+            err += 2 * y + 1;
+        } else {
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+}
+
+// filled circle as horizontal spans, each row is drawn exactly once
+void gfx_fill_circle(ssd1306_t *d, int xc, int yc, int r, unsigned char color) {
+    if (r < 0) return;
+    int x = r, y = 0, err = 1 - r;
+    while (x >= y) {
+        gfx_hline(d, xc - x, xc + x, yc + y, color);
+        if (y) gfx_hline(d, xc - x, xc + x, yc - y, color);
+        if (err >= 0 && x != y) {
+            // x shrinks after this step, so rows yc +- x are at full width
+            gfx_hline(d, xc - y, xc + y, yc + x, color);
+            gfx_hline(d, xc - y, xc + y, yc - x, color);
+        }
+        y++;
+        if (err < 0) {
+            err += 2 * y + 1;
+        } else {
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+}
+
+void gfx_char(ssd1306_t *d, int x, int y, char c) {
+    unsigned char ch = (unsigned char)c;
+    if (ch < 0x20 || ch > 0x7F) return;
+    if (x + GFX_CHAR_W <= 0 || x >= W || y + GFX_CHAR_H <= 0 || y >= H) return;
+
+    // clip the column range and the two pages once
+    int c0 = x < 0 ? -x : 0;
+    int c1 = x + GFX_CHAR_W > W ? W - x : GFX_CHAR_W;
+    int page = y >> 3; // floor, also for negative y
+    int shift = y & 7;
+    int pages = d->pages;
+    unsigned char *lo = (page >= 0) ? FB + page * W + x : 0;
+    unsigned char *hi = (shift && page + 1 < pages) ? FB + (page + 1) * W + x : 0;
+
+    const char *glyph = ASCII[ch - 0x20];
+    if (!shift) {
+        for (int col = c0; col < c1; col++) {
+            lo[col] = col < 5 ? glyph[col] : 0;
+        }
+        return;
+    }
+    unsigned char lo_mask = (unsigned char)(0xFF << shift);
+    unsigned char hi_mask = (unsigned char)~lo_mask;
+    for (int col = c0; col < c1; col++) {
+        unsigned int bits = (col < 5 ? (unsigned char)glyph[col] : 0) << shift;
+        if (lo) lo[col] = (lo[col] & ~lo_mask) | (bits & lo_mask);
+        if (hi) hi[col] = (hi[col] & ~hi_mask) | ((bits >> 8) & hi_mask);
+    }
+}
+
+int gfx_string(ssd1306_t *d, int x, int y, const char *s) {
+    for (; *s; s++) {
+        gfx_char(d, x, y, *s);
+        x += GFX_CHAR_W;
+        if (x >= W) break;
+    }
+    return x;
+}
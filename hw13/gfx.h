@@ -0,0 +1,27 @@
+#ifndef GFX_H__
+#define GFX_H__
+
+// Clipped raster primitives that write straight into a display's buffer.
+// Every primitive clips once against the panel and then runs without
+// per-pixel bounds checks. Coordinates may be negative or off-screen.
+// color: 1 sets pixels, 0 clears them. Call ssd1306_update(d) to push.
+
+#include "ssd1306.h"
+
+void gfx_hline(ssd1306_t *d, int x0, int x1, int y, unsigned char color);
+void gfx_vline(ssd1306_t *d, int x, int y0, int y1, unsigned char color);
+void gfx_fill_rect(ssd1306_t *d, int x, int y, int w, int h, unsigned char color);
+void gfx_rect(ssd1306_t *d, int x, int y, int w, int h, unsigned char color);
+void gfx_line(ssd1306_t *d, int x0, int y0, int x1, int y1, unsigned char color);
+void gfx_circle(ssd1306_t *d, int xc, int yc, int r, unsigned char color);
+void gfx_fill_circle(ssd1306_t *d, int xc, int yc, int r, unsigned char color);
+
+// 5x7 text from font.h on a 6x8 cell. Cells are opaque, so redrawing text
+// over old text needs no clear. Rows at y = 0, 8, 16... are plain byte
+// copies, other rows are shifted across two pages.
+#define GFX_CHAR_W 6
+#define GFX_CHAR_H 8
+void gfx_char(ssd1306_t *d, int x, int y, char c);
+int gfx_string(ssd1306_t *d, int x, int y, const char *s); // returns x after the text
+
+#endif
@@ -0,0 +1,193 @@
+// 4-level grayscale by plane cycling, see gray.h
+
+#include <string.h>
+#include "gray.h"
+#include "gfx.h"
+
+#define GDDRAM_PAGES 8
+#define PAGE_STALE   0xFF // page_plane[]: neither plane, send it whole
+
+// plane shown in each slot: bit 1 twice, bit 0 once
+static const uint8_t slot_plane[GRAY_SLOTS] = { 1, 1, 0 };
+
+void gray_init(gray_t *g, ssd1306_t *d) {
+    memset(g, 0, sizeof(*g));
+    g->d = d;
+    for (int k = 0; k < 2; k++) {
+        // views of the planes with d's geometry, only ever drawn into
+        g->plane[k] = *d;
+        g->plane[k].buffer = g->buf[k];
+        g->plane[k].dma_words = NULL;
+        g->plane[k].dma_chan = -1;
+        g->buf[k][0] = 0x40;
+    }
+    g->hidden_pages = 2 * d->pages <= GDDRAM_PAGES;
+    g->shown = 1;
+    g->upload = 2 * d->pages; // nothing to upload yet
+    memset(g->page_plane, PAGE_STALE, sizeof(g->page_plane));
+
+    // fastest internal oscillator, so the panel scans several frames per
+    // slot and a plane change rarely shows up as a torn frame
+    ssd1306_command(d, SSD1306_SETDISPLAYCLOCKDIV);
+    ssd1306_command(d, 0xF0);
+}
+
+static bool gray_timer_callback(repeating_timer_t *rt) {
+    gray_tick((gray_t *)rt->user_data);
+    return true;
+}
+
+bool gray_start(gray_t *g, int slot_hz) {
+    // negative period: measured start to start, so the slots don't drift
+    return add_repeating_timer_us(-1000000 / slot_hz, gray_timer_callback, g, &g->timer);
+}
+
+void gray_tick(gray_t *g) {
+    g->ticks++;
+}
+
+static void send(gray_t *g, uint8_t x0, uint8_t x1, uint8_t page, const unsigned char *src) {
+    static unsigned char out[1 + 128];
+    int n = x1 - x0 + 1;
+    out[0] = 0x40;
+    memcpy(out + 1, src + x0, n);
+    ssd1306_write_gddram(g->d, x0, x1, page, page, out, 1 + n);
+    g->stats.bytes += 7 + 1 + n;
+    g->stats.transactions += 2;
+}
+
+// No spare GDDRAM: the first page where the panel doesn't have the plane
+// that should be showing, just the columns that differ. One page a call,
+// like the hidden page upload; false once the panel has all of it.
+static bool resend_page(gray_t *g) {
+    ssd1306_t *d = g->d;
+    int k = g->shown;
+    for (int p = 0; p < d->pages; p++) {
+        uint8_t had = g->page_plane[p];
+        if (had == k) {
+            continue;
+        }
+        g->page_plane[p] = k;
+        const unsigned char *a = g->buf[k] + 1 + p * d->width;
+        int x0 = 0, x1 = d->width - 1;
+        if (had != PAGE_STALE) {
+            const unsigned char *b = g->buf[had] + 1 + p * d->width;
+            while (x0 <= x1 && a[x0] == b[x0]) x0++;
+            while (x1 >= x0 && a[x1] == b[x1]) x1--;
+            if (x0 > x1) {
+                continue;
+            }
+        }
+        send(g, x0, x1, p, a);
+        return true;
+    }
+    return false;
+}
+
+// the plane that should be showing is all on the panel
+static bool plane_done(const gray_t *g) {
+    if (g->hidden_pages) {
+        return true;
+    }
+    for (int p = 0; p < g->d->pages; p++) {
+        if (g->page_plane[p] != g->shown) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void show_plane(gray_t *g, int k) {
+    g->shown = k;
+    if (g->hidden_pages) {
+        ssd1306_set_start_line(g->d, k ? 0 : g->d->pages * 8);
+        g->stats.bytes += 2;
+        g->stats.transactions += 1;
+    } else {
+        resend_page(g);
+    }
+}
+
+void gray_task(gray_t *g) {
+    uint32_t ticks = g->ticks;
+    if (ticks != g->served) {
+        g->stats.missed += ticks - g->served - 1;
+        g->served = ticks;
+        // the slot ending now only counts if its plane made it
+        if (plane_done(g)) {
+            g->stats.slots++;
+        } else {
+            g->stats.missed++;
+        }
+        g->slot = (g->slot + 1) % GRAY_SLOTS;
+        if (slot_plane[g->slot] != g->shown) {
+            show_plane(g, slot_plane[g->slot]);
+        }
+        return;
+    }
+
+    if (!g->hidden_pages) {
+        // the rest of a plane change, or of a new frame
+        resend_page(g);
+        return;
+    }
+    // between slots: one page of a new frame. Bit 1 goes to pages 0..,
+    // bit 0 to the pages after it.
+    if (g->upload < 2 * g->d->pages) {
+        int pages = g->d->pages;
+        int k = g->upload < pages ? 1 : 0;
+        int p = g->upload % pages;
+        send(g, 0, g->d->width - 1, g->upload, g->buf[k] + 1 + p * g->d->width);
+        g->upload++;
+    }
+}
+
+void gray_present(gray_t *g) {
+    if (g->hidden_pages) {
+        g->upload = 0;
+    } else {
+        // what the panel holds no longer matches either plane
+        memset(g->page_plane, PAGE_STALE, sizeof(g->page_plane));
+        resend_page(g);
+    }
+}
+
+bool gray_uploading(const gray_t *g) {
+    if (g->hidden_pages) {
+        return g->upload < 2 * g->d->pages;
+    }
+    for (int p = 0; p < g->d->pages; p++) {
+        if (g->page_plane[p] == PAGE_STALE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void gray_clear(gray_t *g) {
+    ssd1306_clear(&g->plane[0]);
+    ssd1306_clear(&g->plane[1]);
+}
+
+void gray_pixel(gray_t *g, int x, int y, int level) {
+    gfx_hline(&g->plane[1], x, x, y, (level >> 1) & 1);
+    gfx_hline(&g->plane[0], x, x, y, level & 1);
+}
+
+void gray_fill_rect(gray_t *g, int x, int y, int w, int h, int level) {
+    gfx_fill_rect(&g->plane[1], x, y, w, h, (level >> 1) & 1);
+    gfx_fill_rect(&g->plane[0], x, y, w, h, level & 1);
+}
+
+int gray_string(gray_t *g, int x, int y, const char *s, int level) {
+    int w = (int)strlen(s) * GFX_CHAR_W;
+    for (int k = 0; k < 2; k++) {
+        if ((level >> k) & 1) {
+            gfx_string(&g->plane[k], x, y, s);
+        } else {
+            // text cells are opaque, so this plane gets blank cells
+            gfx_fill_rect(&g->plane[k], x, y, w, GFX_CHAR_H, 0);
+        }
+    }
+    return x + w;
+}
@@ -0,0 +1,74 @@
+#ifndef GRAY_H__
+#define GRAY_H__
+
+// 4-level grayscale on the 1-bit ssd1306 by time multiplexing two planes.
+//
+// A pixel's level 0..3 is split into bit 1 and bit 0, kept in two page
+// ordered planes that gfx can draw into directly. A timer cuts time into
+// slots, GRAY_SLOTS per gray frame: bit 1 is shown for two slots and bit 0
+// for one, so a pixel is lit for level/3 of the time.
+//
+// On a 128x32 panel both planes live in GDDRAM at once (bit 1 in pages
+// 0-3, bit 0 in pages 4-7) and a slot change is a single SETSTARTLINE
+// command, so cycling costs almost no bus time and new content is
+// uploaded a page at a time. Taller panels have no spare pages, so each
+// plane change resends the columns where the planes differ, a page at a
+// time too. Over 400 kHz I2C that's more than the bus has: slots are
+// missed, and the stats show it. SPI keeps up.
+//
+// The timer only counts slots; all bus traffic happens in gray_task(),
+// called from the main loop between sensor reads, and no single call
+// holds the bus for more than one page (about 3 ms at 400 kHz).
+// Grayscale owns its display and moves the start line, so don't mix it
+// with ssd1306_update() on the same panel.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#include "ssd1306.h"
+
+#define GRAY_SLOTS   3   // slots per gray frame
+#define GRAY_SLOT_HZ 180 // 60 gray frames per second
+
+typedef struct {
+    uint32_t slots;          // slots shown whole
+    uint32_t missed;         // slots that passed before gray_task() got to them, or
+                             // before their plane was all on the panel
+    uint32_t bytes;          // bus bytes sent for grayscale, as on I2C: each
+                             // transaction starts with a control byte
+    uint32_t transactions;
+} gray_stats_t;
+
+typedef struct {
+    ssd1306_t *d;
+    ssd1306_t plane[2];      // plane[1] is bit 1, plane[0] bit 0. Draw with gfx, then gray_present()
+    unsigned char buf[2][SSD1306_BUFFER_SIZE(128, 64)];
+    bool hidden_pages;       // both planes fit in GDDRAM
+    uint8_t slot;            // 0..GRAY_SLOTS-1
+    uint8_t shown;           // plane on the panel, or going onto it
+    uint8_t upload;          // next GDDRAM page to upload, hidden_pages only
+    uint8_t page_plane[8];   // plane each page holds, not hidden_pages
+    volatile uint32_t ticks; // slots counted by the timer
+    uint32_t served;         // slots handled by gray_task()
+    gray_stats_t stats;
+    repeating_timer_t timer;
+} gray_t;
+
+void gray_init(gray_t *g, ssd1306_t *d);
+// start cycling planes at slot_hz from a repeating timer
+bool gray_start(gray_t *g, int slot_hz);
+// count one slot, what the timer calls. Safe from an interrupt.
+void gray_tick(gray_t *g);
+// show the next slot if one is due, otherwise upload part of a new frame
+void gray_task(gray_t *g);
+
+void gray_clear(gray_t *g);
+void gray_pixel(gray_t *g, int x, int y, int level);
+void gray_fill_rect(gray_t *g, int x, int y, int w, int h, int level);
+int gray_string(gray_t *g, int x, int y, const char *s, int level);
+// the planes are finished, send them
+void gray_present(gray_t *g);
+// a presented frame is still going out, drawing now would tear it
+bool gray_uploading(const gray_t *g);
+
+#endif
@@ -0,0 +1,350 @@
+// Host benchmark for the Mahony filter: cost per update, accuracy on known
+// motions and on recorded traces, and the seqlock under two threads.
+//
+//   ./bench_ahrs [-o dir]          synthetic runs, -o saves them as traces
+//   ./bench_ahrs trace.csv ...     replay traces recorded with IMU_TRACE
+//
+// The synthetic runs know the true orientation at every sample: the IMU
+// readings are made from it with MPU6050 noise, gyro bias and LSB
+// quantisation, at 1 kHz. Tilt error is the angle between the true and the
+// estimated "down", heading error the yaw difference.
+//
+// Traces are CSV lines of t_us,ax,ay,az,gx,gy,gz (g and deg/s), optionally
+// followed by the true roll,pitch,yaw in degrees. Without the truth, the
+// filter's down is compared with the accelerometer's instead, which is only
+// a fair reference when the board is held still or moved gently.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include "mahony.h"
+
+#define RATE_HZ 1000
+#define RUN_S 20
+#define SETTLE_S 2          // errors are counted after this
+#define DEG (M_PI / 180.0)
+
+// hw13's defaults
+#define KP 2.0f
+#define KI 0.5f
+
+typedef struct {
+    double tilt_sum2, tilt_max;
+    double head_sum2, head_max, head_end;
+    uint32_t n;
+} errors_t;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// deterministic noise, so runs compare
+static uint64_t rng = 0x2545F4914F6CDD1DULL;
+static double gauss(void) {
+    double u[2];
+    for (int i = 0; i < 2; i++) {
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        u[i] = ((rng >> 11) + 0.5) / 9007199254740992.0;
+    }
+    return sqrt(-2 * log(u[0])) * cos(2 * M_PI * u[1]);
+}
+
+static void quat_from_euler(double roll, double pitch, double yaw, double *q) {
+    double cr = cos(roll / 2), sr = sin(roll / 2);
+    double cp = cos(pitch / 2), sp = sin(pitch / 2);
+    double cy = cos(yaw / 2), sy = sin(yaw / 2);
+    q[0] = cr * cp * cy + sr * sp * sy;
+    q[1] = sr * cp * cy - cr * sp * sy;
+    q[2] = cr * sp * cy + sr * cp * sy;
+    q[3] = cr * cp * sy - sr * sp * cy;
+}
+
+// a world vector seen from the body
+static void to_body(const double *q, const double *v, double *out) {
+    double w = q[0], x = -q[1], y = -q[2], z = -q[3];
+    double tx = 2 * (y * v[2] - z * v[1]);
+    double ty = 2 * (z * v[0] - x * v[2]);
+    double tz = 2 * (x * v[1] - y * v[0]);
+    out[0] = v[0] + w * tx + (y * tz - z * ty);
+    out[1] = v[1] + w * ty + (z * tx - x * tz);
+    out[2] = v[2] + w * tz + (x * ty - y * tx);
+}
+
+static double wrap180(double deg) {
+    while (deg > 180) deg -= 360;
+    while (deg < -180) deg += 360;
+    return deg;
+}
+
+static void score(errors_t *e, const float *q_est, const double *q_true) {
+    float ve[3], vt[3], qt[4] = { (float)q_true[0], (float)q_true[1], (float)q_true[2], (float)q_true[3] };
+    mahony_gravity(q_est, ve);
+    mahony_gravity(qt, vt);
+    double dot = ve[0] * vt[0] + ve[1] * vt[1] + ve[2] * vt[2];
+    double tilt = acos(dot > 1 ? 1 : dot < -1 ? -1 : dot) / DEG;
+    float r, p, ye, yt;
+    mahony_euler(q_est, &r, &p, &ye);
+    mahony_euler(qt, &r, &p, &yt);
+    double head = fabs(wrap180(ye - yt));
+    e->tilt_sum2 += tilt * tilt;
+    if (tilt > e->tilt_max) e->tilt_max = tilt;
+    e->head_sum2 += head * head;
+    if (head > e->head_max) e->head_max = head;
+    e->head_end = head;
+    e->n++;
+}
+
+static void print_errors(const char *name, const errors_t *e) {
+    printf("  %-30s tilt %6.2f deg rms %6.2f max, heading %6.2f rms %6.2f at the end\n", name,
+           sqrt(e->tilt_sum2 / e->n), e->tilt_max, sqrt(e->head_sum2 / e->n), e->head_end);
+}
+
+// true roll, pitch, yaw (rad) and linear acceleration (g, world) at t
+typedef void (*trajectory_t)(double t, double *euler, double *lin);
+
+static void still(double t, double *e, double *lin) {
+    (void)t;
+    e[0] = 30 * DEG;
+    e[1] = -15 * DEG;
+    e[2] = 0;
+    lin[0] = lin[1] = lin[2] = 0;
+}
+
+static void sway(double t, double *e, double *lin) {
+    e[0] = 45 * DEG * sin(2 * M_PI * 0.5 * t);
+    e[1] = 30 * DEG * sin(2 * M_PI * 0.3 * t);
+    e[2] = 30 * DEG * t; // a slow turn
+    lin[0] = lin[1] = lin[2] = 0;
+}
+
+static void shaken(double t, double *e, double *lin) {
+    sway(t, e, lin);
+    lin[0] = 0.3 * sin(2 * M_PI * 5 * t);
+    lin[1] = 0.2 * sin(2 * M_PI * 3.7 * t);
+}
+
+typedef struct {
+    double t_us;
+    float accel[3], gyro[3];
+    double q_true[4];
+} sample_t;
+
+// the IMU readings for one sample of a trajectory
+static void make_sample(trajectory_t traj, double t, sample_t *s) {
+    static const double bias[3] = { 0.8, -0.5, 0.6 }; // deg/s
+    double e[3], lin[3], q[4], qa[4], qb[4], h = 1e-5;
+    traj(t, e, lin);
+    quat_from_euler(e[0], e[1], e[2], q);
+    // body rates from the quaternion's derivative, 2 q* dq/dt
+    traj(t - h, e, lin);
+    quat_from_euler(e[0], e[1], e[2], qa);
+    traj(t + h, e, lin);
+    quat_from_euler(e[0], e[1], e[2], qb);
+    double d[4];
+    for (int i = 0; i < 4; i++) d[i] = (qb[i] - qa[i]) / (2 * h);
+    double w[3] = {
+        2 * (q[0] * d[1] - q[1] * d[0] - q[2] * d[3] + q[3] * d[2]),
+        2 * (q[0] * d[2] + q[1] * d[3] - q[2] * d[0] - q[3] * d[1]),
+        2 * (q[0] * d[3] - q[1] * d[2] + q[2] * d[1] - q[3] * d[0]),
+    };
+    double up[3] = { lin[0], lin[1], lin[2] + 1.0 }, a[3];
+    to_body(q, up, a);
+    for (int i = 0; i < 3; i++) {
+        // noise at the DLPF's bandwidth, then the register LSB
+        double ai = a[i] + 0.003 * gauss();
+        double gi = w[i] / DEG + bias[i] + 0.05 * gauss();
+        s->accel[i] = (float)(lrint(ai * 16384) / 16384.0);
+        s->gyro[i] = (float)(lrint(gi * 131) / 131.0);
+    }
+    for (int i = 0; i < 4; i++) s->q_true[i] = q[i];
+    s->t_us = t * 1e6;
+}
+
+static void run_synthetic(const char *name, trajectory_t traj, float kp, float ki, const char *save_dir) {
+    FILE *out = NULL;
+    if (save_dir) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s.csv", save_dir, name);
+        out = fopen(path, "w");
+        if (out) fprintf(out, "t_us,ax,ay,az,gx,gy,gz,roll,pitch,yaw\n");
+    }
+    mahony_t f;
+    mahony_init(&f, kp, ki);
+    errors_t e = { 0 };
+    rng = 0x2545F4914F6CDD1DULL;
+    for (int i = 0; i < RUN_S * RATE_HZ; i++) {
+        sample_t s;
+        make_sample(traj, (double)i / RATE_HZ, &s);
+        mahony_update(&f, s.accel, s.gyro, 1.0f / RATE_HZ);
+        if (i >= SETTLE_S * RATE_HZ) {
+            score(&e, f.q, s.q_true);
+        }
+        if (out) {
+            float qt[4] = { (float)s.q_true[0], (float)s.q_true[1], (float)s.q_true[2], (float)s.q_true[3] };
+            float r, p, y;
+            mahony_euler(qt, &r, &p, &y);
+            fprintf(out, "%.0f,%.5f,%.5f,%.5f,%.4f,%.4f,%.4f,%.3f,%.3f,%.3f\n", s.t_us, s.accel[0], s.accel[1],
+                    s.accel[2], s.gyro[0], s.gyro[1], s.gyro[2], r, p, y);
+        }
+    }
+    if (out) fclose(out);
+    char label[64];
+    snprintf(label, sizeof(label), "%s, kp %.1f ki %.2f", name, kp, ki);
+    print_errors(label, &e);
+}
+
+static void bench_cost(void) {
+    enum { N = 2000000 };
+    static sample_t s[1024];
+    for (int i = 0; i < 1024; i++) make_sample(sway, i * 1e-3, &s[i]);
+    mahony_t f;
+    mahony_init(&f, KP, KI);
+    mahony_state_t st;
+    double t0 = now_ns();
+    for (int i = 0; i < N; i++) {
+        mahony_update(&f, s[i & 1023].accel, s[i & 1023].gyro, 1e-3f);
+    }
+    double t1 = now_ns();
+    for (int i = 0; i < N; i++) {
+        mahony_update(&f, s[i & 1023].accel, s[i & 1023].gyro, 1e-3f);
+        mahony_euler(f.q, &st.roll, &st.pitch, &st.yaw);
+    }
+    double t2 = now_ns();
+    printf("  update %.1f ns, with Euler angles %.1f ns (q %.3f)\n", (t1 - t0) / N, (t2 - t1) / N, f.q[0]);
+}
+
+// one thread publishes states whose fields all carry the same counter,
+// the other checks every snapshot for a mix of two updates
+static mahony_shared_t shared;
+static volatile int writer_done;
+
+static void *writer(void *arg) {
+    uint32_t n = *(uint32_t *)arg;
+    mahony_state_t s;
+    for (uint32_t k = 1; k <= n; k++) {
+        for (int i = 0; i < 4; i++) s.q[i] = (float)k;
+        s.roll = s.pitch = s.yaw = (float)k;
+        s.t_us = k;
+        s.updates = s.cycles_last = s.cycles_max = k;
+        mahony_publish(&shared, &s);
+    }
+    writer_done = 1;
+    return NULL;
+}
+
+static void bench_seqlock(void) {
+    uint32_t n = 20000000;
+    pthread_t t;
+    writer_done = 0;
+    pthread_create(&t, NULL, writer, &n);
+    uint32_t reads = 0, torn = 0, last = 0, backwards = 0;
+    while (!writer_done) {
+        mahony_state_t s;
+        mahony_snapshot(&shared, &s);
+        uint32_t k = s.updates;
+        if (s.q[0] != (float)k || s.q[3] != (float)k || s.yaw != (float)k || s.t_us != k || s.cycles_max != k) {
+            torn++;
+        }
+        if (k < last) backwards++;
+        last = k;
+        reads++;
+    }
+    pthread_join(t, NULL);
+    printf("  seqlock: %u snapshots during %u updates, %u torn, %u went backwards\n", reads, n, torn, backwards);
+}
+
+static int replay(const char *path) {
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        perror(path);
+        return 1;
+    }
+    char line[256];
+    mahony_t f;
+    mahony_init(&f, KP, KI);
+    errors_t truth = { 0 };
+    double vs_accel_sum = 0, vs_accel_max = 0, t_first = -1, t_prev = -1;
+    float start[3] = { 0 }, end[3] = { 0 };
+    uint32_t n = 0, scored = 0;
+    while (fgets(line, sizeof(line), in)) {
+        double v[10];
+        int k = sscanf(line, "%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5],
+                       &v[6], &v[7], &v[8], &v[9]);
+        if (k < 7) {
+            continue; // the header
+        }
+        float a[3] = { (float)v[1], (float)v[2], (float)v[3] }, g[3] = { (float)v[4], (float)v[5], (float)v[6] };
+        // 32 bit microseconds on the Pico, unwrap
+        double t = v[0];
+        while (t_prev >= 0 && t < t_prev - 2147483648.0) t += 4294967296.0;
+        float dt = t_prev >= 0 ? (float)((t - t_prev) * 1e-6) : 1.0f / RATE_HZ;
+        if (t_first < 0) t_first = t;
+        t_prev = t;
+        mahony_update(&f, a, g, dt);
+        n++;
+        if (t - t_first < SETTLE_S * 1e6) {
+            mahony_euler(f.q, &start[0], &start[1], &start[2]);
+            continue;
+        }
+        if (k >= 10) {
+            double q[4];
+            quat_from_euler(v[7] * DEG, v[8] * DEG, v[9] * DEG, q);
+            score(&truth, f.q, q);
+        }
+        float ve[3];
+        mahony_gravity(f.q, ve);
+        double norm = sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+        if (norm > 0) {
+            double dot = (ve[0] * a[0] + ve[1] * a[1] + ve[2] * a[2]) / norm;
+            double angle = acos(dot > 1 ? 1 : dot < -1 ? -1 : dot) / DEG;
+            vs_accel_sum += angle;
+            if (angle > vs_accel_max) vs_accel_max = angle;
+            scored++;
+        }
+        mahony_euler(f.q, &end[0], &end[1], &end[2]);
+    }
+    fclose(in);
+    printf("%s: %u samples over %.1f s\n", path, n, (t_prev - t_first) * 1e-6);
+    if (truth.n) {
+        print_errors("against the recorded truth", &truth);
+    }
+    if (scored) {
+        printf("  %-30s %6.2f deg mean %6.2f max\n", "down vs the accelerometer", vs_accel_sum / scored, vs_accel_max);
+        printf("  %-30s roll %+.2f pitch %+.2f yaw %+.2f deg from %.0f s to the end\n", "moved", end[0] - start[0],
+               end[1] - start[1], wrap180(end[2] - start[2]), (double)SETTLE_S);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *save_dir = NULL;
+    if (argc > 2 && strcmp(argv[1], "-o") == 0) {
+        save_dir = argv[2];
+    } else if (argc > 1) {
+        int status = 0;
+        for (int i = 1; i < argc; i++) {
+            status |= replay(argv[i]);
+        }
+        return status;
+    }
+
+    printf("cost per sample on this machine\n");
+    bench_cost();
+    printf("synthetic motion at %d Hz for %d s, gyro bias (0.8, -0.5, 0.6) deg/s\n", RATE_HZ, RUN_S);
+    struct { const char *name; trajectory_t traj; } runs[] = {
+        { "still", still },
+        { "sway", sway },
+        { "shaken", shaken },
+    };
+    for (unsigned i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+        run_synthetic(runs[i].name, runs[i].traj, KP, 0, NULL);
+        run_synthetic(runs[i].name, runs[i].traj, KP, KI, save_dir);
+    }
+    bench_seqlock();
+    return 0;
+}
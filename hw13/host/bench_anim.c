@@ -0,0 +1,139 @@
+// Host benchmark for compressed bitmaps and animation playback.
+//
+//   ./bench_anim [frame_dir]
+//
+// Draws the boot logo and plays the spinner as fast as the bus allows,
+// decoding each frame straight into the frame buffer and sending only the
+// columns it changed. Reports decode time, bus bytes per frame and the
+// frame rate the wire allows, against resending the whole spinner box
+// every frame. After two laps the spinner has to match its first frame
+// again, which checks the wrap frame.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "ssd1306.h"
+#include "bitmap.h"
+#include "assets/logo.h"
+#include "assets/spinner.h"
+#include "fake_bus.h"
+
+SSD1306_DEFINE(oled, 128, 32, i2c0, SSD1306_DEFAULT_ADDRESS);
+SSD1306_DEFINE(oled64, 128, 64, i2c1, SSD1306_DEFAULT_ADDRESS);
+SSD1306_DEFINE_SPI(oled_spi, 128, 64, spi0, 20, 17, 21);
+
+static const char *frame_dir;
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static bool panel_matches(ssd1306_t *d) {
+    const fake_ssd1306_t *p = fake_bus_panel(d);
+    for (int page = 0; page < d->pages; page++) {
+        if (memcmp(p->gddram[page], d->buffer + 1 + page * d->width, d->width) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void report_bus(const char *name, fake_bus_stats_t s, int frames, ssd1306_t *d) {
+    double ms = fake_bus_wire_us(d, s) / frames / 1000.0;
+    printf("  %-22s %6u bytes %4u transactions per frame, %6.2f ms on the wire (%4.0f fps), panel %s\n",
+           name, s.bytes / frames, s.transactions / frames, ms, 1000.0 / ms,
+           panel_matches(d) ? "matches buffer" : "DIFFERS from buffer");
+}
+
+static void dump(ssd1306_t *d, const char *name) {
+    if (!frame_dir) {
+        return;
+    }
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s_%dx%d.pbm", frame_dir, name, d->width, d->height);
+    if (!fake_ssd1306_write_pbm(fake_bus_panel(d), path)) {
+        printf("  could not write %s\n", path);
+    }
+}
+
+static void bench_logo(ssd1306_t *d) {
+    ssd1306_clear(d);
+    ssd1306_update(d);
+    fake_bus_reset_stats();
+    double t0 = now_us();
+    bitmap_draw(d, logo_blob, 0, 0);
+    double t1 = now_us();
+    ssd1306_update_dirty(d);
+    printf("  %-22s %9.3f us to decode %u blob bytes\n", "logo", t1 - t0, (unsigned)sizeof(logo_blob));
+    report_bus("logo", fake_bus_stats(d), 1, d);
+    dump(d, "logo");
+}
+
+static void bench_spinner(ssd1306_t *d) {
+    int frames = bitmap_frames(spinner_blob);
+    int w = bitmap_width(spinner_blob);
+    int pages = bitmap_pages(spinner_blob);
+    if (pages > d->pages) {
+        pages = d->pages;
+    }
+    int x = d->width - w;
+    int laps = 2, n = laps * frames;
+    unsigned char first[8][128];
+    anim_t a;
+
+    ssd1306_clear(d);
+    anim_init(&a, d, spinner_blob, x, 0, 0);
+    ssd1306_update(d);
+    for (int p = 0; p < pages; p++) {
+        memcpy(first[p], d->buffer + 1 + p * d->width + x, w);
+    }
+
+    fake_bus_reset_stats();
+    double us = 0;
+    for (int i = 0; i < n; i++) {
+        double t0 = now_us();
+        anim_task(&a, 0);
+        us += now_us() - t0;
+        ssd1306_update_dirty(d);
+    }
+    fake_bus_stats_t s = fake_bus_stats(d);
+
+    bool wrapped = a.frame == 0;
+    for (int p = 0; p < pages; p++) {
+        wrapped = wrapped && memcmp(first[p], d->buffer + 1 + p * d->width + x, w) == 0;
+    }
+    printf("  %-22s %9.3f us/frame to decode, %d frames in %u bytes, %s after %d laps\n",
+           "spinner", us / n, frames, (unsigned)sizeof(spinner_blob),
+           wrapped ? "back on frame 0" : "NOT back on frame 0", laps);
+    report_bus("spinner, deltas", s, n, d);
+
+    // the same frames sent as whole boxes
+    fake_bus_reset_stats();
+    for (int i = 0; i < n; i++) {
+        anim_task(&a, 0);
+        ssd1306_mark_dirty(d, x, 0, w, pages * 8);
+        ssd1306_update_dirty(d);
+    }
+    report_bus("spinner, whole box", fake_bus_stats(d), n, d);
+    dump(d, "spinner");
+}
+
+static void run(ssd1306_t *d) {
+    printf("%dx%d on %s\n", d->width, d->height, fake_bus_name(d));
+    fake_bus_connect(d);
+    ssd1306_setup(d);
+    bench_logo(d);
+    bench_spinner(d);
+}
+
+int main(int argc, char **argv) {
+    frame_dir = argc > 1 ? argv[1] : NULL;
+    fake_bus_reset();
+    run(&oled);
+    run(&oled64);
+    run(&oled_spi);
+    return 0;
+}
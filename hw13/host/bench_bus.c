@@ -0,0 +1,256 @@
+// Host benchmark for the shared I2C bus scheduler (i2cbus.c).
+//
+//   ./bench_bus
+//
+// The display and the MPU6050 on i2c0 at 400 kHz, the display redrawn and
+// sent in full as fast as it goes, the IMU at 1 kHz. First the way hw13
+// shares the bus without the scheduler: blocking full frames and FIFO
+// reads in between, so a sample waits for the frame in front of it. Then
+// through the scheduler with data-ready reads queued from the interrupt,
+// for a few piece sizes, and the dashboard's partial updates. Each run
+// checks every sample arrived once and the panel ends up with the frame
+// the buffer holds.
+//
+// Latency is from the sample being taken (the data-ready edge) to its
+// bytes in RAM. The bound is i2cbus_bound_us() for the 14 byte read.
+//
+// Then reads to an address nobody answers every 10 ms on top of the
+// dashboard: each has to come back aborted and nothing else may notice,
+// and a full queue behind a split frame has to refuse the one too many
+// rather than overrun. Exits non-zero if either goes wrong.
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "ssd1306.h"
+#include "gfx.h"
+#include "widget.h"
+#include "mpu6050.h"
+#include "i2cbus.h"
+#include "fake_bus.h"
+#include "fake_mpu6050.h"
+
+#define RUN_US 2000000
+#define RATE_HZ 1000
+#define INT_GPIO 16
+#define GHOST_ADDR 0x50
+#define GHOST_US   10000
+
+static i2cbus_t bus;
+
+SSD1306_DEFINE(oled, 128, 32, i2c0, SSD1306_DEFAULT_ADDRESS);
+SSD1306_DEFINE_BUS(oled_bus, 128, 32, &bus, SSD1306_DEFAULT_ADDRESS);
+
+static mpu6050_t imu;
+static mpu6050_drdy_t drdy;
+static mpu6050_sample_t samples[MPU6050_FIFO_SIZE / MPU6050_FIFO_SAMPLE];
+static widget_t dash[3];
+
+typedef struct {
+    uint32_t frames, samples, skipped, repeated;
+    uint64_t last;
+    bool any;
+    double latency_sum_us, latency_max_us;
+} tally_t;
+
+static void see(tally_t *t, const float *accel) {
+    uint32_t raw = (uint32_t)lrintf(accel[0] / MPU6050_ACCEL_G) & 0x7FFF;
+    uint64_t index = t->any ? t->last + ((raw - t->last) & 0x7FFF) : raw;
+    if (t->any) {
+        if (index == t->last) {
+            t->repeated++;
+            return;
+        }
+        t->skipped += (uint32_t)(index - t->last - 1);
+    }
+    t->any = true;
+    t->last = index;
+    t->samples++;
+}
+
+static void wobble(uint32_t index, uint64_t t_us, int16_t raw[6]) {
+    raw[0] = (int16_t)(index & 0x7FFF);
+    raw[1] = (int16_t)(8192 * sin(2 * M_PI * 3 * t_us / 1e6));
+    raw[2] = 16384;
+    raw[3] = raw[4] = raw[5] = 0;
+}
+
+static bool panel_matches(ssd1306_t *d) {
+    const fake_ssd1306_t *p = fake_bus_panel(d);
+    for (int page = 0; page < d->pages; page++) {
+        if (memcmp(p->gddram[page], d->buffer + 1 + page * d->width, d->width) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// a frame that changes everywhere
+static void draw(ssd1306_t *d, const tally_t *t) {
+    ssd1306_clear(d);
+    int x = t->frames % d->width;
+    gfx_fill_rect(d, 0, 0, x, d->height / 2, 1);
+    gfx_line(d, 0, d->height - 1, d->width - 1 - x, d->height / 2, 1);
+}
+
+static void setup(void) {
+    fake_bus_reset();
+    fake_mpu6050()->motion = wobble;
+    fake_mpu6050()->int_gpio = INT_GPIO;
+    widget_crosshair(&dash[0], 0, 0, 64, 32, 100);
+    widget_number(&dash[1], 66, 0, 10, 2, "Y:");
+    widget_number(&dash[2], 66, 8, 10, 2, "Z:");
+}
+
+static void report(const char *name, const tally_t *t, ssd1306_t *d) {
+    double s = RUN_US / 1e6;
+    printf("  %-26s %4.0f fps %5.0f samples/s, %u skipped %u repeated, panel %s\n", name, t->frames / s,
+           t->samples / s, t->skipped, t->repeated, panel_matches(d) ? "matches buffer" : "DIFFERS from buffer");
+}
+
+// full frames with ssd1306_update(), FIFO reads between them
+static void bench_blocking(void) {
+    tally_t t = { 0 };
+    setup();
+    ssd1306_setup(&oled);
+    mpu6050_init(&imu, i2c0, MPU6050_ADDR);
+    mpu6050_fifo_start(&imu, RATE_HZ, 3);
+    uint64_t end = time_us_64() + RUN_US;
+    while (time_us_64() < end) {
+        int n = mpu6050_fifo_read(&imu, samples, sizeof(samples) / sizeof(samples[0]));
+        uint64_t now = time_us_64();
+        for (int i = 0; i < n; i++) {
+            // the model stamps exactly, so this is when it was taken
+            double wait = (double)(now - samples[i].t_us);
+            t.latency_sum_us += wait;
+            if (wait > t.latency_max_us) t.latency_max_us = wait;
+            see(&t, samples[i].accel);
+        }
+        draw(&oled, &t);
+        ssd1306_update(&oled);
+        t.frames++;
+    }
+    report("blocking, FIFO", &t, &oled);
+    printf("  %-26s sample to RAM %.0f us mean, %.0f us max, %u lost in %u overflows\n", "",
+           t.latency_sum_us / t.samples, t.latency_max_us, imu.lost, imu.overflows);
+}
+
+static void report_bus(void) {
+    uint32_t bound = i2cbus_bound_us(&bus, MPU6050_DATA_BYTES + 1);
+    printf("  %-26s edge to RAM %.0f us mean, %u us max, bound %u us: %s; %u missed (%u busy, %u full, %u gaps)\n",
+           "", drdy.reads ? (double)drdy.latency_sum_us / drdy.reads : 0.0, drdy.latency_max_us, bound,
+           drdy.latency_max_us <= bound ? "held" : "BROKEN", mpu6050_drdy_missed(&drdy), drdy.busy, drdy.full,
+           drdy.gaps);
+    for (int i = 0; i < bus.devices; i++) {
+        const i2cbus_device_t *dev = &bus.dev[i];
+        printf("  %-26s %-4s %5.1f%% of the bus, %6u txns, %3u past deadline, %u aborted\n", "", dev->name,
+               100 * i2cbus_utilization(&bus, i), dev->txns, dev->misses, dev->aborts);
+    }
+}
+
+// data-ready reads through the scheduler, the display either full frames
+// on DMA or the dashboard's partial updates, and with ghost reads to
+// nobody every GHOST_US. False if something went wrong.
+static bool bench_scheduled(const char *name, uint16_t piece, bool full, bool ghost) {
+    tally_t t = { 0 };
+    setup();
+    i2cbus_init(&bus, i2c0, 400000, piece);
+    ssd1306_setup(&oled_bus);
+    mpu6050_init_bus(&imu, &bus, MPU6050_ADDR);
+    mpu6050_drdy_start(&drdy, &imu, INT_GPIO, RATE_HZ, 3);
+    int nobody = ghost ? i2cbus_add_device(&bus, "none", I2CBUS_PRIO_HIGH) : 0;
+    uint8_t reg = 0, rx[6];
+    i2cbus_txn_t probe = {
+        .addr = GHOST_ADDR, .device = (uint8_t)nobody, .priority = I2CBUS_PRIO_HIGH,
+        .prefix = I2CBUS_NO_PREFIX, .tx = &reg, .tx_len = 1, .rx = rx, .rx_len = sizeof(rx),
+    };
+    uint32_t probes = 0;
+    i2cbus_reset_stats(&bus);
+
+    uint64_t end = time_us_64() + RUN_US;
+    uint64_t next_probe = time_us_64() + GHOST_US;
+    while (time_us_64() < end) {
+        if (ghost && time_us_64() >= next_probe && !i2cbus_busy(&probe)) {
+            probes += i2cbus_submit(&bus, &probe);
+            next_probe += GHOST_US;
+        }
+        int n = mpu6050_drdy_read(&drdy, samples, sizeof(samples) / sizeof(samples[0]));
+        for (int i = 0; i < n; i++) {
+            see(&t, samples[i].accel);
+        }
+        if (full) {
+            if (!ssd1306_update_busy(&oled_bus)) {
+                draw(&oled_bus, &t);
+                ssd1306_update_start(&oled_bus);
+                t.frames++;
+            }
+        } else if (n > 0) {
+            const float *a = samples[n - 1].accel;
+            widget_set_xy(&dash[0], 0, (int32_t)(a[1] * 100));
+            widget_set(&dash[1], (int32_t)(a[1] * 100));
+            widget_set(&dash[2], (int32_t)(a[2] * 100));
+            widget_render_all(&oled_bus, dash, 3);
+            ssd1306_update_dirty(&oled_bus);
+            t.frames++;
+        }
+        tight_loop_contents();
+    }
+    ssd1306_update_wait(&oled_bus);
+    while (i2cbus_busy(&probe)) {
+        tight_loop_contents();
+    }
+    mpu6050_drdy_stop(&drdy);
+    report(name, &t, &oled_bus);
+    report_bus();
+    bool ok = panel_matches(&oled_bus);
+    if (ghost) {
+        ok = ok && t.skipped == 0 && t.repeated == 0 && bus.dev[nobody].aborts == probes &&
+             bus.dev[nobody].txns == probes;
+        printf("  %-26s %u reads to 0x%02X, %u aborted: %s\n", "", probes, GHOST_ADDR, bus.dev[nobody].aborts,
+               ok ? "ok" : "WRONG");
+    }
+    return ok;
+}
+
+// a split frame running and the queue filled up behind it: the last
+// submit is refused, the frame's pieces still all go out
+static bool bench_queue_full(void) {
+    setup();
+    i2cbus_init(&bus, i2c0, 400000, 16);
+    ssd1306_setup(&oled_bus);
+    int nobody = i2cbus_add_device(&bus, "none", I2CBUS_PRIO_HIGH);
+    static uint8_t reg;
+    static i2cbus_txn_t probes[I2CBUS_QUEUE];
+    draw(&oled_bus, &(tally_t){ .frames = 40 });
+    ssd1306_update_start(&oled_bus);
+    int taken = 0;
+    for (int i = 0; i < I2CBUS_QUEUE; i++) {
+        probes[i] = (i2cbus_txn_t){
+            .addr = GHOST_ADDR, .device = (uint8_t)nobody, .priority = I2CBUS_PRIO_LOW,
+            .prefix = I2CBUS_NO_PREFIX, .tx = &reg, .tx_len = 1,
+        };
+        taken += i2cbus_submit(&bus, &probes[i]);
+    }
+    ssd1306_update_wait(&oled_bus);
+    for (int i = 0; i < taken; i++) {
+        i2cbus_wait(&bus, &probes[i]);
+    }
+    bool ok = taken == I2CBUS_QUEUE - 1 && bus.count == 0 && !bus.running && panel_matches(&oled_bus);
+    printf("  %-26s %d of %d taken behind a split frame, panel %s: %s\n", "queue full", taken, I2CBUS_QUEUE,
+           panel_matches(&oled_bus) ? "matches buffer" : "DIFFERS from buffer", ok ? "ok" : "WRONG");
+    return ok;
+}
+
+int main(void) {
+    printf("128x32 display and MPU6050 at %d Hz sharing i2c0 at 400 kHz, %d s\n", RATE_HZ, RUN_US / 1000000);
+    bench_blocking();
+    bool ok = true;
+    ok &= bench_scheduled("scheduled, page pieces", 128, true, false);
+    ok &= bench_scheduled("scheduled, 32 byte pieces", 32, true, false);
+    ok &= bench_scheduled("scheduled, 16 byte pieces", 16, true, false);
+    ok &= bench_scheduled("scheduled, dashboard", 16, false, false);
+    ok &= bench_scheduled("dashboard, NACKed reads", 16, false, true);
+    ok &= bench_queue_full();
+    return ok ? 0 : 1;
+}
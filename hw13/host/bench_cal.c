@@ -0,0 +1,204 @@
+// Host benchmark for the six-position IMU calibration (imucal.c).
+//
+//   ./bench_cal
+//
+// The MPU6050 model is given known errors: an accel offset and scale per
+// axis, a gyro offset, noise, and a board that sits a degree off each
+// face. A scripted session turns it through the six faces with 0.6 s
+// turns and 2 s holds, polling at 200 Hz the way hw13 does, with a knock
+// during one of the holds. The estimate is compared with the errors put
+// in, and the g readings on each face with and without it. Then the flash
+// record: written, read back as after a reboot, and refused when blank,
+// damaged or from another version.
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "hardware/flash.h"
+#include "mpu6050.h"
+#include "imucal.h"
+#include "fake_bus.h"
+#include "fake_mpu6050.h"
+
+#define POLL_US   5000
+#define TURN_US   600000
+#define HOLD_US   2000000
+#define KNOCK_US  50000
+
+static const double accel_offset[3] = { 310, -205, 480 };   // counts
+static const double accel_scale[3] = { 1.021, 0.985, 1.034 };
+static const double gyro_offset[3] = { 105, -66, 79 };      // counts, 0.8 -0.5 0.6 deg/s
+static const double accel_noise = 40, gyro_noise = 7;       // counts rms
+
+// never two opposite faces in a row, so every turn is a quarter turn
+static const int order[IMUCAL_FACES] = { 4, 0, 5, 2, 1, 3 }; // +Z +X -Z +Y -X -Y
+static const int knocked = 3;                                 // during this hold
+
+static mpu6050_t imu;
+static int failures;
+
+static uint64_t rng = 0x2545F4914F6CDD1DULL;
+static double gauss(void) {
+    double u[2];
+    for (int i = 0; i < 2; i++) {
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        u[i] = ((rng >> 11) + 0.5) / 9007199254740992.0;
+    }
+    return sqrt(-2 * log(u[0])) * cos(2 * M_PI * u[1]);
+}
+
+// gravity in g with `face` up, a degree off towards the next axis
+static void face_vector(int face, double *g) {
+    int axis = face / 2;
+    g[0] = g[1] = g[2] = 0;
+    g[axis] = face & 1 ? -1 : 1;
+    g[(axis + 1) % 3] = 0.017;
+}
+
+static void normalize(double *v) {
+    double n = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    for (int i = 0; i < 3; i++) v[i] /= n;
+}
+
+// where the script has the board at t: gravity in g, rotation in deg/s
+static uint64_t script_start;
+static int hold_face = -1; // fixed face for the checks after the script
+
+static void script(uint64_t t_us, double *g, double *w) {
+    w[0] = w[1] = w[2] = 0;
+    if (hold_face >= 0) {
+        face_vector(hold_face, g);
+        normalize(g);
+        return;
+    }
+    uint64_t t = t_us - script_start;
+    int step = (int)(t / (TURN_US + HOLD_US));
+    if (step >= IMUCAL_FACES) {
+        face_vector(order[IMUCAL_FACES - 1], g);
+        normalize(g);
+        return;
+    }
+    uint64_t in = t % (TURN_US + HOLD_US);
+    int to = order[step];
+    if (in < TURN_US && step > 0) {
+        // a quarter turn from the last face at a steady rate
+        double from_g[3], to_g[3], s = (double)in / TURN_US;
+        face_vector(order[step - 1], from_g);
+        face_vector(to, to_g);
+        for (int i = 0; i < 3; i++) {
+            g[i] = cos(s * M_PI / 2) * from_g[i] + sin(s * M_PI / 2) * to_g[i];
+        }
+        double rate = 90.0 / (TURN_US / 1e6);
+        // about from x to
+        w[0] = (from_g[1] * to_g[2] - from_g[2] * to_g[1]) * rate;
+        w[1] = (from_g[2] * to_g[0] - from_g[0] * to_g[2]) * rate;
+        w[2] = (from_g[0] * to_g[1] - from_g[1] * to_g[0]) * rate;
+    } else {
+        face_vector(to, g);
+        if (step == knocked && in > TURN_US + HOLD_US / 4 && in < TURN_US + HOLD_US / 4 + KNOCK_US) {
+            g[(to / 2 + 2) % 3] += 0.1;
+            w[to / 2] = 20;
+        }
+    }
+    normalize(g);
+}
+
+static void motion(uint32_t index, uint64_t t_us, int16_t raw[6]) {
+    (void)index;
+    double g[3], w[3];
+    script(t_us, g, w);
+    for (int i = 0; i < 3; i++) {
+        double a = g[i] / MPU6050_ACCEL_G * accel_scale[i] + accel_offset[i] + accel_noise * gauss();
+        double r = w[i] / MPU6050_GYRO_DPS + gyro_offset[i] + gyro_noise * gauss();
+        raw[i] = (int16_t)fmax(-32768, fmin(32767, lrint(a)));
+        raw[3 + i] = (int16_t)fmax(-32768, fmin(32767, lrint(r)));
+    }
+}
+
+// the worst |a| - 1 g over the faces and the mean gyro, with imu.cal as set
+static void check_faces(const char *name) {
+    double worst = 0, gyro[3] = { 0 };
+    int n = 0;
+    for (int f = 0; f < IMUCAL_FACES; f++) {
+        hold_face = f;
+        double sum[3] = { 0 };
+        for (int k = 0; k < 200; k++) {
+            float a[3], w[3], temp;
+            mpu6050_read(&imu, a, w, &temp);
+            for (int i = 0; i < 3; i++) {
+                sum[i] += a[i];
+                gyro[i] += w[i];
+            }
+            n++;
+            fake_time_advance_us(POLL_US);
+        }
+        double mag = sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]) / 200;
+        if (fabs(mag - 1) > worst) worst = fabs(mag - 1);
+    }
+    hold_face = -1;
+    printf("  %-14s |a| off 1 g by up to %5.1f mg, gyro at rest %6.3f %6.3f %6.3f deg/s\n", name, worst * 1000,
+           gyro[0] / n, gyro[1] / n, gyro[2] / n);
+}
+
+static void expect(const char *what, bool ok) {
+    printf("  %-44s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) failures++;
+}
+
+int main(void) {
+    fake_bus_reset();
+    fake_flash_reset();
+    fake_mpu6050()->motion = motion;
+    mpu6050_init(&imu, i2c0, MPU6050_ADDR);
+
+    printf("six-position calibration, polled at %d Hz, %d sample windows\n", 1000000 / POLL_US, IMUCAL_WINDOW);
+    imucal_t cal;
+    imucal_begin(&cal);
+    script_start = time_us_64();
+    uint64_t end = script_start + (uint64_t)IMUCAL_FACES * (TURN_US + HOLD_US);
+    while (time_us_64() < end && !imucal_complete(&cal)) {
+        int16_t a[3], w[3];
+        mpu6050_read_raw(&imu, a, w);
+        int face = imucal_feed(&cal, a, w);
+        if (face >= 0) {
+            printf("  %s done at %5.2f s\n", imucal_face_name(face), (time_us_64() - script_start) / 1e6);
+        }
+        fake_time_advance_us(POLL_US);
+    }
+    printf("  %u windows restarted for moving\n", cal.restarts);
+
+    mpu6050_cal_t result;
+    mpu6050_cal_identity(&result);
+    expect("all six faces, plausible result", imucal_result(&cal, &result));
+    printf("  %-6s %18s %18s %18s\n", "axis", "accel offset", "accel scale", "gyro offset");
+    for (int i = 0; i < 3; i++) {
+        printf("  %-6c %8d (%5.0f)   %8.4f (%6.4f)   %8d (%5.0f)\n", 'X' + i, result.accel_offset[i],
+               accel_offset[i], (double)result.accel_scale[i] / MPU6050_CAL_ONE, 1 / accel_scale[i],
+               result.gyro_offset[i], gyro_offset[i]);
+    }
+    printf("  (what the model was given in brackets)\n");
+
+    check_faces("uncalibrated");
+    imu.cal = result;
+    check_faces("calibrated");
+
+    printf("flash record, last sector of %u KB\n", PICO_FLASH_SIZE_BYTES / 1024);
+    mpu6050_cal_t loaded;
+    expect("blank flash refused", !imucal_load(&loaded));
+    expect("saved and read back", imucal_save(&result));
+    fake_flash_stats_t fs = fake_flash_stats();
+    printf("  %u sector erased, %u page programmed, %u misaligned\n", fs.erases, fs.programs, fs.misaligned);
+    memset(&loaded, 0, sizeof(loaded));
+    expect("loads after a reboot, same values", imucal_load(&loaded) && !memcmp(&loaded, &result, sizeof(loaded)));
+
+    uint8_t *record = fake_flash + PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE;
+    record[10] ^= 0x04; // one bit of the accel offsets
+    expect("one flipped bit refused", !imucal_load(&loaded));
+    record[10] ^= 0x04;
+    record[4] = IMUCAL_VERSION + 1;
+    expect("another version refused", !imucal_load(&loaded));
+    record[4] = IMUCAL_VERSION;
+    expect("and back as it was", imucal_load(&loaded));
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,142 @@
+// Host benchmark for the OLED console.
+//
+//   ./bench_console [frame_dir]
+//
+// Measures what console_write() costs the caller during a printf storm,
+// how many bytes each console line puts on the bus, and checks that the
+// panel model shows the last lines written, start line scrolling included.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "ssd1306.h"
+#include "gfx.h"
+#include "console.h"
+#include "fake_bus.h"
+
+
+SSD1306_DEFINE(oled, 128, 32, i2c0, SSD1306_DEFAULT_ADDRESS);
+SSD1306_DEFINE(oled64, 128, 64, i2c1, SSD1306_DEFAULT_ADDRESS);
+SSD1306_DEFINE_SPI(oled_spi, 128, 64, spi0, 20, 17, 21);
+
+// only the buffer is used, to render the expected screen with gfx
+SSD1306_DEFINE(ref, 128, 64, i2c1, SSD1306_DEFAULT_ADDRESS);
+
+static const char *frame_dir;
+static uint32_t now_ms;
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void line_text(char *s, int size, int i) {
+    snprintf(s, size, "ax=%+.2f line %d", (i % 200 - 100) / 100.0, i);
+}
+
+// one printf worth of output
+static void write_line(int i) {
+    char s[32];
+    line_text(s, sizeof(s), i);
+    strcat(s, "\n");
+    console_write(s, strlen(s));
+}
+
+// run console_task() at its rate until everything queued is on the panel
+static void drain(void) {
+    do {
+        now_ms += CONSOLE_PERIOD_MS;
+        console_task(now_ms);
+    } while (console_pending());
+}
+
+// the bottom rows of the panel should be lines first..last
+static bool shows_lines(ssd1306_t *d, int first, int last) {
+    const fake_ssd1306_t *p = fake_bus_panel(d);
+    memset(ref.buffer + 1, 0, SSD1306_BUFFER_SIZE(128, 64) - 1);
+    int rows = d->height / 8;
+    int r = rows - 1;
+    for (int i = last; i >= first && r >= 0; i--, r--) {
+        char s[32];
+        line_text(s, sizeof(s), i);
+        gfx_string(&ref, 0, r * 8, s);
+    }
+    for (int y = (r + 1) * 8; y < d->height; y++) {
+        for (int x = 0; x < d->width; x++) {
+            int want = (ref.buffer[1 + (y / 8) * 128 + x] >> (y & 7)) & 1;
+            if (fake_ssd1306_pixel(p, x, y) != want) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void run(ssd1306_t *d) {
+    const int lines = 40;
+    printf("%dx%d on %s\n", d->width, d->height, fake_bus_name(d));
+    fake_bus_connect(d);
+    ssd1306_setup(d);
+    console_init(d);
+
+    // steady output the console can keep up with
+    fake_bus_reset_stats();
+    for (int i = 0; i < lines; i++) {
+        write_line(i);
+        now_ms += CONSOLE_PERIOD_MS;
+        console_task(now_ms);
+    }
+    fake_bus_stats_t st = fake_bus_stats(d);
+    printf("  %-24s %6u bytes %4u transactions per line, %6.2f ms on the wire (full frame: %d bytes)\n",
+           "line + scroll", st.bytes / lines, st.transactions / lines,
+           fake_bus_wire_us(d, st) / lines / 1000.0,
+           SSD1306_BUFFER_SIZE(d->width, d->height));
+    printf("  %-24s %s\n", "panel", shows_lines(d, 0, lines - 1) ? "shows the last lines" : "WRONG");
+
+    // a printf storm: the writer only ever copies into the ring
+    const int storm = 100000;
+    uint32_t dropped0 = console_dropped();
+    double t0 = now_us();
+    for (int i = 0; i < storm; i++) {
+        write_line(lines + i);
+    }
+    double t1 = now_us();
+    printf("  %-24s %9.3f us per line written, %u bytes dropped\n", "storm, writer",
+           (t1 - t0) / storm, console_dropped() - dropped0);
+
+    fake_bus_reset_stats();
+    uint32_t ms0 = now_ms;
+    drain();
+    st = fake_bus_stats(d);
+    printf("  %-24s %6u ms of refreshes, %6.2f ms bus time per refresh at most %d lines\n",
+           "storm, drain", now_ms - ms0,
+           fake_bus_wire_us(d, st) / ((now_ms - ms0) / CONSOLE_PERIOD_MS) / 1000.0,
+           CONSOLE_LINES_PER_TASK);
+
+    // after draining, new output shows up normally again
+    for (int i = 0; i < 5; i++) {
+        write_line(1000000 + i);
+    }
+    drain();
+    printf("  %-24s %s\n", "panel after storm",
+           shows_lines(d, 1000000, 1000004) ? "shows the last lines" : "WRONG");
+
+    if (frame_dir) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/console_%dx%d.pbm", frame_dir, d->width, d->height);
+        fake_ssd1306_write_pbm(fake_bus_panel(d), path);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        frame_dir = argv[1];
+    }
+    fake_bus_reset();
+    run(&oled);
+    run(&oled64);
+    run(&oled_spi);
+    return 0;
+}
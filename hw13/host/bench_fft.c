@@ -0,0 +1,195 @@
+// Host benchmark for the Q15 FFT (fft.c) and the vibration spectrum
+// (spectrum.c).
+//
+//   ./bench_fft [frame_dir]
+//
+// First the FFT on its own against a double precision DFT of the same
+// input, for a full scale random signal and for small tones, where a
+// fixed scaling per stage would have lost most of the bits: the error is
+// given as SNR over the output. Then the spectrum on the MPU6050 model's
+// FIFO at 1 kHz, the board shaking at two known frequencies and
+// amplitudes with accelerometer noise on top, for 256 and 512 points:
+// the peaks found against the ones put in, and the time per block. With a
+// frame_dir the display showing it is saved as a PBM.
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <math.h>
+#include "ssd1306.h"
+#include "gfx.h"
+#include "mpu6050.h"
+#include "fft.h"
+#include "spectrum.h"
+#include "fake_bus.h"
+#include "fake_mpu6050.h"
+
+#define RATE_HZ 1000
+#define RUN_US  2000000
+#define ROUNDS  2000
+
+SSD1306_DEFINE(oled, 128, 32, i2c0, SSD1306_DEFAULT_ADDRESS);
+
+static const char *frame_dir;
+static int failures;
+
+// the shaking: X and Y tones on 1 g of gravity along Z
+static const double tone_hz[2] = { 37.3, 121.7 };
+static const double tone_g[2] = { 0.050, 0.012 };
+static const double noise_g = 0.0024;
+
+static mpu6050_t imu;
+static mpu6050_sample_t samples[MPU6050_FIFO_SIZE / MPU6050_FIFO_SAMPLE];
+static spectrum_t spectrum, scratch;
+
+static uint64_t rng = 0x9E3779B97F4A7C15ULL;
+static double gauss(void) {
+    double u[2];
+    for (int i = 0; i < 2; i++) {
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        u[i] = ((rng >> 11) + 0.5) / 9007199254740992.0;
+    }
+    return sqrt(-2 * log(u[0])) * cos(2 * M_PI * u[1]);
+}
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void expect(const char *what, bool ok) {
+    printf("  %-52s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) failures++;
+}
+
+// SNR of the Q15 transform of x against a double DFT, in dB
+static double fft_snr(const int16_t *x, int log2n) {
+    int n = 1 << log2n;
+    int16_t re[FFT_MAX], im[FFT_MAX];
+    memcpy(re, x, n * sizeof(int16_t));
+    memset(im, 0, n * sizeof(int16_t));
+    int e = fft_q15(re, im, log2n);
+    double signal = 0, error = 0;
+    for (int k = 0; k < n; k++) {
+        double sr = 0, si = 0;
+        for (int i = 0; i < n; i++) {
+            double a = -2 * M_PI * (double)k * i / n;
+            sr += x[i] * cos(a);
+            si += x[i] * sin(a);
+        }
+        double gr = ldexp(re[k], e), gi = ldexp(im[k], e);
+        signal += sr * sr + si * si;
+        error += (gr - sr) * (gr - sr) + (gi - si) * (gi - si);
+    }
+    return 10 * log10(signal / (error > 0 ? error : 1e-30));
+}
+
+static void bench_fft(void) {
+    int16_t x[FFT_MAX];
+    printf("Q15 FFT against a double DFT\n");
+    for (int log2n = 8; log2n <= FFT_MAX_LOG2; log2n++) {
+        int n = 1 << log2n;
+        for (int i = 0; i < n; i++) x[i] = (int16_t)lrint(fmax(-32768, fmin(32767, 9000 * gauss())));
+        double noise = fft_snr(x, log2n);
+        for (int i = 0; i < n; i++) x[i] = (int16_t)lrint(20000 * sin(2 * M_PI * 10.3 * i / n));
+        double big = fft_snr(x, log2n);
+        for (int i = 0; i < n; i++) x[i] = (int16_t)lrint(40 * sin(2 * M_PI * 10.3 * i / n));
+        double small = fft_snr(x, log2n);
+
+        int16_t re[FFT_MAX], im[FFT_MAX];
+        double t0 = now_us();
+        for (int r = 0; r < ROUNDS; r++) {
+            memcpy(re, x, n * sizeof(int16_t));
+            memset(im, 0, n * sizeof(int16_t));
+            fft_q15(re, im, log2n);
+        }
+        double us = (now_us() - t0) / ROUNDS;
+        printf("  %3d points: SNR %5.1f dB random, %5.1f dB 20000 count tone, %5.1f dB 40 count tone, %5.2f us\n",
+               n, noise, big, small, us);
+        expect(n == 256 ? "256 points: over 55 dB, small tones too" : "512 points: over 55 dB, small tones too",
+               noise > 55 && big > 55 && small > 55);
+    }
+}
+
+static void shake(uint32_t index, uint64_t t_us, int16_t raw[6]) {
+    (void)index;
+    double t = t_us / 1e6;
+    double a[3] = { tone_g[0] * sin(2 * M_PI * tone_hz[0] * t), tone_g[1] * sin(2 * M_PI * tone_hz[1] * t + 1), 1 };
+    for (int i = 0; i < 3; i++) {
+        raw[i] = (int16_t)lrint((a[i] + noise_g * gauss()) / MPU6050_ACCEL_G);
+        raw[3 + i] = (int16_t)lrint(20 * gauss());
+    }
+}
+
+static void bench_spectrum(int log2n) {
+    fake_bus_reset();
+    fake_mpu6050()->motion = shake;
+    mpu6050_init(&imu, i2c0, MPU6050_ADDR);
+    mpu6050_fifo_start(&imu, RATE_HZ, 1);
+    spectrum_init(&spectrum, log2n, imu.rate_hz, SPECTRUM_ALL);
+    ssd1306_setup(&oled);
+
+    double worst_hz = 0, worst_amp = 0, compute = 0;
+    int blocks = 0, found = 0;
+    uint64_t end = time_us_64() + RUN_US;
+    while (time_us_64() < end) {
+        int n = mpu6050_fifo_read(&imu, samples, sizeof(samples) / sizeof(samples[0]));
+        for (int i = 0; i < n; i++) {
+            if (spectrum.fill == spectrum.n - 1) {
+                // the same block on a copy, for the time
+                double t0 = now_us();
+                for (int r = 0; r < 20; r++) {
+                    scratch = spectrum;
+                    spectrum_add(&scratch, samples[i].raw);
+                }
+                compute += (now_us() - t0) / 20;
+            }
+            if (!spectrum_add(&spectrum, samples[i].raw)) {
+                continue;
+            }
+            blocks++;
+            spectrum_draw(&spectrum, &oled, 0, 8, oled.width, oled.height - 8);
+            // both tones, biggest first
+            if (spectrum.peaks < 2) continue;
+            found++;
+            for (int k = 0; k < 2; k++) {
+                double dhz = fabs(spectrum.peak[k].hz - tone_hz[k]);
+                double damp = fabs(spectrum.peak[k].g / tone_g[k] - 1);
+                if (dhz > worst_hz) worst_hz = dhz;
+                if (damp > worst_amp) worst_amp = damp;
+            }
+        }
+        fake_time_advance_us(5000);
+    }
+    ssd1306_update(&oled);
+
+    printf("  %3d points, %.2f Hz bins: %d blocks, %.1f us each\n", spectrum.n, spectrum_bin_hz(&spectrum), blocks,
+           compute / blocks);
+    for (int k = 0; k < spectrum.peaks; k++) {
+        printf("    peak %d: %7.2f Hz %6.2f mg\n", k, spectrum.peak[k].hz, spectrum.peak[k].g * 1000);
+    }
+    printf("    worst over the blocks: %.2f Hz, %.1f%% amplitude\n", worst_hz, worst_amp * 100);
+    expect("both tones found in every block", found == blocks && blocks > 0);
+    expect("frequency within a fifth of a bin", worst_hz < 0.2 * spectrum_bin_hz(&spectrum));
+    // the noise in the small tone's bins is a few percent of it
+    expect("amplitude within 8%", worst_amp < 0.08);
+
+    if (frame_dir) {
+        char path[256];
+        snprintf(path, sizeof(path), "%s/spectrum%d_%dx%d.pbm", frame_dir, spectrum.n, oled.width, oled.height);
+        fake_ssd1306_write_pbm(fake_bus_panel(&oled), path);
+    }
+}
+
+int main(int argc, char **argv) {
+    frame_dir = argc > 1 ? argv[1] : NULL;
+    fft_init();
+    bench_fft();
+    printf("spectrum of the MPU6050 model at %d Hz: %.1f Hz %.0f mg on X, %.1f Hz %.0f mg on Y, %.1f mg noise\n",
+           RATE_HZ, tone_hz[0], tone_g[0] * 1000, tone_hz[1], tone_g[1] * 1000, noise_g * 1000);
+    bench_spectrum(8);
+    bench_spectrum(9);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,189 @@
+// Host benchmark for fmt against the C library's snprintf.
+//
+//   ./bench_fmt
+//
+// Formats the same values both ways: plain integers, fixed point, floats
+// and hex, the kinds of numbers the hw13 readouts print. Reports the time
+// per call and checks that fmt produced the same text, exiting non-zero
+// if it didn't anywhere. Floats are only compared where float rounding
+// can't make the two disagree on the last digit. On the host this is
+// glibc, not newlib, so the ratio rather than the absolute time is what
+// carries over to the Pico.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "fmt.h"
+
+#define VALUES 4096
+#define ROUNDS 50
+
+static int32_t ints[VALUES];
+static float floats[VALUES];
+static volatile int sink;
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static uint32_t seed = 1;
+static uint32_t rnd(void) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed;
+}
+
+static int differ; // over all the reports, main's exit status
+
+static void report(const char *name, double us_fmt, double us_libc, int mismatches, int compared) {
+    differ += mismatches;
+    int calls = VALUES * ROUNDS;
+    printf("  %-16s fmt %7.1f ns  snprintf %7.1f ns  %5.1fx faster, %d/%d differ\n", name,
+           us_fmt * 1000 / calls, us_libc * 1000 / calls, us_libc / us_fmt, mismatches, compared);
+}
+
+static void bench_int(void) {
+    char a[32], b[32];
+    fmt_t f;
+    double t0 = now_us();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < VALUES; i++) {
+            fmt_begin(&f, a, sizeof(a));
+            fmt_int(&f, ints[i], 6);
+            sink += a[0];
+        }
+    }
+    double t1 = now_us();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < VALUES; i++) {
+            snprintf(b, sizeof(b), "%6ld", (long)ints[i]);
+            sink += b[0];
+        }
+    }
+    double t2 = now_us();
+    int bad = 0;
+    for (int i = 0; i < VALUES; i++) {
+        fmt_begin(&f, a, sizeof(a));
+        fmt_int(&f, ints[i], 6);
+        snprintf(b, sizeof(b), "%6ld", (long)ints[i]);
+        bad += strcmp(a, b) != 0;
+    }
+    report("int, width 6", t1 - t0, t2 - t1, bad, VALUES);
+}
+
+static void bench_fixed(void) {
+    // hundredths, what the widgets get: the same text as "%.2f" of v/100
+    char a[32], b[32];
+    fmt_t f;
+    double t0 = now_us();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < VALUES; i++) {
+            fmt_begin(&f, a, sizeof(a));
+            fmt_fixed(&f, ints[i] % 100000, 2, 0);
+            sink += a[0];
+        }
+    }
+    double t1 = now_us();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < VALUES; i++) {
+            snprintf(b, sizeof(b), "%.2f", (ints[i] % 100000) / 100.0);
+            sink += b[0];
+        }
+    }
+    double t2 = now_us();
+    int bad = 0;
+    for (int i = 0; i < VALUES; i++) {
+        fmt_begin(&f, a, sizeof(a));
+        fmt_fixed(&f, ints[i] % 100000, 2, 0);
+        snprintf(b, sizeof(b), "%.2f", (ints[i] % 100000) / 100.0);
+        bad += strcmp(a, b) != 0;
+    }
+    report("fixed, 2 places", t1 - t0, t2 - t1, bad, VALUES);
+}
+
+static void bench_float(void) {
+    char a[32], b[32];
+    fmt_t f;
+    double t0 = now_us();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < VALUES; i++) {
+            fmt_begin(&f, a, sizeof(a));
+            fmt_float(&f, floats[i], 3, 0);
+            sink += a[0];
+        }
+    }
+    double t1 = now_us();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < VALUES; i++) {
+            snprintf(b, sizeof(b), "%.3f", floats[i]);
+            sink += b[0];
+        }
+    }
+    double t2 = now_us();
+    int bad = 0, compared = 0;
+    for (int i = 0; i < VALUES; i++) {
+        // skip values within float error of a rounding boundary, and
+        // small negatives that round to "-0.000" in printf
+        double scaled = floats[i] * 1000.0;
+        double frac = scaled - (double)(int64_t)scaled;
+        if (frac < 0) frac = -frac;
+        if ((frac > 0.499 && frac < 0.501) || (floats[i] < 0 && floats[i] > -0.0005f)) {
+            continue;
+        }
+        fmt_begin(&f, a, sizeof(a));
+        fmt_float(&f, floats[i], 3, 0);
+        snprintf(b, sizeof(b), "%.3f", floats[i]);
+        bad += strcmp(a, b) != 0;
+        compared++;
+    }
+    report("float, 3 places", t1 - t0, t2 - t1, bad, compared);
+}
+
+static void bench_hex(void) {
+    char a[32], b[32];
+    fmt_t f;
+    double t0 = now_us();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < VALUES; i++) {
+            fmt_begin(&f, a, sizeof(a));
+            fmt_hex(&f, (uint32_t)ints[i], 4);
+            sink += a[0];
+        }
+    }
+    double t1 = now_us();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < VALUES; i++) {
+            snprintf(b, sizeof(b), "%04lx", (unsigned long)(uint32_t)ints[i]);
+            sink += b[0];
+        }
+    }
+    double t2 = now_us();
+    int bad = 0;
+    for (int i = 0; i < VALUES; i++) {
+        fmt_begin(&f, a, sizeof(a));
+        fmt_hex(&f, (uint32_t)ints[i], 4);
+        snprintf(b, sizeof(b), "%04lx", (unsigned long)(uint32_t)ints[i]);
+        bad += strcmp(a, b) != 0;
+    }
+    report("hex, 4 digits", t1 - t0, t2 - t1, bad, VALUES);
+}
+
+int main(void) {
+    // readout sized numbers: mostly a few digits, some large, both signs
+    for (int i = 0; i < VALUES; i++) {
+        uint32_t r = rnd();
+        int32_t mag = (int32_t)(r >> 8) % (i % 8 == 0 ? 2000000000 : 100000);
+        ints[i] = (r & 1) ? -mag : mag;
+        floats[i] = (float)((int32_t)(rnd() >> 12) - (1 << 19)) / 65536.0f; // about +-8 g
+    }
+    ints[0] = INT32_MIN;
+    ints[1] = 0;
+    printf("%d values x %d rounds\n", VALUES, ROUNDS);
+    bench_int();
+    bench_fixed();
+    bench_float();
+    bench_hex();
+    return differ != 0;
+}
@@ -0,0 +1,230 @@
+// Host benchmark: gfx.c primitives vs the per-pixel ssd1306_drawPixel() path.
+// Prints pixels per microsecond for each primitive and checks that both
+// paths leave identical buffers for on-screen lines; exits non-zero if not.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ssd1306.h"
+#include "gfx.h"
+
+SSD1306_DEFINE(oled, 128, 32, i2c0, SSD1306_DEFAULT_ADDRESS);
+
+#define ITERATIONS 200000
+
+// the old hw13 draw_line(), one bounds-checked pixel at a time
+static void ref_line(int x0, int y0, int x1, int y1) {
+    int dx = abs(x1 - x0);
+    int sx = x0 < x1 ? 1 : -1;
+    int dy = -abs(y1 - y0);
+    int sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    int e2;
+
+    while (1) {
+        ssd1306_drawPixel(&oled, x0, y0, 1);
+        if (x0 == x1 && y0 == y1) break;
+        e2 = 2 * err;
+        if (e2 >= dy) {
+            if (x0 == x1) break;
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx) {
+            if (y0 == y1) break;
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+static void ref_fill_rect(int x, int y, int w, int h) {
+    for (int j = y; j < y + h; j++) {
+        for (int i = x; i < x + w; i++) {
+            ssd1306_drawPixel(&oled, i, j, 1);
+        }
+    }
+}
+
+static void ref_circle(int xc, int yc, int r) {
+    int x = r, y = 0, err = 1 - r;
+    while (x >= y) {
+        ssd1306_drawPixel(&oled, xc + x, yc + y, 1); ssd1306_drawPixel(&oled, xc - x, yc + y, 1);
+        ssd1306_drawPixel(&oled, xc + x, yc - y, 1); ssd1306_drawPixel(&oled, xc - x, yc - y, 1);
+        ssd1306_drawPixel(&oled, xc + y, yc + x, 1); ssd1306_drawPixel(&oled, xc - y, yc + x, 1);
+        ssd1306_drawPixel(&oled, xc + y, yc - x, 1); ssd1306_drawPixel(&oled, xc - y, yc - x, 1);
+        y++;
+        if (err < 0) {
+            err += 2 * y + 1;
+        } else {
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+}
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// small LCG so both paths see the same coordinates
+static uint32_t seed;
+static int rnd(int n) {
+    seed = seed * 1664525u + 1013904223u;
+    return (int)((seed >> 8) % (uint32_t)n);
+}
+
+static long line_pixels(int x0, int y0, int x1, int y1) {
+    int dx = abs(x1 - x0), dy = abs(y1 - y0);
+    return (dx > dy ? dx : dy) + 1;
+}
+
+static void report(const char *name, long pixels, double ref_us, double fast_us) {
+    printf("%-12s %10.1f px/us per-pixel %10.1f px/us gfx   (x%.1f)\n",
+           name, pixels / ref_us, pixels / fast_us, ref_us / fast_us);
+}
+
+static int bench_lines(void) {
+    static unsigned char ref_buf[SSD1306_BUFFER_SIZE(128, 32)];
+    long pixels = 0;
+    double t0, ref_us, fast_us;
+
+    seed = 1;
+    ssd1306_clear(&oled);
+    t0 = now_us();
+    for (int i = 0; i < ITERATIONS; i++) {
+        int x0 = rnd(oled.width), y0 = rnd(oled.height);
+        int x1 = rnd(oled.width), y1 = rnd(oled.height);
+        ref_line(x0, y0, x1, y1);
+        pixels += line_pixels(x0, y0, x1, y1);
+    }
+    ref_us = now_us() - t0;
+    memcpy(ref_buf, oled.buffer, sizeof(ref_buf));
+
+    seed = 1;
+    ssd1306_clear(&oled);
+    t0 = now_us();
+    for (int i = 0; i < ITERATIONS; i++) {
+        int x0 = rnd(oled.width), y0 = rnd(oled.height);
+        int x1 = rnd(oled.width), y1 = rnd(oled.height);
+        gfx_line(&oled, x0, y0, x1, y1, 1);
+    }
+    fast_us = now_us() - t0;
+
+    report("line", pixels, ref_us, fast_us);
+
+    // buffers saturate quickly, so compare a single line at a time as well
+    int mismatches = memcmp(ref_buf, oled.buffer, sizeof(ref_buf)) != 0;
+    seed = 7;
+    for (int i = 0; i < 1000; i++) {
+        int x0 = rnd(oled.width), y0 = rnd(oled.height);
+        int x1 = rnd(oled.width), y1 = rnd(oled.height);
+        ssd1306_clear(&oled);
+        ref_line(x0, y0, x1, y1);
+        memcpy(ref_buf, oled.buffer, sizeof(ref_buf));
+        ssd1306_clear(&oled);
+        gfx_line(&oled, x0, y0, x1, y1, 1);
+        mismatches += memcmp(ref_buf, oled.buffer, sizeof(ref_buf)) != 0;
+    }
+    printf("             line output mismatches vs per-pixel path: %d\n", mismatches);
+    return mismatches;
+}
+
+static void bench_spans(void) {
+    long pixels = 0;
+    double t0, ref_us, fast_us;
+
+    // horizontal
+    seed = 2;
+    t0 = now_us();
+    for (int i = 0; i < ITERATIONS; i++) {
+        int x0 = rnd(oled.width), x1 = rnd(oled.width), y = rnd(oled.height);
+        ref_line(x0, y, x1, y);
+        pixels += abs(x1 - x0) + 1;
+    }
+    ref_us = now_us() - t0;
+    seed = 2;
+    t0 = now_us();
+    for (int i = 0; i < ITERATIONS; i++) {
+        int x0 = rnd(oled.width), x1 = rnd(oled.width), y = rnd(oled.height);
+        gfx_hline(&oled, x0, x1, y, 1);
+    }
+    fast_us = now_us() - t0;
+    report("hline", pixels, ref_us, fast_us);
+
+    // vertical
+    pixels = 0;
+    seed = 3;
+    t0 = now_us();
+    for (int i = 0; i < ITERATIONS; i++) {
+        int x = rnd(oled.width), y0 = rnd(oled.height), y1 = rnd(oled.height);
+        ref_line(x, y0, x, y1);
+        pixels += abs(y1 - y0) + 1;
+    }
+    ref_us = now_us() - t0;
+    seed = 3;
+    t0 = now_us();
+    for (int i = 0; i < ITERATIONS; i++) {
+        int x = rnd(oled.width), y0 = rnd(oled.height), y1 = rnd(oled.height);
+        gfx_vline(&oled, x, y0, y1, 1);
+    }
+    fast_us = now_us() - t0;
+    report("vline", pixels, ref_us, fast_us);
+}
+
+static void bench_shapes(void) {
+    long pixels = 0;
+    double t0, ref_us, fast_us;
+
+    seed = 4;
+    t0 = now_us();
+    for (int i = 0; i < ITERATIONS / 10; i++) {
+        int x = rnd(oled.width), y = rnd(oled.height);
+        int w = rnd(oled.width - x) + 1, h = rnd(oled.height - y) + 1;
+        ref_fill_rect(x, y, w, h);
+        pixels += (long)w * h;
+    }
+    ref_us = now_us() - t0;
+    seed = 4;
+    t0 = now_us();
+    for (int i = 0; i < ITERATIONS / 10; i++) {
+        int x = rnd(oled.width), y = rnd(oled.height);
+        int w = rnd(oled.width - x) + 1, h = rnd(oled.height - y) + 1;
+        gfx_fill_rect(&oled, x, y, w, h, 1);
+    }
+    fast_us = now_us() - t0;
+    report("fill_rect", pixels, ref_us, fast_us);
+
+    // circles fully on screen, 8 points per midpoint step
+    pixels = 0;
+    seed = 5;
+    t0 = now_us();
+    for (int i = 0; i < ITERATIONS; i++) {
+        int r = rnd(oled.height / 2);
+        int xc = r + rnd(oled.width - 2 * r), yc = r + rnd(oled.height - 2 * r);
+        ref_circle(xc, yc, r);
+        pixels += 8 * (r * 707 / 1000 + 1);
+    }
+    ref_us = now_us() - t0;
+    seed = 5;
+    t0 = now_us();
+    for (int i = 0; i < ITERATIONS; i++) {
+        int r = rnd(oled.height / 2);
+        int xc = r + rnd(oled.width - 2 * r), yc = r + rnd(oled.height - 2 * r);
+        gfx_circle(&oled, xc, yc, r, 1);
+    }
+    fast_us = now_us() - t0;
+    report("circle", pixels, ref_us, fast_us);
+}
+
+int main(void) {
+    printf("hw13 gfx benchmark, %dx%d buffer\n", oled.width, oled.height);
+    int mismatches = bench_lines();
+    bench_spans();
+    bench_shapes();
+    return mismatches != 0;
+}
@@ -0,0 +1,134 @@
+// Host benchmark for the grayscale mode.
+//
+//   ./bench_gray
+//
+// Draws four gray bars and works out the bus time a gray frame's plane
+// changes need. Then it runs a second of the simulated clock with the
+// slot timer ticking on it and the main loop calling gray_task(), the
+// way hw13 does. Wire time spent inside gray_task() delays the slots
+// after it, and a slot that ends before its plane is all on the panel
+// is missed, so a panel that needs more bus than there is shows it. Sampling the panel model every 100 us gives how long each bar
+// is really lit, against level/3.
+
+#include <stdio.h>
+#include <stdint.h>
+#include "ssd1306.h"
+#include "gray.h"
+#include "fake_bus.h"
+
+#define RUN_US    1000000
+#define SAMPLE_US 100
+
+SSD1306_DEFINE(oled, 128, 32, i2c0, SSD1306_DEFAULT_ADDRESS);
+SSD1306_DEFINE(oled64, 128, 64, i2c1, SSD1306_DEFAULT_ADDRESS);
+SSD1306_DEFINE_SPI(oled_spi, 128, 64, spi0, 20, 17, 21);
+
+static gray_t gray;
+static ssd1306_t *panel;
+static int bar, lit[4], samples;
+
+// the slot timer, on the simulated clock
+static void tick(void *arg) {
+    (void)arg;
+    gray_tick(&gray);
+    fake_time_at(time_us_64() + 1000000 / GRAY_SLOT_HZ, tick, NULL);
+}
+
+static void sample(void *arg) {
+    (void)arg;
+    const fake_ssd1306_t *p = fake_bus_panel(panel);
+    for (int level = 0; level < 4; level++) {
+        lit[level] += fake_ssd1306_pixel(p, level * bar + bar / 2, panel->height / 2);
+    }
+    samples++;
+    fake_time_at(time_us_64() + SAMPLE_US, sample, NULL);
+}
+
+// I2C moves the clock on as it sends, the fake SPI doesn't, so that's
+// done here
+static void task(ssd1306_t *d) {
+    fake_bus_stats_t before = fake_bus_stats(d);
+    gray_task(&gray);
+    if (d->transport == &ssd1306_spi_transport) {
+        fake_bus_stats_t after = fake_bus_stats(d);
+        fake_bus_stats_t sent = { after.transactions - before.transactions, after.bytes - before.bytes };
+        fake_time_advance_us((uint64_t)fake_bus_wire_us(d, sent));
+    }
+}
+
+static void run(ssd1306_t *d) {
+    printf("%dx%d on %s\n", d->width, d->height, fake_bus_name(d));
+    fake_time_cancel_all();
+    fake_bus_connect(d);
+    ssd1306_setup(d);
+    gray_init(&gray, d);
+    gray_start(&gray, GRAY_SLOT_HZ);
+    panel = d;
+
+    bar = d->width / 4;
+    for (int level = 0; level < 4; level++) {
+        gray_fill_rect(&gray, level * bar, 8, bar, d->height - 8, level);
+    }
+    gray_string(&gray, 0, 0, "gray 0 1 2 3", 3);
+    gray_present(&gray);
+
+    // let the upload finish before measuring
+    for (int i = 0; i < 4 * d->pages; i++) {
+        task(d);
+    }
+
+    // one gray frame's plane changes, each left to finish, untimed
+    fake_bus_reset_stats();
+    for (int s = 0; s < GRAY_SLOTS; s++) {
+        gray_tick(&gray);
+        for (int i = 0; i < 2 * d->pages + 1; i++) {
+            task(d);
+        }
+    }
+    fake_bus_stats_t st = fake_bus_stats(d);
+    double need = fake_bus_wire_us(d, st) * GRAY_SLOT_HZ / GRAY_SLOTS / RUN_US * 100;
+    printf("  %-20s %6u bytes %4u transactions per gray frame, %5.1f%% of the bus at %d fps%s\n",
+           "cycling needs", st.bytes, st.transactions, need, GRAY_SLOT_HZ / GRAY_SLOTS,
+           need > 100 ? "  ** more than the bus has **" : "");
+
+    // a second of slots on the clock
+    fake_bus_reset_stats();
+    gray_stats_t before = gray.stats;
+    lit[0] = lit[1] = lit[2] = lit[3] = samples = 0;
+    uint64_t start = time_us_64();
+    fake_time_at(start + 1000000 / GRAY_SLOT_HZ, tick, NULL);
+    fake_time_at(start, sample, NULL);
+    while (time_us_64() < start + RUN_US) {
+        task(d);
+        tight_loop_contents();
+    }
+    fake_time_cancel_all();
+    gray_task(&gray); // the last tick
+    st = fake_bus_stats(d);
+    uint32_t slots = gray.stats.slots - before.slots, missed = gray.stats.missed - before.missed;
+    printf("  %-20s %3u gray frames, %u of %u slots missed, bus %5.1f%% busy\n", "one second",
+           slots / GRAY_SLOTS, missed, slots + missed, fake_bus_wire_us(d, st) / RUN_US * 100);
+    for (int level = 0; level < 4; level++) {
+        printf("  %-20s lit %5.1f%% of the time (want %5.1f%%)\n", level ? "" : "bars 0..3",
+               100.0 * lit[level] / samples, 100.0 * level / GRAY_SLOTS);
+    }
+
+    // a new frame: the upload is spread over the passes between slots
+    fake_bus_reset_stats();
+    gray_fill_rect(&gray, 0, 8, d->width, d->height - 8, 2);
+    gray_present(&gray);
+    for (int i = 0; i < 4 * d->pages; i++) {
+        task(d);
+    }
+    st = fake_bus_stats(d);
+    printf("  %-20s %6u bytes %4u transactions, %6.2f ms of bus\n", "new frame upload",
+           st.bytes, st.transactions, fake_bus_wire_us(d, st) / 1000.0);
+}
+
+int main(void) {
+    fake_bus_reset();
+    run(&oled);
+    run(&oled64);
+    run(&oled_spi);
+    return 0;
+}
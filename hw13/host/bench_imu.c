@@ -0,0 +1,220 @@
+// Host benchmark for MPU6050 sampling: polled, FIFO and data-ready.
+//
+//   ./bench_imu
+//
+// Runs the hw13 dashboard loop for two simulated seconds on i2c0, with
+// the MPU6050 model sampling at 1 kHz on the same bus. The model counts
+// its samples in accel X, so every sample the loop gets can be checked
+// for skips and repeats, and its timestamp compared with when the model
+// really took it. The simulated clock moves with the bus traffic, so the
+// display updates slow the loop down the way they do on the Pico.
+//
+// Data-ready mode needs i2c0 to itself, so those runs move the display to
+// i2c1 and wire the model's INT pin to GPIO 16. Its pulses and the DMA
+// reads they start happen on the simulated clock's events, in between
+// (and during) the display transfers, as interrupts would. Interrupt
+// entry takes no time here, so the timestamps come out exact; on the
+// Pico they are late by the GPIO interrupt latency, a microsecond or so.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include "ssd1306.h"
+#include "widget.h"
+#include "mpu6050.h"
+#include "fake_bus.h"
+#include "fake_mpu6050.h"
+
+#define RUN_US 2000000
+#define RATE_HZ 1000
+#define INT_GPIO 16
+
+SSD1306_DEFINE(oled, 128, 32, i2c0, SSD1306_DEFAULT_ADDRESS);
+SSD1306_DEFINE(oled1, 128, 32, i2c1, SSD1306_DEFAULT_ADDRESS);
+
+static mpu6050_t imu;
+static mpu6050_drdy_t drdy;
+static mpu6050_sample_t samples[MPU6050_FIFO_SIZE / MPU6050_FIFO_SAMPLE];
+static widget_t dash[3];
+
+typedef struct {
+    uint32_t frames, samples, skipped, repeated;
+    uint64_t last;            // full index of the last sample seen
+    bool any;
+    double err_sum_us, err_max_us;
+    uint32_t stamped;
+    uint64_t imu_us;          // time spent reading the IMU
+} tally_t;
+
+// the sample number the model wrote into accel X, unwrapped
+static void see(tally_t *t, const float *accel, const uint64_t *t_us) {
+    uint32_t raw = (uint32_t)lrintf(accel[0] / MPU6050_ACCEL_G) & 0x7FFF;
+    uint64_t index = t->any ? t->last + ((raw - t->last) & 0x7FFF) : raw;
+    if (t->any) {
+        if (index == t->last) {
+            t->repeated++;
+            return;
+        }
+        t->skipped += (uint32_t)(index - t->last - 1);
+    }
+    t->any = true;
+    t->last = index;
+    t->samples++;
+    if (t_us) {
+        double err = fabs((double)*t_us - (double)fake_mpu6050_sample_us(fake_mpu6050(), (uint32_t)index));
+        t->err_sum_us += err;
+        if (err > t->err_max_us) t->err_max_us = err;
+        t->stamped++;
+    }
+}
+
+// the counting motion plus a 3 Hz wobble on Y, so the dashboard has
+// something to redraw every frame
+static void wobble(uint32_t index, uint64_t t_us, int16_t raw[6]) {
+    raw[0] = (int16_t)(index & 0x7FFF);
+    raw[1] = (int16_t)(8192 * sin(2 * M_PI * 3 * t_us / 1e6));
+    raw[2] = 16384;
+    raw[3] = raw[4] = raw[5] = 0;
+}
+
+static void dashboard(ssd1306_t *d, const float *accel) {
+    widget_set_xy(&dash[0], 0, (int32_t)(accel[1] * 100));
+    widget_set(&dash[1], (int32_t)(accel[1] * 100));
+    widget_set(&dash[2], (int32_t)(accel[2] * 100));
+    widget_render_all(d, dash, 3);
+    ssd1306_update_dirty(d);
+}
+
+static void setup(ssd1306_t *d, double clock_error) {
+    fake_bus_reset();
+    fake_mpu6050()->clock_error = clock_error;
+    fake_mpu6050()->motion = wobble;
+    fake_mpu6050()->int_gpio = INT_GPIO;
+    ssd1306_setup(d);
+    widget_crosshair(&dash[0], 0, 0, 64, 32, 100);
+    widget_number(&dash[1], 66, 0, 10, 2, "Y:");
+    widget_number(&dash[2], 66, 8, 10, 2, "Z:");
+    mpu6050_init(&imu, i2c0, MPU6050_ADDR);
+    mpu6050_fifo_start(&imu, RATE_HZ, 3);
+}
+
+static void report(const char *name, const tally_t *t, bool fifo, const mpu6050_drdy_t *r) {
+    double s = RUN_US / 1e6;
+    printf("  %-26s %5.0f fps %6.0f samples/s, %5u skipped %5u repeated", name, t->frames / s,
+           t->samples / s, t->skipped, t->repeated);
+    if (fifo) {
+        printf(", %u lost in %u overflows", imu.lost, imu.overflows);
+    }
+    if (r) {
+        printf(", %u missed (%u busy, %u ring full, %u gaps, %u aborted)", mpu6050_drdy_missed(r), r->busy,
+               r->full, r->gaps, r->aborts);
+    }
+    printf("\n");
+    if (r && r->reads) {
+        printf("  %-26s edge to data in RAM %.0f us mean, %u us max\n", "",
+               (double)r->latency_sum_us / r->reads, r->latency_max_us);
+    }
+    if (t->stamped) {
+        printf("  %-26s timestamps off by %.0f us mean, %.0f us max\n", "", t->err_sum_us / t->stamped,
+               t->err_max_us);
+    }
+    printf("  %-26s IMU reads take %.1f%% of the loop\n", "", 100.0 * t->imu_us / RUN_US);
+}
+
+// one register snapshot per frame, as hw13 does without IMU_FIFO_HZ
+static void bench_poll(void) {
+    tally_t t = { 0 };
+    setup(&oled, 0);
+    mpu6050_fifo_stop(&imu); // same 1 kHz sample clock, just no FIFO
+    uint64_t end = time_us_64() + RUN_US;
+    while (time_us_64() < end) {
+        float accel[3], gyro[3], temp;
+        uint64_t t0 = time_us_64();
+        mpu6050_read(&imu, accel, gyro, &temp);
+        t.imu_us += time_us_64() - t0;
+        see(&t, accel, NULL);
+        dashboard(&oled, accel);
+        t.frames++;
+    }
+    report("poll, one read per frame", &t, false, NULL);
+}
+
+static void bench_fifo(const char *name, ssd1306_t *d, double clock_error, uint32_t stall_us) {
+    tally_t t = { 0 };
+    setup(d, clock_error);
+    uint64_t start = time_us_64();
+    uint64_t end = start + RUN_US;
+    bool stalled = false;
+    while (time_us_64() < end) {
+        uint64_t t0 = time_us_64();
+        int n = mpu6050_fifo_read(&imu, samples, sizeof(samples) / sizeof(samples[0]));
+        t.imu_us += time_us_64() - t0;
+        for (int i = 0; i < n; i++) {
+            see(&t, samples[i].accel, &samples[i].t_us);
+        }
+        if (n > 0) {
+            dashboard(d, samples[n - 1].accel);
+        }
+        t.frames++;
+        if (stall_us && !stalled && time_us_64() - start > RUN_US / 2) {
+            // something else holds the loop up for longer than the FIFO lasts
+            fake_time_advance_us(stall_us);
+            stalled = true;
+        }
+    }
+    report(name, &t, true, NULL);
+}
+
+// gone_us: the reads go to an address nobody answers for that long,
+// halfway through, as if the IMU dropped off the bus with its INT still
+// going. Each one is aborted and the next edge starts a fresh read.
+static void bench_drdy(const char *name, double clock_error, uint32_t stall_us, uint32_t gone_us) {
+    tally_t t = { 0 };
+    setup(&oled1, clock_error);
+    mpu6050_drdy_start(&drdy, &imu, INT_GPIO, RATE_HZ, 3);
+    uint64_t start = time_us_64();
+    uint64_t end = start + RUN_US;
+    bool stalled = false;
+    uint32_t tar = i2c0->hw.tar;
+    while (time_us_64() < end) {
+        if (gone_us) {
+            uint64_t in = time_us_64() - start;
+            i2c0->hw.tar = in > RUN_US / 2 && in < RUN_US / 2 + gone_us ? 0x50 : tar;
+        }
+        uint64_t t0 = time_us_64();
+        int n = mpu6050_drdy_read(&drdy, samples, sizeof(samples) / sizeof(samples[0]));
+        t.imu_us += time_us_64() - t0;
+        for (int i = 0; i < n; i++) {
+            see(&t, samples[i].accel, &samples[i].t_us);
+        }
+        if (n > 0) {
+            dashboard(&oled1, samples[n - 1].accel);
+            t.frames++;
+        } else {
+            tight_loop_contents(); // nothing new, don't redraw
+        }
+        if (stall_us && !stalled && time_us_64() - start > RUN_US / 2) {
+            // longer than the ring holds, the edges keep coming meanwhile
+            fake_time_advance_us(stall_us);
+            stalled = true;
+        }
+    }
+    mpu6050_drdy_stop(&drdy);
+    report(name, &t, false, &drdy);
+}
+
+int main(void) {
+    printf("dashboard on 128x32 i2c0 400 kHz, MPU6050 at %d Hz on the same bus, %d s\n", RATE_HZ,
+           RUN_US / 1000000);
+    bench_poll();
+    bench_fifo("FIFO", &oled, 0, 0);
+    bench_fifo("FIFO, 150 ms stall", &oled, 0, 150000);
+    bench_fifo("FIFO, chip clock 1% slow", &oled, 0.01, 0);
+    printf("dashboard moved to i2c1, MPU6050 INT on GPIO %d\n", INT_GPIO);
+    bench_fifo("FIFO", &oled1, 0, 0);
+    bench_drdy("data-ready", 0, 0, 0);
+    bench_drdy("data-ready, 150 ms stall", 0, 150000, 0);
+    bench_drdy("data-ready, clock 1% slow", 0.01, 0, 0);
+    bench_drdy("data-ready, IMU gone 50 ms", 0, 0, 50000);
+    return 0;
+}
@@ -0,0 +1,304 @@
+// Host rendering benchmarks on top of the fake i2c and spi buses and the SSD1306 model.
+//
+//   ./bench_render [frame_dir]
+//
+// Times clear, text, lines, full updates, a widget dashboard, the strip chart and the 3D cube, counts the bus bytes and
+// transactions each frame costs, and checks that the panel model ends up
+// showing the frame buffer. With frame_dir, every scenario also leaves a
+// PBM of what the panel shows there.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "ssd1306.h"
+#include "gfx.h"
+#include "widget.h"
+#include "stripchart.h"
+#include "wire3d.h"
+#include <math.h>
+#include "fake_bus.h"
+
+#define ITERATIONS 20000
+
+SSD1306_DEFINE(oled, 128, 32, i2c0, SSD1306_DEFAULT_ADDRESS);
+SSD1306_DEFINE(oled64, 128, 64, i2c1, SSD1306_DEFAULT_ADDRESS);
+SSD1306_DEFINE_SPI(oled_spi, 128, 64, spi0, 20, 17, 21);
+
+static const char *frame_dir;
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static uint32_t seed;
+static int rnd(int n) {
+    seed = seed * 1664525u + 1013904223u;
+    return (int)((seed >> 8) % (uint32_t)n);
+}
+
+static void dump(ssd1306_t *d, const char *name) {
+    if (!frame_dir) {
+        return;
+    }
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s_%dx%d.pbm", frame_dir, name, d->width, d->height);
+    if (!fake_ssd1306_write_pbm(fake_bus_panel(d), path)) {
+        printf("  could not write %s\n", path);
+    }
+}
+
+// does the panel model hold exactly what is in the frame buffer?
+static bool panel_matches(ssd1306_t *d) {
+    const fake_ssd1306_t *p = fake_bus_panel(d);
+    for (int page = 0; page < d->pages; page++) {
+        if (memcmp(p->gddram[page], d->buffer + 1 + page * d->width, d->width) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void report_cpu(const char *name, double total_us, int iterations) {
+    printf("  %-22s %9.3f us/frame\n", name, total_us / iterations);
+}
+
+static void report_bus(const char *name, fake_bus_stats_t s, int frames, ssd1306_t *d) {
+    printf("  %-22s %6u bytes %4u transactions per frame, %6.2f ms on the wire, panel %s\n",
+           name, s.bytes / frames, s.transactions / frames,
+           fake_bus_wire_us(d, s) / frames / 1000.0,
+           panel_matches(d) ? "matches buffer" : "DIFFERS from buffer");
+}
+
+static void bench_clear(ssd1306_t *d) {
+    double t0 = now_us();
+    for (int i = 0; i < ITERATIONS; i++) {
+        ssd1306_clear(d);
+    }
+    report_cpu("clear", now_us() - t0, ITERATIONS);
+}
+
+static void bench_text(ssd1306_t *d) {
+    static const char line[] = "The quick brown fox j";
+    int rows = d->height / GFX_CHAR_H;
+    double t0;
+
+    // page aligned rows are straight byte copies
+    t0 = now_us();
+    for (int i = 0; i < ITERATIONS; i++) {
+        for (int r = 0; r < rows; r++) {
+            gfx_string(d, 0, r * GFX_CHAR_H, line);
+        }
+    }
+    report_cpu("text, aligned rows", now_us() - t0, ITERATIONS);
+
+    ssd1306_clear(d);
+    t0 = now_us();
+    for (int i = 0; i < ITERATIONS; i++) {
+        for (int r = 0; r < rows - 1; r++) {
+            gfx_string(d, 1, r * GFX_CHAR_H + 3, line);
+        }
+    }
+    report_cpu("text, shifted rows", now_us() - t0, ITERATIONS);
+
+    ssd1306_update(d);
+    dump(d, "text");
+}
+
+static void bench_lines(ssd1306_t *d) {
+    const int lines_per_frame = 32;
+    seed = 1;
+    double t0 = now_us();
+    for (int i = 0; i < ITERATIONS; i++) {
+        ssd1306_clear(d);
+        for (int l = 0; l < lines_per_frame; l++) {
+            gfx_line(d, rnd(d->width), rnd(d->height), rnd(d->width), rnd(d->height), 1);
+        }
+    }
+    report_cpu("clear + 32 lines", now_us() - t0, ITERATIONS);
+
+    ssd1306_update(d);
+    dump(d, "lines");
+}
+
+static void bench_update(ssd1306_t *d) {
+    const int frames = 100;
+    fake_bus_stats_t s;
+
+    ssd1306_clear(d);
+    gfx_string(d, 0, 0, "full update");
+    gfx_circle(d, d->width / 2, d->height / 2, d->height / 2 - 1, 1);
+
+    fake_bus_reset_stats();
+    double t0 = now_us();
+    for (int i = 0; i < frames; i++) {
+        ssd1306_update(d);
+    }
+    double t1 = now_us();
+    s = fake_bus_stats(d);
+    report_cpu("update (blocking)", t1 - t0, frames);
+    report_bus("update (blocking)", s, frames, d);
+
+    gfx_fill_rect(d, 0, d->height - 8, d->width, 8, 1);
+    fake_bus_reset_stats();
+    for (int i = 0; i < frames; i++) {
+        ssd1306_update_start(d);
+        ssd1306_update_wait(d);
+    }
+    s = fake_bus_stats(d);
+    report_bus("update_start (DMA)", s, frames, d);
+    dump(d, "update");
+}
+
+// The hw13 dashboard with slowly changing values: a full update every
+// frame against sending only the widgets that changed.
+static void bench_widgets(ssd1306_t *d) {
+    const int frames = 1000;
+    widget_t dash[5];
+    widget_crosshair(&dash[0], 0, 0, 64, 32, 100);
+    widget_number(&dash[1], 66, 0, 10, 2, "X:");
+    widget_number(&dash[2], 66, 8, 10, 2, "Y:");
+    widget_number(&dash[3], 66, 16, 10, 1, "FPS:");
+    widget_bar(&dash[4], 66, 25, 62, 6, -100, 100);
+
+    ssd1306_clear(d);
+    ssd1306_update(d);
+    fake_bus_reset_stats();
+    seed = 7;
+    int redrawn = 0;
+    double t0 = now_us();
+    for (int i = 0; i < frames; i++) {
+        // x drifts every frame, y every 4th, fps once per "second"
+        widget_set_xy(&dash[0], 50 - i % 100, 20 + i / 4 % 3);
+        widget_set(&dash[1], 50 - i % 100);
+        widget_set(&dash[2], 20 + i / 4 % 3);
+        widget_set(&dash[3], 600 + i / 60);
+        widget_set(&dash[4], rnd(16) == 0 ? rnd(200) - 100 : dash[4].value);
+        redrawn += widget_render_all(d, dash, 5);
+        ssd1306_update_dirty(d);
+    }
+    double t1 = now_us();
+    fake_bus_stats_t s = fake_bus_stats(d);
+    report_cpu("widgets + dirty update", t1 - t0, frames);
+    report_bus("widgets + dirty update", s, frames, d);
+    printf("  %-22s %9.2f of 5 widgets redrawn per frame\n", "", (double)redrawn / frames);
+
+    // nothing changed: rendering is just the comparisons, nothing is sent
+    fake_bus_reset_stats();
+    t0 = now_us();
+    for (int i = 0; i < frames; i++) {
+        widget_render_all(d, dash, 5);
+        ssd1306_update_dirty(d);
+    }
+    t1 = now_us();
+    s = fake_bus_stats(d);
+    report_cpu("widgets, unchanged", t1 - t0, frames);
+    report_bus("widgets, unchanged", s, frames, d);
+    dump(d, "widgets");
+}
+
+// one sample per push, compare with sending a full frame per sample
+static void bench_stripchart(ssd1306_t *d) {
+    const int samples = 1000;
+    stripchart_t chart;
+    ssd1306_clear(d);
+    ssd1306_update(d);
+    stripchart_init(&chart, d, 0, d->width, 0, d->pages, -100, 100);
+    ssd1306_update_dirty(d);
+
+    fake_bus_reset_stats();
+    seed = 3;
+    int32_t v = 0;
+    double t0 = now_us();
+    for (int i = 0; i < samples; i++) {
+        v += rnd(21) - 10;
+        if (v > 100 || v < -100) v /= 2;
+        stripchart_push(&chart, v);
+    }
+    double t1 = now_us();
+    fake_bus_stats_t s = fake_bus_stats(d);
+    report_cpu("strip chart push", t1 - t0, samples);
+    report_bus("strip chart push", s, samples, d);
+    dump(d, "stripchart");
+}
+
+// the hw13 CUBE_3D loop with a steady spin instead of the IMU: time per
+// stage and the bytes the dirty box update sends
+static void bench_cube(ssd1306_t *d) {
+    const int frames = 2000;
+    int16_t points[WIRE3D_MAX_VERTS][2];
+    wire3d_rot_t rot;
+    wire3d_box_t prev = { 0, 0, -1, -1 };
+    int side = d->height;
+    double us_math = 0, us_raster = 0, us_flush = 0;
+
+    ssd1306_clear(d);
+    ssd1306_update(d);
+    fake_bus_reset_stats();
+    for (int i = 0; i < frames; i++) {
+        // 1 degree per frame about a skewed axis
+        float a = i * 3.14159265f / 360.0f;
+        float n = sqrtf(14.0f);
+        float q[4] = { cosf(a), sinf(a) / n, 2 * sinf(a) / n, 3 * sinf(a) / n };
+
+        double t0 = now_us();
+        wire3d_rot_from_quat(&rot, q);
+        wire3d_box_t box = wire3d_project(&wire3d_cube, &rot, side / 2, d->height / 2, side * 3 / 8, points);
+        double t1 = now_us();
+        if (prev.x1 >= prev.x0) {
+            int w = prev.x1 - prev.x0 + 1, h = prev.y1 - prev.y0 + 1;
+            gfx_fill_rect(d, prev.x0, prev.y0, w, h, 0);
+            ssd1306_mark_dirty(d, prev.x0, prev.y0, w, h);
+        }
+        wire3d_draw(d, &wire3d_cube, (const int16_t (*)[2])points);
+        ssd1306_mark_dirty(d, box.x0, box.y0, box.x1 - box.x0 + 1, box.y1 - box.y0 + 1);
+        prev = box;
+        double t2 = now_us();
+        ssd1306_update_dirty(d);
+        double t3 = now_us();
+        us_math += t1 - t0;
+        us_raster += t2 - t1;
+        us_flush += t3 - t2;
+    }
+    fake_bus_stats_t s = fake_bus_stats(d);
+    report_cpu("cube: rotate+project", us_math, frames);
+    report_cpu("cube: clear+draw", us_raster, frames);
+    report_cpu("cube: update_dirty", us_flush, frames);
+    report_bus("cube", s, frames, d);
+    double wire_ms = fake_bus_wire_us(d, s) / frames / 1000.0;
+    printf("  %-22s %9.0f fps if the bus is the limit\n", "", 1000.0 / wire_ms);
+    dump(d, "cube");
+}
+
+static void run(ssd1306_t *d) {
+    printf("%dx%d on %s\n", d->width, d->height, fake_bus_name(d));
+    fake_bus_connect(d);
+    ssd1306_setup(d);
+    dump(d, "clear");
+    bench_clear(d);
+    bench_text(d);
+    bench_lines(d);
+    bench_update(d);
+    bench_widgets(d);
+    bench_stripchart(d);
+    bench_cube(d);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        frame_dir = argv[1];
+    }
+    fake_bus_reset();
+    run(&oled);
+    run(&oled64);
+    run(&oled_spi);
+
+    if (fake_bus_panel(&oled)->unknown_commands || fake_bus_panel(&oled64)->unknown_commands ||
+        fake_bus_panel(&oled_spi)->unknown_commands) {
+        printf("panel model saw unknown commands\n");
+        return 1;
+    }
+    return 0;
+}
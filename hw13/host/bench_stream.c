@@ -0,0 +1,314 @@
+// Host benchmark for the binary IMU stream (imustream.c).
+//
+//   ./bench_stream [-o out_dir]
+//
+// Three seconds of the MPU6050 model sampling into its FIFO at 1 kHz, read
+// every 5 ms the way hw13 does with IMU_TRACE_BINARY, with a 150 ms stall
+// a second in that overflows the FIFO. The stream is decoded again here
+// and every sample checked against what went in, along with the sample
+// index, the lost count and how long samples waited in the stream for
+// their packet.
+// Then the cost per sample against the IMU_TRACE CSV line.
+//
+// With -o, out_dir gets stream.bin, the stream as the USB port would give
+// it, with text in front of it, one packet damaged and one missing, and
+// expected.csv, the raw samples tools/imudecode.py --raw should get out
+// of it:
+//
+//   python3 ../tools/imudecode.py --raw stream.bin -o got.csv
+//   diff expected.csv got.csv
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <math.h>
+#include "mpu6050.h"
+#include "imustream.h"
+#include "fmt.h"
+#include "fake_bus.h"
+#include "fake_mpu6050.h"
+
+#define RUN_US      3000000
+#define RATE_HZ     1000
+#define POLL_US     5000
+#define STALL_AT_US 1000000
+#define STALL_US    150000
+#define DAMAGED     10   // packet, by sequence number
+#define DROPPED     40
+#define ROUNDS      200
+
+#define SAMPLES_MAX (RUN_US / 1000000 * RATE_HZ)
+#define STREAM_MAX  (SAMPLES_MAX * 20)
+#define PACKETS_MAX (SAMPLES_MAX)
+
+static mpu6050_t imu;
+static imustream_t stream;
+static mpu6050_sample_t buffer[MPU6050_FIFO_SIZE / MPU6050_FIFO_SAMPLE];
+
+// what went in
+static mpu6050_sample_t sent[SAMPLES_MAX];
+static uint32_t sent_lost[SAMPLES_MAX];
+static uint64_t sent_us[SAMPLES_MAX];   // when it was handed to the stream
+static int sent_n;
+
+// what came out of the link
+static uint8_t bytes[STREAM_MAX];
+static size_t bytes_n;
+static size_t packet_end[PACKETS_MAX];  // offset after each packet's delimiter
+static uint64_t packet_us[PACKETS_MAX]; // when it was written
+static int packets_n;
+
+static uint64_t stall_us;               // when the loop stalled
+
+static int failures;
+static volatile uint32_t sink;
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void link_write(const uint8_t *data, size_t len) {
+    memcpy(bytes + bytes_n, data, len);
+    bytes_n += len;
+    if (len > 1) {
+        packet_end[packets_n] = bytes_n;
+        packet_us[packets_n++] = time_us_64();
+    }
+}
+
+static void null_write(const uint8_t *data, size_t len) {
+    sink += data[0] + (uint32_t)len;
+}
+
+static void sway(uint32_t index, uint64_t t_us, int16_t raw[6]) {
+    double t = t_us / 1e6;
+    raw[0] = (int16_t)(3000 * sin(2 * M_PI * 0.7 * t)) + (int16_t)(index % 7);
+    raw[1] = (int16_t)(-2000 * cos(2 * M_PI * 1.3 * t));
+    raw[2] = (int16_t)(16384 + 500 * sin(2 * M_PI * 5 * t));
+    raw[3] = (int16_t)(1200 * sin(2 * M_PI * 0.5 * t) + 40);
+    raw[4] = (int16_t)(-(int32_t)(index * 37 % 60001) + 30000);
+    raw[5] = (int16_t)(index & 1 ? 32767 : -32768);
+}
+
+static void expect(const char *what, bool ok) {
+    printf("  %-48s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) failures++;
+}
+
+static void record(void) {
+    fake_bus_reset();
+    fake_mpu6050()->motion = sway;
+    mpu6050_init(&imu, i2c0, MPU6050_ADDR);
+    // something other than identity, for the info packet to carry
+    imu.cal = (mpu6050_cal_t){ { 310, -205, 480 }, { 16047, 16634, 15845 }, { 105, -66, 79 } };
+    mpu6050_fifo_start(&imu, RATE_HZ, 3);
+    imustream_begin(&stream, link_write, imu.rate_hz, &imu.cal);
+
+    uint64_t start = time_us_64();
+    bool stalled = false;
+    while (time_us_64() - start < RUN_US) {
+        if (!stalled && time_us_64() - start >= STALL_AT_US) {
+            stall_us = time_us_64();
+            fake_time_advance_us(STALL_US);
+            stalled = true;
+        }
+        int n = mpu6050_fifo_read(&imu, buffer, sizeof(buffer) / sizeof(buffer[0]));
+        for (int i = 0; i < n && sent_n < SAMPLES_MAX; i++) {
+            sent[sent_n] = buffer[i];
+            sent_us[sent_n] = time_us_64();
+            sent_lost[sent_n++] = imu.lost;
+            imustream_add(&stream, &buffer[i], imu.lost);
+        }
+        imustream_poll(&stream, time_us_64());
+        fake_time_advance_us(POLL_US);
+    }
+    imustream_flush(&stream);
+}
+
+static uint32_t get16(const uint8_t *p) { return p[0] | p[1] << 8; }
+static uint32_t get32(const uint8_t *p) { return get16(p) | get16(p + 2) << 16; }
+
+// one frame without its delimiter, back to the payload. 0 if it isn't COBS.
+static size_t uncobs(const uint8_t *in, size_t len, uint8_t *out) {
+    size_t i = 0, o = 0;
+    while (i < len) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > len) return 0;
+        for (int k = 1; k < code; k++) out[o++] = in[i++];
+        if (code < 0xFF && i < len) out[o++] = 0;
+    }
+    return o;
+}
+
+// decode what link_write() got and check it against what went in
+static void check(void) {
+    int next = 0, infos = 0, bad = 0, seq_gaps = 0;
+    uint32_t reported_lost = 0;
+    uint64_t wait_max = 0;
+    size_t start = 0;
+    int packet = 0;
+    for (size_t i = 0; i < bytes_n; i++) {
+        if (bytes[i] != 0) continue;
+        uint8_t p[IMUSTREAM_PACKET_MAX];
+        size_t len = i > start ? uncobs(bytes + start, i - start, p) : 0;
+        size_t end = i + 1;
+        start = end;
+        if (len == 0) continue;
+        while (packet < packets_n && packet_end[packet] < end) packet++;
+        if (len < 4 || get16(p + len - 2) != imustream_crc16(p, len - 2)) {
+            bad++;
+            continue;
+        }
+        if (p[0] == IMUSTREAM_INFO) {
+            mpu6050_cal_t cal;
+            for (int k = 0; k < 3; k++) {
+                cal.accel_offset[k] = (int16_t)get16(p + 12 + 2 * k);
+                cal.accel_scale[k] = (uint16_t)get16(p + 18 + 2 * k);
+                cal.gyro_offset[k] = (int16_t)get16(p + 24 + 2 * k);
+            }
+            bad += get16(p + 2) != imu.rate_hz || memcmp(&cal, &imu.cal, sizeof(cal)) != 0;
+            infos++;
+            continue;
+        }
+        int n = p[1];
+        uint32_t index = get32(p + 4), lost = get32(p + 8), t = get32(p + 12);
+        seq_gaps += get16(p + 2) != (uint32_t)(packet - infos);
+        // nothing polls during the stall, the packet open then waits it out
+        uint64_t wait = packet_us[packet] - sent_us[index];
+        if (wait > wait_max && !(sent_us[index] <= stall_us && packet_us[packet] > stall_us)) wait_max = wait;
+        for (int k = 0; k < n; k++) {
+            const uint8_t *s = p + IMUSTREAM_HEADER + k * IMUSTREAM_SAMPLE;
+            t += get16(s);
+            bool same = index + k == (uint32_t)next && next < sent_n && t == (uint32_t)sent[next].t_us
+                        && lost == sent_lost[next];
+            for (int j = 0; j < 6; j++) {
+                same &= (int16_t)get16(s + 2 + 2 * j) == sent[next].raw[j];
+            }
+            bad += !same;
+            next++;
+        }
+        reported_lost = lost;
+    }
+    printf("  %d samples in %u packets and %d info packets, %u bytes, %.2f bytes a sample\n", next,
+           stream.packets - infos, infos, (unsigned)bytes_n, (double)bytes_n / next);
+    printf("  %u lost in %u FIFO overflows, the stream says %u\n", imu.lost, imu.overflows, reported_lost);
+    printf("  longest a sample waited for its packet, stall aside: %.1f ms (flush at %d ms)\n", wait_max / 1e3,
+           IMUSTREAM_FLUSH_US / 1000);
+    expect("every sample decodes as it went in", next == sent_n && bad == 0);
+    expect("packet sequence unbroken", seq_gaps == 0);
+    expect("the FIFO loss is in the stream", imu.lost > 0 && reported_lost == imu.lost);
+    expect("no sample waits past the flush time", wait_max <= IMUSTREAM_FLUSH_US + POLL_US);
+}
+
+// imustream_add() against the IMU_TRACE line, on the samples recorded
+static void bench_cost(void) {
+    imustream_t s;
+    double t0 = now_us();
+    uint32_t packed = 0;
+    for (int r = 0; r < ROUNDS; r++) {
+        imustream_begin(&s, null_write, RATE_HZ, &imu.cal);
+        for (int i = 0; i < sent_n; i++) imustream_add(&s, &sent[i], sent_lost[i]);
+        imustream_flush(&s);
+        packed += s.bytes;
+    }
+    double t1 = now_us();
+    uint32_t text = 0;
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < sent_n; i++) {
+            char line[80];
+            fmt_t f;
+            fmt_begin(&f, line, sizeof(line));
+            fmt_uint(&f, (uint32_t)sent[i].t_us, 0);
+            for (int k = 0; k < 3; k++) {
+                fmt_char(&f, ',');
+                fmt_float(&f, sent[i].accel[k], 4, 0);
+            }
+            for (int k = 0; k < 3; k++) {
+                fmt_char(&f, ',');
+                fmt_float(&f, sent[i].gyro[k], 3, 0);
+            }
+            text += (uint32_t)strlen(line) + 2; // CR LF
+        }
+    }
+    double t2 = now_us();
+    double calls = (double)ROUNDS * sent_n;
+    printf("  %-12s %6.1f ns %6.2f bytes a sample\n", "binary", (t1 - t0) * 1000 / calls, packed / calls);
+    printf("  %-12s %6.1f ns %6.2f bytes a sample, IMU_TRACE\n", "CSV", (t2 - t1) * 1000 / calls, text / calls);
+    printf("  at %d Hz: %.1f KB/s binary, %.1f KB/s CSV\n", RATE_HZ, packed / calls * RATE_HZ / 1024,
+           text / calls * RATE_HZ / 1024);
+}
+
+// the stream with damage, and the samples a decoder should still find
+static int save(const char *dir) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/stream.bin", dir);
+    FILE *out = fopen(path, "wb");
+    if (!out) {
+        perror(path);
+        return 1;
+    }
+    fputs("MPU6050 initialized successfully.\nIMU FIFO at 1000 Hz\n", out);
+    // the delimiter imustream_begin() starts with, then the packets
+    fputc(bytes[0], out);
+    size_t from = 1;
+    int damaged_from = -1, damaged_to = -1, dropped_from = -1, dropped_to = -1;
+    int index = 0;
+    for (int k = 0; k < packets_n; k++) {
+        size_t len = packet_end[k] - from;
+        uint8_t p[IMUSTREAM_PACKET_MAX];
+        memcpy(p, bytes + from, len);
+        uint8_t payload[IMUSTREAM_PACKET_MAX];
+        uncobs(p, len - 1, payload);
+        int n = payload[0] == IMUSTREAM_SAMPLES ? payload[1] : 0;
+        int seq = n ? (int)get16(payload + 2) : -1;
+        if (seq == DAMAGED) {
+            p[len / 2] ^= 0x10;
+            damaged_from = index;
+            damaged_to = index + n;
+        }
+        if (seq != DROPPED) {
+            fwrite(p, 1, len, out);
+        } else {
+            dropped_from = index;
+            dropped_to = index + n;
+        }
+        index += n;
+        from = packet_end[k];
+    }
+    fclose(out);
+
+    snprintf(path, sizeof(path), "%s/expected.csv", dir);
+    out = fopen(path, "w");
+    if (!out) {
+        perror(path);
+        return 1;
+    }
+    fputs("index,t_us,ax,ay,az,gx,gy,gz\n", out);
+    for (int i = 0; i < sent_n; i++) {
+        if ((i >= damaged_from && i < damaged_to) || (i >= dropped_from && i < dropped_to)) continue;
+        const int16_t *r = sent[i].raw;
+        fprintf(out, "%d,%llu,%d,%d,%d,%d,%d,%d\n", i, (unsigned long long)sent[i].t_us, r[0], r[1], r[2], r[3],
+                r[4], r[5]);
+    }
+    fclose(out);
+    printf("  wrote %s/stream.bin and expected.csv: packet %d damaged (samples %d-%d), packet %d dropped (samples "
+           "%d-%d)\n",
+           dir, DAMAGED, damaged_from, damaged_to - 1, DROPPED, dropped_from, dropped_to - 1);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    printf("MPU6050 FIFO at %d Hz read every %d ms, %d ms stall at %d s, %d s\n", RATE_HZ, POLL_US / 1000,
+           STALL_US / 1000, STALL_AT_US / 1000000, RUN_US / 1000000);
+    record();
+    check();
+    printf("encoding cost\n");
+    bench_cost();
+    if (argc > 2 && strcmp(argv[1], "-o") == 0 && save(argv[2])) {
+        return 1;
+    }
+    return failures ? 1 : 0;
+}
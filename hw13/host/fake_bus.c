@@ -0,0 +1,61 @@
+// per-display view of the fake buses, see fake_bus.h
+
+#include <stdio.h>
+#include "fake_bus.h"
+
+static bool is_spi(const ssd1306_t *d) {
+    return d->transport == &ssd1306_spi_transport;
+}
+
+void fake_bus_reset(void) {
+    fake_i2c_reset();
+    fake_spi_reset();
+}
+
+void fake_bus_reset_stats(void) {
+    fake_i2c_reset_stats();
+    fake_spi_reset_stats();
+}
+
+fake_bus_stats_t fake_bus_stats(const ssd1306_t *d) {
+    fake_bus_stats_t s;
+    if (is_spi(d)) {
+        fake_spi_stats_t t = fake_spi_stats();
+        s.transactions = t.transactions;
+        s.bytes = t.bytes;
+    } else {
+        fake_i2c_stats_t t = fake_i2c_stats();
+        s.transactions = t.transactions;
+        s.bytes = t.bytes;
+    }
+    return s;
+}
+
+double fake_bus_wire_us(const ssd1306_t *d, fake_bus_stats_t s) {
+    if (is_spi(d)) {
+        fake_spi_stats_t t = { s.transactions, s.bytes };
+        return fake_spi_wire_us(t, FAKE_BUS_SPI_HZ);
+    }
+    fake_i2c_stats_t t = { s.transactions, s.bytes };
+    return fake_i2c_wire_us(t, FAKE_BUS_I2C_HZ);
+}
+
+fake_ssd1306_t *fake_bus_panel(const ssd1306_t *d) {
+    return is_spi(d) ? fake_spi_panel(d->spi) : fake_i2c_panel(d->i2c);
+}
+
+const char *fake_bus_name(const ssd1306_t *d) {
+    static char name[32];
+    if (is_spi(d)) {
+        snprintf(name, sizeof(name), "spi%d %d MHz", d->spi->index, FAKE_BUS_SPI_HZ / 1000000);
+    } else {
+        snprintf(name, sizeof(name), "i2c%d %d kHz", d->i2c->index, FAKE_BUS_I2C_HZ / 1000);
+    }
+    return name;
+}
+
+void fake_bus_connect(const ssd1306_t *d) {
+    if (is_spi(d)) {
+        fake_spi_connect(d->spi, d->dc_pin, d->cs_pin);
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef FAKE_BUS_H
+#define FAKE_BUS_H
+
+#include <stdint.h>
+#include "ssd1306.h"
+#include "fake_i2c.h"
+#include "fake_spi.h"
+
+// Per-display view of the fake buses, so a benchmark can run the same
+// scenario on I2C and SPI panels. Wire times use these clocks.
+
+#define FAKE_BUS_I2C_HZ FAKE_I2C_HZ
+#define FAKE_BUS_SPI_HZ 10000000
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;
+} fake_bus_stats_t;
+
+void fake_bus_reset(void);           // both buses, stats and panels
+void fake_bus_reset_stats(void);
+fake_bus_stats_t fake_bus_stats(const ssd1306_t *d); // traffic on d's bus
+double fake_bus_wire_us(const ssd1306_t *d, fake_bus_stats_t s);
+fake_ssd1306_t *fake_bus_panel(const ssd1306_t *d);
+const char *fake_bus_name(const ssd1306_t *d);       // "i2c0 400 kHz"
+
+// wire an SPI display's D/C and CS to the panel model on its bus
+void fake_bus_connect(const ssd1306_t *d);
+
+#endif
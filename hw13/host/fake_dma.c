@@ -0,0 +1,81 @@
+// dma for host builds: a triggered transfer is copied out in one go.
+// Writes aimed at an i2c IC_DATA_CMD or spi data register go to the fake
+// bus behind it. Reads from an IC_DATA_CMD are handed to the fake i2c bus,
+// which finishes them once the bytes have come in.
+
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "fake_i2c.h"
+#include "fake_spi.h"
+
+static int next_channel;
+static uint32_t irq1_enabled, irq1_status;
+
+int dma_claim_unused_channel(bool required) {
+    (void)required;
+    return next_channel++;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    (void)channel;
+    dma_channel_config c = { DMA_SIZE_32, true, false, 0 };
+    return c;
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger) {
+    if (!trigger) {
+        return;
+    }
+    if (read_addr == &i2c0->hw.data_cmd || read_addr == &i2c1->hw.data_cmd) {
+        i2c_inst_t *i2c = read_addr == &i2c0->hw.data_cmd ? i2c0 : i2c1;
+        fake_i2c_rx_dma(i2c, channel, write_addr, transfer_count);
+        return;
+    }
+    const volatile uint8_t *src = read_addr;
+    uint step = config->read_increment ? 1u << config->size : 0;
+    for (uint i = 0; i < transfer_count; i++, src += step) {
+        uint32_t word;
+        switch (config->size) {
+            case DMA_SIZE_8:  word = *src; break;
+            case DMA_SIZE_16: word = *(const volatile uint16_t *)src; break;
+            default:          word = *(const volatile uint32_t *)src; break;
+        }
+        if (write_addr == &i2c0->hw.data_cmd) {
+            fake_i2c_data_cmd(i2c0, word);
+        } else if (write_addr == &i2c1->hw.data_cmd) {
+            fake_i2c_data_cmd(i2c1, word);
+        } else if (write_addr == &spi0->hw.dr) {
+            fake_spi_byte(spi0, word & 0xFF);
+        } else if (write_addr == &spi1->hw.dr) {
+            fake_spi_byte(spi1, word & 0xFF);
+        } else {
+            *(volatile uint32_t *)write_addr = word;
+        }
+    }
+}
+
+void dma_channel_set_irq1_enabled(uint channel, bool enabled) {
+    if (enabled) {
+        irq1_enabled |= 1u << channel;
+    } else {
+        irq1_enabled &= ~(1u << channel);
+    }
+}
+
+bool dma_channel_get_irq1_status(uint channel) {
+    return irq1_status & (1u << channel);
+}
+
+void dma_channel_acknowledge_irq1(uint channel) {
+    irq1_status &= ~(1u << channel);
+}
+
+void fake_dma_done(uint channel) {
+    if (irq1_enabled & (1u << channel)) {
+        irq1_status |= 1u << channel;
+        fake_irq_raise(DMA_IRQ_1);
+    }
+}
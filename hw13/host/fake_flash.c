@@ -0,0 +1,36 @@
+// flash for host builds, see include/hardware/flash.h
+
+#include <string.h>
+#include "hardware/flash.h"
+
+uint8_t fake_flash[PICO_FLASH_SIZE_BYTES];
+static fake_flash_stats_t stats;
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    if (flash_offs % FLASH_SECTOR_SIZE || count % FLASH_SECTOR_SIZE || flash_offs + count > PICO_FLASH_SIZE_BYTES) {
+        stats.misaligned++;
+        return;
+    }
+    memset(fake_flash + flash_offs, 0xFF, count);
+    stats.erases += count / FLASH_SECTOR_SIZE;
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    if (flash_offs % FLASH_PAGE_SIZE || count % FLASH_PAGE_SIZE || flash_offs + count > PICO_FLASH_SIZE_BYTES) {
+        stats.misaligned++;
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        fake_flash[flash_offs + i] &= data[i];
+    }
+    stats.programs += count / FLASH_PAGE_SIZE;
+}
+
+void fake_flash_reset(void) {
+    memset(fake_flash, 0xFF, sizeof(fake_flash));
+    stats = (fake_flash_stats_t){ 0 };
+}
+
+fake_flash_stats_t fake_flash_stats(void) {
+    return stats;
+}
@@ -0,0 +1,60 @@
+// gpio for host builds, see include/hardware/gpio.h
+
+#include "hardware/gpio.h"
+
+static bool level[FAKE_GPIO_COUNT];
+static uint32_t edges[FAKE_GPIO_COUNT];
+static uint32_t irq_mask[FAKE_GPIO_COUNT];
+static gpio_irq_callback_t callback;
+
+void gpio_init(uint gpio) {
+    gpio_put(gpio, 0);
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    (void)gpio;
+    (void)out;
+}
+
+void gpio_put(uint gpio, bool value) {
+    if (gpio < FAKE_GPIO_COUNT && level[gpio] != value) {
+        level[gpio] = value;
+        edges[gpio]++;
+    }
+}
+
+bool gpio_get(uint gpio) {
+    return gpio < FAKE_GPIO_COUNT && level[gpio];
+}
+
+uint32_t fake_gpio_edges(uint gpio) {
+    return gpio < FAKE_GPIO_COUNT ? edges[gpio] : 0;
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled) {
+    if (gpio >= FAKE_GPIO_COUNT) {
+        return;
+    }
+    if (enabled) {
+        irq_mask[gpio] |= event_mask;
+    } else {
+        irq_mask[gpio] &= ~event_mask;
+    }
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled,
+                                        gpio_irq_callback_t cb) {
+    gpio_set_irq_enabled(gpio, event_mask, enabled);
+    callback = cb; // one per core, as on the Pico
+}
+
+void fake_gpio_drive(uint gpio, bool value) {
+    if (gpio >= FAKE_GPIO_COUNT || level[gpio] == value) {
+        return;
+    }
+    gpio_put(gpio, value);
+    uint32_t event = value ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    if ((irq_mask[gpio] & event) && callback) {
+        callback(gpio, event);
+    }
+}
@@ -0,0 +1,238 @@
+// i2c bus for host builds, see fake_i2c.h
+
+#include "hardware/i2c.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "fake_i2c.h"
+#include "fake_mpu6050.h"
+
+#define MAX_TRANSACTION 4096
+
+i2c_inst_t i2c0_inst = { .index = 0 };
+i2c_inst_t i2c1_inst = { .index = 1 };
+
+static fake_i2c_stats_t stats;
+static fake_ssd1306_t panels[2];
+static bool panels_ready;
+
+// bytes written through IC_DATA_CMD since the last STOP, per bus
+static uint8_t pending[2][MAX_TRANSACTION];
+static uint32_t pending_len[2];
+
+// reads queued through IC_DATA_CMD (CMD bit set), finished in the background,
+// and with the STOP_DET interrupt unmasked, writes too
+static struct queued_read {
+    uint8_t addr;
+    uint32_t reads, len;
+    uint8_t tx[MAX_TRANSACTION];       // what goes out first, in the background case
+    uint32_t tx_len;
+    bool rx_waiting;
+    uint rx_channel;
+    volatile uint8_t *rx_dst;
+    uint rx_count;
+} queued[2];
+
+static bool is_panel_address(uint8_t addr) {
+    return addr == 0x3C || addr == 0x3D;
+}
+
+fake_ssd1306_t *fake_i2c_panel(i2c_inst_t *i2c) {
+    if (!panels_ready) {
+        fake_i2c_reset();
+    }
+    return &panels[i2c->index];
+}
+
+// the simulated clock moves on by the time the transaction takes
+static void advance(uint32_t len) {
+    static double carry_us;
+    fake_i2c_stats_t one = { 1, len };
+    carry_us += fake_i2c_wire_us(one, FAKE_I2C_HZ);
+    uint64_t whole = (uint64_t)carry_us;
+    carry_us -= whole;
+    fake_time_advance_us(whole);
+}
+
+// hand a transaction to whoever is at addr on this bus
+static void route_write(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, uint32_t len) {
+    if (is_panel_address(addr)) {
+        fake_ssd1306_write(fake_i2c_panel(i2c), src, len);
+    } else if (addr == FAKE_MPU6050_ADDR && i2c->index == 0) {
+        fake_mpu6050_write(fake_mpu6050(), src, len);
+    }
+}
+
+static void route_read(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, uint32_t len) {
+    if (addr == FAKE_MPU6050_ADDR && i2c->index == 0) {
+        fake_mpu6050_read(fake_mpu6050(), dst, len);
+    } else {
+        for (uint32_t i = 0; i < len; i++) dst[i] = 0xFF; // nobody there
+    }
+}
+
+static void transaction(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, uint32_t len) {
+    stats.transactions++;
+    stats.bytes += len;
+    route_write(i2c, addr, src, len);
+    advance(len);
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    (void)nostop;
+    transaction(i2c, addr, src, (uint32_t)len);
+    return (int)len;
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop) {
+    (void)nostop;
+    stats.transactions++;
+    stats.bytes += (uint32_t)len;
+    route_read(i2c, addr, dst, (uint32_t)len);
+    advance((uint32_t)len);
+    return (int)len;
+}
+
+// the reads of a queued transaction have been clocked in
+static void reads_done(void *arg) {
+    i2c_inst_t *i2c = arg;
+    struct queued_read *q = &queued[i2c->index];
+    uint8_t data[MAX_TRANSACTION];
+    route_read(i2c, q->addr, data, q->reads);
+    i2c->hw.raw_intr_stat |= I2C_IC_RAW_INTR_STAT_STOP_DET_BITS;
+    q->reads = 0;
+    if (q->rx_waiting) {
+        q->rx_waiting = false;
+        uint n = q->rx_count < q->len ? q->rx_count : q->len;
+        for (uint i = 0; i < n; i++) {
+            q->rx_dst[i] = data[i];
+        }
+        fake_dma_done(q->rx_channel);
+    }
+}
+
+// a whole transaction has gone out with the STOP_DET interrupt unmasked:
+// the write reaches the device and the reads come back only now, then the
+// interrupt goes off as it does on the chip. The handler reads
+// IC_CLR_STOP_DET, which a plain field can't notice, so the bit drops again
+// once it has run.
+static void transaction_done(void *arg) {
+    i2c_inst_t *i2c = arg;
+    struct queued_read *q = &queued[i2c->index];
+    route_write(i2c, q->addr, q->tx, q->tx_len);
+    q->tx_len = 0;
+    if (q->reads) {
+        reads_done(i2c);
+    } else {
+        i2c->hw.raw_intr_stat |= I2C_IC_RAW_INTR_STAT_STOP_DET_BITS;
+    }
+    fake_irq_raise(I2C0_IRQ + i2c->index);
+    i2c->hw.raw_intr_stat &= ~I2C_IC_RAW_INTR_STAT_STOP_DET_BITS;
+}
+
+static bool anyone_at(i2c_inst_t *i2c, uint8_t addr) {
+    return is_panel_address(addr) || (addr == FAKE_MPU6050_ADDR && i2c->index == 0);
+}
+
+// the STOP the controller sends after an abort, a little after the abort
+static void nack_stop(void *arg) {
+    i2c_inst_t *i2c = arg;
+    i2c->hw.raw_intr_stat |= I2C_IC_RAW_INTR_STAT_STOP_DET_BITS;
+    fake_irq_raise(I2C0_IRQ + i2c->index);
+    i2c->hw.raw_intr_stat &= ~I2C_IC_RAW_INTR_STAT_STOP_DET_BITS;
+}
+
+// nobody acknowledged the address: TX_ABRT now, the STOP after it, and
+// the rest of the transaction is flushed
+static void nack(void *arg) {
+    i2c_inst_t *i2c = arg;
+    struct queued_read *q = &queued[i2c->index];
+    q->tx_len = 0;
+    q->reads = 0;
+    q->rx_waiting = false;
+    i2c->hw.raw_intr_stat |= I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS;
+    fake_irq_raise(I2C0_IRQ + i2c->index);
+    i2c->hw.raw_intr_stat &= ~I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS;
+    fake_time_at(time_us_64() + FAKE_I2C_STOP_US, nack_stop, i2c);
+}
+
+void fake_i2c_rx_dma(i2c_inst_t *i2c, uint channel, volatile void *dst, uint count) {
+    struct queued_read *q = &queued[i2c->index];
+    q->rx_channel = channel;
+    q->rx_dst = dst;
+    q->rx_count = count;
+    q->rx_waiting = true;
+}
+
+void fake_i2c_data_cmd(i2c_inst_t *i2c, uint32_t word) {
+    uint32_t *len = &pending_len[i2c->index];
+    struct queued_read *q = &queued[i2c->index];
+    if (word & I2C_IC_DATA_CMD_CMD_BITS) {
+        q->reads++;
+    } else if (*len < MAX_TRANSACTION) {
+        pending[i2c->index][(*len)++] = word & 0xFF;
+    }
+    if (!(word & I2C_IC_DATA_CMD_STOP_BITS)) {
+        return;
+    }
+    uint8_t addr = (uint8_t)i2c->hw.tar;
+    if ((i2c->hw.intr_mask & I2C_IC_INTR_MASK_M_TX_ABRT_BITS) && !anyone_at(i2c, addr)) {
+        // the address byte goes out and comes back NACKed
+        fake_i2c_stats_t t = { 1, 0 };
+        stats.transactions++;
+        fake_time_at(time_us_64() + (uint64_t)fake_i2c_wire_us(t, FAKE_I2C_HZ), nack, i2c);
+    } else if (i2c->hw.intr_mask & I2C_IC_INTR_MASK_M_STOP_DET_BITS) {
+        // driven by the interrupt: all of it finishes in the background
+        fake_i2c_stats_t t = { q->reads && *len ? 2 : 1, *len + q->reads };
+        stats.transactions += t.transactions;
+        stats.bytes += t.bytes;
+        for (uint32_t i = 0; i < *len; i++) {
+            q->tx[i] = pending[i2c->index][i];
+        }
+        q->tx_len = *len;
+        q->addr = addr;
+        q->len = q->reads;
+        fake_time_at(time_us_64() + (uint64_t)fake_i2c_wire_us(t, FAKE_I2C_HZ), transaction_done, i2c);
+    } else if (q->reads) {
+        // the register address goes out now, the reads come back after
+        // the whole transaction's time on the wire while the CPU gets on
+        // with something else
+        fake_i2c_stats_t t = { 2, *len + q->reads };
+        stats.transactions += t.transactions;
+        stats.bytes += t.bytes;
+        route_write(i2c, addr, pending[i2c->index], *len);
+        q->addr = addr;
+        q->len = q->reads;
+        fake_time_at(time_us_64() + (uint64_t)fake_i2c_wire_us(t, FAKE_I2C_HZ), reads_done, i2c);
+    } else {
+        transaction(i2c, addr, pending[i2c->index], *len);
+        i2c->hw.raw_intr_stat |= I2C_IC_RAW_INTR_STAT_STOP_DET_BITS;
+    }
+    *len = 0;
+}
+
+void fake_i2c_reset(void) {
+    fake_ssd1306_reset(&panels[0]);
+    fake_ssd1306_reset(&panels[1]);
+    fake_mpu6050_reset();
+    panels_ready = true;
+    pending_len[0] = pending_len[1] = 0;
+    i2c0_inst.hw.intr_mask = i2c1_inst.hw.intr_mask = 0;
+    i2c0_inst.hw.raw_intr_stat = i2c1_inst.hw.raw_intr_stat = 0;
+    queued[0] = queued[1] = (struct queued_read){ 0 };
+    fake_time_cancel_all();
+    fake_i2c_reset_stats();
+}
+
+void fake_i2c_reset_stats(void) {
+    stats.transactions = 0;
+    stats.bytes = 0;
+}
+
+fake_i2c_stats_t fake_i2c_stats(void) {
+    return stats;
+}
+
+double fake_i2c_wire_us(fake_i2c_stats_t s, uint32_t scl_hz) {
+    double clocks = 9.0 * s.bytes + (1 + 9 + 1) * (double)s.transactions;
+    return clocks * 1e6 / scl_hz;
+}
@@ -0,0 +1,44 @@
+#ifndef FAKE_I2C_H
+#define FAKE_I2C_H
+
+#include <stdint.h>
+#include "hardware/i2c.h"
+#include "fake_ssd1306.h"
+
+// Fake i2c0/i2c1 for host builds. Every transaction is counted and handed
+// to the SSD1306 model on that bus, or the MPU6050 model on i2c0, if it is
+// addressed to them. Each one moves the simulated clock on by its time on
+// the wire at FAKE_I2C_HZ, except reads queued through IC_DATA_CMD by DMA:
+// those run in the background and finish their RX DMA channel when the
+// wire time is up, as they do on the chip. With the STOP_DET interrupt
+// unmasked in intr_mask every transaction through IC_DATA_CMD runs in the
+// background and raises I2C0_IRQ/I2C1_IRQ at the end. With TX_ABRT
+// unmasked too, one to an address nobody answers is NACKed: TX_ABRT after
+// the address byte, then STOP_DET FAKE_I2C_STOP_US later, as the chip does.
+
+#define FAKE_I2C_HZ 400000
+#define FAKE_I2C_STOP_US 3
+
+// bus traffic seen since the last reset
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;          // payload bytes, not counting the address byte
+} fake_i2c_stats_t;
+
+void fake_i2c_reset(void);   // stats and panels
+void fake_i2c_reset_stats(void);
+fake_i2c_stats_t fake_i2c_stats(void);
+
+// time on the wire at the given SCL rate: 9 clocks per byte, plus start,
+// address byte and stop for every transaction
+double fake_i2c_wire_us(fake_i2c_stats_t s, uint32_t scl_hz);
+
+// the panel model listening on this bus
+fake_ssd1306_t *fake_i2c_panel(i2c_inst_t *i2c);
+
+// one word written to IC_DATA_CMD, as the DMA does
+void fake_i2c_data_cmd(i2c_inst_t *i2c, uint32_t word);
+// a DMA channel waiting to read count bytes out of IC_DATA_CMD into dst
+void fake_i2c_rx_dma(i2c_inst_t *i2c, uint channel, volatile void *dst, uint count);
+
+#endif
@@ -0,0 +1,59 @@
+// interrupts for host builds, see include/hardware/irq.h
+
+#include "hardware/irq.h"
+
+#define MAX_SHARED 4
+
+static irq_handler_t handlers[FAKE_IRQ_COUNT][MAX_SHARED];
+static bool enabled[FAKE_IRQ_COUNT];
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority) {
+    (void)order_priority;
+    if (num >= FAKE_IRQ_COUNT) {
+        return;
+    }
+    for (int i = 0; i < MAX_SHARED; i++) {
+        if (!handlers[num][i]) {
+            handlers[num][i] = handler;
+            return;
+        }
+    }
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+    if (num >= FAKE_IRQ_COUNT) {
+        return;
+    }
+    for (int i = 0; i < MAX_SHARED; i++) {
+        handlers[num][i] = NULL;
+    }
+    handlers[num][0] = handler;
+}
+
+void irq_remove_handler(uint num, irq_handler_t handler) {
+    if (num >= FAKE_IRQ_COUNT) {
+        return;
+    }
+    for (int i = 0; i < MAX_SHARED; i++) {
+        if (handlers[num][i] == handler) {
+            handlers[num][i] = NULL;
+        }
+    }
+}
+
+void irq_set_enabled(uint num, bool on) {
+    if (num < FAKE_IRQ_COUNT) {
+        enabled[num] = on;
+    }
+}
+
+void fake_irq_raise(uint num) {
+    if (num >= FAKE_IRQ_COUNT || !enabled[num]) {
+        return;
+    }
+    for (int i = 0; i < MAX_SHARED; i++) {
+        if (handlers[num][i]) {
+            handlers[num][i]();
+        }
+    }
+}
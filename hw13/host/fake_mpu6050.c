@@ -0,0 +1,220 @@
+// MPU6050 model behind the fake i2c bus, see fake_mpu6050.h
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "fake_mpu6050.h"
+
+#define SMPLRT_DIV   0x19
+#define CONFIG       0x1A
+#define FIFO_EN      0x23
+#define INT_ENABLE   0x38
+#define INT_STATUS   0x3A
+#define ACCEL_XOUT_H 0x3B
+#define USER_CTRL    0x6A
+#define PWR_MGMT_1   0x6B
+#define FIFO_COUNTH  0x72
+#define FIFO_COUNTL  0x73
+#define FIFO_R_W     0x74
+#define WHO_AM_I     0x75
+
+static fake_mpu6050_t model;
+static bool ready;
+
+// sample timeline, restarted when the rate changes
+static uint64_t start_us;
+static uint32_t start_index;
+static bool awake;
+
+static void counting_motion(uint32_t index, uint64_t t_us, int16_t raw[6]) {
+    (void)t_us;
+    raw[0] = (int16_t)(index & 0x7FFF);
+    raw[1] = 0;
+    raw[2] = 16384; // 1 g at +-2 g
+    raw[3] = raw[4] = raw[5] = 0;
+}
+
+void fake_mpu6050_reset(void) {
+    memset(&model, 0, sizeof(model));
+    model.regs[WHO_AM_I] = FAKE_MPU6050_ADDR;
+    model.regs[PWR_MGMT_1] = 0x40; // asleep
+    model.motion = counting_motion;
+    model.int_gpio = -1;
+    awake = false;
+    ready = true;
+}
+
+fake_mpu6050_t *fake_mpu6050(void) {
+    if (!ready) {
+        fake_mpu6050_reset();
+    }
+    return &model;
+}
+
+uint32_t fake_mpu6050_period_us(const fake_mpu6050_t *m) {
+    // 8 kHz gyro output without the DLPF, 1 kHz with it
+    uint32_t base = (m->regs[CONFIG] & 7) ? 1000 : 8000;
+    return 1000000u * (m->regs[SMPLRT_DIV] + 1u) / base;
+}
+
+uint64_t fake_mpu6050_sample_us(const fake_mpu6050_t *m, uint32_t index) {
+    double period = fake_mpu6050_period_us(m) * (1.0 + m->clock_error);
+    return start_us + (uint64_t)((index - start_index + 1) * period);
+}
+
+static void data_ready(void *arg);
+
+// queue the INT pulse for the next sample, if anyone is listening
+static void schedule_int(fake_mpu6050_t *m) {
+    if (!awake || m->int_gpio < 0 || !(m->regs[INT_ENABLE] & 0x01)) {
+        m->next_us = 0;
+        return;
+    }
+    m->next_us = fake_mpu6050_sample_us(m, m->index);
+    fake_time_at(m->next_us, data_ready, m);
+}
+
+static void data_ready(void *arg) {
+    fake_mpu6050_t *m = arg;
+    if (!m->next_us || time_us_64() < m->next_us) {
+        return; // rescheduled or switched off since
+    }
+    fake_mpu6050_run(m);
+    // a 50 us pulse, only the rising edge matters here
+    fake_gpio_drive((uint)m->int_gpio, true);
+    fake_gpio_drive((uint)m->int_gpio, false);
+    schedule_int(m);
+}
+
+static void restart_timeline(fake_mpu6050_t *m) {
+    start_us = time_us_64();
+    start_index = m->index;
+    schedule_int(m);
+}
+
+static void fifo_push(fake_mpu6050_t *m, const uint8_t *src, int n) {
+    for (int i = 0; i < n; i++) {
+        if (m->fifo_len == sizeof(m->fifo)) {
+            // full: the oldest byte goes
+            m->fifo_head = (m->fifo_head + 1) % sizeof(m->fifo);
+            m->fifo_len--;
+            m->regs[INT_STATUS] |= 0x10;
+        }
+        m->fifo[(m->fifo_head + m->fifo_len) % sizeof(m->fifo)] = src[i];
+        m->fifo_len++;
+    }
+}
+
+static void take_sample(fake_mpu6050_t *m, uint64_t t) {
+    int16_t raw[6];
+    m->motion(m->index, t, raw);
+    uint8_t *r = &m->regs[ACCEL_XOUT_H];
+    for (int i = 0; i < 3; i++) {
+        r[2 * i] = (uint8_t)(raw[i] >> 8);
+        r[2 * i + 1] = (uint8_t)raw[i];
+        r[8 + 2 * i] = (uint8_t)(raw[3 + i] >> 8);
+        r[8 + 2 * i + 1] = (uint8_t)raw[3 + i];
+    }
+    r[6] = r[7] = 0; // temperature
+    m->regs[INT_STATUS] |= 0x01;
+
+    if (m->regs[USER_CTRL] & 0x40) {
+        // in register order: accel, temp, gyro x, y, z
+        uint8_t en = m->regs[FIFO_EN];
+        if (en & 0x08) fifo_push(m, r, 6);
+        if (en & 0x80) fifo_push(m, r + 6, 2);
+        if (en & 0x40) fifo_push(m, r + 8, 2);
+        if (en & 0x20) fifo_push(m, r + 10, 2);
+        if (en & 0x10) fifo_push(m, r + 12, 2);
+    }
+    m->index++;
+}
+
+void fake_mpu6050_run(fake_mpu6050_t *m) {
+    if (!awake) {
+        return;
+    }
+    uint64_t now = time_us_64();
+    for (;;) {
+        uint64_t t = fake_mpu6050_sample_us(m, m->index);
+        if (t > now) {
+            break;
+        }
+        take_sample(m, t);
+    }
+}
+
+static void write_reg(fake_mpu6050_t *m, uint8_t reg, uint8_t value) {
+    switch (reg) {
+        case USER_CTRL:
+            if (value & 0x04) {
+                m->fifo_head = m->fifo_len = 0;
+            }
+            m->regs[reg] = value & ~0x04; // FIFO_RESET clears itself
+            return;
+        case PWR_MGMT_1:
+            m->regs[reg] = value;
+            if (!(value & 0x40) && !awake) {
+                awake = true;
+                restart_timeline(m);
+            }
+            return;
+        case SMPLRT_DIV:
+        case CONFIG:
+            m->regs[reg] = value;
+            restart_timeline(m);
+            return;
+        case INT_ENABLE:
+            m->regs[reg] = value;
+            schedule_int(m);
+            return;
+        case WHO_AM_I:
+        case INT_STATUS:
+            return; // read only
+        default:
+            m->regs[reg & 0x7F] = value;
+    }
+}
+
+void fake_mpu6050_write(fake_mpu6050_t *m, const uint8_t *src, uint32_t len) {
+    fake_mpu6050_run(m);
+    if (len == 0) {
+        return;
+    }
+    m->pointer = src[0] & 0x7F;
+    for (uint32_t i = 1; i < len; i++) {
+        write_reg(m, m->pointer, src[i]);
+        m->pointer = (m->pointer + 1) & 0x7F;
+    }
+}
+
+void fake_mpu6050_read(fake_mpu6050_t *m, uint8_t *dst, uint32_t len) {
+    fake_mpu6050_run(m);
+    for (uint32_t i = 0; i < len; i++) {
+        uint8_t reg = m->pointer;
+        switch (reg) {
+            case FIFO_R_W:
+                // no auto-increment, a burst drains the FIFO
+                if (m->fifo_len) {
+                    dst[i] = m->fifo[m->fifo_head];
+                    m->fifo_head = (m->fifo_head + 1) % sizeof(m->fifo);
+                    m->fifo_len--;
+                } else {
+                    dst[i] = 0;
+                }
+                continue;
+            case FIFO_COUNTH:
+                dst[i] = (uint8_t)(m->fifo_len >> 8);
+                break;
+            case FIFO_COUNTL:
+                dst[i] = (uint8_t)m->fifo_len;
+                break;
+            case INT_STATUS:
+                dst[i] = m->regs[reg];
+                m->regs[reg] = 0; // cleared by reading
+                break;
+            default:
+                dst[i] = m->regs[reg];
+        }
+        m->pointer = (reg + 1) & 0x7F;
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef FAKE_MPU6050_H
+#define FAKE_MPU6050_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Model of an MPU6050 at 0x68 on the fake i2c0. It keeps the register
+// file and samples on its own clock, on the simulated time from
+// pico/stdlib.h: the data registers follow each sample and, with the FIFO
+// enabled, accel and gyro are pushed into a 1024 byte FIFO that drops its
+// oldest bytes and flags an overflow when full, as the chip does.
+//
+// With DATA_RDY set in INT_ENABLE and int_gpio wired, every sample pulses
+// that GPIO at the moment it is taken, on the simulated clock's events, so
+// edge interrupts see it without the bus being touched.
+//
+// What gets sampled comes from a motion function. The default one counts:
+// accel X holds the sample number (mod 32768) so a benchmark can spot
+// skipped and repeated samples, accel Z is 1 g and the gyro reads 0.
+
+#define FAKE_MPU6050_ADDR 0x68
+
+// raw accel xyz and gyro xyz for sample `index`, taken at t_us
+typedef void (*fake_mpu6050_motion_t)(uint32_t index, uint64_t t_us, int16_t raw[6]);
+
+typedef struct {
+    uint8_t regs[128];
+    uint8_t pointer;           // register the next read starts at
+
+    uint8_t fifo[1024];
+    uint32_t fifo_head, fifo_len;
+
+    uint32_t index;            // samples taken
+    uint64_t next_us;          // when the next data-ready pulse is due
+    double clock_error;        // sample clock vs nominal, 0.01 is 1% slow
+
+    fake_mpu6050_motion_t motion;
+
+    int int_gpio;              // GPIO the INT pin drives, -1 if not wired
+} fake_mpu6050_t;
+
+void fake_mpu6050_reset(void);
+fake_mpu6050_t *fake_mpu6050(void);
+// the sample clock period with the current SMPLRT_DIV and CONFIG
+uint32_t fake_mpu6050_period_us(const fake_mpu6050_t *m);
+// when sample `index` was taken (the first one is index 0)
+uint64_t fake_mpu6050_sample_us(const fake_mpu6050_t *m, uint32_t index);
+// take every sample due up to now
+void fake_mpu6050_run(fake_mpu6050_t *m);
+
+// the i2c side, one call per transaction
+void fake_mpu6050_write(fake_mpu6050_t *m, const uint8_t *src, uint32_t len);
+void fake_mpu6050_read(fake_mpu6050_t *m, uint8_t *dst, uint32_t len);
+
+#endif
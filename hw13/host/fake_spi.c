@@ -0,0 +1,72 @@
+// spi bus for host builds, see fake_spi.h
+
+#include "hardware/spi.h"
+#include "hardware/gpio.h"
+#include "fake_spi.h"
+
+spi_inst_t spi0_inst = { .index = 0 };
+spi_inst_t spi1_inst = { .index = 1 };
+
+static fake_spi_stats_t stats;
+static fake_ssd1306_t panels[2];
+static bool panels_ready;
+
+// panel wiring, and the CS edge count when its last byte arrived
+static uint dc[2], cs[2];
+static bool connected[2];
+static uint32_t cs_seen[2];
+
+fake_ssd1306_t *fake_spi_panel(spi_inst_t *spi) {
+    if (!panels_ready) {
+        fake_spi_reset();
+    }
+    return &panels[spi->index];
+}
+
+void fake_spi_connect(spi_inst_t *spi, uint dc_pin, uint cs_pin) {
+    dc[spi->index] = dc_pin;
+    cs[spi->index] = cs_pin;
+    connected[spi->index] = true;
+    cs_seen[spi->index] = fake_gpio_edges(cs_pin);
+}
+
+void fake_spi_byte(spi_inst_t *spi, uint8_t byte) {
+    int i = spi->index;
+    stats.bytes++;
+    if (!connected[i] || gpio_get(cs[i])) {
+        return;
+    }
+    if (fake_gpio_edges(cs[i]) != cs_seen[i]) {
+        // CS went low again since the last byte
+        cs_seen[i] = fake_gpio_edges(cs[i]);
+        stats.transactions++;
+    }
+    fake_ssd1306_spi_byte(fake_spi_panel(spi), gpio_get(dc[i]), byte);
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        fake_spi_byte(spi, src[i]);
+    }
+    return (int)len;
+}
+
+void fake_spi_reset(void) {
+    fake_ssd1306_reset(&panels[0]);
+    fake_ssd1306_reset(&panels[1]);
+    panels_ready = true;
+    fake_spi_reset_stats();
+}
+
+void fake_spi_reset_stats(void) {
+    stats.transactions = 0;
+    stats.bytes = 0;
+}
+
+fake_spi_stats_t fake_spi_stats(void) {
+    return stats;
+}
+
+double fake_spi_wire_us(fake_spi_stats_t s, uint32_t sck_hz) {
+    return 8.0 * s.bytes * 1e6 / sck_hz;
+}
@@ -0,0 +1,30 @@
+#ifndef FAKE_SPI_H
+#define FAKE_SPI_H
+
+#include <stdint.h>
+#include "hardware/spi.h"
+#include "fake_ssd1306.h"
+
+// Fake spi0/spi1 for host builds. Each bus has an SSD1306 model wired to
+// the D/C and CS GPIOs given to fake_spi_connect(); bytes sent while CS is
+// high are counted but go nowhere.
+
+typedef struct {
+    uint32_t transactions;   // CS low periods that carried bytes
+    uint32_t bytes;
+} fake_spi_stats_t;
+
+void fake_spi_reset(void);   // stats and panels
+void fake_spi_reset_stats(void);
+fake_spi_stats_t fake_spi_stats(void);
+
+// time on the wire at the given SCK rate, 8 clocks per byte
+double fake_spi_wire_us(fake_spi_stats_t s, uint32_t sck_hz);
+
+void fake_spi_connect(spi_inst_t *spi, uint dc_pin, uint cs_pin);
+fake_ssd1306_t *fake_spi_panel(spi_inst_t *spi);
+
+// one byte written to the data register, as the DMA does
+void fake_spi_byte(spi_inst_t *spi, uint8_t byte);
+
+#endif
@@ -0,0 +1,200 @@
+// SSD1306 controller model for the host build, see fake_ssd1306.h
+
+#include <stdio.h>
+#include <string.h>
+#include "fake_ssd1306.h"
+#include "ssd1306.h"
+
+void fake_ssd1306_reset(fake_ssd1306_t *p) {
+    memset(p, 0, sizeof(*p));
+    // power-on defaults from the datasheet
+    p->mode = 2;
+    p->col_end = FAKE_SSD1306_COLS - 1;
+    p->page_end = FAKE_SSD1306_PAGES - 1;
+    p->mux = 63;
+    p->contrast = 0x7F;
+}
+
+// number of argument bytes that follow a command byte
+static int command_args(uint8_t c) {
+    switch (c) {
+        case SSD1306_MEMORYMODE:
+        case SSD1306_SETCONTRAST:
+        case SSD1306_CHARGEPUMP:
+        case SSD1306_SETMULTIPLEX:
+        case SSD1306_SETDISPLAYOFFSET:
+        case SSD1306_SETDISPLAYCLOCKDIV:
+        case SSD1306_SETPRECHARGE:
+        case SSD1306_SETCOMPINS:
+        case SSD1306_SETVCOMDETECT:
+            return 1;
+        case SSD1306_COLUMNADDR:
+        case SSD1306_PAGEADDR:
+        case 0xA3: // vertical scroll area
+            return 2;
+        case 0x29: // vertical and horizontal scroll setup
+        case 0x2A:
+            return 5;
+        case 0x26: // horizontal scroll setup
+        case 0x27:
+            return 6;
+        default:
+            return 0;
+    }
+}
+
+static void run_command(fake_ssd1306_t *p) {
+    uint8_t c = p->cmd;
+    const uint8_t *a = p->args;
+
+    if (c <= 0x0F) {                      // page mode lower column nibble
+        p->col = (p->col & 0xF0) | c;
+    } else if (c <= 0x1F) {               // page mode upper column nibble
+        p->col = (p->col & 0x0F) | ((c & 0x0F) << 4);
+    } else if (c >= 0x40 && c <= 0x7F) {  // SETSTARTLINE
+        p->start_line = c & 0x3F;
+    } else if (c >= 0xB0 && c <= 0xB7) {  // page mode page start
+        p->page = c & 0x07;
+    } else {
+        switch (c) {
+            case SSD1306_MEMORYMODE:       p->mode = a[0] & 0x03; break;
+            case SSD1306_COLUMNADDR:
+                p->col_start = a[0] & 0x7F;
+                p->col_end = a[1] & 0x7F;
+                p->col = p->col_start;
+                break;
+            case SSD1306_PAGEADDR:
+                p->page_start = a[0] & 0x07;
+                p->page_end = a[1] & 0x07;
+                p->page = p->page_start;
+                break;
+            case SSD1306_SETCONTRAST:      p->contrast = a[0]; break;
+            case SSD1306_SETMULTIPLEX:     p->mux = a[0] & 0x3F; break;
+            case SSD1306_SETDISPLAYOFFSET: p->offset = a[0] & 0x3F; break;
+            case SSD1306_NORMALDISPLAY:    p->inverted = false; break;
+            case SSD1306_INVERTDISPLAY:    p->inverted = true; break;
+            case SSD1306_DISPLAYOFF:       p->on = false; break;
+            case SSD1306_DISPLAYON:        p->on = true; break;
+            // accepted, but they don't change what the model shows
+            case SSD1306_CHARGEPUMP:
+            case SSD1306_SETDISPLAYCLOCKDIV:
+            case SSD1306_SETPRECHARGE:
+            case SSD1306_SETCOMPINS:
+            case SSD1306_SETVCOMDETECT:
+            case SSD1306_SEGREMAP:
+            case SSD1306_SEGREMAP | 0x1:
+            case SSD1306_COMSCANDEC:
+            case 0xC0: // COM scan increment
+            case SSD1306_DISPLAYALLON_RESUME:
+            case SSD1306_DEACTIVATE_SCROLL:
+            case 0x2F: // activate scroll
+            case 0x26: case 0x27: case 0x29: case 0x2A: case 0xA3:
+            case 0xE3: // nop
+                break;
+            default:
+                p->unknown_commands++;
+                break;
+        }
+    }
+}
+
+static void command_byte(fake_ssd1306_t *p, uint8_t b) {
+    if (p->argc) {
+        p->args[p->argn++] = b;
+        if (p->argn == p->argc) {
+            p->argc = 0;
+            run_command(p);
+        }
+        return;
+    }
+    p->cmd = b;
+    p->argn = 0;
+    p->argc = command_args(b);
+    if (!p->argc) {
+        run_command(p);
+    }
+}
+
+static void data_byte(fake_ssd1306_t *p, uint8_t b) {
+    p->gddram[p->page][p->col] = b;
+    switch (p->mode) {
+        case 0: // horizontal
+            if (p->col++ >= p->col_end) {
+                p->col = p->col_start;
+                p->page = p->page >= p->page_end ? p->page_start : p->page + 1;
+            }
+            break;
+        case 1: // vertical
+            if (p->page++ >= p->page_end) {
+                p->page = p->page_start;
+                p->col = p->col >= p->col_end ? p->col_start : p->col + 1;
+            }
+            break;
+        default: // page, the column wraps and the page stays
+            p->col = (p->col + 1) & 0x7F;
+            break;
+    }
+}
+
+// The first byte is a control byte: D/C (bit 6) says whether what follows is
+// data or commands, Co (bit 7) says another control byte comes after the
+// next byte. With Co clear, everything to the STOP is data or commands.
+void fake_ssd1306_write(fake_ssd1306_t *p, const uint8_t *bytes, uint32_t len) {
+    uint32_t i = 0;
+    while (i < len) {
+        uint8_t control = bytes[i++];
+        bool more_control = control & 0x80;
+        bool data = control & 0x40;
+        while (i < len) {
+            if (data) {
+                data_byte(p, bytes[i++]);
+            } else {
+                command_byte(p, bytes[i++]);
+            }
+            if (more_control) {
+                break;
+            }
+        }
+    }
+}
+
+void fake_ssd1306_spi_byte(fake_ssd1306_t *p, bool dc, uint8_t byte) {
+    if (dc) {
+        data_byte(p, byte);
+    } else {
+        command_byte(p, byte);
+    }
+}
+
+int fake_ssd1306_rows(const fake_ssd1306_t *p) {
+    return p->mux + 1;
+}
+
+int fake_ssd1306_pixel(const fake_ssd1306_t *p, int x, int y) {
+    if (!p->on) {
+        return 0;
+    }
+    int row = (y + p->start_line + p->offset) & 63;
+    int bit = (p->gddram[row >> 3][x] >> (row & 7)) & 1;
+    return bit ^ p->inverted;
+}
+
+bool fake_ssd1306_write_pbm(const fake_ssd1306_t *p, const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+    int rows = fake_ssd1306_rows(p);
+    fprintf(f, "P4\n%d %d\n", FAKE_SSD1306_COLS, rows);
+    for (int y = 0; y < rows; y++) {
+        // P4 packs 8 pixels per byte, MSB first, 1 is black
+        for (int x = 0; x < FAKE_SSD1306_COLS; x += 8) {
+            uint8_t packed = 0;
+            for (int i = 0; i < 8; i++) {
+                packed = (packed << 1) | (fake_ssd1306_pixel(p, x + i, y) ? 0 : 1);
+            }
+            fputc(packed, f);
+        }
+    }
+    return fclose(f) == 0;
+}
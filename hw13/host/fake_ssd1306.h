@@ -0,0 +1,55 @@
+#ifndef FAKE_SSD1306_H
+#define FAKE_SSD1306_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Model of the SSD1306 controller behind the fake i2c bus. It decodes the
+// control bytes, commands and data the same way the chip does and keeps
+// its own GDDRAM, so what the host build "shows" is what the panel would.
+// Segment remap and COM scan direction are taken as the driver sets them
+// and not modelled, so GDDRAM column x is screen column x.
+
+#define FAKE_SSD1306_COLS  128
+#define FAKE_SSD1306_PAGES 8
+
+typedef struct {
+    uint8_t gddram[FAKE_SSD1306_PAGES][FAKE_SSD1306_COLS];
+
+    // addressing
+    uint8_t mode;            // 0 horizontal, 1 vertical, 2 page
+    uint8_t col, col_start, col_end;
+    uint8_t page, page_start, page_end;
+
+    // display
+    uint8_t start_line;      // 0..63
+    uint8_t offset;          // SETDISPLAYOFFSET
+    uint8_t mux;             // rows shown = mux + 1
+    uint8_t contrast;
+    bool on;
+    bool inverted;
+
+    // command parser, arguments can arrive in later transactions
+    uint8_t cmd;
+    uint8_t argc;            // arguments cmd still needs
+    uint8_t argn;            // arguments collected so far
+    uint8_t args[6];
+
+    uint32_t unknown_commands;
+} fake_ssd1306_t;
+
+void fake_ssd1306_reset(fake_ssd1306_t *p);
+
+// one i2c write transaction addressed to the panel
+void fake_ssd1306_write(fake_ssd1306_t *p, const uint8_t *bytes, uint32_t len);
+// one byte clocked in over 4-wire SPI, dc is the level of the D/C pin
+void fake_ssd1306_spi_byte(fake_ssd1306_t *p, bool dc, uint8_t byte);
+
+// screen pixel as the panel shows it, after start line and offset
+int fake_ssd1306_pixel(const fake_ssd1306_t *p, int x, int y);
+int fake_ssd1306_rows(const fake_ssd1306_t *p);
+
+// write what the panel shows as a binary PBM, returns false on error
+bool fake_ssd1306_write_pbm(const fake_ssd1306_t *p, const char *path);
+
+#endif
@@ -0,0 +1,61 @@
+// simulated clock for host builds, see include/pico/stdlib.h
+
+#include "pico/stdlib.h"
+
+#define MAX_EVENTS 64
+
+uint64_t fake_time_now_us;
+
+// pending events, kept sorted by time
+static struct {
+    uint64_t t_us;
+    fake_time_event_t fn;
+    void *arg;
+} events[MAX_EVENTS];
+static int event_count;
+static bool dispatching;
+
+void fake_time_at(uint64_t t_us, fake_time_event_t fn, void *arg) {
+    if (event_count == MAX_EVENTS) {
+        return;
+    }
+    int i = event_count++;
+    // after any already due at the same time, so they run in order
+    while (i > 0 && events[i - 1].t_us > t_us) {
+        events[i] = events[i - 1];
+        i--;
+    }
+    events[i].t_us = t_us;
+    events[i].fn = fn;
+    events[i].arg = arg;
+}
+
+void fake_time_cancel_all(void) {
+    event_count = 0;
+}
+
+void fake_time_advance_us(uint64_t us) {
+    uint64_t target = fake_time_now_us + us;
+    if (dispatching) {
+        // time taken inside an event, it runs on from where the event is
+        fake_time_now_us = target;
+        return;
+    }
+    dispatching = true;
+    while (event_count && events[0].t_us <= target) {
+        fake_time_event_t fn = events[0].fn;
+        void *arg = events[0].arg;
+        if (events[0].t_us > fake_time_now_us) {
+            fake_time_now_us = events[0].t_us;
+        }
+        event_count--;
+        for (int i = 0; i < event_count; i++) {
+            events[i] = events[i + 1];
+        }
+        fn(arg);
+    }
+    dispatching = false;
+    if (target > fake_time_now_us) {
+        fake_time_now_us = target;
+    }
+}
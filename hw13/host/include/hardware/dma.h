@@ -0,0 +1,45 @@
+#ifndef HOST_HARDWARE_DMA_H
+#define HOST_HARDWARE_DMA_H
+
+// Host stand-in for hardware/dma.h. A triggered channel runs its whole
+// transfer immediately, except one reading an i2c IC_DATA_CMD, which fills
+// in when the bus has clocked the bytes in, see fake_dma.c.
+
+#include "pico/stdlib.h"
+
+enum dma_channel_transfer_size {
+    DMA_SIZE_8 = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2
+};
+
+typedef struct {
+    enum dma_channel_transfer_size size;
+    bool read_increment;
+    bool write_increment;
+    uint dreq;
+} dma_channel_config;
+
+int dma_claim_unused_channel(bool required);
+static inline void dma_channel_unclaim(uint channel) { (void)channel; }
+dma_channel_config dma_channel_get_default_config(uint channel);
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) { c->size = size; }
+static inline void channel_config_set_read_increment(dma_channel_config *c, bool incr) { c->read_increment = incr; }
+static inline void channel_config_set_write_increment(dma_channel_config *c, bool incr) { c->write_increment = incr; }
+static inline void channel_config_set_dreq(dma_channel_config *c, uint dreq) { c->dreq = dreq; }
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger);
+static inline bool dma_channel_is_busy(uint channel) { (void)channel; return false; }
+static inline void dma_channel_abort(uint channel) { (void)channel; }
+
+void dma_channel_set_irq1_enabled(uint channel, bool enabled);
+bool dma_channel_get_irq1_status(uint channel);
+void dma_channel_acknowledge_irq1(uint channel);
+
+// the transfer on channel has finished: flag it and raise DMA_IRQ_1 if
+// the channel is enabled on it
+void fake_dma_done(uint channel);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef HOST_HARDWARE_FLASH_H
+#define HOST_HARDWARE_FLASH_H
+
+// Host stand-in for hardware/flash.h. The flash is a RAM array that reads
+// through XIP_BASE as on the chip and programs like NOR: erasing sets a
+// sector to 0xFF, programming can only clear bits. See fake_flash.c.
+
+#include "pico/stdlib.h"
+
+#define FLASH_PAGE_SIZE       256u
+#define FLASH_SECTOR_SIZE     4096u
+#define PICO_FLASH_SIZE_BYTES (64u * 1024)
+
+extern uint8_t fake_flash[PICO_FLASH_SIZE_BYTES];
+#define XIP_BASE ((uintptr_t)fake_flash)
+
+// offsets from the start of flash, sector and page aligned as the SDK wants
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
+
+// all of it erased, counts cleared
+void fake_flash_reset(void);
+// erases and programs since the reset, and misaligned calls
+typedef struct {
+    uint32_t erases, programs, misaligned;
+} fake_flash_stats_t;
+fake_flash_stats_t fake_flash_stats(void);
+
+#endif
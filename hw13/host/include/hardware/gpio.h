@@ -0,0 +1,41 @@
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+// Host stand-in for hardware/gpio.h. Output levels are kept in fake_gpio.c
+// so the fake SPI bus can see D/C and CS, and models can drive inputs,
+// which raise the GPIO interrupt callback on enabled edges.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef unsigned int uint;
+
+#define GPIO_OUT 1
+#define GPIO_IN  0
+#define FAKE_GPIO_COUNT 48
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+
+enum gpio_irq_level {
+    GPIO_IRQ_LEVEL_LOW = 0x1u,
+    GPIO_IRQ_LEVEL_HIGH = 0x2u,
+    GPIO_IRQ_EDGE_FALL = 0x4u,
+    GPIO_IRQ_EDGE_RISE = 0x8u,
+};
+
+typedef void (*gpio_irq_callback_t)(uint gpio, uint32_t event_mask);
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled);
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled,
+                                        gpio_irq_callback_t callback);
+
+// an outside signal on an input pin, edge interrupts fire from here
+void fake_gpio_drive(uint gpio, bool value);
+
+// times the pin has changed level, to spot CS pulses between bytes
+uint32_t fake_gpio_edges(uint gpio);
+
+#endif
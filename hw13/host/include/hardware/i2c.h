@@ -0,0 +1,46 @@
+#ifndef HOST_HARDWARE_I2C_H
+#define HOST_HARDWARE_I2C_H
+
+// Host stand-in for hardware/i2c.h. Transactions land in fake_i2c.c.
+
+#include "pico/stdlib.h"
+
+#define I2C_IC_DATA_CMD_RESTART_BITS         0x00000400u
+#define I2C_IC_DATA_CMD_STOP_BITS            0x00000200u
+#define I2C_IC_DATA_CMD_CMD_BITS             0x00000100u
+#define I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS    0x00000040u
+#define I2C_IC_RAW_INTR_STAT_STOP_DET_BITS   0x00000200u
+#define I2C_IC_INTR_MASK_M_TX_ABRT_BITS      0x00000040u
+#define I2C_IC_INTR_MASK_M_STOP_DET_BITS     0x00000200u
+
+// the registers the driver touches directly
+typedef struct {
+    io_rw_32 enable;
+    io_rw_32 tar;
+    io_rw_32 data_cmd;
+    io_rw_32 intr_mask;
+    io_ro_32 raw_intr_stat;
+    io_ro_32 clr_stop_det;
+    io_ro_32 clr_tx_abrt;
+} i2c_hw_t;
+
+typedef struct i2c_inst {
+    i2c_hw_t hw;
+    int index;
+} i2c_inst_t;
+
+extern i2c_inst_t i2c0_inst;
+extern i2c_inst_t i2c1_inst;
+
+#define i2c0 (&i2c0_inst)
+#define i2c1 (&i2c1_inst)
+#define i2c_default i2c0
+
+static inline i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c) { return &i2c->hw; }
+static inline uint i2c_hw_index(i2c_inst_t *i2c) { return (uint)i2c->index; }
+static inline uint i2c_get_dreq(i2c_inst_t *i2c, bool is_tx) { return 2 * i2c->index + (is_tx ? 0 : 1); }
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+
+#endif
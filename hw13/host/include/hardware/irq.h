@@ -0,0 +1,29 @@
+#ifndef HOST_HARDWARE_IRQ_H
+#define HOST_HARDWARE_IRQ_H
+
+// Host stand-in for hardware/irq.h. Shared handlers are kept per IRQ and
+// called by fake_irq_raise() when it is enabled, see fake_irq.c.
+
+#include "pico/stdlib.h"
+
+// RP2350 numbers
+#define DMA_IRQ_0 10
+#define DMA_IRQ_1 11
+#define I2C0_IRQ 36
+#define I2C1_IRQ 37
+#define FAKE_IRQ_COUNT 64
+
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+typedef void (*irq_handler_t)(void);
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority);
+// replaces whatever was there
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_remove_handler(uint num, irq_handler_t handler);
+void irq_set_enabled(uint num, bool enabled);
+
+// the peripheral side: run num's handlers now, if it is enabled
+void fake_irq_raise(uint num);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef HOST_HARDWARE_SPI_H
+#define HOST_HARDWARE_SPI_H
+
+// Host stand-in for hardware/spi.h. Writes land in fake_spi.c.
+
+#include "pico/stdlib.h"
+
+#define SPI_SSPICR_RORIC_BITS 0x00000001u
+
+typedef enum { SPI_CPHA_0 = 0, SPI_CPHA_1 = 1 } spi_cpha_t;
+typedef enum { SPI_CPOL_0 = 0, SPI_CPOL_1 = 1 } spi_cpol_t;
+typedef enum { SPI_LSB_FIRST = 0, SPI_MSB_FIRST = 1 } spi_order_t;
+
+// the registers the driver touches directly
+typedef struct {
+    io_rw_32 dr;
+    io_rw_32 icr;
+} spi_hw_t;
+
+typedef struct spi_inst {
+    spi_hw_t hw;
+    int index;
+} spi_inst_t;
+
+extern spi_inst_t spi0_inst;
+extern spi_inst_t spi1_inst;
+
+#define spi0 (&spi0_inst)
+#define spi1 (&spi1_inst)
+
+static inline spi_hw_t *spi_get_hw(spi_inst_t *spi) { return &spi->hw; }
+static inline uint spi_get_dreq(spi_inst_t *spi, bool is_tx) { return 8 + 2 * spi->index + (is_tx ? 0 : 1); }
+static inline bool spi_is_busy(const spi_inst_t *spi) { (void)spi; return false; }
+static inline bool spi_is_readable(const spi_inst_t *spi) { (void)spi; return false; }
+static inline void spi_set_format(spi_inst_t *spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha,
+                                  spi_order_t order) {
+    (void)spi; (void)data_bits; (void)cpol; (void)cpha; (void)order;
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef HOST_HARDWARE_SYNC_H
+#define HOST_HARDWARE_SYNC_H
+
+// Host stand-in for hardware/sync.h: the barrier the seqlocks need and
+// spin locks. Interrupts here are events run from whatever moves the
+// simulated clock, never in the middle of a locked section, so the locks
+// only have to keep count.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+static inline void __dmb(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+typedef volatile uint32_t spin_lock_t;
+
+static inline uint32_t save_and_disable_interrupts(void) { return 0; }
+static inline void restore_interrupts(uint32_t status) { (void)status; }
+
+static inline int spin_lock_claim_unused(bool required) {
+    static int next;
+    (void)required;
+    return next++;
+}
+static inline spin_lock_t *spin_lock_init(unsigned int lock_num) {
+    static spin_lock_t locks[32];
+    locks[lock_num % 32] = 0;
+    return &locks[lock_num % 32];
+}
+static inline uint32_t spin_lock_blocking(spin_lock_t *lock) {
+    (*lock)++;
+    return save_and_disable_interrupts();
+}
+static inline void spin_unlock(spin_lock_t *lock, uint32_t saved) {
+    (*lock)--;
+    restore_interrupts(saved);
+}
+
+#endif
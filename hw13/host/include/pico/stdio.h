@@ -0,0 +1,14 @@
+#ifndef HOST_PICO_STDIO_H
+#define HOST_PICO_STDIO_H
+
+// Host stand-in for pico/stdio.h: drivers can be registered but nothing
+// calls them, the host benchmarks write to the console directly.
+
+#include "pico/stdio/driver.h"
+
+static inline void stdio_set_driver_enabled(stdio_driver_t *driver, bool enabled) {
+    (void)driver;
+    (void)enabled;
+}
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef HOST_PICO_STDIO_DRIVER_H
+#define HOST_PICO_STDIO_DRIVER_H
+
+#include <stdbool.h>
+
+typedef struct stdio_driver stdio_driver_t;
+
+struct stdio_driver {
+    void (*out_chars)(const char *buf, int len);
+    void (*out_flush)(void);
+    int (*in_chars)(char *buf, int len);
+    void (*set_chars_available_callback)(void (*fn)(void *), void *param);
+    stdio_driver_t *next;
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+// Host stand-in for the bits of pico/stdlib.h the display code uses.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef unsigned int uint;
+
+#include "hardware/gpio.h"
+
+typedef volatile uint32_t io_rw_32;
+typedef volatile uint32_t io_ro_32;
+
+// a simulated clock, moved on by the fake buses as they send and by
+// benchmarks by hand (fake_time.c)
+extern uint64_t fake_time_now_us;
+static inline uint64_t time_us_64(void) { return fake_time_now_us; }
+static inline uint32_t time_us_32(void) { return (uint32_t)fake_time_now_us; }
+void fake_time_advance_us(uint64_t us);
+
+// Things that happen on their own, like interrupts: fn(arg) runs when the
+// clock passes t_us, with time_us_64() reading t_us, from inside whatever
+// moved the clock. Background bus transfers and the MPU6050 INT pin use it.
+typedef void (*fake_time_event_t)(void *arg);
+void fake_time_at(uint64_t t_us, fake_time_event_t fn, void *arg);
+void fake_time_cancel_all(void);
+
+static inline void sleep_ms(uint32_t ms) { (void)ms; }
+// a spin loop takes time, so events can come while waiting on them
+static inline void tight_loop_contents(void) { fake_time_advance_us(1); }
+
+// repeating timers are accepted but never fire, benchmarks tick by hand
+typedef struct repeating_timer {
+    void *user_data;
+} repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t *rt);
+
+static inline bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback,
+                                          void *user_data, repeating_timer_t *out) {
+    (void)delay_us;
+    (void)callback;
+    out->user_data = user_data;
+    return true;
+}
+
+#endif
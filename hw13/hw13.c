@@ -3,38 +3,27 @@
 #include <math.h>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "hardware/structs/systick.h"
+#include "pico/multicore.h"
+#include "pico/stdio_usb.h"
 #include "ssd1306.h"
-
-// MPU6050 address
-#define MPU6050_ADDR 0x68
-
-// config registers
-#define CONFIG 0x1A
-#define GYRO_CONFIG 0x1B
-#define ACCEL_CONFIG 0x1C
-#define PWR_MGMT_1 0x6B
-#define PWR_MGMT_2 0x6C
-
-// sensor data registers:
-#define ACCEL_XOUT_H 0x3B
-#define ACCEL_XOUT_L 0x3C
-#define ACCEL_YOUT_H 0x3D
-#define ACCEL_YOUT_L 0x3E
-#define ACCEL_ZOUT_H 0x3F
-#define ACCEL_ZOUT_L 0x40
-#define TEMP_OUT_H   0x41
-#define TEMP_OUT_L   0x42
-#define GYRO_XOUT_H  0x43
-#define GYRO_XOUT_L  0x44
-#define GYRO_YOUT_H  0x45
-#define GYRO_YOUT_L  0x46
-#define GYRO_ZOUT_H  0x47
-#define GYRO_ZOUT_L  0x48
-#define WHO_AM_I     0x75
-
-// Conversion factors
-#define ACCEL_CONVERSION_FACTOR 0.000061f  // Convert to g
-#define GYRO_CONVERSION_FACTOR 0.007630f   // Convert to degrees per second
+#include "gfx.h"
+#include "widget.h"
+#include "stripchart.h"
+#include "console.h"
+#include "gray.h"
+#include "wire3d.h"
+#include "mpu6050.h"
+#include "i2cbus.h"
+#include "mahony.h"
+#include "imucal.h"
+#include "imustream.h"
+#include "spectrum.h"
+#include "bitmap.h"
+#include "fmt.h"
+#include "assets/logo.h"
+#include "assets/spinner.h"
 
 // I2C instance to use
 #define I2C_PORT i2c0
@@ -43,109 +32,321 @@
 #define SDA_PIN 12
 #define SCL_PIN 13
 
+// Sample the IMU into its FIFO at this rate and use every sample, each with
+// its own timestamp, instead of one register read per frame. 0 to poll.
+// The cube integrates every sample, the strip chart plots every one.
+#define IMU_FIFO_HZ 0
+#define IMU_DLPF 3 // CONFIG low pass: 3 is 44 Hz
+
+// Or at this rate on the INT pin: each data-ready edge is timestamped in
+// the GPIO interrupt and the sample read by DMA, so the loop never waits
+// on the IMU. The reads start whenever the edges come, so i2c0 has to be
+// the IMU's alone: needs DISPLAY_SPI or I2C_SCHEDULER. 0 for off.
+#define IMU_DRDY_HZ 0
+#define IMU_INT_PIN 16
+
+// Run the six-position IMU calibration at boot and keep it in flash: put
+// the board still on each face in turn until the display says done. Without
+// it the last saved calibration is loaded, if there is one.
+#define IMU_CALIBRATE 0
+
+// Print every sample over USB as CSV instead of running a demo, for
+// host/bench_ahrs to replay. Needs IMU_FIFO_HZ or IMU_DRDY_HZ.
+#define IMU_TRACE 0
+
+// Or send them raw and packed (imustream.h) for tools/imudecode.py, with
+// sequence numbers and a lost count, at about a quarter of the bytes.
+#define IMU_TRACE_BINARY 0
+
 // Display settings
 #define DISPLAY_WIDTH 128
 #define DISPLAY_HEIGHT 32
-#define DISPLAY_CENTER_X (DISPLAY_WIDTH / 2)
-#define DISPLAY_CENTER_Y (DISPLAY_HEIGHT / 2)
 #define LINE_LENGTH_SCALE 35.0f  // Scale factor for line length
 
-// Function to initialize the I2C and MPU6050
-void init_mpu6050() {
-    // Wake up the MPU6050 (clear sleep bit)
-    uint8_t data[2];
-    data[0] = PWR_MGMT_1;
-    data[1] = 0x00;
-    i2c_write_blocking(I2C_PORT, MPU6050_ADDR, data, 2, false);
-    
-    // Configure accelerometer for ±2g range (0x00 for ACCEL_CONFIG)
-    data[0] = ACCEL_CONFIG;
-    data[1] = 0x00;
-    i2c_write_blocking(I2C_PORT, MPU6050_ADDR, data, 2, false);
-    
-    // Configure gyroscope (default range)
-    data[0] = GYRO_CONFIG;
-    data[1] = 0x00;
-    i2c_write_blocking(I2C_PORT, MPU6050_ADDR, data, 2, false);
+// Plot accel Z as a sweeping strip chart at the full IMU read rate instead
+// of showing the dashboard
+#define STRIP_CHART 0
+
+// Vibration spectrum of the accelerometer as bars, 0 Hz to half the IMU
+// rate, with the biggest peaks on the top line and over USB. Needs
+// IMU_FIFO_HZ or IMU_DRDY_HZ, and IMU_DLPF 1 (184 Hz) or the low pass
+// hides most of the range. 2^SPECTRUM_LOG2 points a block (8 or 9), a new
+// one every half block.
+#define SPECTRUM 0
+#define SPECTRUM_LOG2 8
+#define SPECTRUM_AXIS SPECTRUM_ALL // or 0, 1, 2 for one axis
+
+// Use the display as a printf console instead, for running without USB
+#define OLED_CONSOLE 0
+
+// 4-level grayscale demo with an FPS and bus use readout
+#define GRAYSCALE 0
+
+// Spinning wireframe cube that follows the IMU orientation, with a
+// per-stage timing readout
+#define CUBE_3D 0
+#define ORIENTATION_KP 2.0f // how hard the accelerometer pulls the gyro estimate back
+#define ORIENTATION_KI 0.5f  // how fast the gyro bias is learned, 0 for none
+
+// Run the orientation filter on core1 on every IMU sample, instead of on
+// core0 between frames. Core1 owns the IMU then, so it needs IMU_FIFO_HZ or
+// IMU_DRDY_HZ and i2c0 to itself (DISPLAY_SPI) or shared (I2C_SCHEDULER).
+// The cube and the dashboard take the latest estimate from a seqlock
+// snapshot.
+#define ORIENTATION_CORE1 0
+
+// Play the spinner animation from flash as fast as the bus takes it, with
+// an fps and bytes per frame readout
+#define ANIMATION 0
+
+// Optional second display on i2c1, refreshed alongside the first one
+#define SECOND_DISPLAY 0
+#define DISPLAY2_WIDTH 128
+#define DISPLAY2_HEIGHT 64
+#define DISPLAY2_I2C_PORT i2c1
+#define DISPLAY2_SDA_PIN 14
+#define DISPLAY2_SCL_PIN 15
+
+// Share i2c0 through the bus scheduler (i2cbus.h): display frames go out
+// I2C_PIECE bytes at a time and IMU reads slip in between the pieces, so a
+// read waits for one piece at most. A 16 byte piece plus a 14 byte read fit
+// in 1 ms at 400 kHz, a whole 128 byte page takes 3 ms on its own.
+#define I2C_SCHEDULER 0
+#define I2C_PIECE 16
+
+// Display on 4-wire SPI instead of sharing i2c0 with the IMU: a full frame
+// takes under 1 ms at 10 MHz instead of about 12 ms
+#define DISPLAY_SPI 0
+#define DISPLAY_SPI_PORT spi0
+#define DISPLAY_SCK_PIN 18
+#define DISPLAY_MOSI_PIN 19
+#define DISPLAY_CS_PIN 17
+#define DISPLAY_DC_PIN 20
+#define DISPLAY_RST_PIN 21
+
+#if DISPLAY_SPI
+SSD1306_DEFINE_SPI(oled, DISPLAY_WIDTH, DISPLAY_HEIGHT, DISPLAY_SPI_PORT, DISPLAY_DC_PIN, DISPLAY_CS_PIN, DISPLAY_RST_PIN);
+#elif I2C_SCHEDULER
+static i2cbus_t bus0;
+SSD1306_DEFINE_BUS(oled, DISPLAY_WIDTH, DISPLAY_HEIGHT, &bus0, SSD1306_DEFAULT_ADDRESS);
+#else
+SSD1306_DEFINE(oled, DISPLAY_WIDTH, DISPLAY_HEIGHT, I2C_PORT, SSD1306_DEFAULT_ADDRESS);
+#endif
+#if SECOND_DISPLAY
+SSD1306_DEFINE(oled2, DISPLAY2_WIDTH, DISPLAY2_HEIGHT, DISPLAY2_I2C_PORT, SSD1306_DEFAULT_ADDRESS);
+#endif
+
+#if IMU_DRDY_HZ && IMU_FIFO_HZ
+#error "IMU_FIFO_HZ and IMU_DRDY_HZ are two ways of doing the same thing, pick one"
+#endif
+#if DISPLAY_SPI && I2C_SCHEDULER
+#error "I2C_SCHEDULER is for the display sharing i2c0, not for DISPLAY_SPI"
+#endif
+#if IMU_DRDY_HZ && !(DISPLAY_SPI || I2C_SCHEDULER)
+#error "IMU_DRDY_HZ reads i2c0 from interrupts, move the display to SPI (DISPLAY_SPI) or share the bus (I2C_SCHEDULER)"
+#endif
+#define IMU_STREAM (IMU_FIFO_HZ || IMU_DRDY_HZ)
+#if IMU_STREAM && (OLED_CONSOLE || GRAYSCALE)
+#error "the console and grayscale demos poll the IMU with mpu6050_read(), leave IMU_FIFO_HZ and IMU_DRDY_HZ at 0"
+#endif
+#if ORIENTATION_CORE1 && !(IMU_STREAM && (DISPLAY_SPI || I2C_SCHEDULER))
+#error "ORIENTATION_CORE1 gives core1 the IMU: set IMU_FIFO_HZ or IMU_DRDY_HZ, and DISPLAY_SPI or I2C_SCHEDULER"
+#endif
+#if IMU_TRACE && (!IMU_STREAM || ORIENTATION_CORE1)
+#error "IMU_TRACE needs IMU_FIFO_HZ or IMU_DRDY_HZ, and the samples on core0"
+#endif
+#if IMU_TRACE_BINARY && (!IMU_STREAM || ORIENTATION_CORE1 || IMU_TRACE)
+#error "IMU_TRACE_BINARY needs IMU_FIFO_HZ or IMU_DRDY_HZ and the samples on core0, and replaces IMU_TRACE"
+#endif
+#if ORIENTATION_CORE1 && (OLED_CONSOLE || GRAYSCALE || STRIP_CHART || SPECTRUM)
+#error "the console, grayscale, strip chart and spectrum demos read the IMU themselves, not with ORIENTATION_CORE1"
+#endif
+#if SPECTRUM && !IMU_STREAM
+#error "SPECTRUM needs every sample: set IMU_FIFO_HZ or IMU_DRDY_HZ"
+#endif
+
+static mpu6050_t imu;
+#if IMU_STREAM
+#define IMU_SAMPLES_MAX (MPU6050_FIFO_SIZE / MPU6050_FIFO_SAMPLE)
+static mpu6050_sample_t imu_samples[IMU_SAMPLES_MAX];
+#endif
+#if IMU_DRDY_HZ
+static mpu6050_drdy_t imu_drdy;
+#endif
+
+#if IMU_STREAM
+// the samples taken since the last call, from the FIFO or the data-ready ring
+static int imu_stream_read(void) {
+#if IMU_FIFO_HZ
+    return mpu6050_fifo_read(&imu, imu_samples, IMU_SAMPLES_MAX);
+#else
+    return mpu6050_drdy_read(&imu_drdy, imu_samples, IMU_SAMPLES_MAX);
+#endif
 }
 
-// Function to read all sensor data at once for more efficiency
-void read_mpu6050_data(float *accel, float *gyro, float *temp) {
-    uint8_t buffer[14];
-    uint8_t reg = ACCEL_XOUT_H;
-    
-    // Request 14 bytes starting from ACCEL_XOUT_H (0x3B)
-    i2c_write_blocking(I2C_PORT, MPU6050_ADDR, &reg, 1, true);
-    i2c_read_blocking(I2C_PORT, MPU6050_ADDR, buffer, 14, false);
-    
-    // Combine high and low bytes and convert to physical units
-    int16_t raw_accel_x = (int16_t)(buffer[0] << 8 | buffer[1]);
-    int16_t raw_accel_y = (int16_t)(buffer[2] << 8 | buffer[3]);
-    int16_t raw_accel_z = (int16_t)(buffer[4] << 8 | buffer[5]);
-    
-    int16_t raw_temp = (int16_t)(buffer[6] << 8 | buffer[7]);
-    
-    int16_t raw_gyro_x = (int16_t)(buffer[8] << 8 | buffer[9]);
-    int16_t raw_gyro_y = (int16_t)(buffer[10] << 8 | buffer[11]);
-    int16_t raw_gyro_z = (int16_t)(buffer[12] << 8 | buffer[13]);
-    
-    // Convert to physical units
-    accel[0] = raw_accel_x * ACCEL_CONVERSION_FACTOR;  // X acceleration in g
-    accel[1] = raw_accel_y * ACCEL_CONVERSION_FACTOR;  // Y acceleration in g
-    accel[2] = raw_accel_z * ACCEL_CONVERSION_FACTOR;  // Z acceleration in g
-    
-    gyro[0] = raw_gyro_x * GYRO_CONVERSION_FACTOR;   // X rotation in deg/s
-    gyro[1] = raw_gyro_y * GYRO_CONVERSION_FACTOR;   // Y rotation in deg/s
-    gyro[2] = raw_gyro_z * GYRO_CONVERSION_FACTOR;   // Z rotation in deg/s
-    
-    *temp = raw_temp / 340.0f + 36.53f;  // Temperature in degrees C
+// samples the driver dropped so far
+static uint32_t imu_stream_lost(void) {
+#if IMU_FIFO_HZ
+    return imu.lost;
+#else
+    return mpu6050_drdy_missed(&imu_drdy);
+#endif
 }
+#endif
 
-// Function to draw a line using Bresenham's algorithm
-void draw_line(int x0, int y0, int x1, int y1) {
-    int dx = abs(x1 - x0);
-    int sx = x0 < x1 ? 1 : -1;
-    int dy = -abs(y1 - y0);
-    int sy = y0 < y1 ? 1 : -1;
-    int err = dx + dy;
-    int e2;
-    
+#if IMU_TRACE_BINARY
+// straight to the USB driver, printf would turn every 0x0A into CR LF
+static void usb_write(const uint8_t *bytes, size_t len) {
+    stdio_usb.out_chars((const char *)bytes, (int)len);
+}
+#endif
+
+#if ORIENTATION_CORE1
+static mahony_shared_t attitude;
+
+// Core1 starts the sampling, so the data-ready interrupts land on it too,
+// then filters every sample and publishes each estimate. SysTick (per
+// core, counting down on the processor clock) times each update.
+static void core1_orientation(void) {
+#if IMU_FIFO_HZ
+    mpu6050_fifo_start(&imu, IMU_FIFO_HZ, IMU_DLPF);
+#else
+    mpu6050_drdy_start(&imu_drdy, &imu, IMU_INT_PIN, IMU_DRDY_HZ, IMU_DLPF);
+#endif
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5; // enable, processor clock
+
+    mahony_t filter;
+    mahony_init(&filter, ORIENTATION_KP, ORIENTATION_KI);
+    mahony_state_t state = { 0 };
+    float dt = imu.period_us * 1e-6f;
     while (1) {
-        ssd1306_drawPixel(x0, y0, 1);
-        if (x0 == x1 && y0 == y1) break;
-        e2 = 2 * err;
-        if (e2 >= dy) {
-            if (x0 == x1) break;
-            err += dy;
-            x0 += sx;
-        }
-        if (e2 <= dx) {
-            if (y0 == y1) break;
-            err += dx;
-            y0 += sy;
+        int n = imu_stream_read();
+        for (int i = 0; i < n; i++) {
+            uint32_t c0 = systick_hw->cvr;
+            mahony_update(&filter, imu_samples[i].accel, imu_samples[i].gyro, dt);
+            uint32_t cycles = (c0 - systick_hw->cvr) & 0x00FFFFFF;
+
+            for (int k = 0; k < 4; k++) {
+                state.q[k] = filter.q[k];
+            }
+            mahony_euler(filter.q, &state.roll, &state.pitch, &state.yaw);
+            state.t_us = imu_samples[i].t_us;
+            state.updates++;
+            state.cycles_last = cycles;
+            if (cycles > state.cycles_max) state.cycles_max = cycles;
+            mahony_publish(&attitude, &state);
         }
     }
 }
+#endif
 
-// Function to verify MPU6050 connection
-bool check_mpu6050() {
-    uint8_t who_am_i_reg = WHO_AM_I;
-    uint8_t data;
-    
-    i2c_write_blocking(I2C_PORT, MPU6050_ADDR, &who_am_i_reg, 1, true);
-    i2c_read_blocking(I2C_PORT, MPU6050_ADDR, &data, 1, false);
-    
-    return (data == MPU6050_ADDR);
+// Draw the crosshair and the accelerometer X/Y vector from the screen center
+void draw_accel_vector(ssd1306_t *d, const float *accel) {
+    int center_x = d->width / 2;
+    int center_y = d->height / 2;
+
+    // Draw a crosshair at the center (optional)
+    gfx_hline(d, center_x-1, center_x+1, center_y, 1);
+    gfx_vline(d, center_x, center_y-1, center_y+1, 1);
+
+    // Calculate line end point
+    // Note: The X and Y mapping might need to be adjusted depending on the orientation
+    // of your IMU and display. We may need to invert or swap X,Y depending on your setup.
+    // The negative sign for Y is because positive Y on the display is downward.
+    float magnitude = sqrtf(accel[0]*accel[0] + accel[1]*accel[1]);
+
+    // Only draw the line if there's significant acceleration
+    if (magnitude > 0.05f) {
+        // Normalize and scale
+        float scale = (magnitude > 1.0f) ? 1.0f : magnitude;
+        scale *= LINE_LENGTH_SCALE;
+
+        // Map accelerometer X and Y to display coordinates
+        // Note: We may need to adjust these mappings based on your hardware orientation
+        int line_end_x = center_x - (int)(accel[0] * scale);
+        int line_end_y = center_y + (int)(accel[1] * scale);
+
+        // Draw the line, gfx_line clips it to the screen
+        gfx_line(d, center_x, center_y, line_end_x, line_end_y, 1);
+    }
 }
 
+#if IMU_CALIBRATE
+// polled at about 200 Hz, the faces still to do and the window's progress
+// on the display
+static void calibrate_imu(ssd1306_t *d) {
+    imucal_t c;
+    imucal_begin(&c);
+    printf("IMU calibration: hold the board still on each face in turn\n");
+    uint32_t polls = 0;
+    while (!imucal_complete(&c)) {
+        int16_t accel[3], gyro[3];
+        mpu6050_read_raw(&imu, accel, gyro);
+        int face = imucal_feed(&c, accel, gyro);
+        if (face >= 0) {
+            printf("  %s done\n", imucal_face_name(face));
+        }
+        if (polls++ % 20 == 0 || face >= 0) {
+            char line[24];
+            fmt_t f;
+            ssd1306_clear(d);
+            gfx_string(d, 0, 0, "IMU calibration");
+            fmt_begin(&f, line, sizeof(line));
+            fmt_str(&f, "do:"); // all six just fit in 21 columns
+            for (int i = 0; i < IMUCAL_FACES; i++) {
+                if (!(c.done & (1u << i))) {
+                    fmt_str(&f, imucal_face_name(i));
+                    fmt_char(&f, ' ');
+                }
+            }
+            gfx_string(d, 0, 8, line);
+            fmt_begin(&f, line, sizeof(line));
+            if (c.face < 0 || (c.done & (1u << c.face))) {
+                fmt_str(&f, "turn to a new face");
+            } else {
+                fmt_str(&f, imucal_face_name(c.face));
+                fmt_char(&f, ' ');
+                fmt_uint(&f, c.n * 100 / IMUCAL_WINDOW, 0);
+                fmt_str(&f, "% hold still");
+            }
+            gfx_string(d, 0, 16, line);
+            ssd1306_update(d);
+        }
+        sleep_ms(5);
+    }
+
+    mpu6050_cal_t cal;
+    ssd1306_clear(d);
+    if (!imucal_result(&c, &cal)) {
+        printf("IMU calibration out of range, not saved\n");
+        gfx_string(d, 0, 0, "calibration failed");
+    } else {
+        for (int i = 0; i < 3; i++) {
+            printf("  %c: accel offset %d scale %d/%d, gyro offset %d\n", 'X' + i, cal.accel_offset[i],
+                   cal.accel_scale[i], MPU6050_CAL_ONE, cal.gyro_offset[i]);
+        }
+        bool saved = imucal_save(&cal);
+        printf(saved ? "IMU calibration saved\n" : "IMU calibration didn't save\n");
+        gfx_string(d, 0, 0, saved ? "calibration saved" : "flash write failed");
+        imu.cal = cal;
+    }
+    ssd1306_update(d);
+    sleep_ms(2000);
+}
+#endif
+
 int main() {
     // Initialize stdio with USB
     stdio_init_all();
 
+#if !OLED_CONSOLE
     // Wait for USB connection
     while (!stdio_usb_connected()) {
         sleep_ms(100);
     }
+#endif
     printf("USB connected. Starting program...\n");
 
     // Initialize I2C for both MPU6050 and SSD1306
@@ -158,10 +359,17 @@ int main() {
     gpio_pull_up(SCL_PIN);
     
     // Initialize MPU6050
-    init_mpu6050();
+#if I2C_SCHEDULER
+    // everything on i2c0 goes through the scheduler from here on, the
+    // display is added to it by ssd1306_setup()
+    i2cbus_init(&bus0, I2C_PORT, 400 * 1000, I2C_PIECE);
+    mpu6050_init_bus(&imu, &bus0, MPU6050_ADDR);
+#else
+    mpu6050_init(&imu, I2C_PORT, MPU6050_ADDR);
+#endif
     
     // Verify MPU6050 connection
-    if (!check_mpu6050()) {
+    if (!mpu6050_check(&imu)) {
         printf("ERROR: MPU6050 not found!\n");
         while (1) {
             sleep_ms(500);
@@ -169,20 +377,43 @@ int main() {
     }
     
     printf("MPU6050 initialized successfully.\n");
+    if (imucal_load(&imu.cal)) {
+        printf("IMU calibration loaded from flash.\n");
+    } else {
+        printf("No IMU calibration in flash, readings are uncorrected.\n");
+    }
     
     // Initialize OLED display
-    ssd1306_setup();
+#if DISPLAY_SPI
+    spi_init(DISPLAY_SPI_PORT, 10 * 1000 * 1000);
+    gpio_set_function(DISPLAY_SCK_PIN, GPIO_FUNC_SPI);
+    gpio_set_function(DISPLAY_MOSI_PIN, GPIO_FUNC_SPI);
+#endif
+    ssd1306_setup(&oled);
     printf("SSD1306 initialized.\n");
+#if SECOND_DISPLAY
+    i2c_init(DISPLAY2_I2C_PORT, 400 * 1000);
+    gpio_set_function(DISPLAY2_SDA_PIN, GPIO_FUNC_I2C);
+    gpio_set_function(DISPLAY2_SCL_PIN, GPIO_FUNC_I2C);
+    gpio_pull_up(DISPLAY2_SDA_PIN);
+    gpio_pull_up(DISPLAY2_SCL_PIN);
+    ssd1306_setup(&oled2);
+    printf("Second SSD1306 initialized.\n");
+#endif
+#if IMU_CALIBRATE
+    // before core1 starts, the flash write needs it out of the way
+    calibrate_imu(&oled);
+#endif
     
     // Variables to store sensor data
-    float accel[3], gyro[3], temp;
-    
-    // Variables for line drawing
-    int line_end_x, line_end_y;
+    float accel[3] = { 0 }, gyro[3] = { 0 }, temp;
+    (void)gyro; // not every mode uses these
+    (void)temp;
     
-    // Print a startup message
-    ssd1306_clear();
-    ssd1306_update();
+    // Show the logo from flash while things settle
+    ssd1306_clear(&oled);
+    bitmap_draw(&oled, logo_blob, 0, 0);
+    ssd1306_update(&oled);
     sleep_ms(2000);
     
     // Frame rate tracking
@@ -190,52 +421,380 @@ int main() {
     uint32_t t_start = to_ms_since_boot(get_absolute_time());
     uint32_t t_last_fps = t_start;
     float fps = 0.0f;
+
+#if ORIENTATION_CORE1
+    // from here on core0 doesn't touch the IMU
+    multicore_launch_core1(core1_orientation);
+    printf("orientation filter on core1\n");
+#elif IMU_FIFO_HZ
+    // started after the splash so the FIFO doesn't overflow during it
+    mpu6050_fifo_start(&imu, IMU_FIFO_HZ, IMU_DLPF);
+    printf("IMU FIFO at %u Hz\n", imu.rate_hz);
+#elif IMU_DRDY_HZ
+    mpu6050_drdy_start(&imu_drdy, &imu, IMU_INT_PIN, IMU_DRDY_HZ, IMU_DLPF);
+    printf("IMU data-ready on GPIO %d at %u Hz\n", IMU_INT_PIN, imu.rate_hz);
+#endif
+
+#if IMU_TRACE
+    // t_us, accel g, gyro deg/s. About 60 bytes a sample, USB keeps up at 1 kHz.
+    puts("t_us,ax,ay,az,gx,gy,gz");
+    while (1) {
+        int n = imu_stream_read();
+        for (int i = 0; i < n; i++) {
+            char line[80];
+            fmt_t f;
+            fmt_begin(&f, line, sizeof(line));
+            fmt_uint(&f, (uint32_t)imu_samples[i].t_us, 0);
+            for (int k = 0; k < 3; k++) {
+                fmt_char(&f, ',');
+                fmt_float(&f, imu_samples[i].accel[k], 4, 0);
+            }
+            for (int k = 0; k < 3; k++) {
+                fmt_char(&f, ',');
+                fmt_float(&f, imu_samples[i].gyro[k], 3, 0);
+            }
+            puts(line);
+        }
+    }
+#endif
+
+#if IMU_TRACE_BINARY
+    // about 16 bytes a sample, a packet every 16 samples or 20 ms
+    imustream_t stream;
+    imustream_begin(&stream, usb_write, imu.rate_hz, &imu.cal);
+    while (1) {
+        int n = imu_stream_read();
+        uint32_t lost = imu_stream_lost();
+        for (int i = 0; i < n; i++) {
+            imustream_add(&stream, &imu_samples[i], lost);
+        }
+        imustream_poll(&stream, time_us_64());
+    }
+#endif
+
+#if OLED_CONSOLE
+    // printf goes to the display too. The writes only queue, console_task()
+    // sends a couple of lines at most every CONSOLE_PERIOD_MS.
+    console_init(&oled);
+    console_stdio_enable(true);
+    while (1) {
+        mpu6050_read(&imu, accel, gyro, &temp);
+        char line[24];
+        fmt_t f;
+        fmt_begin(&f, line, sizeof(line));
+        for (int i = 0; i < 3; i++) {
+            fmt_str(&f, i ? " " : "");
+            fmt_char(&f, "XYZ"[i]);
+            if (accel[i] >= 0) fmt_char(&f, '+');
+            fmt_float(&f, accel[i], 2, 0);
+        }
+        puts(line);
+        console_task(to_ms_since_boot(get_absolute_time()));
+    }
+#endif
+
+#if GRAYSCALE
+    // Slots come from a timer, the bus work is done here between IMU reads.
+    // The scene is redrawn 10 times a second, once the last one is out.
+    static gray_t gray;
+    gray_init(&gray, &oled);
+    gray_start(&gray, GRAY_SLOT_HZ);
+    gray_stats_t gray_last = gray.stats;
+    uint32_t t_gray = to_ms_since_boot(get_absolute_time());
+    uint32_t t_scene = t_gray;
+    char gray_msg[22] = "";
+    while (1) {
+        mpu6050_read(&imu, accel, gyro, &temp);
+        gray_task(&gray);
+
+        uint32_t t_now = to_ms_since_boot(get_absolute_time());
+        if (t_now - t_gray >= 1000) {
+            uint32_t bytes = gray.stats.bytes - gray_last.bytes;
+            uint32_t transactions = gray.stats.transactions - gray_last.transactions;
+#if DISPLAY_SPI
+            // wire time: 8 clocks per byte, and the control byte each
+            // transaction starts with is the DC pin instead
+            uint32_t bus_us = (uint64_t)(bytes - transactions) * 8 * 1000000 / spi_get_baudrate(DISPLAY_SPI_PORT);
+#else
+            // wire time: 9 clocks per byte, about 11 per start/address/stop
+            uint32_t bus_us = (uint64_t)(bytes * 9 + transactions * 11) * 1000000 / (400 * 1000);
+#endif
+            uint32_t fps = (gray.stats.slots - gray_last.slots) * 1000 / GRAY_SLOTS / (t_now - t_gray);
+            uint32_t bus_pct = bus_us / (10 * (t_now - t_gray));
+            fmt_t f;
+            fmt_begin(&f, gray_msg, sizeof(gray_msg));
+            fmt_uint(&f, fps, 0);
+            fmt_str(&f, "fps bus");
+            fmt_uint(&f, bus_pct, 0);
+            fmt_str(&f, "% miss");
+            fmt_uint(&f, gray.stats.missed - gray_last.missed, 0);
+            fputs("gray: ", stdout);
+            puts(gray_msg);
+            gray_last = gray.stats;
+            t_gray = t_now;
+        }
+
+        if (t_now - t_scene >= 100 && !gray_uploading(&gray)) {
+            t_scene = t_now;
+            int bar = oled.width / 4;
+            for (int level = 0; level < 4; level++) {
+                gray_fill_rect(&gray, level * bar, 8, bar, oled.height - 8, level);
+            }
+            // a bright dot where the tilt points, dark ring around it
+            int bx = oled.width / 2 - (int)(accel[0] * LINE_LENGTH_SCALE);
+            int by = 8 + (oled.height - 8) / 2 + (int)(accel[1] * LINE_LENGTH_SCALE / 2);
+            gray_fill_rect(&gray, bx - 3, by - 3, 7, 7, 0);
+            gray_fill_rect(&gray, bx - 2, by - 2, 5, 5, 3);
+            int end = gray_string(&gray, 0, 0, gray_msg, 3);
+            gray_fill_rect(&gray, end, 0, oled.width - end, 8, 0);
+            gray_present(&gray);
+        }
+    }
+#endif
+
+#if CUBE_3D
+    // The cube lives in a square on the left, timings go on the right. Only
+    // the box the cube covered last frame and this frame is cleared and sent.
+#if !ORIENTATION_CORE1
+    mahony_t filter;
+    mahony_init(&filter, ORIENTATION_KP, ORIENTATION_KI);
+#endif
+    wire3d_rot_t rot;
+    int16_t points[WIRE3D_MAX_VERTS][2];
+    wire3d_box_t prev = { 0, 0, -1, -1 };
+    int side = oled.height;
+    uint32_t us_imu = 0, us_math = 0, us_raster = 0, us_flush = 0, frames3d = 0;
+    uint32_t t_prev = time_us_32();
+    uint32_t t_report = t_prev;
+    ssd1306_clear(&oled);
+    ssd1306_update(&oled);
+    while (1) {
+        uint32_t t0 = time_us_32();
+#if ORIENTATION_CORE1
+        // core1 has filtered every sample, take its latest estimate
+        mahony_state_t att;
+        mahony_snapshot(&attitude, &att);
+        uint32_t t1 = time_us_32();
+        const float *q = att.q;
+        (void)t_prev;
+#elif IMU_STREAM
+        // every sample, spaced by the sample period rather than the frame time
+        int n = imu_stream_read();
+        uint32_t t1 = time_us_32();
+        for (int i = 0; i < n; i++) {
+            mahony_update(&filter, imu_samples[i].accel, imu_samples[i].gyro, imu.period_us * 1e-6f);
+        }
+        const float *q = filter.q;
+        (void)t_prev;
+#else
+        mpu6050_read(&imu, accel, gyro, &temp);
+        uint32_t t1 = time_us_32();
+        mahony_update(&filter, accel, gyro, (t1 - t_prev) * 1e-6f);
+        t_prev = t1;
+        const float *q = filter.q;
+#endif
+        wire3d_rot_from_quat(&rot, q);
+        wire3d_box_t box = wire3d_project(&wire3d_cube, &rot, side / 2, oled.height / 2, side * 3 / 8, points);
+        uint32_t t2 = time_us_32();
+        if (prev.x1 >= prev.x0) {
+            int w = prev.x1 - prev.x0 + 1, h = prev.y1 - prev.y0 + 1;
+            gfx_fill_rect(&oled, prev.x0, prev.y0, w, h, 0);
+            ssd1306_mark_dirty(&oled, prev.x0, prev.y0, w, h);
+        }
+        wire3d_draw(&oled, &wire3d_cube, (const int16_t (*)[2])points);
+        ssd1306_mark_dirty(&oled, box.x0, box.y0, box.x1 - box.x0 + 1, box.y1 - box.y0 + 1);
+        prev = box;
+        uint32_t t3 = time_us_32();
+        ssd1306_update_dirty(&oled);
+        uint32_t t4 = time_us_32();
+
+        us_imu += t1 - t0;
+        us_math += t2 - t1;
+        us_raster += t3 - t2;
+        us_flush += t4 - t3;
+        frames3d++;
+        if (t4 - t_report >= 1000000) {
+            // average microseconds per frame for each stage
+            char line[4][24];
+            fmt_t f;
+            fmt_begin(&f, line[0], sizeof(line[0]));
+            fmt_str(&f, "fps ");
+            fmt_uint(&f, frames3d, 0);
+            fmt_begin(&f, line[1], sizeof(line[1]));
+#if ORIENTATION_CORE1
+            // what one filter update costs core1
+            fmt_str(&f, "ahrs ");
+            fmt_uint(&f, att.cycles_last, 0);
+            fmt_str(&f, "cyc");
+#else
+            fmt_str(&f, "imu ");
+            fmt_uint(&f, us_imu / frames3d, 0);
+            fmt_str(&f, "us");
+#endif
+            fmt_begin(&f, line[2], sizeof(line[2]));
+            fmt_str(&f, "3d ");
+            fmt_uint(&f, us_math / frames3d, 0);
+            fmt_char(&f, '+');
+            fmt_uint(&f, us_raster / frames3d, 0);
+            fmt_str(&f, "us");
+            fmt_begin(&f, line[3], sizeof(line[3]));
+            fmt_str(&f, "tx ");
+            fmt_uint(&f, us_flush / frames3d, 0);
+            fmt_str(&f, "us");
+            int x = side + 4;
+            for (int i = 0; i < 4 && i * 8 < oled.height; i++) {
+                int end = gfx_string(&oled, x, i * 8, line[i]);
+                gfx_fill_rect(&oled, end, i * 8, oled.width - end, 8, 0);
+            }
+            ssd1306_mark_dirty(&oled, x, 0, oled.width - x, 32);
+            for (int i = 0; i < 4; i++) {
+                fputs(line[i], stdout);
+                fputs(i < 3 ? ", " : "\n", stdout);
+            }
+            us_imu = us_math = us_raster = us_flush = frames3d = 0;
+            t_report = t4;
+        }
+    }
+#endif
+
+#if ANIMATION
+    // Only the columns a frame changed are decoded and sent. The readout is
+    // redrawn once a second, which costs one frame's worth of bus time.
+    anim_t spin;
+    ssd1306_clear(&oled);
+    anim_init(&spin, &oled, spinner_blob, oled.width - bitmap_width(spinner_blob), 0, 0);
+    ssd1306_update(&oled);
+    uint32_t anim_frames = 0, anim_bytes = 0;
+    uint32_t t_anim = to_ms_since_boot(get_absolute_time());
+    while (1) {
+        uint32_t t_now = to_ms_since_boot(get_absolute_time());
+        if (anim_task(&spin, t_now)) {
+            anim_frames++;
+            // 7 window bytes and a control byte per dirty page
+            for (int p = 0; p < oled.pages; p++) {
+                if (oled.dirty_pages & (1u << p)) {
+                    anim_bytes += 8 + oled.dirty_x1[p] - oled.dirty_x0[p] + 1;
+                }
+            }
+            ssd1306_update_dirty(&oled);
+        }
+        if (t_now - t_anim >= 1000) {
+            char line[2][16];
+            fmt_t f;
+            fmt_begin(&f, line[0], sizeof(line[0]));
+            fmt_str(&f, "fps ");
+            fmt_uint(&f, anim_frames, 0);
+            fmt_begin(&f, line[1], sizeof(line[1]));
+            fmt_uint(&f, anim_frames ? anim_bytes / anim_frames : 0, 0);
+            fmt_str(&f, "B/frame");
+            for (int i = 0; i < 2; i++) {
+                int end = gfx_string(&oled, 0, i * 8, line[i]);
+                gfx_fill_rect(&oled, end, i * 8, spin.x - end, 8, 0);
+            }
+            ssd1306_mark_dirty(&oled, 0, 0, spin.x, 16);
+            fputs("anim: ", stdout);
+            fputs(line[0], stdout);
+            fputs(" ", stdout);
+            puts(line[1]);
+            anim_frames = anim_bytes = 0;
+            t_anim = t_now;
+        }
+    }
+#endif
+
+#if STRIP_CHART
+    // one column per sample, hundredths of a g over +-2 g
+    stripchart_t chart;
+    stripchart_init(&chart, &oled, 0, oled.width, 0, oled.pages, -200, 200);
+    ssd1306_update_dirty(&oled);
+    while (1) {
+#if IMU_STREAM
+        int n = imu_stream_read();
+        for (int i = 0; i < n; i++) {
+            stripchart_push(&chart, (int32_t)(imu_samples[i].accel[2] * 100));
+        }
+#else
+        mpu6050_read(&imu, accel, gyro, &temp);
+        stripchart_push(&chart, (int32_t)(accel[2] * 100));
+#endif
+    }
+#endif
+
+#if SPECTRUM
+    // the FFTs run in spectrum_add() on the sample that fills a block,
+    // the FIFO keeps sampling meanwhile
+    static spectrum_t spectrum;
+    spectrum_init(&spectrum, SPECTRUM_LOG2, imu.rate_hz, SPECTRUM_AXIS);
+    ssd1306_clear(&oled);
+    ssd1306_update(&oled);
+    while (1) {
+        int n = imu_stream_read();
+        for (int i = 0; i < n; i++) {
+            if (!spectrum_add(&spectrum, imu_samples[i].raw)) {
+                continue;
+            }
+            spectrum_draw(&spectrum, &oled, 0, 8, oled.width, oled.height - 8);
+
+            // the peaks, biggest first: Hz and mg
+            char line[64];
+            fmt_t f;
+            fmt_begin(&f, line, sizeof(line));
+            for (int k = 0; k < spectrum.peaks; k++) {
+                fmt_str(&f, k ? "  " : "");
+                fmt_float(&f, spectrum.peak[k].hz, 1, 0);
+                fmt_str(&f, "Hz ");
+                fmt_float(&f, spectrum.peak[k].g * 1000, 1, 0);
+                fmt_str(&f, "mg");
+            }
+            puts(spectrum.peaks ? line : "no peaks");
+
+            // the biggest on the top line
+            gfx_fill_rect(&oled, 0, 0, oled.width, 8, 0);
+            if (spectrum.peaks) {
+                fmt_begin(&f, line, sizeof(line));
+                fmt_float(&f, spectrum.peak[0].hz, 1, 0);
+                fmt_str(&f, "Hz ");
+                fmt_uint(&f, (uint32_t)lrintf(spectrum.peak[0].g * 1000), 0);
+                fmt_str(&f, "mg");
+                gfx_string(&oled, 0, 0, line);
+            }
+            ssd1306_mark_dirty(&oled, 0, 0, oled.width, 8);
+            ssd1306_update_dirty(&oled);
+        }
+    }
+#endif
+
+    // Dashboard, values in hundredths of a g. Only widgets whose value
+    // changed are redrawn and sent, so a steady board costs almost no bus time.
+    enum { W_VECTOR, W_X, W_Y, W_FPS, W_ZLABEL, W_Z, W_COUNT };
+    widget_t dash[W_COUNT];
+    widget_crosshair(&dash[W_VECTOR], 0, 0, 64, 32, 100);
+    widget_number(&dash[W_X], 66, 0, 10, 2, "X:");
+    widget_number(&dash[W_Y], 66, 8, 10, 2, "Y:");
+    widget_number(&dash[W_FPS], 66, 16, 10, 1, "FPS:");
+    widget_label(&dash[W_ZLABEL], 66, 24, 1, "Z");
+    widget_bar(&dash[W_Z], 74, 25, 54, 6, -100, 100);
     
     // Main loop
     while (1) {
         // Read IMU data
-        read_mpu6050_data(accel, gyro, &temp);
-        
-        // Clear the display
-        ssd1306_clear();
-        
-        // Draw a crosshair at the center (optional)
-        ssd1306_drawPixel(DISPLAY_CENTER_X, DISPLAY_CENTER_Y, 1);
-        ssd1306_drawPixel(DISPLAY_CENTER_X-1, DISPLAY_CENTER_Y, 1);
-        ssd1306_drawPixel(DISPLAY_CENTER_X+1, DISPLAY_CENTER_Y, 1);
-        ssd1306_drawPixel(DISPLAY_CENTER_X, DISPLAY_CENTER_Y-1, 1);
-        ssd1306_drawPixel(DISPLAY_CENTER_X, DISPLAY_CENTER_Y+1, 1);
-        
-        // Calculate line end point
-        // Note: The X and Y mapping might need to be adjusted depending on the orientation
-        // of your IMU and display. We may need to invert or swap X,Y depending on your setup.
-        // The negative sign for Y is because positive Y on the display is downward.
-        float magnitude = sqrtf(accel[0]*accel[0] + accel[1]*accel[1]);
-        
-        // Only draw the line if there's significant acceleration
-        if (magnitude > 0.05f) {
-            // Normalize and scale
-            float scale = (magnitude > 1.0f) ? 1.0f : magnitude;
-            scale *= LINE_LENGTH_SCALE;
-            
-            // Map accelerometer X and Y to display coordinates
-            // Note: We may need to adjust these mappings based on your hardware orientation
-            line_end_x = DISPLAY_CENTER_X - (int)(accel[0] * scale);
-            line_end_y = DISPLAY_CENTER_Y + (int)(accel[1] * scale);
-            
-            // Ensure line_end coordinates are within display bounds
-            if (line_end_x < 0) line_end_x = 0;
-            if (line_end_x >= DISPLAY_WIDTH) line_end_x = DISPLAY_WIDTH - 1;
-            if (line_end_y < 0) line_end_y = 0;
-            if (line_end_y >= DISPLAY_HEIGHT) line_end_y = DISPLAY_HEIGHT - 1;
-            
-            // Draw the line
-            draw_line(DISPLAY_CENTER_X, DISPLAY_CENTER_Y, line_end_x, line_end_y);
+#if ORIENTATION_CORE1
+        // the filtered down vector stands in for the raw accel
+        mahony_state_t att;
+        mahony_snapshot(&attitude, &att);
+        mahony_gravity(att.q, accel);
+#elif IMU_STREAM
+        // the dashboard only shows the newest sample
+        int n = imu_stream_read();
+        if (n > 0) {
+            for (int i = 0; i < 3; i++) {
+                accel[i] = imu_samples[n - 1].accel[i];
+                gyro[i] = imu_samples[n - 1].gyro[i];
+            }
         }
-        
-        // Display acceleration values (optional)
-        char accel_msg[32];
-        sprintf(accel_msg, "X:%.2f Y:%.2f", accel[0], accel[1]);
+#else
+        mpu6050_read(&imu, accel, gyro, &temp);
+#endif
         
         // Calculate FPS
         frame_count++;
@@ -245,18 +804,85 @@ int main() {
             t_last_fps = t_now;
             frame_count = 0;
         }
+
+        widget_set_xy(&dash[W_VECTOR], (int32_t)(-accel[0] * 100), (int32_t)(accel[1] * 100));
+        widget_set(&dash[W_X], (int32_t)(accel[0] * 100));
+        widget_set(&dash[W_Y], (int32_t)(accel[1] * 100));
+        widget_set(&dash[W_FPS], (int32_t)(fps * 10));
+        widget_set(&dash[W_Z], (int32_t)(accel[2] * 100));
+        widget_render_all(&oled, dash, W_COUNT);
+#if SECOND_DISPLAY
+        ssd1306_clear(&oled2);
+        draw_accel_vector(&oled2, accel);
+#endif
         
-        // Display FPS on bottom of screen
-        char fps_msg[16];
-        sprintf(fps_msg, "FPS:%.1f", fps);
-        // ssd1306_drawMessage(0, 24, fps_msg);
-        
-        // Update the display
-        ssd1306_update();
+        // Update the display(s). Only the dirty part of oled goes out, the
+        // second display still sends its whole frame on DMA meanwhile.
+#if SECOND_DISPLAY
+        ssd1306_update_start(&oled2);
+#endif
+        ssd1306_update_dirty(&oled);
+#if SECOND_DISPLAY
+        ssd1306_update_wait(&oled2);
+#endif
         
-        // Print data to USB (optional - can be removed for better performance)
-        printf("Accel: X=%.3f g, Y=%.3f g, Z=%.3f g | FPS: %.1f\n", 
-               accel[0], accel[1], accel[2], fps);
+        // Print data to USB (optional - can be removed for better performance).
+        // Built with fmt, float printf costs tens of microseconds a call.
+        char report[256];
+        fmt_t f;
+        fmt_begin(&f, report, sizeof(report));
+        fmt_str(&f, "Accel: X=");
+        fmt_float(&f, accel[0], 3, 0);
+        fmt_str(&f, " g, Y=");
+        fmt_float(&f, accel[1], 3, 0);
+        fmt_str(&f, " g, Z=");
+        fmt_float(&f, accel[2], 3, 0);
+        fmt_str(&f, " g | FPS: ");
+        fmt_float(&f, fps, 1, 0);
+#if IMU_FIFO_HZ
+        fmt_str(&f, " | IMU: ");
+        fmt_uint(&f, imu.samples, 0);
+        fmt_str(&f, " samples, lost ");
+        fmt_uint(&f, imu.lost, 0);
+#endif
+#if IMU_DRDY_HZ
+        fmt_str(&f, " | IMU: ");
+        fmt_uint(&f, imu.samples, 0);
+        fmt_str(&f, " samples, missed ");
+        fmt_uint(&f, mpu6050_drdy_missed(&imu_drdy), 0);
+        fmt_str(&f, ", read in ");
+        fmt_uint(&f, imu_drdy.reads ? (uint32_t)(imu_drdy.latency_sum_us / imu_drdy.reads) : 0, 0);
+        fmt_str(&f, " us");
+#endif
+#if I2C_SCHEDULER
+        fmt_str(&f, " | bus:");
+        for (int i = 0; i < bus0.devices; i++) {
+            fmt_char(&f, ' ');
+            fmt_str(&f, bus0.dev[i].name);
+            fmt_char(&f, ' ');
+            fmt_uint(&f, (uint32_t)(i2cbus_utilization(&bus0, i) * 100), 0);
+            fmt_str(&f, "%, late ");
+            fmt_uint(&f, bus0.dev[i].misses, 0);
+        }
+        fmt_str(&f, ", IMU read max ");
+        fmt_uint(&f, bus0.dev[imu.bus_dev].latency_max_us, 0);
+        fmt_str(&f, " us of ");
+        fmt_uint(&f, i2cbus_bound_us(&bus0, MPU6050_DATA_BYTES + 1), 0);
+#endif
+#if ORIENTATION_CORE1
+        fmt_str(&f, " | RPY: ");
+        fmt_float(&f, att.roll, 1, 0);
+        fmt_char(&f, ' ');
+        fmt_float(&f, att.pitch, 1, 0);
+        fmt_char(&f, ' ');
+        fmt_float(&f, att.yaw, 1, 0);
+        fmt_str(&f, " deg, ");
+        fmt_uint(&f, att.cycles_last, 0);
+        fmt_str(&f, " cyc/update (max ");
+        fmt_uint(&f, att.cycles_max, 0);
+        fmt_char(&f, ')');
+#endif
+        puts(report);
         
         // Aim for higher refresh rate - remove delay for maximum speed
         // sleep_ms(5);  // Uncomment if you want to limit the update rate
@@ -0,0 +1,275 @@
+// I2C bus scheduler, see i2cbus.h
+
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "i2cbus.h"
+
+static i2cbus_t *buses[2];
+
+// the queued transaction to run next: highest priority, earliest deadline
+// (none counts as last), then first come
+static int pick(const i2cbus_t *b) {
+    int best = 0;
+    for (int i = 1; i < b->count; i++) {
+        const i2cbus_txn_t *t = b->queue[i], *u = b->queue[best];
+        if (t->priority != u->priority) {
+            if (t->priority > u->priority) best = i;
+            continue;
+        }
+        uint64_t dt = t->deadline_us ? t->deadline_us : UINT64_MAX;
+        uint64_t du = u->deadline_us ? u->deadline_us : UINT64_MAX;
+        if (dt < du) best = i;
+    }
+    return best;
+}
+
+// with the lock held and the bus idle
+static void start_next(i2cbus_t *b) {
+    if (b->running || b->stopping || b->count == 0) {
+        return;
+    }
+    int i = pick(b);
+    i2cbus_txn_t *t = b->queue[i];
+    for (; i < b->count - 1; i++) {
+        b->queue[i] = b->queue[i + 1];
+    }
+    b->count--;
+    b->running = t;
+    t->state = I2CBUS_RUNNING;
+
+    int n = 0;
+    if (t->prefix != I2CBUS_NO_PREFIX) {
+        b->words[n++] = (uint8_t)t->prefix;
+    }
+    uint16_t piece = t->tx_len - t->tx_sent;
+    if (t->split && piece > b->max_piece) {
+        piece = b->max_piece;
+    }
+    for (uint16_t k = 0; k < piece; k++) {
+        b->words[n++] = t->tx[t->tx_sent + k];
+    }
+    b->piece = piece;
+    // the rx part only goes with the last piece
+    bool reading = t->rx_len && t->tx_sent + piece == t->tx_len;
+    if (reading) {
+        for (uint16_t k = 0; k < t->rx_len; k++) {
+            b->words[n + k] = I2C_IC_DATA_CMD_CMD_BITS;
+        }
+        if (n) {
+            b->words[n] |= I2C_IC_DATA_CMD_RESTART_BITS;
+        }
+        n += t->rx_len;
+    }
+    b->words[n - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+    i2c_hw_t *hw = i2c_get_hw(b->i2c);
+    if (hw->tar != t->addr) {
+        // the target can only change with the block disabled, it's idle here
+        hw->enable = 0;
+        hw->tar = t->addr;
+        hw->enable = 1;
+    }
+    b->piece_us = time_us_64();
+
+    if (reading) {
+        dma_channel_config c = dma_channel_get_default_config(b->dma_rx);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+        channel_config_set_read_increment(&c, false);
+        channel_config_set_write_increment(&c, true);
+        channel_config_set_dreq(&c, i2c_get_dreq(b->i2c, false));
+        dma_channel_configure(b->dma_rx, &c, t->rx, &hw->data_cmd, t->rx_len, true);
+    }
+    dma_channel_config c = dma_channel_get_default_config(b->dma_tx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(b->i2c, true));
+    dma_channel_configure(b->dma_tx, &c, &hw->data_cmd, b->words, n, true);
+}
+
+static void finish(i2cbus_t *b, i2cbus_txn_t *t, uint8_t state, uint64_t now) {
+    i2cbus_device_t *d = &b->dev[t->device];
+    uint32_t latency = (uint32_t)(now - t->queued_us);
+    d->txns++;
+    d->latency_sum_us += latency;
+    if (latency > d->latency_max_us) d->latency_max_us = latency;
+    if (t->deadline_us && now > t->deadline_us) d->misses++;
+    if (state == I2CBUS_ABORTED) d->aborts++;
+    t->state = state;
+    if (t->done) {
+        t->done(t);
+    }
+}
+
+// the running piece has ended, by its STOP or by an abort, whose STOP is
+// still to come
+static void piece_done(i2cbus_t *b, bool aborted) {
+    i2cbus_txn_t *t = b->running;
+    uint64_t now = time_us_64();
+    uint32_t took = (uint32_t)(now - b->piece_us);
+    i2cbus_device_t *d = &b->dev[t->device];
+    d->busy_us += took;
+    d->bytes += b->piece + (t->prefix != I2CBUS_NO_PREFIX);
+    if (t->priority < I2CBUS_PRIO_HIGH && took > b->longest_us) {
+        b->longest_us = took;
+    }
+    b->running = NULL;
+
+    if (aborted) {
+        dma_channel_abort(b->dma_tx);
+        dma_channel_abort(b->dma_rx);
+        finish(b, t, I2CBUS_ABORTED, now);
+    } else {
+        t->tx_sent += b->piece;
+        if (t->tx_sent < t->tx_len) {
+            // more to send: back in the queue, so others can go in between
+            t->state = I2CBUS_QUEUED;
+            // submit keeps a place for it
+            b->queue[b->count++] = t;
+        } else {
+            d->bytes += t->rx_len;
+            // the last byte is in the rx fifo before the STOP, let the DMA take it
+            while (t->rx_len && dma_channel_is_busy(b->dma_rx)) {
+                tight_loop_contents();
+            }
+            finish(b, t, I2CBUS_DONE, now);
+        }
+    }
+}
+
+static void bus_irq(void) {
+    for (int i = 0; i < 2; i++) {
+        i2cbus_t *b = buses[i];
+        if (!b) {
+            continue;
+        }
+        i2c_hw_t *hw = i2c_get_hw(b->i2c);
+        uint32_t stat = hw->raw_intr_stat;
+        if (!(stat & (I2C_IC_RAW_INTR_STAT_STOP_DET_BITS | I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS))) {
+            continue;
+        }
+        bool aborted = stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS;
+        bool stopped = stat & I2C_IC_RAW_INTR_STAT_STOP_DET_BITS;
+        if (aborted) {
+            (void)hw->clr_tx_abrt;
+        }
+        if (stopped) {
+            (void)hw->clr_stop_det;
+        }
+        uint32_t save = spin_lock_blocking(b->lock);
+        if (b->running) {
+            piece_done(b, aborted);
+            // after an abort the controller still sends a STOP, and that
+            // STOP_DET would look like the end of whatever started next
+            b->stopping = aborted && !stopped;
+        } else if (stopped) {
+            // the STOP after an abort
+            b->stopping = false;
+        }
+        start_next(b);
+        spin_unlock(b->lock, save);
+    }
+}
+
+void i2cbus_init(i2cbus_t *b, i2c_inst_t *i2c, uint32_t baud, uint16_t max_piece) {
+    *b = (i2cbus_t){ .i2c = i2c, .baud = baud };
+    b->max_piece = max_piece > I2CBUS_MAX_WORDS - 1 ? I2CBUS_MAX_WORDS - 1 : max_piece;
+    b->dma_tx = dma_claim_unused_channel(true);
+    b->dma_rx = dma_claim_unused_channel(true);
+    b->lock = spin_lock_init(spin_lock_claim_unused(true));
+    b->since_us = time_us_64();
+
+    uint index = i2c_hw_index(i2c);
+    buses[index] = b;
+    i2c_hw_t *hw = i2c_get_hw(i2c);
+    (void)hw->clr_stop_det;
+    (void)hw->clr_tx_abrt;
+    hw->intr_mask = I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+    irq_set_exclusive_handler(I2C0_IRQ + index, bus_irq);
+    irq_set_enabled(I2C0_IRQ + index, true);
+}
+
+int i2cbus_add_device(i2cbus_t *b, const char *name, uint8_t priority) {
+    if (b->devices == I2CBUS_DEVICES) {
+        return I2CBUS_DEVICES - 1; // shares the last one's stats
+    }
+    b->dev[b->devices] = (i2cbus_device_t){ .name = name, .priority = priority };
+    return b->devices++;
+}
+
+bool i2cbus_submit(i2cbus_t *b, i2cbus_txn_t *t) {
+    // the biggest piece has to fit in the word buffer, and there has to be one
+    uint32_t piece = t->split && t->tx_len > b->max_piece ? b->max_piece : t->tx_len;
+    uint32_t words = (t->prefix != I2CBUS_NO_PREFIX) + piece + t->rx_len;
+    if (words == 0 || words > I2CBUS_MAX_WORDS) {
+        return false;
+    }
+    uint32_t save = spin_lock_blocking(b->lock);
+    // the running one may need its place back, for its next piece
+    if (b->count >= I2CBUS_QUEUE - (b->running != NULL)) {
+        spin_unlock(b->lock, save);
+        return false;
+    }
+    t->state = I2CBUS_QUEUED;
+    t->tx_sent = 0;
+    t->queued_us = time_us_64();
+    b->queue[b->count++] = t;
+    start_next(b);
+    spin_unlock(b->lock, save);
+    return true;
+}
+
+bool i2cbus_wait(i2cbus_t *b, i2cbus_txn_t *t) {
+    (void)b;
+    while (i2cbus_busy(t)) {
+        tight_loop_contents();
+    }
+    return t->state == I2CBUS_DONE;
+}
+
+bool i2cbus_write(i2cbus_t *b, int device, uint8_t addr, const uint8_t *src, uint16_t len) {
+    i2cbus_txn_t t = {
+        .addr = addr, .device = device, .priority = b->dev[device].priority,
+        .prefix = I2CBUS_NO_PREFIX, .tx = src, .tx_len = len,
+    };
+    return i2cbus_submit(b, &t) && i2cbus_wait(b, &t);
+}
+
+bool i2cbus_read_reg(i2cbus_t *b, int device, uint8_t addr, uint8_t reg, uint8_t *dst, uint16_t len) {
+    i2cbus_txn_t t = {
+        .addr = addr, .device = device, .priority = b->dev[device].priority,
+        .prefix = I2CBUS_NO_PREFIX, .tx = &reg, .tx_len = 1, .rx = dst, .rx_len = len,
+    };
+    return i2cbus_submit(b, &t) && i2cbus_wait(b, &t);
+}
+
+uint32_t i2cbus_wire_us(const i2cbus_t *b, uint32_t bytes, uint32_t starts) {
+    // 9 clocks a byte, each start brings an address byte, one stop
+    uint64_t clocks = 9ull * bytes + 10ull * starts + 1;
+    return (uint32_t)((clocks * 1000000 + b->baud - 1) / b->baud);
+}
+
+uint32_t i2cbus_bound_us(const i2cbus_t *b, uint32_t bytes) {
+    uint32_t piece = i2cbus_wire_us(b, b->max_piece + 1, 1);
+    if (b->longest_us > piece) {
+        piece = b->longest_us; // something unsplit went out that was longer
+    }
+    return piece + i2cbus_wire_us(b, bytes, 2) + 2 * I2CBUS_SLACK_US;
+}
+
+float i2cbus_utilization(const i2cbus_t *b, int device) {
+    uint64_t span = time_us_64() - b->since_us;
+    return span ? (float)b->dev[device].busy_us / span : 0.0f;
+}
+
+void i2cbus_reset_stats(i2cbus_t *b) {
+    uint32_t save = spin_lock_blocking(b->lock);
+    for (int i = 0; i < b->devices; i++) {
+        i2cbus_device_t *d = &b->dev[i];
+        *d = (i2cbus_device_t){ .name = d->name, .priority = d->priority };
+    }
+    b->longest_us = 0;
+    b->since_us = time_us_64();
+    spin_unlock(b->lock, save);
+}
@@ -0,0 +1,132 @@
+#ifndef I2CBUS_H__
+#define I2CBUS_H__
+
+// Shared I2C bus scheduler.
+//
+// Every transaction on the bus goes through one queue. The I2C interrupt
+// (STOP detected) finishes the running transaction and starts the next one
+// on DMA, so the CPU only queues work and never waits on the wire unless
+// it wants to. The next transaction is the queued one with the highest
+// priority, then the earliest deadline, then the oldest. After an abort (a
+// NACK) it waits for the STOP the controller sends after it.
+//
+// A write marked splittable (a display frame) goes out in pieces of at
+// most max_piece bytes, each with the same prefix byte in front (0x40 for
+// SSD1306 data, which carries on where the last piece left off). After
+// every piece the transaction goes back in the queue, so a sensor read
+// waits for one piece at most, never a whole frame. With one outstanding
+// read per device at the top priority, its latency is bounded by
+// i2cbus_bound_us().
+//
+// Transactions are owned by the caller and must stay put until done.
+// Submitting is safe from either core and from interrupts.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/i2c.h"
+#include "hardware/sync.h"
+
+#define I2CBUS_QUEUE       8
+#define I2CBUS_DEVICES     4
+#define I2CBUS_MAX_WORDS   400 // IC_DATA_CMD words in one transaction or piece
+
+#define I2CBUS_PRIO_LOW    0   // bulk: display frames
+#define I2CBUS_PRIO_HIGH   2   // sensor reads
+
+#define I2CBUS_NO_PREFIX   (-1)
+#define I2CBUS_SLACK_US    20  // interrupt entry and setting up the next piece
+
+enum {
+    I2CBUS_IDLE,
+    I2CBUS_QUEUED,
+    I2CBUS_RUNNING,
+    I2CBUS_DONE,
+    I2CBUS_ABORTED,   // NACK or arbitration loss
+};
+
+typedef struct i2cbus_txn {
+    uint8_t addr;
+    uint8_t device;          // from i2cbus_add_device(), for the stats
+    uint8_t priority;
+    bool split;              // the tx bytes may go out in pieces
+    int16_t prefix;          // byte sent before the tx bytes (each piece), or I2CBUS_NO_PREFIX
+    const uint8_t *tx;       // bytes to write
+    uint16_t tx_len;
+    uint8_t *rx;             // then bytes to read after a repeated start
+    uint16_t rx_len;
+    uint64_t deadline_us;    // on the time_us_64() clock, 0 for none
+
+    void (*done)(struct i2cbus_txn *t); // from the interrupt, after DONE/ABORTED is set
+    void *arg;
+
+    // kept by the bus
+    volatile uint8_t state;
+    uint16_t tx_sent;
+    uint64_t queued_us;
+} i2cbus_txn_t;
+
+typedef struct {
+    const char *name;
+    uint8_t priority;        // default for its transactions
+    uint32_t txns;
+    uint32_t bytes;
+    uint64_t busy_us;        // time it had the bus
+    uint32_t latency_max_us; // queued to done
+    uint64_t latency_sum_us;
+    uint32_t misses;         // finished after their deadline
+    uint32_t aborts;
+} i2cbus_device_t;
+
+typedef struct i2cbus {
+    i2c_inst_t *i2c;
+    uint32_t baud;
+    uint16_t max_piece;
+    int dma_tx, dma_rx;
+    spin_lock_t *lock;
+
+    i2cbus_txn_t *queue[I2CBUS_QUEUE];
+    int count;
+    i2cbus_txn_t *running;
+    bool stopping;           // aborted, the STOP not seen yet
+    uint16_t piece;          // tx bytes in the running piece
+    uint64_t piece_us;       // when it started
+    uint32_t longest_us;     // longest piece below I2CBUS_PRIO_HIGH so far
+    uint32_t words[I2CBUS_MAX_WORDS];
+
+    i2cbus_device_t dev[I2CBUS_DEVICES];
+    int devices;
+    uint64_t since_us;       // when the stats were reset
+} i2cbus_t;
+
+// take over i2c (already i2c_init()ed at baud): two DMA channels, a spin
+// lock and the I2C interrupt on this core. Splittable writes go out
+// max_piece bytes at a time.
+void i2cbus_init(i2cbus_t *b, i2c_inst_t *i2c, uint32_t baud, uint16_t max_piece);
+// a name for the stats and the default priority, returns the device id
+int i2cbus_add_device(i2cbus_t *b, const char *name, uint8_t priority);
+
+// queue t. Returns false if the queue is full; one place is kept for the
+// running transaction, so that's I2CBUS_QUEUE - 1 while one runs.
+bool i2cbus_submit(i2cbus_t *b, i2cbus_txn_t *t);
+// spin until t is done, returns false if it was aborted
+bool i2cbus_wait(i2cbus_t *b, i2cbus_txn_t *t);
+static inline bool i2cbus_busy(const i2cbus_txn_t *t) {
+    return t->state == I2CBUS_QUEUED || t->state == I2CBUS_RUNNING;
+}
+
+// blocking helpers at the device's priority
+bool i2cbus_write(i2cbus_t *b, int device, uint8_t addr, const uint8_t *src, uint16_t len);
+bool i2cbus_read_reg(i2cbus_t *b, int device, uint8_t addr, uint8_t reg, uint8_t *dst, uint16_t len);
+
+// time on the wire for bytes in one transaction with `starts` START or
+// repeated START conditions
+uint32_t i2cbus_wire_us(const i2cbus_t *b, uint32_t bytes, uint32_t starts);
+// worst case from queueing to done for a top priority transaction of
+// bytes with a repeated start, with no other at its priority ahead of it:
+// the longest piece anything else can be in the middle of, then its own
+uint32_t i2cbus_bound_us(const i2cbus_t *b, uint32_t bytes);
+// fraction of the time since the last reset device had the bus, 0..1
+float i2cbus_utilization(const i2cbus_t *b, int device);
+void i2cbus_reset_stats(i2cbus_t *b);
+
+#endif
@@ -0,0 +1,178 @@
+// six-position IMU calibration and its flash record, see imucal.h
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "imucal.h"
+
+// a steady turn looks still for a sample or two, don't count those
+#define RESTART_MIN 16
+
+// the last sector, well clear of the program
+#define IMUCAL_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;           // sizeof(mpu6050_cal_t), in case it grows
+    mpu6050_cal_t cal;
+    uint32_t crc;            // CRC-32 of everything before it
+} record_t;
+
+static const char *const face_names[IMUCAL_FACES] = { "+X", "-X", "+Y", "-Y", "+Z", "-Z" };
+
+const char *imucal_face_name(int face) {
+    return face >= 0 && face < IMUCAL_FACES ? face_names[face] : "?";
+}
+
+// the face gravity pulls on: 2 * axis, +1 if it points down the axis. -1
+// if it is not mostly along one axis.
+static int face_of(const int16_t *accel) {
+    int axis = 0;
+    for (int i = 1; i < 3; i++) {
+        if (abs(accel[i]) > abs(accel[axis])) axis = i;
+    }
+    if (abs(accel[axis]) < IMUCAL_FACE_MIN) {
+        return -1;
+    }
+    return 2 * axis + (accel[axis] < 0);
+}
+
+static int32_t div_round(int64_t num, int64_t den) {
+    return (int32_t)((num < 0 ? num - den / 2 : num + den / 2) / den);
+}
+
+static void restart(imucal_t *c, int face) {
+    c->face = face;
+    c->n = 0;
+    for (int i = 0; i < 3; i++) {
+        c->sum_accel[i] = c->sum_gyro[i] = 0;
+    }
+}
+
+void imucal_begin(imucal_t *c) {
+    *c = (imucal_t){ 0 };
+    restart(c, -1);
+}
+
+int imucal_feed(imucal_t *c, const int16_t *accel, const int16_t *gyro) {
+    int face = face_of(accel);
+    if (face != c->face) {
+        if (c->n >= RESTART_MIN) c->restarts++;
+        restart(c, face);
+    }
+    if (face < 0 || (c->done & (1u << face))) {
+        return -1;
+    }
+
+    if (c->n == 0) {
+        for (int i = 0; i < 3; i++) {
+            c->min_accel[i] = c->max_accel[i] = accel[i];
+            c->min_gyro[i] = c->max_gyro[i] = gyro[i];
+        }
+    }
+    bool moved = false;
+    for (int i = 0; i < 3; i++) {
+        if (accel[i] < c->min_accel[i]) c->min_accel[i] = accel[i];
+        if (accel[i] > c->max_accel[i]) c->max_accel[i] = accel[i];
+        if (gyro[i] < c->min_gyro[i]) c->min_gyro[i] = gyro[i];
+        if (gyro[i] > c->max_gyro[i]) c->max_gyro[i] = gyro[i];
+        moved |= c->max_accel[i] - c->min_accel[i] > IMUCAL_STILL_ACCEL;
+        moved |= c->max_gyro[i] - c->min_gyro[i] > IMUCAL_STILL_GYRO;
+    }
+    if (moved) {
+        // start again from this sample
+        if (c->n >= RESTART_MIN) c->restarts++;
+        restart(c, face);
+        for (int i = 0; i < 3; i++) {
+            c->min_accel[i] = c->max_accel[i] = accel[i];
+            c->min_gyro[i] = c->max_gyro[i] = gyro[i];
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        c->sum_accel[i] += accel[i];
+        c->sum_gyro[i] += gyro[i];
+    }
+    if (++c->n < IMUCAL_WINDOW) {
+        return -1;
+    }
+
+    int axis = face / 2;
+    c->face_accel[face] = div_round(c->sum_accel[axis], IMUCAL_WINDOW);
+    for (int i = 0; i < 3; i++) {
+        c->gyro_sum[i] += c->sum_gyro[i];
+    }
+    c->gyro_n += IMUCAL_WINDOW;
+    c->done |= 1u << face;
+    restart(c, face);
+    return face;
+}
+
+bool imucal_result(const imucal_t *c, mpu6050_cal_t *out) {
+    if (!imucal_complete(c)) {
+        return false;
+    }
+    const int32_t one_g = (int32_t)(1.0f / MPU6050_ACCEL_G + 0.5f);
+    mpu6050_cal_t r;
+    for (int axis = 0; axis < 3; axis++) {
+        int32_t up = c->face_accel[2 * axis], down = c->face_accel[2 * axis + 1];
+        int32_t offset = div_round((int64_t)up + down, 2);
+        int32_t scale = div_round((int64_t)2 * one_g * MPU6050_CAL_ONE, (int64_t)up - down);
+        if (abs(offset) > one_g / 4 || scale < MPU6050_CAL_ONE * 4 / 5 || scale > MPU6050_CAL_ONE * 6 / 5) {
+            return false;
+        }
+        r.accel_offset[axis] = (int16_t)offset;
+        r.accel_scale[axis] = (uint16_t)scale;
+        r.gyro_offset[axis] = (int16_t)div_round(c->gyro_sum[axis], c->gyro_n);
+    }
+    *out = r;
+    return true;
+}
+
+// reflected, polynomial 0xEDB88320, as zlib
+static uint32_t crc32(const void *data, size_t len) {
+    const uint8_t *p = data;
+    uint32_t crc = 0xFFFFFFFFu;
+    while (len--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++) {
+            crc = crc >> 1 ^ (0xEDB88320u & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+bool imucal_load(mpu6050_cal_t *out) {
+    const record_t *r = (const record_t *)(XIP_BASE + IMUCAL_OFFSET);
+    if (r->magic != IMUCAL_MAGIC || r->version != IMUCAL_VERSION || r->size != sizeof(mpu6050_cal_t)
+        || r->crc != crc32(r, offsetof(record_t, crc))) {
+        return false;
+    }
+    *out = r->cal;
+    return true;
+}
+
+bool imucal_save(const mpu6050_cal_t *cal) {
+    static uint8_t page[FLASH_PAGE_SIZE];
+    record_t r;
+    memset(&r, 0, sizeof(r)); // the padding goes into the CRC too
+    r.magic = IMUCAL_MAGIC;
+    r.version = IMUCAL_VERSION;
+    r.size = sizeof(mpu6050_cal_t);
+    r.cal = *cal;
+    r.crc = crc32(&r, offsetof(record_t, crc));
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, &r, sizeof(r));
+
+    // nothing may run from flash while it is being written
+    uint32_t ints = save_and_disable_interrupts();
+    flash_range_erase(IMUCAL_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(IMUCAL_OFFSET, page, FLASH_PAGE_SIZE);
+    restore_interrupts(ints);
+
+    mpu6050_cal_t back;
+    return imucal_load(&back) && memcmp(&back, cal, sizeof(back)) == 0;
+}
@@ -0,0 +1,60 @@
+#ifndef IMUCAL_H__
+#define IMUCAL_H__
+
+// Six-position MPU6050 calibration, kept in the last sector of flash.
+//
+// Put the board down still on each of its six faces in turn, in any
+// order, and feed it raw samples (mpu6050_read_raw()). A face counts once
+// IMUCAL_WINDOW samples in a row are still, with the accel and gyro spread
+// under the limits below and gravity mostly along one axis. Samples taken
+// while the board moves restart the window. The two faces of an axis give
+// its accel offset, which is halfway between them, and its scale, which
+// maps their difference to 2 g. The gyro offset is the gyro mean over all
+// the still windows.
+//
+// In flash the result has a magic number, a version and a CRC-32, so a
+// blank, old or damaged sector is refused and the readings stay raw.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "mpu6050.h"
+
+#define IMUCAL_WINDOW        256   // still samples per face
+#define IMUCAL_STILL_ACCEL   400   // max spread in a window, counts (0.025 g)
+#define IMUCAL_STILL_GYRO    200   // counts (1.5 deg/s)
+#define IMUCAL_FACE_MIN      13000 // gravity on the face's axis, counts (0.8 g)
+
+#define IMUCAL_MAGIC   0x4C414349u // "ICAL"
+#define IMUCAL_VERSION 1
+
+enum { IMUCAL_FACES = 6 }; // +X -X +Y -Y +Z -Z
+
+typedef struct {
+    uint8_t done;            // bit per face
+    int8_t face;             // face of the current window, -1 for none
+    uint16_t n;              // samples in it so far
+    int32_t sum_accel[3], sum_gyro[3];
+    int16_t min_accel[3], max_accel[3], min_gyro[3], max_gyro[3];
+
+    int32_t face_accel[IMUCAL_FACES]; // mean along the face's axis, counts
+    int64_t gyro_sum[3];              // over all the faces done
+    uint32_t gyro_n;
+    uint32_t restarts;                // windows thrown away for moving, once under way
+} imucal_t;
+
+void imucal_begin(imucal_t *c);
+// one raw sample. Returns the face it finished, or -1.
+int imucal_feed(imucal_t *c, const int16_t *accel, const int16_t *gyro);
+static inline bool imucal_complete(const imucal_t *c) { return c->done == (1u << IMUCAL_FACES) - 1; }
+// the corrections, false if a face is missing or they are not plausible
+// for an MPU6050 (offsets over 0.25 g, scales off by more than 20%)
+bool imucal_result(const imucal_t *c, mpu6050_cal_t *out);
+const char *imucal_face_name(int face);
+
+// false if there is no valid record, out is left alone then
+bool imucal_load(mpu6050_cal_t *out);
+// erase and program the sector with interrupts off, so core1 must not be
+// running from flash. Returns false if it doesn't read back.
+bool imucal_save(const mpu6050_cal_t *cal);
+
+#endif
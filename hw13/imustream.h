@@ -0,0 +1,83 @@
+#ifndef IMUSTREAM_H__
+#define IMUSTREAM_H__
+
+// Binary IMU stream: raw samples in COBS framed packets, for
+// tools/imudecode.py to turn back into units.
+//
+// COBS replaces every zero in a packet with the distance to the next one,
+// so 0x00 only appears as the delimiter after each packet, and a reader
+// that starts in the middle of the stream or loses bytes picks up again
+// at the next zero. Before encoding, every packet is a type byte, its
+// fields little endian, then a CRC-16/CCITT of all of that.
+//
+// Sample packet (IMUSTREAM_SAMPLES):
+//   u8 type, u8 n, u16 packet sequence number,
+//   u32 index of its first sample since the stream began,
+//   u32 samples the driver lost so far (FIFO overflows, missed edges),
+//   u32 t_us of its first sample (low 32 bits of time_us_64()),
+//   n times: u16 us since the sample before (0 for the first),
+//            i16 accel xyz, i16 gyro xyz raw counts,
+//   u16 crc
+// A gap in the sample index means packets were lost on the way, a jump in
+// the lost count means the IMU driver dropped samples.
+//
+// Info packet (IMUSTREAM_INFO), at the start and every 256 packets after:
+//   u8 type, u8 version, u16 sample rate in Hz,
+//   f32 g per accel count, f32 deg/s per gyro count,
+//   mpu6050_cal_t: i16 accel offset xyz, u16 accel scale xyz (16384 is
+//   1.0), i16 gyro offset xyz,
+//   u16 crc
+// The samples are sent before the calibration, so the decoder applies it
+// the same way mpu6050_convert() does.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "mpu6050.h"
+
+#define IMUSTREAM_SAMPLES     0x01
+#define IMUSTREAM_INFO        0x02
+#define IMUSTREAM_VERSION     1
+
+#define IMUSTREAM_MAX_SAMPLES 16   // per packet, keeps it under 254 bytes
+#define IMUSTREAM_HEADER      16
+#define IMUSTREAM_SAMPLE      14
+#define IMUSTREAM_PAYLOAD_MAX (IMUSTREAM_HEADER + IMUSTREAM_MAX_SAMPLES * IMUSTREAM_SAMPLE + 2)
+#define IMUSTREAM_PACKET_MAX  (IMUSTREAM_PAYLOAD_MAX + 2) // COBS code byte and delimiter
+#define IMUSTREAM_INFO_EVERY  256
+#define IMUSTREAM_FLUSH_US    20000 // longest a sample waits for its packet to fill
+
+// hands a finished packet, delimiter included, to the link
+typedef void (*imustream_write_t)(const uint8_t *bytes, size_t len);
+
+typedef struct {
+    imustream_write_t write;
+    uint16_t rate_hz;
+    mpu6050_cal_t cal;
+
+    uint8_t payload[IMUSTREAM_PAYLOAD_MAX]; // the sample packet being filled
+    uint8_t n;
+    uint64_t first_us, last_us;             // of the samples in it
+    uint32_t lost;                          // in its header
+    uint16_t seq;
+    uint32_t index;                         // samples added so far
+
+    uint32_t packets, bytes;                // sent, after encoding
+} imustream_t;
+
+// starts with a delimiter and an info packet
+void imustream_begin(imustream_t *s, imustream_write_t write, uint16_t rate_hz, const mpu6050_cal_t *cal);
+// queue one sample, sending the packet when it is full. lost is the
+// driver's count of samples it dropped so far.
+void imustream_add(imustream_t *s, const mpu6050_sample_t *sample, uint32_t lost);
+// send a partly filled packet once its oldest sample has waited
+// IMUSTREAM_FLUSH_US, call it every loop
+void imustream_poll(imustream_t *s, uint64_t now_us);
+void imustream_flush(imustream_t *s);
+
+// COBS encode len bytes and add the delimiter, returns the bytes written.
+// out needs len + len / 254 + 2.
+size_t imustream_cobs(const uint8_t *in, size_t len, uint8_t *out);
+uint16_t imustream_crc16(const uint8_t *data, size_t len);
+
+#endif
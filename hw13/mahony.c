@@ -0,0 +1,103 @@
+// Mahony filter and its seqlock, see mahony.h
+
+#include <math.h>
+#include "hardware/sync.h"
+#include "mahony.h"
+
+#define DEG (3.14159265f / 180.0f)
+
+void mahony_init(mahony_t *f, float kp, float ki) {
+    *f = (mahony_t){ .q = { 1.0f, 0.0f, 0.0f, 0.0f }, .kp = kp, .ki = ki };
+}
+
+// the shortest rotation taking the measured down onto the world Z axis,
+// so the filter doesn't spend seconds converging from level
+static void align(mahony_t *f, float ax, float ay, float az) {
+    float w = 1.0f + az;
+    if (w < 1e-6f) {
+        // upside down, any half turn about a horizontal axis will do
+        f->q[0] = 0.0f;
+        f->q[1] = 1.0f;
+        f->q[2] = f->q[3] = 0.0f;
+        return;
+    }
+    float inv = 1.0f / sqrtf(w * w + ay * ay + ax * ax);
+    f->q[0] = w * inv;
+    f->q[1] = ay * inv;
+    f->q[2] = -ax * inv;
+    f->q[3] = 0.0f;
+}
+
+void mahony_gravity(const float *q, float *v) {
+    v[0] = 2.0f * (q[1] * q[3] - q[0] * q[2]);
+    v[1] = 2.0f * (q[0] * q[1] + q[2] * q[3]);
+    v[2] = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+}
+
+void mahony_update(mahony_t *f, const float *accel, const float *gyro, float dt) {
+    float gx = gyro[0] * DEG, gy = gyro[1] * DEG, gz = gyro[2] * DEG;
+    float a2 = accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2];
+
+    if (a2 > 0.0f) {
+        float inv = 1.0f / sqrtf(a2);
+        float ax = accel[0] * inv, ay = accel[1] * inv, az = accel[2] * inv;
+        if (!f->started) {
+            align(f, ax, ay, az);
+            f->started = true;
+        }
+        // gravity as q sees it, the cross product with the measurement is the error
+        float v[3];
+        mahony_gravity(f->q, v);
+        float ex = ay * v[2] - az * v[1];
+        float ey = az * v[0] - ax * v[2];
+        float ez = ax * v[1] - ay * v[0];
+        if (f->ki > 0.0f) {
+            f->bias[0] += f->ki * ex * dt;
+            f->bias[1] += f->ki * ey * dt;
+            f->bias[2] += f->ki * ez * dt;
+        }
+        gx += f->kp * ex + f->bias[0];
+        gy += f->kp * ey + f->bias[1];
+        gz += f->kp * ez + f->bias[2];
+    }
+
+    const float *q = f->q;
+    float h = 0.5f * dt;
+    float q0 = q[0] + (-q[1] * gx - q[2] * gy - q[3] * gz) * h;
+    float q1 = q[1] + ( q[0] * gx + q[2] * gz - q[3] * gy) * h;
+    float q2 = q[2] + ( q[0] * gy - q[1] * gz + q[3] * gx) * h;
+    float q3 = q[3] + ( q[0] * gz + q[1] * gy - q[2] * gx) * h;
+    float inv = 1.0f / sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    f->q[0] = q0 * inv;
+    f->q[1] = q1 * inv;
+    f->q[2] = q2 * inv;
+    f->q[3] = q3 * inv;
+}
+
+void mahony_euler(const float *q, float *roll, float *pitch, float *yaw) {
+    float q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    float s = 2.0f * (q0 * q2 - q3 * q1);
+    if (s > 1.0f) s = 1.0f;
+    if (s < -1.0f) s = -1.0f;
+    *roll = atan2f(2.0f * (q0 * q1 + q2 * q3), 1.0f - 2.0f * (q1 * q1 + q2 * q2)) / DEG;
+    *pitch = asinf(s) / DEG;
+    *yaw = atan2f(2.0f * (q0 * q3 + q1 * q2), 1.0f - 2.0f * (q2 * q2 + q3 * q3)) / DEG;
+}
+
+void mahony_publish(mahony_shared_t *s, const mahony_state_t *state) {
+    s->seq++;
+    __dmb();
+    s->state = *state;
+    __dmb();
+    s->seq++;
+}
+
+void mahony_snapshot(const mahony_shared_t *s, mahony_state_t *state) {
+    uint32_t seq;
+    do {
+        seq = s->seq;
+        __dmb();
+        *state = s->state;
+        __dmb();
+    } while ((seq & 1) || seq != s->seq);
+}
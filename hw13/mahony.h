@@ -0,0 +1,55 @@
+#ifndef MAHONY_H__
+#define MAHONY_H__
+
+// Mahony orientation filter: the gyro is integrated into a quaternion and
+// the accelerometer's "down" pulls the tilt back, proportionally (kp) and
+// through an integral term (ki) that learns the gyro bias. Yaw has nothing
+// to pull it back, so it drifts with whatever bias is left.
+//
+// Single precision float throughout, the RP2350's M33 does it in hardware.
+//
+// The estimate is shared between cores with a seqlock: the writer bumps a
+// sequence number to odd, writes the state, bumps it back to even. Readers
+// copy the state and retry if the number was odd or moved meanwhile, so
+// neither side ever waits on a lock and a reader never sees half an update.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    float q[4];        // w, x, y, z, body to world
+    float bias[3];     // integral term, rad/s
+    float kp, ki;
+    bool started;      // the first sample sets the tilt directly
+} mahony_t;
+
+// what gets published after each update
+typedef struct {
+    float q[4];
+    float roll, pitch, yaw;    // degrees
+    uint64_t t_us;             // the sample it is from
+    uint32_t updates;
+    uint32_t cycles_last;      // clock cycles the last update took, 0 if unmeasured
+    uint32_t cycles_max;
+} mahony_state_t;
+
+typedef struct {
+    volatile uint32_t seq;     // odd while the state is being written
+    mahony_state_t state;
+} mahony_shared_t;
+
+void mahony_init(mahony_t *f, float kp, float ki);
+// one sample: accel in g (any scale, only the direction is used), gyro in
+// deg/s, dt in seconds
+void mahony_update(mahony_t *f, const float *accel, const float *gyro, float dt);
+// roll about X, pitch about Y, yaw about Z, degrees
+void mahony_euler(const float *q, float *roll, float *pitch, float *yaw);
+// world "down" seen from the body, what the accelerometer reads at rest
+void mahony_gravity(const float *q, float *v);
+
+// one writer only
+void mahony_publish(mahony_shared_t *s, const mahony_state_t *state);
+// any number of readers, on either core
+void mahony_snapshot(const mahony_shared_t *s, mahony_state_t *state);
+
+#endif
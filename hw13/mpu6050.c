@@ -0,0 +1,388 @@
+// MPU6050 register snapshots, FIFO bursts and data-ready DMA reads, see mpu6050.h
+
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "mpu6050.h"
+
+static void write_reg(mpu6050_t *m, uint8_t reg, uint8_t value) {
+    uint8_t data[2] = { reg, value };
+    if (m->bus) {
+        i2cbus_write(m->bus, m->bus_dev, m->addr, data, 2);
+        return;
+    }
+    i2c_write_blocking(m->i2c, m->addr, data, 2, false);
+}
+
+static void read_regs(mpu6050_t *m, uint8_t reg, uint8_t *dst, size_t len) {
+    if (m->bus) {
+        i2cbus_read_reg(m->bus, m->bus_dev, m->addr, reg, dst, len);
+        return;
+    }
+    i2c_write_blocking(m->i2c, m->addr, &reg, 1, true);
+    i2c_read_blocking(m->i2c, m->addr, dst, len, false);
+}
+
+static void wake(mpu6050_t *m) {
+    // out of sleep, clocked from the X gyro PLL rather than the 8 MHz
+    // oscillator, which the datasheet recommends for stability
+    write_reg(m, MPU6050_PWR_MGMT_1, 0x01);
+    write_reg(m, MPU6050_ACCEL_CONFIG, 0x00); // +-2 g
+    write_reg(m, MPU6050_GYRO_CONFIG, 0x00);  // +-250 deg/s
+}
+
+void mpu6050_init(mpu6050_t *m, i2c_inst_t *i2c, uint8_t addr) {
+    *m = (mpu6050_t){ .i2c = i2c, .addr = addr };
+    mpu6050_cal_identity(&m->cal);
+    wake(m);
+}
+
+void mpu6050_init_bus(mpu6050_t *m, i2cbus_t *bus, uint8_t addr) {
+    *m = (mpu6050_t){ .i2c = bus->i2c, .addr = addr, .bus = bus };
+    m->bus_dev = i2cbus_add_device(bus, "imu", I2CBUS_PRIO_HIGH);
+    mpu6050_cal_identity(&m->cal);
+    wake(m);
+}
+
+bool mpu6050_check(mpu6050_t *m) {
+    uint8_t id;
+    read_regs(m, MPU6050_WHO_AM_I, &id, 1);
+    return id == MPU6050_ADDR;
+}
+
+void mpu6050_cal_identity(mpu6050_cal_t *cal) {
+    for (int i = 0; i < 3; i++) {
+        cal->accel_offset[i] = 0;
+        cal->accel_scale[i] = MPU6050_CAL_ONE;
+        cal->gyro_offset[i] = 0;
+    }
+}
+
+void mpu6050_convert(const mpu6050_cal_t *cal, const uint8_t *accel_be, const uint8_t *gyro_be, float *accel,
+                     float *gyro) {
+    // a subtract and a multiply per axis on the integers, then the same
+    // float scaling as without a calibration. Scales stay under 2.0, so
+    // the product fits in 32 bits.
+    for (int i = 0; i < 3; i++) {
+        int32_t a = (int16_t)(accel_be[2 * i] << 8 | accel_be[2 * i + 1]) - cal->accel_offset[i];
+        int32_t g = (int16_t)(gyro_be[2 * i] << 8 | gyro_be[2 * i + 1]) - cal->gyro_offset[i];
+        accel[i] = (a * cal->accel_scale[i] / MPU6050_CAL_ONE) * MPU6050_ACCEL_G;
+        gyro[i] = g * MPU6050_GYRO_DPS;
+    }
+}
+
+static void keep_raw(int16_t *raw, const uint8_t *accel_be, const uint8_t *gyro_be) {
+    for (int i = 0; i < 3; i++) {
+        raw[i] = (int16_t)(accel_be[2 * i] << 8 | accel_be[2 * i + 1]);
+        raw[3 + i] = (int16_t)(gyro_be[2 * i] << 8 | gyro_be[2 * i + 1]);
+    }
+}
+
+void mpu6050_read(mpu6050_t *m, float *accel, float *gyro, float *temp) {
+    // accel, temp and gyro are consecutive, one 14 byte read
+    uint8_t buffer[14];
+    read_regs(m, MPU6050_ACCEL_XOUT_H, buffer, sizeof(buffer));
+    mpu6050_convert(&m->cal, buffer, buffer + 8, accel, gyro);
+    *temp = (int16_t)(buffer[6] << 8 | buffer[7]) / 340.0f + 36.53f;
+}
+
+void mpu6050_read_raw(mpu6050_t *m, int16_t *accel, int16_t *gyro) {
+    uint8_t buffer[14];
+    read_regs(m, MPU6050_ACCEL_XOUT_H, buffer, sizeof(buffer));
+    for (int i = 0; i < 3; i++) {
+        accel[i] = (int16_t)(buffer[2 * i] << 8 | buffer[2 * i + 1]);
+        gyro[i] = (int16_t)(buffer[8 + 2 * i] << 8 | buffer[8 + 2 * i + 1]);
+    }
+}
+
+static void fifo_reset(mpu6050_t *m) {
+    write_reg(m, MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_RST);
+    write_reg(m, MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_EN);
+    m->anchor_us = time_us_64();
+    m->since_anchor = 0;
+}
+
+static void set_rate(mpu6050_t *m, int rate_hz, int dlpf) {
+    if (dlpf < 0) dlpf = 0;
+    if (dlpf > 6) dlpf = 6;
+    // the gyro output rate is 8 kHz without the DLPF and 1 kHz with it,
+    // the sample rate divides it. Accel samples repeat above 1 kHz.
+    int base = dlpf ? 1000 : 8000;
+    if (rate_hz > 1000) rate_hz = 1000;
+    int div = (base + rate_hz / 2) / (rate_hz > 0 ? rate_hz : 1) - 1;
+    if (div < 0) div = 0;
+    if (div > 255) div = 255;
+    m->rate_hz = base / (div + 1);
+    m->period_us = 1000000u * (div + 1) / base;
+    write_reg(m, MPU6050_CONFIG, dlpf);
+    write_reg(m, MPU6050_SMPLRT_DIV, div);
+}
+
+void mpu6050_fifo_start(mpu6050_t *m, int rate_hz, int dlpf) {
+    write_reg(m, MPU6050_FIFO_EN, 0);
+    set_rate(m, rate_hz, dlpf);
+    write_reg(m, MPU6050_INT_ENABLE, MPU6050_INT_FIFO_OFLOW);
+    write_reg(m, MPU6050_FIFO_EN, MPU6050_FIFO_EN_ACCEL_GYRO);
+    fifo_reset(m);
+}
+
+void mpu6050_fifo_stop(mpu6050_t *m) {
+    write_reg(m, MPU6050_FIFO_EN, 0);
+    write_reg(m, MPU6050_USER_CTRL, 0);
+    m->rate_hz = 0;
+}
+
+int mpu6050_fifo_read(mpu6050_t *m, mpu6050_sample_t *out, int max) {
+    uint8_t status, count_be[2];
+    read_regs(m, MPU6050_INT_STATUS, &status, 1); // reading clears it
+    read_regs(m, MPU6050_FIFO_COUNTH, count_be, 2);
+    uint64_t t_count = time_us_64();
+    int count = count_be[0] << 8 | count_be[1];
+
+    // once full, the FIFO drops the oldest bytes and 1024 isn't a whole
+    // number of samples, so what is left can't be parsed: start over and
+    // count what the gap cost from the time it covers
+    if ((status & MPU6050_INT_FIFO_OFLOW) || count > MPU6050_FIFO_SIZE - MPU6050_FIFO_SAMPLE) {
+        uint64_t now = time_us_64();
+        uint32_t due = (uint32_t)((now - m->anchor_us) / m->period_us);
+        m->lost += due > m->since_anchor ? due - m->since_anchor : 0;
+        m->overflows++;
+        fifo_reset(m);
+        return 0;
+    }
+
+    int n = count / MPU6050_FIFO_SAMPLE;
+    if (n > max) n = max;
+    int done = 0;
+    while (done < n) {
+        uint8_t burst[MPU6050_BURST * MPU6050_FIFO_SAMPLE];
+        int k = n - done > MPU6050_BURST ? MPU6050_BURST : n - done;
+        // FIFO_R_W doesn't auto-increment, the whole burst comes from it
+        read_regs(m, MPU6050_FIFO_R_W, burst, k * MPU6050_FIFO_SAMPLE);
+        m->bursts++;
+        for (int i = 0; i < k; i++) {
+            const uint8_t *s = burst + i * MPU6050_FIFO_SAMPLE;
+            mpu6050_sample_t *o = &out[done + i];
+            mpu6050_convert(&m->cal, s, s + 6, o->accel, o->gyro);
+            keep_raw(o->raw, s, s + 6);
+            // the first sample lands one period after the reset
+            m->since_anchor++;
+            o->t_us = m->anchor_us + (uint64_t)m->since_anchor * m->period_us;
+        }
+        done += k;
+    }
+    m->samples += done;
+
+    // The chip's clock is only good to a percent or so, which count based
+    // stamps would turn into 10 ms of drift a second. When the FIFO was
+    // drained, its newest sample was taken within the period before the
+    // count was read: pull the anchor a little towards that each time.
+    if (done > 0 && done == count / MPU6050_FIFO_SAMPLE) {
+        uint64_t newest = m->anchor_us + (uint64_t)m->since_anchor * m->period_us;
+        int64_t err = (int64_t)(t_count - m->period_us / 2) - (int64_t)newest;
+        m->anchor_us += err / 8;
+    }
+    return done;
+}
+
+// Data-ready mode. The GPIO callback is shared by every pin on the core,
+// so only one IMU can use it at a time.
+static mpu6050_drdy_t *drdy;
+
+// the read for the newest edge is in RAM
+static void drdy_landed(mpu6050_drdy_t *r) {
+    uint32_t slot = r->head & (MPU6050_RING - 1);
+    uint32_t latency = (uint32_t)(time_us_64() - r->ring[slot].t_us);
+    if (latency > r->latency_max_us) r->latency_max_us = latency;
+    r->latency_sum_us += latency;
+    r->reads++;
+    r->head++;
+    r->reading = false;
+}
+
+static void drdy_txn_done(i2cbus_txn_t *t) {
+    mpu6050_drdy_t *r = t->arg;
+    if (t->state == I2CBUS_DONE) {
+        drdy_landed(r);
+    } else {
+        if (t->state == I2CBUS_ABORTED) {
+            r->aborts++;
+        } else {
+            r->busy++;
+        }
+        r->reading = false;
+    }
+}
+
+static void drdy_edge(uint gpio, uint32_t events) {
+    mpu6050_drdy_t *r = drdy;
+    if (!r || gpio != r->gpio || !(events & GPIO_IRQ_EDGE_RISE)) {
+        return;
+    }
+    uint64_t now = time_us_64();
+    r->edges++;
+    // more than one and a half periods since the last edge: some never came
+    if (r->last_edge_us) {
+        uint32_t period = r->m->period_us;
+        uint32_t gap = (uint32_t)(now - r->last_edge_us);
+        if (gap > period + period / 2) {
+            r->gaps += (gap + period / 2) / period - 1;
+        }
+    }
+    r->last_edge_us = now;
+
+    if (r->reading) {
+        r->busy++;
+        return;
+    }
+    if (r->head - r->tail >= MPU6050_RING) {
+        r->full++;
+        return;
+    }
+    uint32_t slot = r->head & (MPU6050_RING - 1);
+    r->ring[slot].t_us = now;
+    r->reading = true;
+
+    if (r->m->bus) {
+        r->txn = (i2cbus_txn_t){
+            .addr = r->m->addr, .device = r->m->bus_dev, .priority = I2CBUS_PRIO_HIGH,
+            .prefix = I2CBUS_NO_PREFIX, .tx = &r->reg, .tx_len = 1,
+            .rx = r->ring[slot].raw, .rx_len = MPU6050_DATA_BYTES,
+            .deadline_us = now + r->m->period_us, .done = drdy_txn_done, .arg = r,
+        };
+        if (!i2cbus_submit(r->m->bus, &r->txn)) {
+            r->busy++;
+            r->reading = false;
+        }
+        return;
+    }
+
+    // rx first, so it is waiting when the first byte comes back
+    i2c_hw_t *hw = i2c_get_hw(r->m->i2c);
+    dma_channel_config c = dma_channel_get_default_config(r->dma_rx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_dreq(&c, i2c_get_dreq(r->m->i2c, false));
+    dma_channel_configure(r->dma_rx, &c, r->ring[slot].raw, &hw->data_cmd, MPU6050_DATA_BYTES, true);
+
+    c = dma_channel_get_default_config(r->dma_tx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(r->m->i2c, true));
+    dma_channel_configure(r->dma_tx, &c, &hw->data_cmd, r->cmd, MPU6050_DATA_BYTES + 1, true);
+}
+
+// the IMU didn't answer (or lost arbitration): the controller has flushed
+// the read and sends a STOP, the rx channel would wait for its bytes forever
+static void drdy_abort(void) {
+    mpu6050_drdy_t *r = drdy;
+    if (!r) {
+        return;
+    }
+    i2c_hw_t *hw = i2c_get_hw(r->m->i2c);
+    if (!(hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS)) {
+        return;
+    }
+    (void)hw->clr_tx_abrt;
+    // an abort can raise the channel's interrupt, keep it out of drdy_landed()
+    dma_channel_set_irq1_enabled(r->dma_rx, false);
+    dma_channel_abort(r->dma_tx);
+    dma_channel_abort(r->dma_rx);
+    dma_channel_acknowledge_irq1(r->dma_rx);
+    dma_channel_set_irq1_enabled(r->dma_rx, true);
+    r->aborts++;
+    r->reading = false;
+}
+
+static void drdy_dma_done(void) {
+    mpu6050_drdy_t *r = drdy;
+    if (!r || !dma_channel_get_irq1_status(r->dma_rx)) {
+        return;
+    }
+    dma_channel_acknowledge_irq1(r->dma_rx);
+    drdy_landed(r);
+}
+
+void mpu6050_drdy_start(mpu6050_drdy_t *r, mpu6050_t *m, uint gpio, int rate_hz, int dlpf) {
+    *r = (mpu6050_drdy_t){ .m = m, .gpio = gpio };
+    write_reg(m, MPU6050_FIFO_EN, 0);
+    write_reg(m, MPU6050_USER_CTRL, 0);
+    m->rate_hz = 0;
+    set_rate(m, rate_hz, dlpf);
+
+    // register address, then 14 reads after a repeated start, STOP on the last
+    r->cmd[0] = MPU6050_ACCEL_XOUT_H;
+    for (int i = 1; i <= MPU6050_DATA_BYTES; i++) {
+        r->cmd[i] = I2C_IC_DATA_CMD_CMD_BITS;
+    }
+    r->cmd[1] |= I2C_IC_DATA_CMD_RESTART_BITS;
+    r->cmd[MPU6050_DATA_BYTES] |= I2C_IC_DATA_CMD_STOP_BITS;
+    r->reg = MPU6050_ACCEL_XOUT_H;
+
+    if (!m->bus) {
+        // the reads all go to the IMU from here on
+        i2c_hw_t *hw = i2c_get_hw(m->i2c);
+        hw->enable = 0;
+        hw->tar = m->addr;
+        hw->enable = 1;
+
+        r->dma_tx = dma_claim_unused_channel(true);
+        r->dma_rx = dma_claim_unused_channel(true);
+        dma_channel_set_irq1_enabled(r->dma_rx, true);
+        irq_add_shared_handler(DMA_IRQ_1, drdy_dma_done, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_1, true);
+
+        uint irq = I2C0_IRQ + i2c_hw_index(m->i2c);
+        hw->intr_mask = I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+        irq_set_exclusive_handler(irq, drdy_abort);
+        irq_set_enabled(irq, true);
+    }
+    drdy = r;
+
+    // INT: active high push-pull, a 50 us pulse per sample
+    write_reg(m, MPU6050_INT_PIN_CFG, 0x00);
+    write_reg(m, MPU6050_INT_ENABLE, MPU6050_INT_DATA_RDY);
+    gpio_init(gpio);
+    gpio_set_dir(gpio, GPIO_IN);
+    gpio_set_irq_enabled_with_callback(gpio, GPIO_IRQ_EDGE_RISE, true, drdy_edge);
+}
+
+void mpu6050_drdy_stop(mpu6050_drdy_t *r) {
+    gpio_set_irq_enabled(r->gpio, GPIO_IRQ_EDGE_RISE, false);
+    while (r->reading) {
+        tight_loop_contents();
+    }
+    if (!r->m->bus) {
+        uint irq = I2C0_IRQ + i2c_hw_index(r->m->i2c);
+        irq_set_enabled(irq, false);
+        irq_remove_handler(irq, drdy_abort);
+        i2c_get_hw(r->m->i2c)->intr_mask = 0;
+        dma_channel_set_irq1_enabled(r->dma_rx, false);
+        irq_remove_handler(DMA_IRQ_1, drdy_dma_done);
+        dma_channel_unclaim(r->dma_tx);
+        dma_channel_unclaim(r->dma_rx);
+    }
+    drdy = NULL;
+    write_reg(r->m, MPU6050_INT_ENABLE, 0);
+}
+
+int mpu6050_drdy_read(mpu6050_drdy_t *r, mpu6050_sample_t *out, int max) {
+    int n = 0;
+    while (n < max && r->tail != r->head) {
+        uint32_t slot = r->tail & (MPU6050_RING - 1);
+        const uint8_t *raw = r->ring[slot].raw;
+        mpu6050_convert(&r->m->cal, raw, raw + 8, out[n].accel, out[n].gyro);
+        keep_raw(out[n].raw, raw, raw + 8);
+        out[n].t_us = r->ring[slot].t_us;
+        r->tail++;
+        n++;
+    }
+    r->m->samples += n;
+    return n;
+}
+
+uint32_t mpu6050_drdy_missed(const mpu6050_drdy_t *r) {
+    return r->busy + r->full + r->gaps + r->aborts;
+}
@@ -0,0 +1,166 @@
+#ifndef MPU6050_H__
+#define MPU6050_H__
+
+// MPU6050 accelerometer/gyro on I2C.
+//
+// mpu6050_read() takes one snapshot of the data registers, so the sample
+// rate is however often it gets called. In FIFO mode the chip samples on
+// its own clock at a set rate (up to 1 kHz) into its 1 KB FIFO, and
+// mpu6050_fifo_read() drains it in bursts of whole samples, so no sample
+// is skipped or read twice however long the rest of the loop takes, as
+// long as it comes back before the FIFO fills (85 samples). Each sample
+// gets a timestamp from its position in the stream, not from when it was
+// read. A full FIFO is detected, reset and the samples it cost counted.
+//
+// In data-ready mode the INT pin is wired to a GPIO instead. Each rising
+// edge is stamped with time_us_64() in the GPIO interrupt, which starts a
+// DMA read of the data registers into a ring of samples; the DMA interrupt
+// marks the sample done. The main loop only copies finished samples out.
+// The reads are started from interrupts at any time, so the I2C port has
+// to belong to the IMU alone in this mode, unless it is shared through the
+// bus scheduler (mpu6050_init_bus()): then each edge queues its read there
+// at high priority, with the next edge as its deadline.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/i2c.h"
+#include "hardware/gpio.h"
+#include "i2cbus.h"
+
+#define MPU6050_ADDR 0x68
+
+// registers
+#define MPU6050_SMPLRT_DIV   0x19
+#define MPU6050_CONFIG       0x1A
+#define MPU6050_GYRO_CONFIG  0x1B
+#define MPU6050_ACCEL_CONFIG 0x1C
+#define MPU6050_FIFO_EN      0x23
+#define MPU6050_INT_PIN_CFG  0x37
+#define MPU6050_INT_ENABLE   0x38
+#define MPU6050_INT_STATUS   0x3A
+#define MPU6050_ACCEL_XOUT_H 0x3B
+#define MPU6050_TEMP_OUT_H   0x41
+#define MPU6050_GYRO_XOUT_H  0x43
+#define MPU6050_USER_CTRL    0x6A
+#define MPU6050_PWR_MGMT_1   0x6B
+#define MPU6050_PWR_MGMT_2   0x6C
+#define MPU6050_FIFO_COUNTH  0x72
+#define MPU6050_FIFO_R_W     0x74
+#define MPU6050_WHO_AM_I     0x75
+
+// register bits
+#define MPU6050_FIFO_EN_ACCEL_GYRO 0x78 // XG, YG, ZG and ACCEL into the FIFO
+#define MPU6050_USER_CTRL_FIFO_EN  0x40
+#define MPU6050_USER_CTRL_FIFO_RST 0x04
+#define MPU6050_INT_FIFO_OFLOW     0x10
+#define MPU6050_INT_DATA_RDY       0x01
+
+#define MPU6050_FIFO_SIZE    1024
+#define MPU6050_FIFO_SAMPLE  12 // accel xyz, gyro xyz, big endian
+#define MPU6050_BURST        32 // samples per FIFO read transaction
+#define MPU6050_RING         64 // data-ready samples, a power of two
+#define MPU6050_DATA_BYTES   14 // accel, temp and gyro registers
+
+// +-2 g and +-250 deg/s
+#define MPU6050_ACCEL_G   0.000061f
+#define MPU6050_GYRO_DPS  0.007630f
+
+// Corrections applied to the raw counts before they become floats: accel
+// (raw - offset) * scale / MPU6050_CAL_ONE, gyro raw - offset. Identity
+// after init, imucal.h works them out and keeps them in flash.
+#define MPU6050_CAL_ONE 16384 // scale 1.0
+
+typedef struct {
+    int16_t accel_offset[3];
+    uint16_t accel_scale[3];
+    int16_t gyro_offset[3];
+} mpu6050_cal_t;
+
+typedef struct {
+    float accel[3];  // g
+    float gyro[3];   // deg/s
+    int16_t raw[6];  // accel xyz, gyro xyz counts as read, before the calibration
+    uint64_t t_us;   // when the chip took it, on the time_us_64() clock
+} mpu6050_sample_t;
+
+typedef struct {
+    i2c_inst_t *i2c;
+    uint8_t addr;
+    i2cbus_t *bus;           // NULL when the driver has the port to itself
+    int bus_dev;
+    mpu6050_cal_t cal;       // applied to every reading
+
+    // FIFO mode, rate_hz is 0 when it's off
+    uint16_t rate_hz;
+    uint32_t period_us;
+    uint64_t anchor_us;      // when the FIFO was last reset
+    uint32_t since_anchor;   // samples read since then
+
+    uint32_t samples;        // samples read from the FIFO or the data-ready ring
+    uint32_t lost;           // samples lost to overflows
+    uint32_t overflows;
+    uint32_t bursts;         // FIFO read transactions
+} mpu6050_t;
+
+typedef struct {
+    mpu6050_t *m;
+    uint gpio;
+    int dma_tx, dma_rx;
+    uint32_t cmd[MPU6050_DATA_BYTES + 1]; // IC_DATA_CMD words for one read
+    i2cbus_txn_t txn;                     // or the same read through the bus
+    uint8_t reg;
+
+    struct {
+        uint8_t raw[MPU6050_DATA_BYTES];
+        uint64_t t_us;                    // data-ready edge
+    } ring[MPU6050_RING];
+    volatile uint32_t head;               // samples landed, moved by the DMA interrupt
+    uint32_t tail;                        // samples handed out
+    volatile bool reading;                // a read is in flight
+    volatile uint64_t last_edge_us;
+
+    // written from the interrupts
+    volatile uint32_t edges;
+    volatile uint32_t busy;               // edges that came while a read was in flight, or lost it
+    volatile uint32_t aborts;             // reads the IMU didn't answer
+    volatile uint32_t full;               // edges dropped because the ring was full
+    volatile uint32_t gaps;               // edges that never came, from the spacing
+    volatile uint32_t reads;
+    volatile uint32_t latency_max_us;     // edge to data in RAM
+    volatile uint64_t latency_sum_us;
+} mpu6050_drdy_t;
+
+// wake it up at +-2 g and +-250 deg/s, gyro PLL clock
+void mpu6050_init(mpu6050_t *m, i2c_inst_t *i2c, uint8_t addr);
+// the same on a shared bus, the IMU is its high priority device
+void mpu6050_init_bus(mpu6050_t *m, i2cbus_t *bus, uint8_t addr);
+bool mpu6050_check(mpu6050_t *m);
+// one snapshot of the data registers
+void mpu6050_read(mpu6050_t *m, float *accel, float *gyro, float *temp);
+// the same as counts, without the calibration, for working it out
+void mpu6050_read_raw(mpu6050_t *m, int16_t *accel, int16_t *gyro);
+
+// sample accel and gyro at rate_hz into the FIFO. dlpf is the CONFIG
+// low pass setting, 1 (184 Hz) .. 6 (5 Hz), or 0 for none. Rates that
+// don't divide the internal rate are rounded.
+void mpu6050_fifo_start(mpu6050_t *m, int rate_hz, int dlpf);
+void mpu6050_fifo_stop(mpu6050_t *m);
+// read up to max samples, oldest first. Returns how many.
+int mpu6050_fifo_read(mpu6050_t *m, mpu6050_sample_t *out, int max);
+
+// sample on data-ready edges from the INT pin on gpio, with the FIFO off.
+// Claims the GPIO interrupt callback, and two DMA channels unless the
+// reads go through a bus.
+void mpu6050_drdy_start(mpu6050_drdy_t *r, mpu6050_t *m, uint gpio, int rate_hz, int dlpf);
+void mpu6050_drdy_stop(mpu6050_drdy_t *r);
+// copy out up to max finished samples, oldest first. Returns how many.
+int mpu6050_drdy_read(mpu6050_drdy_t *r, mpu6050_sample_t *out, int max);
+// samples that never made it into the ring, for any reason
+uint32_t mpu6050_drdy_missed(const mpu6050_drdy_t *r);
+
+// big endian register bytes to physical units, corrected by cal
+void mpu6050_convert(const mpu6050_cal_t *cal, const uint8_t *accel_be, const uint8_t *gyro_be, float *accel,
+                     float *gyro);
+void mpu6050_cal_identity(mpu6050_cal_t *cal);
+
+#endif
@@ -0,0 +1,129 @@
+// accelerometer vibration spectrum, see spectrum.h
+
+#include <string.h>
+#include <math.h>
+#include "pico/stdlib.h"
+#include "spectrum.h"
+#include "mpu6050.h"
+#include "gfx.h"
+
+void spectrum_init(spectrum_t *s, int log2n, uint16_t rate_hz, int axis) {
+    fft_init();
+    s->log2n = (uint8_t)log2n;
+    s->n = (uint16_t)(1u << log2n);
+    s->axis = (uint8_t)axis;
+    s->rate_hz = rate_hz;
+    s->fill = 0;
+    s->peaks = 0;
+    s->blocks = 0;
+    s->compute_us = 0;
+    // periodic Hann, the one whose bins line up with the FFT's
+    for (int i = 0; i < s->n; i++) {
+        s->window[i] = (int16_t)lrintf(32767 * 0.5f * (1 - cosf(2 * (float)M_PI * i / s->n)));
+    }
+    memset(s->amp, 0, sizeof(s->amp));
+}
+
+// amp += the power of one axis, in g^2
+static void add_axis(spectrum_t *s, const int16_t *in) {
+    int n = s->n;
+    int32_t sum = 0;
+    for (int i = 0; i < n; i++) sum += in[i];
+    int32_t mean = sum / n;
+    for (int i = 0; i < n; i++) {
+        int32_t v = in[i] - mean;
+        if (v > 32767) v = 32767;
+        if (v < -32768) v = -32768;
+        s->re[i] = (int16_t)((v * s->window[i] + (1 << 14)) >> 15);
+        s->im[i] = 0;
+    }
+    int exponent = fft_q15(s->re, s->im, s->log2n);
+    // a sine of amplitude A at a bin comes out as A n / 4: half of it in
+    // the bin below n / 2, and the window's mean of a half
+    float scale = ldexpf(4.0f / n * MPU6050_ACCEL_G, exponent);
+    float scale2 = scale * scale;
+    for (int k = 0; k < n / 2; k++) {
+        uint32_t mag2 = (uint32_t)(s->re[k] * s->re[k]) + (uint32_t)(s->im[k] * s->im[k]);
+        s->amp[k] += mag2 * scale2;
+    }
+}
+
+static void find_peaks(spectrum_t *s) {
+    const float *a = s->amp;
+    s->peaks = 0;
+    for (int k = 2; k < s->n / 2 - 1; k++) {
+        if (!(a[k] > a[k - 1] && a[k] >= a[k + 1] && a[k] > SPECTRUM_FLOOR_G)) {
+            continue;
+        }
+        // a Hann main lobe's power is 1.5 bins' worth, most of it in these three
+        float g = sqrtf((a[k - 1] * a[k - 1] + a[k] * a[k] + a[k + 1] * a[k + 1]) / 1.5f);
+        // the lobe is close to a Gaussian, a parabola through the logs finds its top
+        float l0 = logf(a[k - 1] + 1e-9f), l1 = logf(a[k]), l2 = logf(a[k + 1] + 1e-9f);
+        float den = l0 - 2 * l1 + l2;
+        float d = den < 0 ? 0.5f * (l0 - l2) / den : 0;
+        spectrum_peak_t p = { (k + d) * spectrum_bin_hz(s), g };
+
+        // biggest first
+        int at = s->peaks < SPECTRUM_PEAKS ? s->peaks++ : SPECTRUM_PEAKS;
+        while (at > 0 && s->peak[at - 1].g < g) {
+            if (at < SPECTRUM_PEAKS) s->peak[at] = s->peak[at - 1];
+            at--;
+        }
+        if (at < SPECTRUM_PEAKS) s->peak[at] = p;
+    }
+}
+
+bool spectrum_add(spectrum_t *s, const int16_t *accel) {
+    for (int i = 0; i < 3; i++) {
+        s->in[i][s->fill] = accel[i];
+    }
+    if (++s->fill < s->n) {
+        return false;
+    }
+
+    uint32_t t0 = time_us_32();
+    memset(s->amp, 0, sizeof(s->amp));
+    for (int i = 0; i < 3; i++) {
+        if (s->axis == i || s->axis == SPECTRUM_ALL) {
+            add_axis(s, s->in[i]);
+        }
+    }
+    for (int k = 0; k < s->n / 2; k++) {
+        s->amp[k] = sqrtf(s->amp[k]);
+    }
+    find_peaks(s);
+    s->compute_us = time_us_32() - t0;
+    s->blocks++;
+
+    // the second half starts the next block
+    int half = s->n / 2;
+    for (int i = 0; i < 3; i++) {
+        memmove(s->in[i], s->in[i] + half, half * sizeof(int16_t));
+    }
+    s->fill = (uint16_t)half;
+    return true;
+}
+
+void spectrum_draw(const spectrum_t *s, ssd1306_t *d, int x, int y, int w, int h) {
+    const float range = logf(SPECTRUM_TOP_G / SPECTRUM_FLOOR_G);
+    int bins = s->n / 2;
+    gfx_fill_rect(d, x, y, w, h, 0);
+    for (int c = 0; c < w; c++) {
+        // the biggest of the bins under this column
+        int b0 = c * bins / w, b1 = (c + 1) * bins / w;
+        if (b1 <= b0) b1 = b0 + 1;
+        float a = 0;
+        for (int k = b0; k < b1; k++) {
+            if (s->amp[k] > a) a = s->amp[k];
+        }
+        if (a <= SPECTRUM_FLOOR_G) {
+            continue;
+        }
+        int bar = (int)lrintf(logf(a / SPECTRUM_FLOOR_G) / range * h);
+        if (bar > h) bar = h;
+        if (bar > 0) {
+            gfx_vline(d, x + c, y + h - bar, y + h - 1, 1);
+        }
+    }
+    ssd1306_mark_dirty(d, x, y, w, h);
+}
@@ -0,0 +1,64 @@
+#ifndef SPECTRUM_H__
+#define SPECTRUM_H__
+
+// Vibration spectrum of the accelerometer, worked out on the Pico.
+//
+// Raw accel counts go into a block of n points per axis. When a block is
+// full, each axis has its mean taken off, a Hann window applied and a Q15
+// FFT (fft.h) run on it. The bins are turned into the amplitude of a sine
+// at that frequency, in g, and for SPECTRUM_ALL the three axes are added
+// as power, so the direction of the shaking doesn't matter. Blocks overlap
+// by half, a new spectrum every n / 2 samples.
+//
+// The peaks are the largest local maxima above SPECTRUM_FLOOR_G, with the
+// frequency interpolated between bins and the amplitude summed over the
+// main lobe, which keeps both within a percent or so wherever the tone
+// falls between bins. The counts are the raw ones, so the calibration's
+// scale (a few percent) isn't applied.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ssd1306.h"
+#include "fft.h"
+
+#define SPECTRUM_MAX     FFT_MAX
+#define SPECTRUM_ALL     3         // axis: all three
+#define SPECTRUM_PEAKS   3
+#define SPECTRUM_FLOOR_G 0.002f    // smallest peak reported, and the bottom of the bars
+#define SPECTRUM_TOP_G   1.0f      // top of the bars, on a log scale
+
+typedef struct {
+    float hz;
+    float g;                       // amplitude
+} spectrum_peak_t;
+
+typedef struct {
+    uint16_t n;
+    uint8_t log2n;
+    uint8_t axis;                  // 0..2, or SPECTRUM_ALL
+    uint16_t rate_hz;
+    uint16_t fill;                 // samples in the block so far
+
+    int16_t in[3][SPECTRUM_MAX];   // raw counts
+    int16_t window[SPECTRUM_MAX];  // Hann, Q15
+    int16_t re[SPECTRUM_MAX], im[SPECTRUM_MAX];
+
+    float amp[SPECTRUM_MAX / 2];   // g per bin, bin k is k * rate / n Hz
+    spectrum_peak_t peak[SPECTRUM_PEAKS];
+    int peaks;                     // biggest first
+    uint32_t blocks;
+    uint32_t compute_us;           // for the last block
+} spectrum_t;
+
+// log2n 4..FFT_MAX_LOG2
+void spectrum_init(spectrum_t *s, int log2n, uint16_t rate_hz, int axis);
+// one raw accel sample (mpu6050_sample_t raw[0..2]). Returns true when it
+// finished a block and amp and peak are new.
+bool spectrum_add(spectrum_t *s, const int16_t *accel);
+static inline float spectrum_bin_hz(const spectrum_t *s) { return (float)s->rate_hz / s->n; }
+
+// bars over x..x+w-1, y..y+h-1, 0 Hz to rate / 2 left to right, height in
+// dB from SPECTRUM_FLOOR_G to SPECTRUM_TOP_G. Marks the area dirty.
+void spectrum_draw(const spectrum_t *s, ssd1306_t *d, int x, int y, int w, int h);
+
+#endif
@@ -2,49 +2,46 @@
 
 #include <string.h> // for memset
 #include "ssd1306.h"
-#include "hardware/i2c.h"
 #include "pico/stdlib.h"
 
-unsigned char SSD1306_ADDRESS = 0b0111100; // 7bit i2c address
-unsigned char ssd1306_buffer[513]; // 128x32/8. Every bit is a pixel except first byte
-
-void ssd1306_setup() {
-    // first byte in ssd1306_buffer is a command
-    ssd1306_buffer[0] = 0x40;
+void ssd1306_setup(ssd1306_t *d) {
+    // first byte in the buffer is a command
+    d->buffer[0] = 0x40;
+    d->transport->init(d);
     // give a little delay for the ssd1306 to power up
     //_CP0_SET_COUNT(0);
     //while (_CP0_GET_COUNT() < 48000000 / 2 / 50) {
     //}
     sleep_ms(20);
-    ssd1306_command(SSD1306_DISPLAYOFF);
-    ssd1306_command(SSD1306_SETDISPLAYCLOCKDIV);
-    ssd1306_command(0x80);
-    ssd1306_command(SSD1306_SETMULTIPLEX);
-    ssd1306_command(0x1F); // height-1 = 31
-    ssd1306_command(SSD1306_SETDISPLAYOFFSET);
-    ssd1306_command(0x0);
-    ssd1306_command(SSD1306_SETSTARTLINE);
-    ssd1306_command(SSD1306_CHARGEPUMP);
-    ssd1306_command(0x14);
-    ssd1306_command(SSD1306_MEMORYMODE);
-    ssd1306_command(0x00);
-    ssd1306_command(SSD1306_SEGREMAP | 0x1);
-    ssd1306_command(SSD1306_COMSCANDEC);
-    ssd1306_command(SSD1306_SETCOMPINS);
-    ssd1306_command(0x02);
-    ssd1306_command(SSD1306_SETCONTRAST);
-    ssd1306_command(0x8F);
-    ssd1306_command(SSD1306_SETPRECHARGE);
-    ssd1306_command(0xF1);
-    ssd1306_command(SSD1306_SETVCOMDETECT);
-    ssd1306_command(0x40);
-    ssd1306_command(SSD1306_DISPLAYON);
-    ssd1306_clear();
-    ssd1306_update();
+    ssd1306_command(d, SSD1306_DISPLAYOFF);
+    ssd1306_command(d, SSD1306_SETDISPLAYCLOCKDIV);
+    ssd1306_command(d, 0x80);
+    ssd1306_command(d, SSD1306_SETMULTIPLEX);
+    ssd1306_command(d, SSD1306_MULTIPLEX(d->height)); // height-1
+    ssd1306_command(d, SSD1306_SETDISPLAYOFFSET);
+    ssd1306_command(d, 0x0);
+    ssd1306_command(d, SSD1306_SETSTARTLINE);
+    ssd1306_command(d, SSD1306_CHARGEPUMP);
+    ssd1306_command(d, 0x14);
+    ssd1306_command(d, SSD1306_MEMORYMODE);
+    ssd1306_command(d, 0x00);
+    ssd1306_command(d, SSD1306_SEGREMAP | 0x1);
+    ssd1306_command(d, SSD1306_COMSCANDEC);
+    ssd1306_command(d, SSD1306_SETCOMPINS);
+    ssd1306_command(d, SSD1306_COMPINS(d->height));
+    ssd1306_command(d, SSD1306_SETCONTRAST);
+    ssd1306_command(d, 0x8F);
+    ssd1306_command(d, SSD1306_SETPRECHARGE);
+    ssd1306_command(d, 0xF1);
+    ssd1306_command(d, SSD1306_SETVCOMDETECT);
+    ssd1306_command(d, 0x40);
+    ssd1306_command(d, SSD1306_DISPLAYON);
+    ssd1306_clear(d);
+    ssd1306_update(d);
 }
 
 // send a command instruction (not pixel data)
-void ssd1306_command(unsigned char c) {
+void ssd1306_command(ssd1306_t *d, unsigned char c) {
     //i2c_master_start();
     //i2c_master_send(ssd1306_write);
     //i2c_master_send(0x00); // bit 7 is 0 for Co bit (data bytes only), bit 6 is 0 for DC (data is a command))
@@ -54,49 +51,142 @@ void ssd1306_command(unsigned char c) {
     uint8_t buf[2];
     buf[0] = 0x00;
     buf[1] =c;
-    i2c_write_blocking(i2c_default, SSD1306_ADDRESS, buf, 2, false);
+    d->transport->write(d, buf, 2);
+}
+
+// point the controller's write window at columns x0..x1 of pages p0..p1.
+// Co = 0 and D/C = 0 in the control byte: every byte after it is a command,
+// so the whole window is one transaction instead of six.
+static void ssd1306_window(ssd1306_t *d, uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1) {
+    uint8_t buf[7] = { 0x00, SSD1306_PAGEADDR, p0, p1, SSD1306_COLUMNADDR, x0, x1 };
+    d->transport->write(d, buf, sizeof(buf));
+}
+
+static void ssd1306_window_all(ssd1306_t *d) {
+    ssd1306_window(d, 0, d->width - 1, 0, d->pages - 1);
+    d->dirty_pages = 0;
 }
 
 // update every pixel on the screen
-void ssd1306_update() {
-    ssd1306_command(SSD1306_PAGEADDR);
-    ssd1306_command(0);
-    ssd1306_command(0xFF);
-    ssd1306_command(SSD1306_COLUMNADDR);
-    ssd1306_command(0);
-    ssd1306_command(128 - 1); // Width
-
-    unsigned short count = 512; // WIDTH * ((HEIGHT + 7) / 8)
-    unsigned char * ptr = ssd1306_buffer; // first address of the pixel buffer
-    /*
-    i2c_master_start();
-    i2c_master_send(ssd1306_write);
-    i2c_master_send(0x40); // send pixel data
-    // send every pixel
-    while (count--) {
-        i2c_master_send(*ptr++);
+void ssd1306_update(ssd1306_t *d) {
+    ssd1306_update_wait(d);
+    ssd1306_window_all(d);
+
+    // control byte and every pixel in one transaction
+    d->transport->write(d, d->buffer, SSD1306_BUFFER_SIZE(d->width, d->height));
+}
+
+void ssd1306_update_start(ssd1306_t *d) {
+    ssd1306_update_wait(d);
+    ssd1306_window_all(d);
+    d->transport->write_start(d, d->buffer, SSD1306_BUFFER_SIZE(d->width, d->height));
+}
+
+void ssd1306_write_gddram(ssd1306_t *d, uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1,
+                          const uint8_t *data, unsigned int len) {
+    ssd1306_update_wait(d);
+    ssd1306_window(d, x0, x1, p0, p1);
+    d->transport->write(d, data, len);
+}
+
+void ssd1306_set_start_line(ssd1306_t *d, uint8_t line) {
+    ssd1306_update_wait(d);
+    ssd1306_command(d, SSD1306_SETSTARTLINE | (line & 0x3F));
+}
+
+bool ssd1306_update_busy(ssd1306_t *d) {
+    return d->dma_active && d->transport->busy(d);
+}
+
+void ssd1306_update_wait(ssd1306_t *d) {
+    while (ssd1306_update_busy(d)) {
+        tight_loop_contents();
     }
-    i2c_master_stop();
-    */
+}
 
-    i2c_write_blocking(i2c_default, SSD1306_ADDRESS, ptr, 513, false);
+void ssd1306_mark_dirty(ssd1306_t *d, int x, int y, int w, int h) {
+    int x0 = x < 0 ? 0 : x;
+    int x1 = x + w > d->width ? d->width - 1 : x + w - 1;
+    int y0 = y < 0 ? 0 : y;
+    int y1 = y + h > d->height ? d->height - 1 : y + h - 1;
+    if (x0 > x1 || y0 > y1) {
+        return;
+    }
+    for (int p = y0 >> 3; p <= y1 >> 3; p++) {
+        if (d->dirty_pages & (1u << p)) {
+            if (x0 < d->dirty_x0[p]) d->dirty_x0[p] = x0;
+            if (x1 > d->dirty_x1[p]) d->dirty_x1[p] = x1;
+        } else {
+            d->dirty_pages |= 1u << p;
+            d->dirty_x0[p] = x0;
+            d->dirty_x1[p] = x1;
+        }
+    }
+}
+
+// bytes a separate window costs on top of its data: window command
+// transaction (7) plus the data control byte and two address bytes
+#define WINDOW_OVERHEAD 10
+
+// Consecutive dirty pages go out as one window over the union of their
+// columns, as long as that sends fewer bytes than splitting them up.
+void ssd1306_update_dirty(ssd1306_t *d) {
+    static unsigned char out[SSD1306_BUFFER_SIZE(128, 64)];
+
+    ssd1306_update_wait(d);
+    int p = 0;
+    while (p < d->pages) {
+        if (!(d->dirty_pages & (1u << p))) {
+            p++;
+            continue;
+        }
+        int p0 = p;
+        int x0 = d->dirty_x0[p];
+        int x1 = d->dirty_x1[p];
+        int separate = x1 - x0 + 1;
+        while (p + 1 < d->pages && (d->dirty_pages & (1u << (p + 1)))) {
+            int nx0 = d->dirty_x0[p + 1] < x0 ? d->dirty_x0[p + 1] : x0;
+            int nx1 = d->dirty_x1[p + 1] > x1 ? d->dirty_x1[p + 1] : x1;
+            int merged = (p + 2 - p0) * (nx1 - nx0 + 1);
+            int split = separate + WINDOW_OVERHEAD + d->dirty_x1[p + 1] - d->dirty_x0[p + 1] + 1;
+            if (merged > split) {
+                break;
+            }
+            p++;
+            x0 = nx0;
+            x1 = nx1;
+            separate = merged;
+        }
+
+        int n = 0;
+        int width = x1 - x0 + 1;
+        out[n++] = 0x40;
+        for (int q = p0; q <= p; q++) {
+            memcpy(out + n, d->buffer + 1 + q * d->width + x0, width);
+            n += width;
+        }
+        ssd1306_window(d, x0, x1, p0, p);
+        d->transport->write(d, out, n);
+        p++;
+    }
+    d->dirty_pages = 0;
 }
 
 // set a pixel value. Call update() to push to the display)
-void ssd1306_drawPixel(unsigned char x, unsigned char y, unsigned char color) {
-    if ((x < 0) || (x >= 128) || (y < 0) || (y >= 32)) {
+void ssd1306_drawPixel(ssd1306_t *d, unsigned char x, unsigned char y, unsigned char color) {
+    if ((x >= d->width) || (y >= d->height)) {
         return;
     }
 
     if (color == 1) {
-        ssd1306_buffer[1 + x + (y / 8)*128] |= (1 << (y & 7));
+        d->buffer[1 + x + (y / 8)*d->width] |= (1 << (y & 7));
     } else {
-        ssd1306_buffer[1 + x + (y / 8)*128] &= ~(1 << (y & 7));
+        d->buffer[1 + x + (y / 8)*d->width] &= ~(1 << (y & 7));
     }
 }
 
 // zero every pixel value
-void ssd1306_clear() {
-    memset(ssd1306_buffer, 0, 512); // make every bit a 0, memset in string.h
-    ssd1306_buffer[0] = 0x40; // first byte is part of command
+void ssd1306_clear(ssd1306_t *d) {
+    memset(d->buffer, 0, SSD1306_BUFFER_SIZE(d->width, d->height)); // make every bit a 0, memset in string.h
+    d->buffer[0] = 0x40; // first byte is part of command
 }
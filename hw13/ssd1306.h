@@ -1,6 +1,12 @@
 #ifndef SSD1306_H__
 #define SSD1306_H__
 
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "i2cbus.h"
+
 // Based on the adafruit and sparkfun libraries
 #define SSD1306_MEMORYMODE          0x20 
 #define SSD1306_COLUMNADDR          0x21 
@@ -23,12 +29,131 @@
 #define SSD1306_SETSTARTLINE        0x40 
 #define SSD1306_DEACTIVATE_SCROLL   0x2E ///< Stop scroll
 
-void ssd1306_setup(void);
-void ssd1306_update(void);
-void ssd1306_clear(void);
-void ssd1306_drawPixel(unsigned char x, unsigned char y, unsigned char color);
+#define SSD1306_DEFAULT_ADDRESS     0x3C // 7bit i2c address
+
+// Everything that depends on the panel geometry is worked out here, at
+// compile time. 128 wide, 32 or 64 tall. The 64 wide modules are wired
+// to GDDRAM columns 32..95 and 64x32 needs the alternative COM pins too,
+// none of which is handled here.
+#define SSD1306_PAGES(h)            ((h) / 8)
+#define SSD1306_BUFFER_SIZE(w, h)   (1 + (w) * SSD1306_PAGES(h)) // 0x40 control byte + pixels
+#define SSD1306_MULTIPLEX(h)        ((h) - 1)
+#define SSD1306_COMPINS(h)          ((h) == 64 ? 0x12 : 0x02) // alternative COM pins for 64 rows
+
+typedef struct ssd1306 ssd1306_t;
+
+// How bytes reach the controller. bytes[0] is always the I2C control byte
+// (0x00: commands follow, 0x40: data follows, Co clear), so a frame goes
+// out of the buffer as is over I2C. The SPI backend sets D/C from it and
+// sends the rest.
+typedef struct {
+    void (*init)(ssd1306_t *d);                                           // pins and DMA
+    void (*write)(ssd1306_t *d, const uint8_t *bytes, unsigned int len);  // blocking
+    void (*write_start)(ssd1306_t *d, const uint8_t *bytes, unsigned int len); // DMA
+    bool (*busy)(ssd1306_t *d);                                           // write_start still running
+} ssd1306_transport_t;
+
+extern const ssd1306_transport_t ssd1306_i2c_transport; // ssd1306_i2c.c
+extern const ssd1306_transport_t ssd1306_spi_transport; // ssd1306_spi.c, 4-wire up to 10 MHz
+extern const ssd1306_transport_t ssd1306_i2cbus_transport; // ssd1306_i2cbus.c, shared with others
+
+// One display. Make these with SSD1306_DEFINE or SSD1306_DEFINE_SPI so the
+// buffers are sized for the panel, then treat the fields as read only.
+struct ssd1306 {
+    const ssd1306_transport_t *transport;
+    i2c_inst_t *i2c;         // I2C: bus and 7 bit address
+    uint8_t address;
+    i2cbus_t *bus;           // I2C through the bus scheduler: its transaction and device id
+    i2cbus_txn_t *txn;
+    int bus_dev;
+    spi_inst_t *spi;         // SPI: bus (SCK/MOSI set up by the caller) and GPIOs
+    uint8_t dc_pin;
+    uint8_t cs_pin;
+    uint8_t reset_pin;       // SSD1306_NO_PIN if RES is tied high
+    uint8_t width;
+    uint8_t height;
+    uint8_t pages;
+    unsigned char *buffer;   // SSD1306_BUFFER_SIZE bytes, buffer[0] is 0x40
+    uint32_t *dma_words;     // I2C only: IC_DATA_CMD words for ssd1306_update_start()
+    int dma_chan;
+    bool dma_active;         // an update_start() frame has not finished yet
+    uint8_t dirty_pages;     // bit p set: columns dirty_x0[p]..dirty_x1[p] of page p changed
+    uint8_t dirty_x0[8];
+    uint8_t dirty_x1[8];
+};
+
+#define SSD1306_NO_PIN 0xFF
+
+#define SSD1306_CHECK_GEOMETRY(w, h) \
+    _Static_assert((w) == 128 && ((h) == 32 || (h) == 64), \
+                   "unsupported SSD1306 geometry")
+
+// SSD1306_DEFINE(oled, 128, 32, i2c0, SSD1306_DEFAULT_ADDRESS);
+// defines `ssd1306_t oled` plus its statically allocated buffers.
+#define SSD1306_DEFINE(name, w, h, port, addr) \
+    SSD1306_CHECK_GEOMETRY(w, h); \
+    static unsigned char name##_buffer[SSD1306_BUFFER_SIZE(w, h)]; \
+    static uint32_t name##_dma_words[SSD1306_BUFFER_SIZE(w, h)]; \
+    ssd1306_t name = { \
+        .transport = &ssd1306_i2c_transport, .i2c = (port), .address = (addr), \
+        .width = (w), .height = (h), .pages = SSD1306_PAGES(h), \
+        .buffer = name##_buffer, .dma_words = name##_dma_words, .dma_chan = -1, .dma_active = false, \
+    }
+
+// SSD1306_DEFINE_SPI(oled, 128, 64, spi0, 20, 17, 21);
+// same for a panel on SPI with D/C, CS and RES on the given GPIOs. The DMA
+// feeds the SPI data register straight from the buffer.
+#define SSD1306_DEFINE_SPI(name, w, h, port, dc, cs, rst) \
+    SSD1306_CHECK_GEOMETRY(w, h); \
+    static unsigned char name##_buffer[SSD1306_BUFFER_SIZE(w, h)]; \
+    ssd1306_t name = { \
+        .transport = &ssd1306_spi_transport, .spi = (port), \
+        .dc_pin = (dc), .cs_pin = (cs), .reset_pin = (rst), \
+        .width = (w), .height = (h), .pages = SSD1306_PAGES(h), \
+        .buffer = name##_buffer, .dma_words = NULL, .dma_chan = -1, .dma_active = false, \
+    }
+
+// SSD1306_DEFINE_BUS(oled, 128, 32, &bus, SSD1306_DEFAULT_ADDRESS);
+// same for a panel on an I2C bus shared through i2cbus.h. Frames go out a
+// page or so at a time at low priority, so reads of other devices on the
+// bus get in between.
+#define SSD1306_DEFINE_BUS(name, w, h, busp, addr) \
+    SSD1306_CHECK_GEOMETRY(w, h); \
+    static unsigned char name##_buffer[SSD1306_BUFFER_SIZE(w, h)]; \
+    static i2cbus_txn_t name##_txn; \
+    ssd1306_t name = { \
+        .transport = &ssd1306_i2cbus_transport, .bus = (busp), .txn = &name##_txn, .address = (addr), \
+        .width = (w), .height = (h), .pages = SSD1306_PAGES(h), \
+        .buffer = name##_buffer, .dma_words = NULL, .dma_chan = -1, .dma_active = false, \
+    }
+
+void ssd1306_setup(ssd1306_t *d);
+void ssd1306_update(ssd1306_t *d);
+void ssd1306_clear(ssd1306_t *d);
+void ssd1306_drawPixel(ssd1306_t *d, unsigned char x, unsigned char y, unsigned char color);
+
+// DMA version of ssd1306_update(). Returns once the transfer is running, so
+// displays on different buses can be refreshed at the same time. Don't touch
+// the bus or the buffer until ssd1306_update_wait() returns.
+void ssd1306_update_start(ssd1306_t *d);
+bool ssd1306_update_busy(ssd1306_t *d);
+void ssd1306_update_wait(ssd1306_t *d);
+
+// Raw GDDRAM access for code that manages the panel itself (the console).
+// The controller has 8 pages whatever the panel height, so pages the
+// panel doesn't show can be written too and brought in with the start
+// line. data[0] must be the 0x40 control byte, the pixels follow in page
+// order. ssd1306_update() assumes start line 0.
+void ssd1306_write_gddram(ssd1306_t *d, uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1,
+                          const uint8_t *data, unsigned int len);
+void ssd1306_set_start_line(ssd1306_t *d, uint8_t line);
+
+// Partial updates. Drawing code marks what it changed, update_dirty() sends
+// just those columns of those pages. A full update clears the dirty state.
+void ssd1306_mark_dirty(ssd1306_t *d, int x, int y, int w, int h);
+void ssd1306_update_dirty(ssd1306_t *d);
 
 /// this should be private
-void ssd1306_command(unsigned char c);
+void ssd1306_command(ssd1306_t *d, unsigned char c);
 
-#endif
\ No newline at end of file
+#endif
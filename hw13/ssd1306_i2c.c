@@ -0,0 +1,66 @@
+// ssd1306 transport over I2C, see ssd1306_transport_t in ssd1306.h
+
+#include "ssd1306.h"
+#include "hardware/i2c.h"
+#include "hardware/dma.h"
+
+static void i2c_transport_init(ssd1306_t *d) {
+    if (d->dma_chan < 0) {
+        d->dma_chan = dma_claim_unused_channel(true);
+    }
+}
+
+static void i2c_transport_write(ssd1306_t *d, const uint8_t *bytes, unsigned int len) {
+    i2c_write_blocking(d->i2c, d->address, bytes, len, false);
+}
+
+// The DMA feeds IC_DATA_CMD directly, one 32-bit word per byte with STOP
+// set on the last one, which is what i2c_write_blocking() does by hand.
+static void i2c_transport_write_start(ssd1306_t *d, const uint8_t *bytes, unsigned int len) {
+    for (unsigned int i = 0; i < len; i++) {
+        d->dma_words[i] = bytes[i];
+    }
+    d->dma_words[len - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+    i2c_hw_t *hw = i2c_get_hw(d->i2c);
+    hw->enable = 0;
+    hw->tar = d->address;
+    hw->enable = 1;
+    (void)hw->clr_stop_det;
+
+    dma_channel_config c = dma_channel_get_default_config(d->dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(d->i2c, true));
+    d->dma_active = true;
+    dma_channel_configure(d->dma_chan, &c, &hw->data_cmd, d->dma_words, len, true);
+}
+
+static bool i2c_transport_busy(ssd1306_t *d) {
+    i2c_hw_t *hw = i2c_get_hw(d->i2c);
+    if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+        // NACK or arbitration loss: the fifo is flushed, drop the frame
+        dma_channel_abort(d->dma_chan);
+        (void)hw->clr_tx_abrt;
+        d->dma_active = false;
+        return false;
+    }
+    if (dma_channel_is_busy(d->dma_chan)) {
+        return true;
+    }
+    // the last bytes are still in the tx fifo until the STOP goes out
+    if ((hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_STOP_DET_BITS) == 0) {
+        return true;
+    }
+    (void)hw->clr_stop_det;
+    d->dma_active = false;
+    return false;
+}
+
+const ssd1306_transport_t ssd1306_i2c_transport = {
+    .init = i2c_transport_init,
+    .write = i2c_transport_write,
+    .write_start = i2c_transport_write_start,
+    .busy = i2c_transport_busy,
+};
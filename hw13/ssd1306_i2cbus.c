@@ -0,0 +1,51 @@
+// ssd1306 transport over a shared I2C bus, see ssd1306_transport_t in
+// ssd1306.h and i2cbus.h
+//
+// The control byte goes out as the bus prefix, so a frame (0x40, data)
+// can be cut into pieces that each start with 0x40 and carry on where the
+// last one stopped. Commands are never cut.
+
+#include "ssd1306.h"
+#include "i2cbus.h"
+#include "pico/stdlib.h"
+
+static void bus_transport_init(ssd1306_t *d) {
+    d->i2c = d->bus->i2c;
+    d->bus_dev = i2cbus_add_device(d->bus, "oled", I2CBUS_PRIO_LOW);
+}
+
+static void bus_transport_submit(ssd1306_t *d, const uint8_t *bytes, unsigned int len) {
+    *d->txn = (i2cbus_txn_t){
+        .addr = d->address, .device = d->bus_dev, .priority = I2CBUS_PRIO_LOW,
+        .split = bytes[0] == 0x40, .prefix = bytes[0], .tx = bytes + 1, .tx_len = len - 1,
+    };
+    // the queue only fills up if something else floods it, wait it out
+    while (!i2cbus_submit(d->bus, d->txn)) {
+        tight_loop_contents();
+    }
+}
+
+static void bus_transport_write(ssd1306_t *d, const uint8_t *bytes, unsigned int len) {
+    bus_transport_submit(d, bytes, len);
+    i2cbus_wait(d->bus, d->txn);
+}
+
+static void bus_transport_write_start(ssd1306_t *d, const uint8_t *bytes, unsigned int len) {
+    d->dma_active = true;
+    bus_transport_submit(d, bytes, len);
+}
+
+static bool bus_transport_busy(ssd1306_t *d) {
+    if (i2cbus_busy(d->txn)) {
+        return true;
+    }
+    d->dma_active = false;
+    return false;
+}
+
+const ssd1306_transport_t ssd1306_i2cbus_transport = {
+    .init = bus_transport_init,
+    .write = bus_transport_write,
+    .write_start = bus_transport_write_start,
+    .busy = bus_transport_busy,
+};
@@ -0,0 +1,76 @@
+// ssd1306 transport over 4-wire SPI, see ssd1306_transport_t in ssd1306.h
+//
+// D/C low for commands, high for data, sampled with the last bit of each
+// byte, so it only changes while CS is high. CS is a plain GPIO held low
+// for a whole write; the PL022's own chip select would pulse between bytes.
+
+#include "ssd1306.h"
+#include "hardware/spi.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "pico/stdlib.h"
+
+static void spi_transport_init(ssd1306_t *d) {
+    gpio_init(d->dc_pin);
+    gpio_set_dir(d->dc_pin, GPIO_OUT);
+    gpio_init(d->cs_pin);
+    gpio_put(d->cs_pin, 1);
+    gpio_set_dir(d->cs_pin, GPIO_OUT);
+    if (d->reset_pin != SSD1306_NO_PIN) {
+        // RES low for at least 3 us restarts the controller
+        gpio_init(d->reset_pin);
+        gpio_set_dir(d->reset_pin, GPIO_OUT);
+        gpio_put(d->reset_pin, 0);
+        sleep_ms(1);
+        gpio_put(d->reset_pin, 1);
+    }
+    // mode 0, the controller clocks data in on the rising edge
+    spi_set_format(d->spi, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+    if (d->dma_chan < 0) {
+        d->dma_chan = dma_claim_unused_channel(true);
+    }
+}
+
+static void spi_select(ssd1306_t *d, const uint8_t *bytes) {
+    gpio_put(d->dc_pin, (bytes[0] & 0x40) != 0);
+    gpio_put(d->cs_pin, 0);
+}
+
+static void spi_transport_write(ssd1306_t *d, const uint8_t *bytes, unsigned int len) {
+    spi_select(d, bytes);
+    spi_write_blocking(d->spi, bytes + 1, len - 1);
+    gpio_put(d->cs_pin, 1);
+}
+
+static void spi_transport_write_start(ssd1306_t *d, const uint8_t *bytes, unsigned int len) {
+    spi_select(d, bytes);
+    dma_channel_config c = dma_channel_get_default_config(d->dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, spi_get_dreq(d->spi, true));
+    d->dma_active = true;
+    dma_channel_configure(d->dma_chan, &c, &spi_get_hw(d->spi)->dr, bytes + 1, len - 1, true);
+}
+
+static bool spi_transport_busy(ssd1306_t *d) {
+    // the DMA finishes when the last byte is in the fifo, not on the wire
+    if (dma_channel_is_busy(d->dma_chan) || spi_is_busy(d->spi)) {
+        return true;
+    }
+    gpio_put(d->cs_pin, 1);
+    // nothing reads the rx side during DMA, drop what piled up there
+    while (spi_is_readable(d->spi)) {
+        (void)spi_get_hw(d->spi)->dr;
+    }
+    spi_get_hw(d->spi)->icr = SPI_SSPICR_RORIC_BITS;
+    d->dma_active = false;
+    return false;
+}
+
+const ssd1306_transport_t ssd1306_spi_transport = {
+    .init = spi_transport_init,
+    .write = spi_transport_write,
+    .write_start = spi_transport_write_start,
+    .busy = spi_transport_busy,
+};
@@ -0,0 +1,60 @@
+// sweeping strip chart, see stripchart.h
+
+#include "stripchart.h"
+#include "gfx.h"
+
+void stripchart_init(stripchart_t *s, ssd1306_t *d, int x, int w, int page, int pages,
+                     int32_t min, int32_t max) {
+    s->d = d;
+    s->x = x;
+    s->w = w;
+    s->y = page * 8;
+    s->h = pages * 8;
+    s->min = min;
+    s->max = max > min ? max : min + 1;
+    stripchart_clear(s);
+}
+
+void stripchart_clear(stripchart_t *s) {
+    gfx_fill_rect(s->d, s->x, s->y, s->w, s->h, 0);
+    ssd1306_mark_dirty(s->d, s->x, s->y, s->w, s->h);
+    s->head = 0;
+    s->last_row = -1;
+}
+
+static int row_of(const stripchart_t *s, int32_t v) {
+    if (v < s->min) v = s->min;
+    if (v > s->max) v = s->max;
+    // max at the top row, min at the bottom
+    return s->y + s->h - 1 - (int)((int64_t)(v - s->min) * (s->h - 1) / (s->max - s->min));
+}
+
+void stripchart_push(stripchart_t *s, int32_t value) {
+    ssd1306_t *d = s->d;
+    int col = s->x + s->head;
+    int row = row_of(s, value);
+
+    // join the previous sample with a vertical run so fast edges stay visible
+    int from = s->last_row < 0 ? row : s->last_row;
+    gfx_vline(d, col, s->y, s->y + s->h - 1, 0);
+    gfx_vline(d, col, from, row, 1);
+    s->last_row = row;
+
+    int next = s->head + 1 == s->w ? 0 : s->head + 1;
+    gfx_vline(d, s->x + next, s->y, s->y + s->h - 1, 0);
+
+    if (next) {
+        // neighbours: one window, two columns per page
+        ssd1306_mark_dirty(d, col, s->y, 2, s->h);
+        ssd1306_update_dirty(d);
+    } else {
+        // the gap wraps to the left edge, send the two ends separately
+        // rather than a window across the whole chart
+        ssd1306_mark_dirty(d, col, s->y, 1, s->h);
+        ssd1306_update_dirty(d);
+        ssd1306_mark_dirty(d, s->x, s->y, 1, s->h);
+        ssd1306_update_dirty(d);
+        s->last_row = -1; // don't join across the wrap
+    }
+    s->head = next;
+}
@@ -0,0 +1,35 @@
+#ifndef STRIPCHART_H__
+#define STRIPCHART_H__
+
+// Sweeping strip chart for plotting samples at hundreds of Hz.
+//
+// The chart is a ring of columns: each sample is drawn into the column
+// after the last one and a blank gap column moves ahead of it, like a
+// sweeping scope trace. Only those two columns are sent, two bytes per
+// page instead of the whole frame.
+//
+// The SSD1306 can't offset its columns the way SETSTARTLINE offsets rows
+// (its horizontal scroll shifts GDDRAM on its own frame clock), so the
+// trace sweeps instead of scrolling.
+
+#include <stdint.h>
+#include "ssd1306.h"
+
+typedef struct {
+    ssd1306_t *d;
+    int16_t x, w;            // columns x .. x+w-1
+    int16_t y, h;            // rows, whole pages
+    int32_t min, max;        // sample range, clamped to the chart
+    int16_t head;            // column the next sample goes into, 0..w-1
+    int16_t last_row;        // row of the previous sample, -1 for none
+} stripchart_t;
+
+// chart over columns x..x+w-1 of pages page..page+pages-1
+void stripchart_init(stripchart_t *s, ssd1306_t *d, int x, int w, int page, int pages,
+                     int32_t min, int32_t max);
+// clear the chart area and restart the sweep at the left edge
+void stripchart_clear(stripchart_t *s);
+// draw one sample and send its column (and the gap ahead of it) to the panel
+void stripchart_push(stripchart_t *s, int32_t value);
+
+#endif
@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+# Decode the binary IMU stream hw13 sends with IMU_TRACE_BINARY.
+#
+#   python3 imudecode.py [--raw] stream.bin [-o out.csv | -o out.npy]
+#   python3 imudecode.py [--raw] /dev/ttyACM0 [-o out.csv] [seconds]
+#
+# The input is a file of captured bytes or a serial port (needs pyserial),
+# read for the given seconds or until Ctrl-C. Packets are COBS framed and
+# end in 0x00, see imustream.h for the layout. Each sample comes out as its
+# index since the stream began, its time in us and accel in g and gyro in
+# deg/s, corrected with the calibration from the info packet the same way
+# mpu6050_convert() does. --raw leaves them as the counts that were sent.
+# Without -o the CSV goes to stdout, .npy needs numpy.
+#
+# At the end a summary goes to stderr: packets that failed the CRC or the
+# framing, gaps in the packet sequence and the sample index (lost on the
+# way over USB) and the samples the IMU driver says it dropped.
+
+import struct
+import sys
+
+SAMPLES = 0x01
+INFO = 0x02
+VERSION = 1
+HEADER = 16
+SAMPLE = 14
+CAL_ONE = 16384
+
+
+def crc16(data):
+    # CRC-16/CCITT-FALSE, as imustream_crc16()
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def uncobs(frame):
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(frame):
+            return None
+        out += frame[i:i + code - 1]
+        i += code - 1
+        if code < 0xFF and i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+def trunc_div(num, den):
+    # C integer division, towards zero
+    q = abs(num) // den
+    return q if num >= 0 else -q
+
+
+class Decoder:
+    def __init__(self, raw):
+        self.raw = raw
+        self.pending = bytearray()
+        self.info = None
+        self.rows = []
+        self.packets = 0
+        self.infos = 0
+        self.bad = 0
+        self.seq_gaps = 0
+        self.index_gaps = 0
+        self.missing = 0
+        self.dropped = 0
+        self.first_lost = None
+        self.last_seq = None
+        self.next_index = None
+        self.t_high = 0
+        self.t_last = None
+        self.started = False
+
+    def feed(self, data):
+        self.pending += data
+        while True:
+            end = self.pending.find(0)
+            if end < 0:
+                return
+            frame = bytes(self.pending[:end])
+            del self.pending[:end + 1]
+            if not self.started:
+                # anything before the first delimiter is text from boot
+                self.started = True
+                continue
+            if frame:
+                self.packet(frame)
+
+    def packet(self, frame):
+        p = uncobs(frame)
+        if p is None or len(p) < 4 or struct.unpack_from('<H', p, len(p) - 2)[0] != crc16(p[:-2]):
+            self.bad += 1
+            return
+        p = p[:-2]
+        if p[0] == INFO and len(p) == 30:
+            version, rate = struct.unpack_from('<BH', p, 1)
+            if version != VERSION:
+                sys.exit('stream version %d, this decoder reads %d' % (version, VERSION))
+            g, dps = struct.unpack_from('<ff', p, 4)
+            cal = struct.unpack_from('<3h3H3h', p, 12)
+            self.info = (rate, g, dps, cal[0:3], cal[3:6], cal[6:9])
+            self.infos += 1
+        elif p[0] == SAMPLES and len(p) == HEADER + p[1] * SAMPLE:
+            self.samples(p)
+        else:
+            self.bad += 1
+
+    def samples(self, p):
+        n, seq, index, lost, t = struct.unpack_from('<BHIII', p, 1)
+        self.packets += 1
+        if self.last_seq is not None and seq != (self.last_seq + 1) & 0xFFFF:
+            self.seq_gaps += 1
+        self.last_seq = seq
+        if self.next_index is not None and index != self.next_index:
+            self.index_gaps += 1
+            self.missing += (index - self.next_index) & 0xFFFFFFFF
+        self.next_index = index + n
+        if self.first_lost is None:
+            self.first_lost = lost
+        self.dropped = lost - self.first_lost
+        for k in range(n):
+            off = HEADER + k * SAMPLE
+            dt = struct.unpack_from('<H', p, off)[0]
+            counts = struct.unpack_from('<6h', p, off + 2)
+            t = (t + dt) & 0xFFFFFFFF
+            self.rows.append((index + k, self.unwrap(t), self.convert(counts)))
+
+    def unwrap(self, t):
+        # the low 32 bits of time_us_64(), which wrap every 71 minutes
+        if self.t_last is not None and t < self.t_last and self.t_last - t > 1 << 31:
+            self.t_high += 1 << 32
+        self.t_last = t
+        return self.t_high + t
+
+    def convert(self, counts):
+        if self.raw:
+            return counts
+        if self.info is None:
+            sys.exit('samples before any info packet, no scale to convert them with (try --raw)')
+        _, g, dps, offset, scale, gyro_offset = self.info
+        accel = [trunc_div((counts[i] - offset[i]) * scale[i], CAL_ONE) * g for i in range(3)]
+        gyro = [(counts[3 + i] - gyro_offset[i]) * dps for i in range(3)]
+        return accel + gyro
+
+    def summary(self):
+        rate = ', %d Hz' % self.info[0] if self.info else ''
+        print('%d samples in %d packets (%d info%s)' % (len(self.rows), self.packets, self.infos, rate),
+              file=sys.stderr)
+        print('%d packets damaged, %d sequence gaps, %d samples missing in %d index gaps, '
+              '%d dropped by the IMU driver' % (self.bad, self.seq_gaps, self.missing, self.index_gaps,
+                                                self.dropped), file=sys.stderr)
+
+
+def read_input(path, seconds, decoder):
+    if path.startswith('/dev/') or path.upper().startswith('COM'):
+        import time
+        import serial
+        port = serial.Serial(path, timeout=0.1)
+        end = time.time() + seconds if seconds else None
+        try:
+            while end is None or time.time() < end:
+                decoder.feed(port.read(4096))
+        except KeyboardInterrupt:
+            pass
+    else:
+        with open(path, 'rb') as f:
+            decoder.feed(f.read())
+
+
+def write_csv(out, rows, raw):
+    out.write('index,t_us,ax,ay,az,gx,gy,gz\n')
+    for index, t, v in rows:
+        if raw:
+            values = ','.join('%d' % x for x in v)
+        else:
+            values = ','.join(['%.5f' % x for x in v[:3]] + ['%.4f' % x for x in v[3:]])
+        out.write('%d,%d,%s\n' % (index, t, values))
+
+
+def main():
+    args = sys.argv[1:]
+    raw = '--raw' in args
+    args = [a for a in args if a != '--raw']
+    out_path = None
+    if '-o' in args:
+        i = args.index('-o')
+        out_path = args[i + 1]
+        del args[i:i + 2]
+    if not args:
+        sys.exit('usage: imudecode.py [--raw] input [-o out.csv|out.npy] [seconds]')
+    seconds = float(args[1]) if len(args) > 1 else None
+
+    decoder = Decoder(raw)
+    read_input(args[0], seconds, decoder)
+
+    if out_path and out_path.endswith('.npy'):
+        import numpy as np
+        table = np.array([(i, t) + tuple(v) for i, t, v in decoder.rows], dtype=np.float64)
+        np.save(out_path, table.reshape(-1, 8))
+    elif out_path:
+        with open(out_path, 'w') as out:
+            write_csv(out, decoder.rows, raw)
+    else:
+        write_csv(sys.stdout, decoder.rows, raw)
+    decoder.summary()
+
+
+if __name__ == '__main__':
+    main()
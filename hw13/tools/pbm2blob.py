@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+# Convert PBM images into compressed SSD1306 blobs for bitmap.c.
+#
+#   python3 pbm2blob.py name frame0.pbm [frame1.pbm ...] > name.h
+#
+# One file makes a still image, several make an animation. Images are cut
+# into 8-row pages, column bytes in GDDRAM order. The first frame is stored
+# whole, every later one only as the columns that changed from the frame
+# before it, and an animation ends with a wrap frame that goes from the
+# last frame back to the first. Each page range is stored raw or run-length
+# coded, whichever is smaller. See bitmap.h for the byte layout.
+#
+# The decoder is run on the output before it is written, so a blob that
+# would not play back exactly is never produced.
+
+import sys
+
+RLE = 0x80
+END = 0xFF
+
+
+def read_pbm(path):
+    data = open(path, 'rb').read()
+    # header fields, skipping comments
+    fields = []
+    pos = 0
+    while len(fields) < 3:
+        while data[pos:pos + 1].isspace():
+            pos += 1
+        if data[pos:pos + 1] == b'#':
+            while data[pos:pos + 1] not in (b'\n', b''):
+                pos += 1
+            continue
+        start = pos
+        while not data[pos:pos + 1].isspace():
+            pos += 1
+        fields.append(data[start:pos])
+    magic, w, h = fields[0], int(fields[1]), int(fields[2])
+    if magic == b'P4':
+        pos += 1  # single whitespace before the raster
+        stride = (w + 7) // 8
+        raster = data[pos:pos + stride * h]
+        bits = [[(raster[y * stride + x // 8] >> (7 - x % 8)) & 1 for x in range(w)] for y in range(h)]
+    elif magic == b'P1':
+        digits = [c - 48 for c in data[pos:] if c in (48, 49)]
+        bits = [digits[y * w:(y + 1) * w] for y in range(h)]
+    else:
+        sys.exit('%s: not a PBM (P1 or P4)' % path)
+    return w, h, bits
+
+
+def to_pages(w, h, bits):
+    pages = []
+    for p in range((h + 7) // 8):
+        row = []
+        for x in range(w):
+            b = 0
+            for i in range(8):
+                y = p * 8 + i
+                if y < h and bits[y][x]:
+                    b |= 1 << i
+            row.append(b)
+        pages.append(row)
+    return pages
+
+
+def rle(data):
+    # control byte c < 0x80: c+1 literal bytes follow
+    #              c >= 0x80: the next byte repeats c-0x80+2 times
+    out = bytearray()
+    lit = bytearray()
+    i = 0
+    while i < len(data):
+        run = 1
+        while i + run < len(data) and data[i + run] == data[i] and run < 129:
+            run += 1
+        if run >= 3 or (run == 2 and not lit):
+            if lit:
+                out += bytes([len(lit) - 1]) + lit
+                lit = bytearray()
+            out += bytes([RLE + run - 2, data[i]])
+            i += run
+        else:
+            lit.append(data[i])
+            i += 1
+            if len(lit) == 128:
+                out += bytes([127]) + lit
+                lit = bytearray()
+    if lit:
+        out += bytes([len(lit) - 1]) + lit
+    return bytes(out)
+
+
+def encode_frame(new, old):
+    # old is None for the first frame: every column is sent
+    out = bytearray()
+    for p, row in enumerate(new):
+        x0, x1 = 0, len(row) - 1
+        if old is not None:
+            while x0 <= x1 and row[x0] == old[p][x0]:
+                x0 += 1
+            while x1 >= x0 and row[x1] == old[p][x1]:
+                x1 -= 1
+            if x0 > x1:
+                continue
+        span = bytes(row[x0:x1 + 1])
+        packed = rle(span)
+        if len(packed) < len(span):
+            out += bytes([p | RLE, x0, len(span) - 1]) + packed
+        else:
+            out += bytes([p, x0, len(span) - 1]) + span
+    out.append(END)
+    return bytes(out)
+
+
+def decode_frame(blob, pos, pages):
+    # mirrors bitmap_decode_frame(), to check the encoder
+    while blob[pos] != END:
+        p, x, n = blob[pos] & 0x7F, blob[pos + 1], blob[pos + 2] + 1
+        coded = blob[pos] & RLE
+        pos += 3
+        if not coded:
+            pages[p][x:x + n] = blob[pos:pos + n]
+            pos += n
+            continue
+        while n > 0:
+            c = blob[pos]
+            if c & RLE:
+                k = c - RLE + 2
+                pages[p][x:x + k] = [blob[pos + 1]] * k
+                pos += 2
+            else:
+                k = c + 1
+                pages[p][x:x + k] = blob[pos + 1:pos + 1 + k]
+                pos += 1 + k
+            x += k
+            n -= k
+    return pos + 1
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit('usage: pbm2blob.py name frame0.pbm [frame1.pbm ...] > name.h')
+    name, paths = sys.argv[1], sys.argv[2:]
+    frames = []
+    size = None
+    for path in paths:
+        w, h, bits = read_pbm(path)
+        if size and size != (w, h):
+            sys.exit('%s: %dx%d, the first frame is %dx%d' % (path, w, h, size[0], size[1]))
+        if w > 128 or h > 64:
+            sys.exit('%s: bigger than the panel' % path)
+        size = (w, h)
+        frames.append(to_pages(w, h, bits))
+
+    w, h = size
+    n = len(frames)
+    blob = bytearray([w, len(frames[0]), n & 0xFF, n >> 8])
+    blob += encode_frame(frames[0], None)
+    for i in range(1, n):
+        blob += encode_frame(frames[i], frames[i - 1])
+    if n > 1:
+        blob += encode_frame(frames[0], frames[-1])
+
+    # play it back twice, through the wrap, and compare every frame
+    pages = [[0] * w for _ in frames[0]]
+    pos = decode_frame(blob, 4, pages)
+    loop = pos
+    order = list(range(1, n)) + [0] if n > 1 else []
+    for lap in range(2):
+        pos = loop
+        for i in order:
+            pos = decode_frame(blob, pos, pages)
+            if pages != frames[i]:
+                sys.exit('%s: frame %d does not decode back, encoder bug' % (name, i))
+    if pages != frames[0]:
+        sys.exit('%s: frame 0 does not decode back, encoder bug' % name)
+
+    raw = len(frames[0]) * w * n
+    print('// generated by tools/pbm2blob.py from %s' % ' '.join(p.split('/')[-1] for p in paths))
+    print('// %dx%d, %d frame%s, %d bytes (%d raw)' % (w, h, n, 's' if n > 1 else '', len(blob), raw))
+    print()
+    print('#ifndef %s_H__' % name.upper())
+    print('#define %s_H__' % name.upper())
+    print()
+    print('#include <stdint.h>')
+    print()
+    print('static const uint8_t %s[%d] = {' % (name, len(blob)))
+    for i in range(0, len(blob), 16):
+        print('    ' + ' '.join('0x%02x,' % b for b in blob[i:i + 16]))
+    print('};')
+    print()
+    print('#endif')
+    sys.stderr.write('%s: %d frames, %d bytes, %d raw\n' % (name, n, len(blob), raw))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,161 @@
+// retained-mode widgets, see widget.h
+
+#include <string.h>
+#include "widget.h"
+#include "gfx.h"
+#include "fmt.h"
+
+static void widget_init(widget_t *w, widget_kind_t kind, int x, int y, int width, int height) {
+    memset(w, 0, sizeof(*w));
+    w->kind = kind;
+    w->x = x;
+    w->y = y;
+    w->w = width;
+    w->h = height;
+}
+
+void widget_label(widget_t *w, int x, int y, int max_chars, const char *text) {
+    if (max_chars > WIDGET_TEXT_MAX) max_chars = WIDGET_TEXT_MAX;
+    widget_init(w, WIDGET_LABEL, x, y, max_chars * GFX_CHAR_W, GFX_CHAR_H);
+    w->chars = max_chars;
+    w->text = text;
+}
+
+void widget_number(widget_t *w, int x, int y, int chars, int decimals, const char *prefix) {
+    if (chars > WIDGET_TEXT_MAX) chars = WIDGET_TEXT_MAX;
+    widget_init(w, WIDGET_NUMBER, x, y, chars * GFX_CHAR_W, GFX_CHAR_H);
+    w->chars = chars;
+    w->decimals = decimals > 9 ? 9 : decimals; // 10^decimals fits in int32_t
+    w->text = prefix ? prefix : "";
+}
+
+void widget_bar(widget_t *w, int x, int y, int width, int height, int32_t min, int32_t max) {
+    widget_init(w, WIDGET_BAR, x, y, width, height);
+    w->min = min;
+    w->max = max > min ? max : min + 1;
+    w->value = min;
+}
+
+void widget_crosshair(widget_t *w, int x, int y, int width, int height, int32_t full_scale) {
+    widget_init(w, WIDGET_CROSSHAIR, x, y, width, height);
+    w->max = full_scale > 0 ? full_scale : 1;
+}
+
+void widget_set(widget_t *w, int32_t value) {
+    w->value = value;
+}
+
+void widget_set_xy(widget_t *w, int32_t vx, int32_t vy) {
+    w->value = vx;
+    w->value2 = vy;
+}
+
+void widget_set_text(widget_t *w, const char *text) {
+    w->text = text;
+}
+
+void widget_invalidate(widget_t *w) {
+    w->drawn = false;
+}
+
+static int32_t clamp(int32_t v, int32_t lo, int32_t hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// prefix, then value / 10^decimals right aligned to chars characters in all
+static void format_number(const widget_t *w, char *out) {
+    fmt_t f;
+    fmt_begin(&f, out, w->chars + 1); // never spill out of the box
+    fmt_str(&f, w->text);
+    fmt_fixed(&f, w->value, w->decimals, w->chars - fmt_len(&f));
+}
+
+// same text as last drawn, compared up to the box width
+static bool label_same(const widget_t *w) {
+    const char *text = w->text ? w->text : "";
+    for (int i = 0; i < w->chars; i++) {
+        if (text[i] != w->shown_text[i]) return false;
+        if (!text[i]) return true;
+    }
+    return true;
+}
+
+// Only the cheap comparison runs every frame, formatting and drawing
+// happen once per change.
+static bool changed(const widget_t *w) {
+    if (!w->drawn) return true;
+    switch (w->kind) {
+        case WIDGET_LABEL:
+            return !label_same(w);
+        case WIDGET_NUMBER:
+        case WIDGET_BAR:
+            return w->value != w->shown;
+        case WIDGET_CROSSHAIR:
+            return w->value != w->shown || w->value2 != w->shown2;
+    }
+    return false;
+}
+
+static void draw_bar(ssd1306_t *d, const widget_t *w) {
+    int32_t v = clamp(w->value, w->min, w->max);
+    int inner = w->w - 2;
+    int fill = (int)((int64_t)(v - w->min) * inner / (w->max - w->min));
+    gfx_rect(d, w->x, w->y, w->w, w->h, 1);
+    gfx_fill_rect(d, w->x + 1, w->y + 1, fill, w->h - 2, 1);
+}
+
+static void draw_crosshair(ssd1306_t *d, const widget_t *w) {
+    int cx = w->x + w->w / 2;
+    int cy = w->y + w->h / 2;
+    // the needle end stays inside the box for any value
+    int ex = cx + (int)((int64_t)clamp(w->value, -w->max, w->max) * (w->w / 2 - 1) / w->max);
+    int ey = cy + (int)((int64_t)clamp(w->value2, -w->max, w->max) * (w->h / 2 - 1) / w->max);
+    gfx_hline(d, cx - 1, cx + 1, cy, 1);
+    gfx_vline(d, cx, cy - 1, cy + 1, 1);
+    gfx_line(d, cx, cy, ex, ey, 1);
+}
+
+bool widget_render(ssd1306_t *d, widget_t *w) {
+    if (!changed(w)) {
+        return false;
+    }
+
+    // text cells are opaque and cover the box, everything else starts blank
+    char text[WIDGET_TEXT_MAX + 1];
+    switch (w->kind) {
+        case WIDGET_LABEL:
+        case WIDGET_NUMBER: {
+            if (w->kind == WIDGET_LABEL) {
+                strncpy(text, w->text ? w->text : "", w->chars);
+                text[w->chars] = '\0';
+                strcpy(w->shown_text, text);
+            } else {
+                format_number(w, text);
+            }
+            int end = gfx_string(d, w->x, w->y, text);
+            gfx_fill_rect(d, end, w->y, w->x + w->w - end, w->h, 0);
+            break;
+        }
+        case WIDGET_BAR:
+            gfx_fill_rect(d, w->x, w->y, w->w, w->h, 0);
+            draw_bar(d, w);
+            break;
+        case WIDGET_CROSSHAIR:
+            gfx_fill_rect(d, w->x, w->y, w->w, w->h, 0);
+            draw_crosshair(d, w);
+            break;
+    }
+    w->shown = w->value;
+    w->shown2 = w->value2;
+    w->drawn = true;
+    ssd1306_mark_dirty(d, w->x, w->y, w->w, w->h);
+    return true;
+}
+
+int widget_render_all(ssd1306_t *d, widget_t *widgets, int count) {
+    int redrawn = 0;
+    for (int i = 0; i < count; i++) {
+        redrawn += widget_render(d, &widgets[i]);
+    }
+    return redrawn;
+}
@@ -0,0 +1,60 @@
+#ifndef WIDGET_H__
+#define WIDGET_H__
+
+// Retained-mode widgets for dashboards on the ssd1306.
+//
+// A widget owns a box on the screen and remembers what it last drew there.
+// Setting a value is cheap; widget_render() only redraws the box (and marks
+// it dirty on the display) when the value differs from what is shown, so
+// ssd1306_update_dirty() sends just the widgets that changed.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ssd1306.h"
+
+#define WIDGET_TEXT_MAX 21 // one 128 pixel row of 6 pixel characters
+
+typedef enum {
+    WIDGET_LABEL,
+    WIDGET_NUMBER,
+    WIDGET_BAR,
+    WIDGET_CROSSHAIR
+} widget_kind_t;
+
+typedef struct {
+    widget_kind_t kind;
+    int16_t x, y, w, h;          // bounding box, never drawn outside of it
+    bool drawn;                  // false until the first render, or after invalidate
+
+    // wanted vs shown values
+    int32_t value, shown;        // number / bar value, crosshair x
+    int32_t value2, shown2;      // crosshair y
+    const char *text;            // label text / number prefix
+    char shown_text[WIDGET_TEXT_MAX + 1]; // label text as last drawn
+
+    // kind specific settings
+    uint8_t chars;               // number: field width in characters
+    uint8_t decimals;            // number: value is scaled by 10^decimals
+    int32_t min, max;            // bar range, crosshair full scale is max
+} widget_t;
+
+// text at (x, y), the box is sized for max_chars characters
+void widget_label(widget_t *w, int x, int y, int max_chars, const char *text);
+// fixed point number, "prefix" then value / 10^decimals right aligned in chars characters
+void widget_number(widget_t *w, int x, int y, int chars, int decimals, const char *prefix);
+// horizontal bar gauge filled in proportion to value in [min, max]
+void widget_bar(widget_t *w, int x, int y, int width, int height, int32_t min, int32_t max);
+// crosshair at the box center with a needle out to (vx, vy), +-full_scale reaches the box edge
+void widget_crosshair(widget_t *w, int x, int y, int width, int height, int32_t full_scale);
+
+void widget_set(widget_t *w, int32_t value);
+void widget_set_xy(widget_t *w, int32_t vx, int32_t vy);
+void widget_set_text(widget_t *w, const char *text);
+void widget_invalidate(widget_t *w);
+
+// redraw w if it changed, returns true if it did
+bool widget_render(ssd1306_t *d, widget_t *w);
+// render a whole dashboard, returns how many widgets were redrawn
+int widget_render_all(ssd1306_t *d, widget_t *widgets, int count);
+
+#endif
@@ -0,0 +1,80 @@
+// fixed point 3D wireframes, see wire3d.h
+
+#include "wire3d.h"
+#include "gfx.h"
+
+#define HALF 16384 // 0.5 in Q15, the cube is 1 unit wide
+
+static const q15_t cube_verts[8][3] = {
+    { -HALF, -HALF, -HALF }, {  HALF, -HALF, -HALF }, {  HALF,  HALF, -HALF }, { -HALF,  HALF, -HALF },
+    { -HALF, -HALF,  HALF }, {  HALF, -HALF,  HALF }, {  HALF,  HALF,  HALF }, { -HALF,  HALF,  HALF },
+};
+
+static const uint8_t cube_edges[12][2] = {
+    { 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 0 }, // back face
+    { 4, 5 }, { 5, 6 }, { 6, 7 }, { 7, 4 }, // front face
+    { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 },
+};
+
+const wire3d_mesh_t wire3d_cube = {
+    .verts = cube_verts,
+    .edges = cube_edges,
+    .vert_count = 8,
+    .edge_count = 12,
+};
+
+// camera distance from the mesh center, in Q15 units (2.5)
+#define CAMERA_Z (5 * 16384)
+
+static q15_t to_q15(float v) {
+    if (v >= 1.0f) return Q15_ONE;
+    if (v <= -1.0f) return -Q15_ONE;
+    return (q15_t)(v * 32768.0f);
+}
+
+void wire3d_rot_from_quat(wire3d_rot_t *r, const float q[4]) {
+    float w = q[0], x = q[1], y = q[2], z = q[3];
+    r->m[0][0] = to_q15(1 - 2 * (y * y + z * z));
+    r->m[0][1] = to_q15(2 * (x * y - w * z));
+    r->m[0][2] = to_q15(2 * (x * z + w * y));
+    r->m[1][0] = to_q15(2 * (x * y + w * z));
+    r->m[1][1] = to_q15(1 - 2 * (x * x + z * z));
+    r->m[1][2] = to_q15(2 * (y * z - w * x));
+    r->m[2][0] = to_q15(2 * (x * z - w * y));
+    r->m[2][1] = to_q15(2 * (y * z + w * x));
+    r->m[2][2] = to_q15(1 - 2 * (x * x + y * y));
+}
+
+wire3d_box_t wire3d_project(const wire3d_mesh_t *mesh, const wire3d_rot_t *r, int cx, int cy, int scale,
+                            int16_t (*points)[2]) {
+    wire3d_box_t box = { INT16_MAX, INT16_MAX, INT16_MIN, INT16_MIN };
+    // a unit at the mesh center is `scale` pixels: x * scale * CAMERA_Z / depth
+    int32_t focal = scale * CAMERA_Z / 32768;
+    for (int i = 0; i < mesh->vert_count; i++) {
+        const q15_t *v = mesh->verts[i];
+        int32_t p[3];
+        for (int row = 0; row < 3; row++) {
+            p[row] = ((int32_t)r->m[row][0] * v[0] + (int32_t)r->m[row][1] * v[1] +
+                      (int32_t)r->m[row][2] * v[2]) >> 15;
+        }
+        // +z towards the viewer, screen y grows downwards
+        int32_t depth = CAMERA_Z - p[2];
+        int sx = cx + (int)(p[0] * focal / depth);
+        int sy = cy - (int)(p[1] * focal / depth);
+        points[i][0] = sx;
+        points[i][1] = sy;
+        if (sx < box.x0) box.x0 = sx;
+        if (sx > box.x1) box.x1 = sx;
+        if (sy < box.y0) box.y0 = sy;
+        if (sy > box.y1) box.y1 = sy;
+    }
+    return box;
+}
+
+void wire3d_draw(ssd1306_t *d, const wire3d_mesh_t *mesh, const int16_t (*points)[2]) {
+    for (int i = 0; i < mesh->edge_count; i++) {
+        const int16_t *a = points[mesh->edges[i][0]];
+        const int16_t *b = points[mesh->edges[i][1]];
+        gfx_line(d, a[0], a[1], b[0], b[1], 1);
+    }
+}
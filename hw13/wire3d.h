@@ -0,0 +1,45 @@
+#ifndef WIRE3D_H__
+#define WIRE3D_H__
+
+// Fixed point 3D wireframes on the ssd1306.
+//
+// Meshes are const tables (so they stay in flash) of Q15 vertices and
+// vertex index pairs. An orientation quaternion is turned into a Q15
+// rotation matrix once per frame, each vertex costs nine 16x16 multiplies
+// and one divide for the perspective, and edges go to gfx_line().
+
+#include <stdint.h>
+#include "ssd1306.h"
+
+typedef int16_t q15_t; // -1.0 .. 1.0 - 2^-15
+
+#define Q15_ONE 32767
+#define WIRE3D_MAX_VERTS 32
+
+typedef struct {
+    const q15_t (*verts)[3];
+    const uint8_t (*edges)[2];
+    uint8_t vert_count;
+    uint8_t edge_count;
+} wire3d_mesh_t;
+
+extern const wire3d_mesh_t wire3d_cube;
+
+typedef struct {
+    q15_t m[3][3];
+} wire3d_rot_t;
+
+// the screen box a frame touched, to clear and send just that next time
+typedef struct {
+    int16_t x0, y0, x1, y1; // x1 < x0 when empty
+} wire3d_box_t;
+
+// q = (w, x, y, z), unit length
+void wire3d_rot_from_quat(wire3d_rot_t *r, const float q[4]);
+// rotate and project the mesh around (cx, cy), a unit length spans about
+// `scale` pixels. Writes the projected points, returns their bounding box.
+wire3d_box_t wire3d_project(const wire3d_mesh_t *mesh, const wire3d_rot_t *r, int cx, int cy, int scale,
+                            int16_t (*points)[2]);
+void wire3d_draw(ssd1306_t *d, const wire3d_mesh_t *mesh, const int16_t (*points)[2]);
+
+#endif
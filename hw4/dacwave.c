@@ -0,0 +1,152 @@
+// DMA paced DAC waveforms, see dacwave.h
+
+#include "pico/stdlib.h"
+#include "hardware/spi.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/clocks.h"
+#include "dacwave.h"
+
+// the one streaming, for the interrupt
+static dacwave_t *streaming;
+
+// how far num / den of sys is from hz, times den
+static uint64_t off(uint64_t num, uint64_t den, uint32_t hz, uint32_t sys) {
+    uint64_t a = num * sys, b = den * hz;
+    return a > b ? a - b : b - a;
+}
+
+// num / den of clk_sys as close to hz as 16 bits each allow: the last
+// convergent of hz / sys that fits, or the semiconvergent after it that
+// takes den up to the limit if that's closer
+static uint32_t set_timer(int timer, uint32_t hz) {
+    uint32_t sys = clock_get_hz(clk_sys);
+    uint64_t n0 = 0, d0 = 1, n1 = 1, d1 = 0;
+    uint64_t p = hz < sys ? hz : sys, q = sys;
+    while (q) {
+        uint64_t a = p / q;
+        if (d0 + a * d1 > 0xFFFF) {
+            uint64_t t = (0xFFFF - d0) / d1;
+            uint64_t n = n0 + t * n1, d = d0 + t * d1;
+            if (off(n, d, hz, sys) * d1 < off(n1, d1, hz, sys) * d) {
+                n1 = n;
+                d1 = d;
+            }
+            break;
+        }
+        uint64_t n = n0 + a * n1, d = d0 + a * d1;
+        n0 = n1;
+        d0 = d1;
+        n1 = n;
+        d1 = d;
+        uint64_t r = p - a * q;
+        p = q;
+        q = r;
+    }
+    if (n1 == 0) {
+        n1 = 1;
+        d1 = 0xFFFF;
+    }
+    dma_timer_set_fraction(timer, (uint16_t)n1, (uint16_t)d1);
+    return (uint32_t)((uint64_t)sys * n1 / d1);
+}
+
+bool dacwave_init(dacwave_t *w, spi_inst_t *spi, uint32_t rate_hz) {
+    w->spi = spi;
+    w->running = false;
+    w->blocks = w->late = 0;
+    // CSn goes high between frames in mode 0, which latches each word
+    spi_set_format(spi, 16, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+    w->timer = dma_claim_unused_timer(true);
+    w->data = dma_claim_unused_channel(true);
+    w->reload = dma_claim_unused_channel(true);
+    w->rate_hz = set_timer(w->timer, 2 * rate_hz) / 2;
+    // a word is 16 clocks and a clock of CSn high, the FIFO evens out the rest
+    return spi_get_baudrate(spi) / 17 >= 2 * w->rate_hz;
+}
+
+static void start(dacwave_t *w, const uint16_t *first, uint32_t words, bool irq) {
+    dma_channel_config c = dma_channel_get_default_config(w->data);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, dma_get_timer_dreq(w->timer));
+    channel_config_set_chain_to(&c, w->reload);
+    dma_channel_configure(w->data, &c, &spi_get_hw(w->spi)->dr, first, words, false);
+    dma_channel_set_irq0_enabled(w->data, irq);
+
+    // one word a trigger, from the ring of two
+    c = dma_channel_get_default_config(w->reload);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_ring(&c, false, 3);
+    dma_channel_configure(w->reload, &c, &dma_hw->ch[w->data].al3_read_addr_trig, &w->next[1], 1, false);
+
+    w->running = true;
+    dma_channel_start(w->data);
+}
+
+void dacwave_play(dacwave_t *w, const uint16_t *words, uint32_t n) {
+    dacwave_stop(w);
+    w->next[0] = w->next[1] = words;
+    start(w, words, n, false);
+}
+
+static void __isr stream_done(void) {
+    dacwave_t *w = streaming;
+    if (!w || !dma_channel_get_irq0_status(w->data)) {
+        return;
+    }
+    dma_channel_acknowledge_irq0(w->data);
+    // the reload has already started the other buffer
+    uint32_t done = w->blocks & 1;
+    w->fill(w->buffer[done], w->words / 2);
+    w->blocks++;
+    if (dma_channel_get_irq0_status(w->data)) {
+        // that one ran out before this was ready
+        w->late++;
+    }
+}
+
+void dacwave_stream(dacwave_t *w, uint16_t *buffer0, uint16_t *buffer1, uint32_t pairs, dacwave_fill_t fill) {
+    dacwave_stop(w);
+    w->buffer[0] = buffer0;
+    w->buffer[1] = buffer1;
+    w->words = 2 * pairs;
+    w->fill = fill;
+    w->blocks = w->late = 0;
+    fill(buffer0, pairs);
+    fill(buffer1, pairs);
+    w->next[0] = buffer0;
+    w->next[1] = buffer1;
+    streaming = w;
+    irq_add_shared_handler(DMA_IRQ_0, stream_done, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+    start(w, buffer0, w->words, true);
+}
+
+void dacwave_stop(dacwave_t *w) {
+    if (!w->running) {
+        return;
+    }
+    // the reload could restart the data channel between the two aborts,
+    // so the reload goes first and again after
+    dma_channel_abort(w->reload);
+    dma_channel_abort(w->data);
+    dma_channel_abort(w->reload);
+    dma_channel_set_irq0_enabled(w->data, false);
+    if (streaming == w) {
+        irq_remove_handler(DMA_IRQ_0, stream_done);
+        streaming = NULL;
+    }
+    w->running = false;
+}
+
+void dacwave_table(uint16_t *words, uint32_t pairs, int ch, uint32_t cycles, float (*shape)(float phase)) {
+    for (uint32_t i = 0; i < pairs; i++) {
+        float phase = (float)((uint64_t)i * cycles % pairs) / pairs;
+        float v = (shape(phase) + 1.0f) * 0.5f * 1023.0f + 0.5f;
+        words[2 * i + ch] = dacwave_word(ch, v < 0 ? 0 : v > 1023 ? 1023 : (uint16_t)v);
+    }
+}
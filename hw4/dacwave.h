@@ -0,0 +1,67 @@
+#ifndef DACWAVE_H__
+#define DACWAVE_H__
+
+// Waveform output to the MCP4912 with no CPU per sample.
+//
+// The samples are the DAC's 16-bit command words, ready to send, A and B
+// interleaved. A DMA channel writes them to the SPI data register, paced
+// by a DMA timer at twice the sample rate, so each channel updates at the
+// sample rate, the two half a sample apart. The SPI runs 16-bit frames in
+// mode 0, where the PL022 raises its CSn pin between frames on its own, and
+// the DAC latches each word on that edge.
+//
+// When the channel finishes a buffer it chains to a second channel, which
+// writes the next buffer's address into the first one's read-address
+// trigger, from a two-entry ring. Playing one table in a loop, both
+// entries are the same and nothing else runs. Streaming, they are two
+// buffers, and the DMA interrupt refills the one that just finished while
+// the other plays.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/spi.h"
+
+#define DACWAVE_A 0
+#define DACWAVE_B 1
+
+// 10-bit value as the command for channel ch: buffered, 1x gain, active
+static inline uint16_t dacwave_word(int ch, uint16_t value) {
+    return (uint16_t)((ch ? 0xF000 : 0x7000) | (value & 0x3FF) << 2);
+}
+
+// fills `pairs` A, B word pairs
+typedef void (*dacwave_fill_t)(uint16_t *words, uint32_t pairs);
+
+typedef struct {
+    // read by the reload channel, which wraps on this 8 byte boundary
+    const uint16_t *next[2] __attribute__((aligned(8)));
+    spi_inst_t *spi;
+    int timer, data, reload;
+    uint32_t rate_hz;             // per channel, as the timer divides it
+
+    uint16_t *buffer[2];          // streaming
+    uint32_t words;               // per buffer
+    dacwave_fill_t fill;
+    volatile uint32_t blocks;     // buffers finished
+    volatile uint32_t late;       // refills still running when the next buffer ran out
+    bool running;
+} dacwave_t;
+
+// spi set up with its pins (CSn included), switched to 16-bit mode 0.
+// Claims a DMA timer and two channels. rate_hz is rounded to what the
+// timer can divide clk_sys into, false if the SPI clock is too slow for it.
+bool dacwave_init(dacwave_t *w, spi_inst_t *spi, uint32_t rate_hz);
+// play words (n of them, A and B interleaved) in a loop until stopped.
+// They are read as they go out, so they have to stay put.
+void dacwave_play(dacwave_t *w, const uint16_t *words, uint32_t n);
+// play buffer0, buffer1, buffer0 ..., pairs samples each, calling fill for
+// each from the DMA interrupt (DMA_IRQ_0) once it has gone out. Both are
+// filled before it starts.
+void dacwave_stream(dacwave_t *w, uint16_t *buffer0, uint16_t *buffer1, uint32_t pairs, dacwave_fill_t fill);
+void dacwave_stop(dacwave_t *w);
+
+// cycles periods of shape (phase 0..1 to -1..1) into the channel's half of
+// a table for dacwave_play(), scaled to 0..1023
+void dacwave_table(uint16_t *words, uint32_t pairs, int ch, uint32_t cycles, float (*shape)(float phase));
+
+#endif
@@ -0,0 +1,130 @@
+// Direct digital synthesis, see dds.h
+
+#include <math.h>
+#include "dacwave.h"
+#include "dds.h"
+
+#define LUT_BITS 8
+
+// sin(2 pi i / 256) in Q15, and the first again so entry i + 1 is always there
+static const int16_t sine_lut[(1 << LUT_BITS) + 1] = {
+    0, 804, 1608, 2410, 3212, 4011, 4808, 5602, 6393, 7179, 7962, 8739,
+    9512, 10278, 11039, 11793, 12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594, 23170, 23731, 24279, 24811,
+    25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521,
+    32609, 32678, 32728, 32757, 32767, 32757, 32728, 32678, 32609, 32521, 32412, 32285,
+    32137, 31971, 31785, 31580, 31356, 31113, 30852, 30571, 30273, 29956, 29621, 29268,
+    28898, 28510, 28105, 27683, 27245, 26790, 26319, 25832, 25329, 24811, 24279, 23731,
+    23170, 22594, 22005, 21403, 20787, 20159, 19519, 18868, 18204, 17530, 16846, 16151,
+    15446, 14732, 14010, 13279, 12539, 11793, 11039, 10278, 9512, 8739, 7962, 7179,
+    6393, 5602, 4808, 4011, 3212, 2410, 1608, 804, 0, -804, -1608, -2410,
+    -3212, -4011, -4808, -5602, -6393, -7179, -7962, -8739, -9512, -10278, -11039, -11793,
+    -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530, -18204, -18868, -19519, -20159,
+    -20787, -21403, -22005, -22594, -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790,
+    -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956, -30273, -30571, -30852, -31113,
+    -31356, -31580, -31785, -31971, -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+    -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285, -32137, -31971, -31785, -31580,
+    -31356, -31113, -30852, -30571, -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683,
+    -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731, -23170, -22594, -22005, -21403,
+    -20787, -20159, -19519, -18868, -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+    -12539, -11793, -11039, -10278, -9512, -8739, -7962, -7179, -6393, -5602, -4808, -4011,
+    -3212, -2410, -1608, -804, 0,
+};
+
+static inline int32_t sine(uint32_t phase) {
+    uint32_t i = phase >> (32 - LUT_BITS);
+    int32_t frac = (int32_t)(phase >> (16 - LUT_BITS) & 0xFFFF);
+    int32_t a = sine_lut[i];
+    return a + (((sine_lut[i + 1] - a) * frac + 32768) >> 16);
+}
+
+// -1 at 0, up to +1 at half a turn and back, like the table version
+static inline int32_t triangle(uint32_t phase) {
+    int32_t v = (int32_t)(phase >> 15);
+    return v < 65536 ? v - 32768 : 98303 - v;
+}
+
+static inline int32_t saw(uint32_t phase) {
+    int32_t v = (int32_t)(phase >> 16) - 32768;
+    return v < -32767 ? -32767 : v;
+}
+
+static inline int32_t square(uint32_t phase) {
+    return phase < 0x80000000u ? 32767 : -32767;
+}
+
+int16_t dds_wave(dds_shape_t shape, uint32_t phase) {
+    switch (shape) {
+    case DDS_TRIANGLE: return (int16_t)triangle(phase);
+    case DDS_SAW:      return (int16_t)saw(phase);
+    case DDS_SQUARE:   return (int16_t)square(phase);
+    default:           return (int16_t)sine(phase);
+    }
+}
+
+const char *dds_shape_name(dds_shape_t shape) {
+    static const char *const names[DDS_SHAPES] = { "sine", "triangle", "saw", "square" };
+    return shape < DDS_SHAPES ? names[shape] : "?";
+}
+
+void dds_init(dds_t *d, uint32_t rate_hz) {
+    d->rate_hz = rate_hz;
+    for (int ch = 0; ch < 2; ch++) {
+        d->ch[ch].step = d->ch[ch].offset = d->ch[ch].phase = 0;
+        d->ch[ch].amplitude = 0;
+        d->ch[ch].shape = DDS_SINE;
+    }
+}
+
+void dds_set_hz(dds_t *d, int ch, float hz) {
+    // double for the 32 bits, this isn't per sample
+    double turns = (double)hz / d->rate_hz;
+    if (turns < 0) turns = 0;
+    if (turns > 0.5) turns = 0.5;
+    d->ch[ch].step = (uint32_t)llround(turns * 4294967296.0);
+}
+
+void dds_set_phase(dds_t *d, int ch, float degrees) {
+    double turns = fmod((double)degrees / 360.0, 1.0);
+    if (turns < 0) turns += 1.0;
+    d->ch[ch].offset = (uint32_t)(uint64_t)llround(turns * 4294967296.0);
+}
+
+void dds_set(dds_t *d, int ch, dds_shape_t shape, float hz, uint16_t amplitude) {
+    d->ch[ch].shape = (uint8_t)(shape < DDS_SHAPES ? shape : DDS_SINE);
+    d->ch[ch].amplitude = amplitude > 511 ? 511 : amplitude;
+    dds_set_hz(d, ch, hz);
+}
+
+float dds_hz(const dds_t *d, int ch) {
+    return (float)((double)d->ch[ch].step * d->rate_hz / 4294967296.0);
+}
+
+// One loop per shape, so the switch is once a block and not once a sample.
+// Q15 times the amplitude, rounded, around mid scale: 1..1023.
+#define FILL(wave)                                                           \
+    for (uint32_t i = 0; i < pairs; i++, words += 2) {                       \
+        int32_t v = 512 + ((wave(phase + offset) * amplitude + 16384) >> 15); \
+        *words = (uint16_t)(command | v << 2);                               \
+        phase += step;                                                       \
+    }
+
+static void fill_channel(dds_channel_t *c, int ch, uint16_t *words, uint32_t pairs) {
+    // read once, a change lands on a block boundary
+    uint32_t step = c->step, offset = c->offset, phase = c->phase;
+    int32_t amplitude = c->amplitude;
+    uint16_t command = dacwave_word(ch, 0);
+    switch (c->shape) {
+    case DDS_TRIANGLE: FILL(triangle); break;
+    case DDS_SAW:      FILL(saw); break;
+    case DDS_SQUARE:   FILL(square); break;
+    default:           FILL(sine); break;
+    }
+    c->phase = phase;
+}
+
+void dds_fill(dds_t *d, uint16_t *words, uint32_t pairs) {
+    fill_channel(&d->ch[DACWAVE_A], DACWAVE_A, words + DACWAVE_A, pairs);
+    fill_channel(&d->ch[DACWAVE_B], DACWAVE_B, words + DACWAVE_B, pairs);
+}
@@ -0,0 +1,52 @@
+#ifndef DDS_H__
+#define DDS_H__
+
+// Direct digital synthesis for the two DAC channels, at a fixed sample
+// rate.
+//
+// Each channel has a 32-bit phase accumulator that steps by f / rate of a
+// turn every sample, so the frequency resolution is rate / 2^32 and any
+// frequency below rate / 2 plays without touching the timing. The top 8
+// bits of the phase pick an entry of a 257 entry sine table (in flash,
+// const), the next 16 interpolate to the one after it, which puts the
+// table's error around -91 dB, far under the 10-bit DAC's -62. Triangle,
+// saw and square are worked out from the phase directly; their edges alias,
+// there's nothing band-limiting them.
+//
+// Frequency, phase, shape and amplitude are single stores, so they can be
+// changed from the main loop while the DMA interrupt fills buffers. A new
+// frequency carries on from the current phase, without a jump.
+
+#include <stdint.h>
+
+typedef enum { DDS_SINE, DDS_TRIANGLE, DDS_SAW, DDS_SQUARE, DDS_SHAPES } dds_shape_t;
+
+typedef struct {
+    volatile uint32_t step;      // 2^32 f / rate
+    volatile uint32_t offset;    // added to the phase, 2^32 is a turn
+    volatile uint16_t amplitude; // peak, 0..511 DAC counts around mid scale
+    volatile uint8_t shape;
+    uint32_t phase;
+} dds_channel_t;
+
+typedef struct {
+    uint32_t rate_hz;
+    dds_channel_t ch[2];
+} dds_t;
+
+// both channels silent at mid scale
+void dds_init(dds_t *d, uint32_t rate_hz);
+void dds_set(dds_t *d, int ch, dds_shape_t shape, float hz, uint16_t amplitude);
+void dds_set_hz(dds_t *d, int ch, float hz);
+// where the channel is in its cycle relative to its accumulator, 0..360
+void dds_set_phase(dds_t *d, int ch, float degrees);
+// the frequency the step really gives
+float dds_hz(const dds_t *d, int ch);
+const char *dds_shape_name(dds_shape_t shape);
+
+// full scale Q15 for the shape at phase
+int16_t dds_wave(dds_shape_t shape, uint32_t phase);
+// pairs A, B MCP4912 command words, the accumulators moved on by as much
+void dds_fill(dds_t *d, uint16_t *words, uint32_t pairs);
+
+#endif
@@ -0,0 +1,253 @@
+// Host benchmark for the DDS (dds.c): spectral purity of what it sends the
+// DAC.
+//
+//   ./bench_dds
+//
+// The words dds_fill() makes are turned back into the 10-bit DAC values,
+// 65536 samples at a time, and windowed (7-term Blackman-Harris, so the
+// window's own leakage is far under anything measured) into a double FFT. From that: SINAD, the effective bits,
+// SFDR, and the frequency of the peak. Each sine is set next to the same
+// sine worked out in double and rounded to 10 bits, the best a 10-bit DAC
+// can do, and should come within a fraction of a bit of it; the Q15 values
+// before rounding should be far past it, which is the table and the
+// interpolation on their own. Then that changing the frequency doesn't
+// jump, that B's phase lands where it's set, the other shapes for
+// reference (their aliasing included), and the time per sample.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include "dacwave.h"
+#include "dds.h"
+
+#define RATE_HZ 10000
+#define LOG2N   16
+#define N       (1 << LOG2N)
+#define BLOCK   256
+#define LOBE    10
+#define ROUNDS  200
+
+static int failures;
+static dds_t dds;
+static uint16_t words[2 * N];
+static double x[N], re[N], im[N], window[N];
+
+static void expect(const char *what, bool ok) {
+    printf("  %-56s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) failures++;
+}
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void fft(double *r, double *i, int log2n) {
+    int n = 1 << log2n;
+    for (int a = 1, b = 0; a < n; a++) {
+        int bit = n >> 1;
+        for (; b & bit; bit >>= 1) b ^= bit;
+        b ^= bit;
+        if (a < b) {
+            double t = r[a]; r[a] = r[b]; r[b] = t;
+            t = i[a]; i[a] = i[b]; i[b] = t;
+        }
+    }
+    for (int len = 2; len <= n; len <<= 1) {
+        double a = -2 * M_PI / len;
+        for (int s = 0; s < n; s += len) {
+            for (int k = 0; k < len / 2; k++) {
+                double wr = cos(a * k), wi = sin(a * k);
+                int p = s + k, q = p + len / 2;
+                double tr = r[q] * wr - i[q] * wi, ti = r[q] * wi + i[q] * wr;
+                r[q] = r[p] - tr; i[q] = i[p] - ti;
+                r[p] += tr; i[p] += ti;
+            }
+        }
+    }
+}
+
+typedef struct {
+    double sinad, enob, sfdr, hz;
+} purity_t;
+
+// the fundamental is the biggest bin and the 10 either side of it (the
+// window's main lobe is 7), DC and its lobe are left out, the rest is
+// noise and distortion
+static purity_t purity(const double *v) {
+    double mean = 0;
+    for (int i = 0; i < N; i++) mean += v[i];
+    mean /= N;
+    for (int i = 0; i < N; i++) {
+        re[i] = (v[i] - mean) * window[i];
+        im[i] = 0;
+    }
+    fft(re, im, LOG2N);
+    static double p[N / 2];
+    int peak = 0;
+    for (int k = 0; k < N / 2; k++) {
+        p[k] = re[k] * re[k] + im[k] * im[k];
+        if (k > LOBE && p[k] > p[peak]) peak = k;
+    }
+    double signal = 0, rest = 0, spur = 0, moment = 0;
+    for (int k = LOBE + 1; k < N / 2; k++) {
+        if (k >= peak - LOBE && k <= peak + LOBE) {
+            signal += p[k];
+            moment += p[k] * k;
+        } else {
+            rest += p[k];
+        }
+    }
+    // spurs are a window's worth of bins too
+    for (int k = 2 * LOBE + 1; k < N / 2 - 7; k++) {
+        if (k >= peak - 2 * LOBE && k <= peak + 2 * LOBE) continue;
+        double s = 0;
+        for (int j = -7; j <= 7; j++) s += p[k + j];
+        if (s > spur) spur = s;
+    }
+    purity_t r;
+    r.sinad = 10 * log10(signal / rest);
+    r.enob = (r.sinad - 1.76) / 6.02;
+    r.sfdr = 10 * log10(signal / spur);
+    r.hz = moment / signal * RATE_HZ / N;
+    return r;
+}
+
+// channel ch's DAC values, checking the command bits as it goes
+static bool values(int ch, double *v) {
+    bool ok = true;
+    for (int i = 0; i < N; i++) {
+        uint16_t w = words[2 * i + ch];
+        ok &= (w & 0xF003) == dacwave_word(ch, 0);
+        v[i] = w >> 2 & 0x3FF;
+    }
+    return ok;
+}
+
+static void run(void) {
+    for (int i = 0; i < N; i += BLOCK) dds_fill(&dds, words + 2 * i, BLOCK);
+}
+
+static void sine(double hz) {
+    dds_init(&dds, RATE_HZ);
+    dds_set(&dds, DACWAVE_A, DDS_SINE, (float)hz, 511);
+    run();
+    bool ok = values(DACWAVE_A, x);
+    purity_t got = purity(x);
+
+    // the ideal 10 bits, at the frequency the step gives
+    double f = dds_hz(&dds, DACWAVE_A);
+    for (int i = 0; i < N; i++) x[i] = 512 + round(511 * sin(2 * M_PI * f * i / RATE_HZ));
+    purity_t ideal = purity(x);
+
+    // before rounding to 10 bits
+    uint32_t phase = 0, step = dds.ch[DACWAVE_A].step;
+    for (int i = 0; i < N; i++, phase += step) x[i] = dds_wave(DDS_SINE, phase);
+    purity_t q15 = purity(x);
+
+    printf("  %8.2f Hz: SINAD %5.2f dB (%4.2f bits), SFDR %5.1f dB;"
+           " ideal 10 bits %5.2f dB (%4.2f bits), SFDR %5.1f; Q15 %5.1f dB\n",
+           hz, got.sinad, got.enob, got.sfdr, ideal.sinad, ideal.enob, ideal.sfdr, q15.sinad);
+    char what[80];
+    snprintf(what, sizeof(what), "%.2f Hz: command bits, frequency", hz);
+    // hz goes in as a float
+    expect(what, ok && fabs(f - (float)hz) <= (double)RATE_HZ / 4294967296.0 && fabs(got.hz - hz) < 0.1);
+    snprintf(what, sizeof(what), "%.2f Hz: within 0.1 bit of ideal 10 bits", hz);
+    expect(what, got.enob > ideal.enob - 0.1);
+    snprintf(what, sizeof(what), "%.2f Hz: table and interpolation over 85 dB", hz);
+    expect(what, q15.sinad > 85);
+}
+
+// a new frequency mid stream carries on from where the phase was
+static void glide(void) {
+    dds_init(&dds, RATE_HZ);
+    dds_set(&dds, DACWAVE_A, DDS_SINE, 50, 511);
+    int worst = 0;
+    for (int b = 0; b < 64; b++) {
+        dds_set_hz(&dds, DACWAVE_A, 50 + 23.7f * b);
+        dds_fill(&dds, words + 2 * b * BLOCK, BLOCK);
+    }
+    // no step bigger than the fastest of them can make
+    double f = 50 + 23.7 * 63, biggest = 511 * 2 * M_PI * f / RATE_HZ + 2;
+    for (int i = 1; i < 64 * BLOCK; i++) {
+        int d = abs((words[2 * i] >> 2 & 0x3FF) - (words[2 * i - 2] >> 2 & 0x3FF));
+        if (d > worst) worst = d;
+    }
+    printf("  64 frequency changes 50..1543 Hz: biggest step %d counts, %.0f allowed\n", worst, biggest);
+    expect("frequency changes without a jump", worst <= biggest);
+}
+
+// B a quarter turn ahead of A is A's cosine
+static void quarter(void) {
+    dds_init(&dds, RATE_HZ);
+    dds_set(&dds, DACWAVE_A, DDS_SINE, 321.5f, 511);
+    dds_set(&dds, DACWAVE_B, DDS_SINE, 321.5f, 511);
+    dds_set_phase(&dds, DACWAVE_B, 90);
+    run();
+    double sa = 0, ca = 0, sb = 0, cb = 0;
+    for (int i = 0; i < N; i++) {
+        double w = 2 * M_PI * dds_hz(&dds, DACWAVE_A) * i / RATE_HZ;
+        double a = (words[2 * i] >> 2 & 0x3FF) - 512.0, b = (words[2 * i + 1] >> 2 & 0x3FF) - 512.0;
+        sa += a * sin(w); ca += a * cos(w);
+        sb += b * sin(w); cb += b * cos(w);
+    }
+    double deg = (atan2(cb, sb) - atan2(ca, sa)) * 180 / M_PI;
+    if (deg < 0) deg += 360;
+    printf("  B set 90 degrees after A: %.4f degrees\n", deg);
+    expect("phase within 0.01 degree", fabs(deg - 90) < 0.01);
+}
+
+static void shapes(void) {
+    static const float hz[DDS_SHAPES] = { 0, 101.3f, 101.3f, 101.3f };
+    for (int s = DDS_TRIANGLE; s < DDS_SHAPES; s++) {
+        dds_init(&dds, RATE_HZ);
+        dds_set(&dds, DACWAVE_A, s, hz[s], 511);
+        run();
+        values(DACWAVE_A, x);
+        purity_t got = purity(x);
+        // harmonics count against it here, this is only how clean the
+        // fundamental sits among them
+        printf("  %-8s %6.1f Hz: fundamental %6.2f Hz, %5.1f dB over the harmonics and aliases\n",
+               dds_shape_name(s), hz[s], got.hz, got.sinad);
+    }
+}
+
+static void timing(void) {
+    dds_init(&dds, RATE_HZ);
+    for (int s = 0; s < DDS_SHAPES; s++) {
+        dds_set(&dds, DACWAVE_A, s, 440, 511);
+        dds_set(&dds, DACWAVE_B, s, 441, 400);
+        double t0 = now_us();
+        for (int r = 0; r < ROUNDS; r++) dds_fill(&dds, words, N);
+        double ns = (now_us() - t0) * 1000 / ROUNDS / N;
+        printf("  %-8s %.2f ns per A, B pair\n", dds_shape_name(s), ns);
+    }
+}
+
+int main(void) {
+    static const double bh7[7] = { 0.27105140069342, -0.43329793923448, 0.21812299954311, -0.06592544638803,
+                                   0.01081174209837, -0.00077658482522, 0.00001388721735 };
+    for (int i = 0; i < N; i++) {
+        window[i] = 0;
+        for (int j = 0; j < 7; j++) window[i] += bh7[j] * cos(2 * M_PI * j * i / N);
+    }
+    printf("sine purity at %d samples/s, %d samples, full scale\n", RATE_HZ, N);
+    sine(1000);
+    sine(997.3);
+    sine(123.456);
+    sine(3141.59);
+    sine(4700.1);
+    printf("changes while playing\n");
+    glide();
+    quarter();
+    printf("other shapes\n");
+    shapes();
+    printf("fill time on this machine\n");
+    timing();
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,12 @@
+#ifndef HOST_HARDWARE_SPI_H
+#define HOST_HARDWARE_SPI_H
+
+// Host stand-in for hardware/spi.h, enough for dacwave.h's declarations.
+// Nothing on the host sends anything.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct spi_inst spi_inst_t;
+
+#endif
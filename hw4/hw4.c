@@ -1,124 +1,152 @@
 #include <stdio.h>
+#include <string.h>
 #include "pico/stdlib.h"
 #include "hardware/spi.h"
+#include "hardware/structs/systick.h"
 #include <math.h>
+#include "dacwave.h"
+#include "dds.h"
 
 // SPI Defines. These pins are used for SPI0:
 #define SPI_PORT spi0
 #define PIN_MISO 16
-#define PIN_CS   20
+#define PIN_CS   17 // SPI0 CSn, so the SPI block toggles it for every word
 #define PIN_SCK  18
 #define PIN_MOSI 19
 
-// Chip select functions. The inline assembly nops provide a small delay before/after toggling.
-static inline void cs_select(uint cs_pin) {
-    asm volatile("nop \n nop \n nop");
-    gpio_put(cs_pin, 0);
-    asm volatile("nop \n nop \n nop");
+// Samples per second on each DAC channel. The DMA timer paces the words,
+// so the rate is exact and the CPU does nothing per sample.
+#define SAMPLE_RATE_HZ 10000
+
+// Sine on channel A and triangle on channel B, in Hz
+#define SINE_HZ     2
+#define TRIANGLE_HZ 1
+
+// 1 makes the waves with phase accumulators (dds.c), streamed in blocks,
+// at any frequency and changeable over USB while playing: lines like
+// "a sine 440", "b square 25.5 200" (amplitude 0..511) or "p 90" (B's phase
+// in degrees). 0 plays one precomputed table, where the rate has to be a
+// whole multiple of both frequencies.
+#define DDS 1
+#define DDS_BLOCK_PAIRS 256 // 25.6 ms at 10 kHz
+
+static dacwave_t wave;
+
+#if DDS
+static dds_t dds;
+static uint16_t block[2][2 * DDS_BLOCK_PAIRS];
+// SysTick cycles in the refills and the samples they made
+static volatile uint32_t fill_cycles, fill_pairs;
+
+static void fill(uint16_t *words, uint32_t pairs) {
+    uint32_t c0 = systick_hw->cvr;
+    dds_fill(&dds, words, pairs);
+    fill_cycles += (c0 - systick_hw->cvr) & 0x00FFFFFF;
+    fill_pairs += pairs;
+}
+
+static void command(char *line) {
+    char which[8], shape[12];
+    float hz, degrees;
+    unsigned amplitude = 511;
+    if (sscanf(line, "p %f", &degrees) == 1) {
+        dds_set_phase(&dds, DACWAVE_B, degrees);
+        return;
+    }
+    int n = sscanf(line, "%7s %11s %f %u", which, shape, &hz, &amplitude);
+    if (n < 3 || (strcmp(which, "a") && strcmp(which, "b"))) {
+        printf("? a|b sine|triangle|saw|square hz [amplitude], or p degrees\n");
+        return;
+    }
+    for (int s = 0; s < DDS_SHAPES; s++) {
+        if (!strncmp(shape, dds_shape_name(s), strlen(shape))) {
+            dds_set(&dds, which[0] == 'b' ? DACWAVE_B : DACWAVE_A, s, hz, amplitude);
+            return;
+        }
+    }
+    printf("? %s\n", shape);
 }
+#else
+#define TABLE_HZ    1 // the slower of the two, or their common divisor
+#define TABLE_PAIRS (SAMPLE_RATE_HZ / TABLE_HZ)
+
+static uint16_t table[2 * TABLE_PAIRS];
+#endif
 
-static inline void cs_deselect(uint cs_pin) {
-    asm volatile("nop \n nop \n nop");
-    gpio_put(cs_pin, 1);
-    asm volatile("nop \n nop \n nop");
+#if !DDS
+static float sine(float phase) {
+    return sinf(2.0f * (float)M_PI * phase);
 }
 
+// up over the first half of the period, back down over the second
+static float triangle(float phase) {
+    return phase < 0.5f ? 4.0f * phase - 1.0f : 3.0f - 4.0f * phase;
+}
+#endif
+
 int main() {
     stdio_init_all();
 
-    // Initialize SPI0 with a baud rate of 1mHz.
-    spi_init(SPI_PORT, 1000*1000); // 1 MHz SPI clock
+    // The MCP4912 takes up to 20 MHz, a 16 bit word and the CS gap take
+    // under 1 us, so both channels fit many times over at 10 kHz.
+    spi_init(SPI_PORT, 20 * 1000 * 1000);
     gpio_set_function(PIN_MISO, GPIO_FUNC_SPI);
     gpio_set_function(PIN_SCK,  GPIO_FUNC_SPI);
     gpio_set_function(PIN_MOSI, GPIO_FUNC_SPI);
-    // Set the chip-select pin for manual control.
-    gpio_set_function(PIN_CS, GPIO_FUNC_SIO);
-    gpio_set_dir(PIN_CS, GPIO_OUT);
-    gpio_put(PIN_CS, 1);
-
-    // Sine wave parameters (Channel A):
-    // A 2 Hz sine wave has a period of 0.5 sec.
-    // With an update rate of 100 Hz (every 10 ms), we need 50 samples per cycle.
-    const float update_interval_ms = 10.0f;  // 10 ms update period
-    const int sine_samples_per_cycle = 50;
-    const float sine_phase_increment = (2.0f * M_PI) / sine_samples_per_cycle;
-    float sine_phase = 0.0f;
-
-    // Triangle wave parameters (Channel B):
-    // A 1 Hz triangle wave has a period of 1 sec.
-    // With a 100 Hz update rate, we need 100 samples per cycle.
-    const int triangle_samples_per_cycle = 100;
-    int triangle_index = 0; // Ranges from 0 to 99 over one full cycle.
-
-    // it takes time to write to dac, and lower baud rate means slower write time -> potentially greater waveform distortion - unless we use interrupt
+    // CS is the SPI block's own now: it goes high between 16 bit frames,
+    // which is the edge the DAC latches each word on
+    gpio_set_function(PIN_CS,   GPIO_FUNC_SPI);
+
+    if (!dacwave_init(&wave, SPI_PORT, SAMPLE_RATE_HZ)) {
+        printf("SPI too slow for %d samples/s\n", SAMPLE_RATE_HZ);
+    }
+
+#if DDS
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5; // enable, processor clock
+
+    dds_init(&dds, wave.rate_hz);
+    dds_set(&dds, DACWAVE_A, DDS_SINE, SINE_HZ, 511);
+    dds_set(&dds, DACWAVE_B, DDS_TRIANGLE, TRIANGLE_HZ, 511);
+    dacwave_stream(&wave, block[0], block[1], DDS_BLOCK_PAIRS, fill);
+
+    // the DMA interrupt does the samples, the loop takes commands
+    char line[48];
+    int len = 0;
+    uint64_t next = time_us_64();
     while (true) {
-        /////////// Channel A: 2 Hz Sine Wave ///////////
-        // Compute the sine wave sample.
-        // sinf returns values between -1 and 1, so we normalize to a 0–1 range.
-        float sine_val = sinf(sine_phase);
-        float sine_normalized = (sine_val + 1.0f) / 2.0f;
-        // Scale to a 10-bit value (0–1023).
-        uint16_t sine_dac_value = (uint16_t)(sine_normalized * 1023);
-        // Build the 16-bit command word:
-        // For Channel A, configuration bits are:
-        //   Bit15 = 0 (Channel A)
-        //   Bit14 = 1 (buffer enabled)
-        //   Bit13 = 1 (gain = 1x)
-        //   Bit12 = 1 (active mode)
-        // Hence: (0b0111 << 12) | (sine_dac_value << 2)
-        uint16_t command_word_A = (0b0111 << 12) | (sine_dac_value << 2);
-        // Pack the command word into two bytes (big-endian).
-        uint8_t data_A[2];
-        data_A[0] = (command_word_A >> 8) & 0xFF;
-        data_A[1] = command_word_A & 0xFF;
-        // Transmit the command for Channel A:
-        cs_select(PIN_CS);
-        spi_write_blocking(SPI_PORT, data_A, 2);
-        cs_deselect(PIN_CS);
-
-        /////////// Channel B: 1 Hz Triangle Wave ///////////
-        // Generate the triangle wave sample.
-        float triangle_normalized;
-        if (triangle_index < (triangle_samples_per_cycle / 2)) {
-            // Rising slope: from 0 to 1 over the first half-cycle.
-            triangle_normalized = (float)triangle_index / (triangle_samples_per_cycle / 2);
-        } else {
-            // Falling slope: from 1 back to 0 during the second half-cycle.
-            triangle_normalized = (float)(triangle_samples_per_cycle - triangle_index) / (triangle_samples_per_cycle / 2);
-        }
-        // Convert the normalized value to a 10-bit value.
-        uint16_t triangle_dac_value = (uint16_t)(triangle_normalized * 1023);
-        // Build the 16-bit command word for Channel B:
-        // For Channel B, set Bit15 = 1 (to select Channel B) while keeping other configuration bits:
-        //   Bit15 = 1 (Channel B)
-        //   Bit14 = 1 (buffer enabled)
-        //   Bit13 = 1 (gain = 1x)
-        //   Bit12 = 1 (active mode)
-        // Hence: (0b1111 << 12) | (triangle_dac_value << 2)
-        uint16_t command_word_B = (0b1111 << 12) | (triangle_dac_value << 2);
-        // Pack the command word into two bytes (big-endian).
-        uint8_t data_B[2];
-        data_B[0] = (command_word_B >> 8) & 0xFF;
-        data_B[1] = command_word_B & 0xFF;
-        // Transmit the command for Channel B:
-        cs_select(PIN_CS);
-        spi_write_blocking(SPI_PORT, data_B, 2);
-        cs_deselect(PIN_CS);
-
-        // Update the sine wave phase.
-        sine_phase += sine_phase_increment;
-        if (sine_phase >= 2.0f * M_PI) {
-            sine_phase -= 2.0f * M_PI;
+        int c = getchar_timeout_us(10000);
+        if (c == '\r' || c == '\n') {
+            line[len] = 0;
+            if (len) command(line);
+            len = 0;
+        } else if (c >= 0 && len < (int)sizeof(line) - 1) {
+            line[len++] = (char)c;
         }
+        if (time_us_64() < next) continue;
+        next += 1000000;
+        uint32_t cycles = fill_cycles, pairs = fill_pairs;
+        fill_cycles = fill_pairs = 0;
+        printf("A %s %.3f Hz, B %s %.3f Hz, %u samples/s: %.1f cycles/sample pair, %u late\n",
+               dds_shape_name(dds.ch[DACWAVE_A].shape), dds_hz(&dds, DACWAVE_A),
+               dds_shape_name(dds.ch[DACWAVE_B].shape), dds_hz(&dds, DACWAVE_B), (unsigned)wave.rate_hz,
+               pairs ? (double)cycles / pairs : 0.0, (unsigned)wave.late);
+    }
+#else
+    // The command words are worked out once. For channel A the
+    // configuration bits are 0b0111 (channel A, buffered, 1x gain, active),
+    // for channel B 0b1111, then the 10 bit value shifted up by 2.
+    dacwave_table(table, TABLE_PAIRS, DACWAVE_A, SINE_HZ / TABLE_HZ, sine);
+    dacwave_table(table, TABLE_PAIRS, DACWAVE_B, TRIANGLE_HZ / TABLE_HZ, triangle);
+    dacwave_play(&wave, table, 2 * TABLE_PAIRS);
 
-        // Update the triangle wave index.
-        triangle_index++;
-        if (triangle_index >= triangle_samples_per_cycle)
-            triangle_index = 0;
-
-        // Wait for the next update.
-        sleep_ms((int)update_interval_ms);
+    // From here the DMA does everything, the loop is free
+    while (true) {
+        printf("%u samples/s per channel, %u byte table\n", (unsigned)wave.rate_hz, (unsigned)sizeof(table));
+        sleep_ms(1000);
     }
+#endif
 
     return 0;
 }
@@ -0,0 +1,39 @@
+// MCP4912 on a PIO state machine, see dacpio.h
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/clocks.h"
+#include "dacpio.h"
+#include "dac_spi.pio.h"
+
+bool dacpio_init(dacpio_t *d, uint pin_sdi, uint pin_sck, uint32_t baud) {
+    uint lo = pin_sdi < pin_sck ? pin_sdi : pin_sck;
+    uint hi = pin_sdi > pin_sck + 1 ? pin_sdi : pin_sck + 1;
+    if (!pio_claim_free_sm_and_add_program_for_gpio_range(&dac_spi_program, &d->pio, &d->sm, &d->offset, lo,
+                                                          hi - lo + 1, true)) {
+        return false;
+    }
+    // the divider is 16.8 fixed point, the fraction cut off, and no less than 1
+    uint32_t sys = clock_get_hz(clk_sys);
+    uint64_t div256 = (uint64_t)sys * 256 / (DAC_SPI_CYCLES_PER_BIT * (uint64_t)baud);
+    if (div256 < 256) {
+        div256 = 256;
+        baud = sys / DAC_SPI_CYCLES_PER_BIT;
+    }
+    d->baud = (uint32_t)((uint64_t)sys * 256 / (DAC_SPI_CYCLES_PER_BIT * div256));
+    dac_spi_program_init(d->pio, d->sm, d->offset, pin_sdi, pin_sck, (float)baud);
+    return true;
+}
+
+void dacpio_deinit(dacpio_t *d) {
+    pio_sm_set_enabled(d->pio, d->sm, false);
+    pio_remove_program_and_unclaim_sm(&dac_spi_program, d->pio, d->sm, d->offset);
+}
+
+void dacpio_put(dacpio_t *d, uint16_t word) {
+    dac_spi_put(d->pio, d->sm, word);
+}
+
+uint32_t dacpio_max_rate(const dacpio_t *d) {
+    return d->baud * DAC_SPI_CYCLES_PER_BIT / DAC_SPI_CYCLES_PER_FRAME;
+}
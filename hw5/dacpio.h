@@ -0,0 +1,44 @@
+#ifndef DACPIO_H__
+#define DACPIO_H__
+
+// The MCP4912 on a PIO state machine instead of the SPI block.
+//
+// dac_spi.pio sends each 16-bit command word as its own frame with CSn low
+// for it and high after, so a word written to the state machine's FIFO is
+// a sample on the output, with no chip select to toggle by hand. The DAC
+// has its own three pins, and spi0 is left to the SRAM, so the two can
+// transfer at the same time. Words can come from the CPU (dacpio_put()) or
+// from a DMA channel writing 16 bits at a time into dacpio_fifo().
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/pio.h"
+
+typedef struct {
+    PIO pio;
+    uint sm, offset;
+    uint32_t baud;  // as the clock divider gives it
+} dacpio_t;
+
+// Claims a state machine and loads the program. CSn is pin_sck + 1. baud
+// is the SCK rate, up to 20 MHz for the MCP4912.
+bool dacpio_init(dacpio_t *d, uint pin_sdi, uint pin_sck, uint32_t baud);
+void dacpio_deinit(dacpio_t *d);
+
+// waits for room in the FIFO, which is 8 words deep
+void dacpio_put(dacpio_t *d, uint16_t word);
+
+// frames a second the program can send at its baud rate
+uint32_t dacpio_max_rate(const dacpio_t *d);
+
+static inline volatile void *dacpio_fifo(const dacpio_t *d) {
+    return &d->pio->txf[d->sm];
+}
+
+// for a DMA channel writing 16-bit words to dacpio_fifo() as fast as the
+// state machine sends them; a DMA timer's DREQ paces them at a sample rate
+static inline uint dacpio_dreq(const dacpio_t *d) {
+    return pio_get_dreq(d->pio, d->sm, true);
+}
+
+#endif
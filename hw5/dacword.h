@@ -0,0 +1,38 @@
+#ifndef DACWORD_H__
+#define DACWORD_H__
+
+// The sample format in the SRAM: each sample is the MCP4912 command word,
+// channel and configuration bits included, big-endian, so the bytes are in
+// the order they go out on the wire. The float math happens once, when a
+// waveform is encoded; playing it is copying words, 2 bytes of SRAM a
+// sample instead of a float's 4. The DMA into the PIO's FIFO swaps each
+// word's bytes on the way (channel_config_set_bswap()).
+
+#include <stdint.h>
+
+#define DACWORD_A 0
+#define DACWORD_B 1
+
+// the 10-bit value as the command for channel ch: buffered, 1x gain, active
+static inline uint16_t dacword(int ch, uint16_t value) {
+    return (uint16_t)((ch ? 0xF000 : 0x7000) | (value & 0x3FF) << 2);
+}
+
+// 0 to 3.3 V, clamped, as the DAC's 10-bit value
+static inline uint16_t dacword_volts(int ch, float volts) {
+    float normalized = volts / 3.3f;
+    if (normalized > 1.0f) normalized = 1.0f;
+    if (normalized < 0.0f) normalized = 0.0f;
+    return dacword(ch, (uint16_t)(normalized * 1023 + 0.5f));
+}
+
+static inline void dacword_store(uint8_t *dst, uint16_t word) {
+    dst[0] = (uint8_t)(word >> 8);
+    dst[1] = (uint8_t)word;
+}
+
+static inline uint16_t dacword_load(const uint8_t *src) {
+    return (uint16_t)(src[0] << 8 | src[1]);
+}
+
+#endif
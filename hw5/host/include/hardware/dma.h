@@ -0,0 +1,13 @@
+#ifndef HOST_HARDWARE_DMA_H
+#define HOST_HARDWARE_DMA_H
+
+// Host stand-in for hardware/dma.h: no DMA, nothing is ever busy.
+
+#include <stdbool.h>
+
+static inline bool dma_channel_is_busy(unsigned int channel) {
+    (void)channel;
+    return false;
+}
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef HOST_HARDWARE_SPI_H
+#define HOST_HARDWARE_SPI_H
+
+// Host stand-in for hardware/spi.h, enough for sram.h's declarations.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef unsigned int uint;
+typedef struct spi_inst spi_inst_t;
+
+#endif
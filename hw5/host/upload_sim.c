@@ -0,0 +1,112 @@
+// hw5's upload protocol (upload.c) on the host, on a pseudo-terminal, with
+// the SRAM as an array and a player that only keeps count.
+//
+//   ./upload_sim [-o sram.bin]
+//
+// Prints the pty's path, then answers on it the way the board would over
+// USB until it's interrupted, telling stderr what each command did to the
+// SRAM and the waves. With -o the SRAM is saved at the end.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+#include "upload.h"
+
+static uint8_t sram[SRAM_SIZE];
+static sramplay_t player;
+static dacpio_t dac;
+static upload_t upload;
+static int pty = -1;
+static volatile sig_atomic_t stop;
+
+// the player: a queued wave takes over at once
+
+uint32_t dacpio_max_rate(const dacpio_t *d) {
+    (void)d;
+    return 20000000 / 17;
+}
+
+void sramplay_write(sramplay_t *p, uint32_t addr, const void *src, uint32_t len) {
+    (void)p;
+    for (uint32_t i = 0; i < len; i++) sram[(addr + i) % SRAM_SIZE] = ((const uint8_t *)src)[i];
+    fprintf(stderr, "  write %u words at word %u\n", (unsigned)len / 2, (unsigned)addr / 2);
+}
+
+void sramplay_read(sramplay_t *p, uint32_t addr, void *dst, uint32_t len) {
+    (void)p;
+    for (uint32_t i = 0; i < len; i++) ((uint8_t *)dst)[i] = sram[(addr + i) % SRAM_SIZE];
+}
+
+void sramplay_queue(sramplay_t *p, const sramplay_wave_t *wave, uint32_t rate_hz) {
+    fprintf(stderr, "  play %u words at word %u, loop %u..%u, %u samples/s\n", (unsigned)wave->words,
+            (unsigned)wave->start / 2, (unsigned)wave->loop_start, (unsigned)wave->loop_end, (unsigned)rate_hz);
+    p->rate_hz = rate_hz ? rate_hz : p->rate_hz;
+    p->switches++;
+}
+
+static void pty_write(const uint8_t *bytes, size_t len) {
+    while (len) {
+        ssize_t n = write(pty, bytes, len);
+        if (n <= 0) return;
+        bytes += n;
+        len -= (size_t)n;
+    }
+}
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+int main(int argc, char **argv) {
+    const char *out = argc > 2 && !strcmp(argv[1], "-o") ? argv[2] : NULL;
+    pty = posix_openpt(O_RDWR | O_NOCTTY);
+    if (pty < 0 || grantpt(pty) || unlockpt(pty)) {
+        perror("pty");
+        return 1;
+    }
+    struct termios t;
+    tcgetattr(pty, &t);
+    cfmakeraw(&t);
+    tcsetattr(pty, TCSANOW, &t);
+    printf("%s\n", ptsname(pty));
+    fflush(stdout);
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    // the built-in sine: 1000 words at 0, at 100 kHz
+    player.dac = &dac;
+    player.rate_hz = 100000;
+    sramplay_wave_t sine = { 0, 1000, 0, 0 };
+    upload_init(&upload, &player, &sine, player.rate_hz, pty_write);
+
+    // before the other end opens the pty, and after it closes it, the
+    // master reads EIO, which is only waiting
+    while (!stop) {
+        struct pollfd pfd = { pty, POLLIN, 0 };
+        poll(&pfd, 1, 100);
+        uint8_t buf[512];
+        ssize_t n = read(pty, buf, sizeof(buf));
+        if (n > 0) {
+            upload_bytes(&upload, buf, (size_t)n);
+        } else {
+            usleep(20000);
+        }
+    }
+    fprintf(stderr, "%u commands, %u bad packets, wave %d playing\n", (unsigned)upload.commands,
+            (unsigned)upload.errors, upload_playing(&upload));
+    if (out) {
+        FILE *f = fopen(out, "wb");
+        if (!f || fwrite(sram, 1, sizeof(sram), f) != sizeof(sram)) {
+            perror(out);
+            return 1;
+        }
+        fclose(f);
+    }
+    return 0;
+}
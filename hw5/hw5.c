@@ -3,72 +3,70 @@
 #include "hardware/spi.h"
 #include "hardware/clocks.h"
 #include "pico/time.h"
+#include "pico/stdio_usb.h"
 #include <math.h>
+#include "dacpio.h"
+#include "sram.h"
+#include "sramplay.h"
+#include "dacword.h"
+#include "upload.h"
+#include "ubench.h"
+#include "kernels.h"
 
 // -----------------------------------------------------------------------------
 // SPI configuration
-// Using SPI0 with shared pins for both external RAM and DAC.
-// DAC chip-select (CS) is on GPIO20.
-// External RAM chip-select (CS) is on GPIO21.
+// SPI0 is the external RAM's alone, its chip-select (CS) is on GPIO21.
+// The DAC is on a PIO state machine (dacpio.c) with pins of its own, which
+// frames every word with its CS, so the two don't share a bus or wait on
+// each other. SCK and CS have to be next to each other.
 #define SPI_PORT      spi0
 #define PIN_MISO      16
 #define PIN_SCK       18
 #define PIN_MOSI      19
-#define PIN_DAC_CS    20   // For DAC
 #define PIN_RAM_CS    21   // For external SRAM
+#define RAM_BAUD      (20 * 1000 * 1000) // the 23K256's most
+#define PIN_DAC_SDI   13
+#define PIN_DAC_SCK   14
+#define PIN_DAC_CS    15   // PIN_DAC_SCK + 1
+#define DAC_BAUD      (20 * 1000 * 1000)
 
 // -----------------------------------------------------------------------------
-// External SRAM op codes (23K256)
-// WRITE: Write command opcode (0x02)
-// READ:  Read command opcode (0x03)
-// WRMR: Write Mode Register command opcode (0x01)
-#define SRAM_WRITE    0x02
-#define SRAM_READ     0x03
-#define SRAM_WRMR     0x01
+// External SRAM (23K256): the op codes and sequential mode are in sram.h.
 
-// Number of sine samples to store in external RAM.
-// With one sample per millisecond, 1000 samples gives a 1 Hz cycle.
-#define NUM_SAMPLES 1000
+// Number of sine samples to store in external RAM, played at
+// SAMPLE_RATE_HZ: 1000 samples at 100 kHz is a 100 Hz cycle.
+#define NUM_SAMPLES    1000
+#define SAMPLE_RATE_HZ 100000
+
+// Samples read from the SRAM at a time, into each of two buffers. A block
+// of DAC words is 512 bytes, 2.6 ms of playing and about 0.22 ms of reading.
+#define BLOCK_SAMPLES  256
+
+// Trials of each benchmark kept, after the ones that warm up the cache
+#define BENCH_TRIALS 31
+#define BENCH_WARMUP 3
 
 // -----------------------------------------------------------------------------
 // DAC command construction (for a typical HW4 DAC)
 // The DAC expects a 16-bit command word.
-// For Channel A (using DAC CS on GPIO20) the configuration bits are:
+// For Channel A the configuration bits are:
 //   Bit15 = 0 (channel A)
 //   Bit14 = 1 (buffer enabled)
 //   Bit13 = 1 (gain = 1x)
 //   Bit12 = 1 (active mode)
 // Thus, we shift 0b0111 into the upper nibble and OR in the 10-bit sample (shifted left by 2).
 // (The DAC is assumed to be a 10-bit DAC.)
+// dacword.h builds them, and the SRAM holds them ready to send.
  
-// -----------------------------------------------------------------------------
-// Inline chip-select helper functions.
-static inline void cs_select(uint cs_pin) {
-    asm volatile("nop \n nop \n nop");
-    gpio_put(cs_pin, 0);
-    asm volatile("nop \n nop \n nop");
-}
-
-static inline void cs_deselect(uint cs_pin) {
-    asm volatile("nop \n nop \n nop");
-    gpio_put(cs_pin, 1);
-    asm volatile("nop \n nop \n nop");
-}
-
-// -----------------------------------------------------------------------------
-// spi_ram_init()
-// Initializes the 23K256 SRAM in sequential mode.
-// In this device, the Write Mode Register (WRMR) command (0x01)
-// must be followed by the mode byte. Here, we use 0x40 (0b01000000)
-// to set sequential mode.
-void spi_ram_init() {
-    uint8_t tx_buf[2];
-    tx_buf[0] = SRAM_WRMR;  // Write Mode Register command
-    tx_buf[1] = 0x40;       // 0b01000000 -> Sequential mode
-    
-    cs_select(PIN_RAM_CS);
-    spi_write_blocking(SPI_PORT, tx_buf, 2);
-    cs_deselect(PIN_RAM_CS);
+static dacpio_t dac;
+static sram_t sram;
+static sramplay_t player;
+static uint16_t block[2][BLOCK_SAMPLES];
+static upload_t upload;
+
+// upload answers are binary, so they skip stdio's CR/LF translation
+static void usb_write(const uint8_t *bytes, size_t len) {
+    stdio_usb.out_chars((const char *)bytes, (int)len);
 }
 
 // -----------------------------------------------------------------------------
@@ -81,172 +79,109 @@ int main() {
     }
     printf("USB connected. Starting program...\n");
     
-    // Initialize SPI0 at 1 MHz.
-    spi_init(SPI_PORT, 1000 * 1000);
+    // Initialize SPI0, sram_init() sets the rate.
+    spi_init(SPI_PORT, RAM_BAUD);
     gpio_set_function(PIN_MISO, GPIO_FUNC_SPI);
     gpio_set_function(PIN_SCK,  GPIO_FUNC_SPI);
     gpio_set_function(PIN_MOSI, GPIO_FUNC_SPI);
     
-    // Initialize DAC and SRAM chip-select GPIOs as SIO.
-    gpio_init(PIN_DAC_CS);
-    gpio_set_dir(PIN_DAC_CS, GPIO_OUT);
-    gpio_put(PIN_DAC_CS, 1);
-    
+    // Initialize the SRAM chip-select GPIO as SIO.
     gpio_init(PIN_RAM_CS);
     gpio_set_dir(PIN_RAM_CS, GPIO_OUT);
     gpio_put(PIN_RAM_CS, 1);
     
     // Initialize external RAM (23K256) in sequential mode.
-    spi_ram_init();
+    if (!sram_init(&sram, SPI_PORT, PIN_RAM_CS, RAM_BAUD)) {
+        printf("SRAM mode register didn't read back sequential\n");
+    }
+    printf("SRAM at %u Hz\n", (unsigned)sram.baud);
+
+    // The DAC on its state machine, CS is its pin after SCK.
+    if (!dacpio_init(&dac, PIN_DAC_SDI, PIN_DAC_SCK, DAC_BAUD)) {
+        printf("No free PIO state machine for the DAC\n");
+    }
+    printf("DAC on PIO at %u Hz, up to %u words/s\n", (unsigned)dac.baud, (unsigned)dacpio_max_rate(&dac));
 
     // Get system clock frequency in Hz
     uint32_t freq_hz = clock_get_hz(clk_sys);
     uint32_t freq_mhz = freq_hz / 1000000; // e.g., 125 for 125 MHz
     printf("System clock frequency: %u Hz (%u MHz)\n", freq_hz, freq_mhz);
 
-    // Part 1: Floating-point speed test
-    volatile float f1, f2;
+    // Part 1: cycle counts of the arithmetic (ubench.h, kernels.c), as
+    // CSV. The operands come from here, so none of it is known when it's
+    // compiled.
+    float f1 = 1.5f, f2 = 2.5f;
     printf("Enter two floats to use: ");
     scanf("%f %f", &f1, &f2);
     printf("f1 = %f, f2 = %f\n", f1, f2);
-
-    volatile float f_add, f_sub, f_mult, f_div;
-    int loop_count = 1000;
-
-    absolute_time_t t1, t2;
-    uint64_t elapsed_us, elapsed_cycles, single_cycle;
-
-    // Addition
-    t1 = get_absolute_time();
-    for (int i = 0; i < loop_count; i++) {
-        f_add = f1 + f2;
-    }
-    t2 = get_absolute_time();
-    elapsed_us = to_us_since_boot(t2) - to_us_since_boot(t1);  // Correct order
-    elapsed_cycles = elapsed_us * freq_mhz;  // Approximate cycles
-    single_cycle = elapsed_cycles / loop_count;  // Average cycle per operation
-    printf("Time to add %d times: %llu us (%llu cycles, %llu for a single cycle)\n", loop_count, elapsed_us, elapsed_cycles, single_cycle);
-
-    // Subtraction
-    t1 = get_absolute_time();
-    for (int i = 0; i < loop_count; i++) {
-        f_sub = f1 - f2;
-    }
-    t2 = get_absolute_time();
-    elapsed_us = to_us_since_boot(t2) - to_us_since_boot(t1);
-    elapsed_cycles = elapsed_us * freq_mhz;
-    single_cycle = elapsed_cycles / loop_count;  // Average cycle per operation
-    printf("Time to subtract %d times: %llu us (%llu cycles, %llu for a single cycle)\n", loop_count, elapsed_us, elapsed_cycles, single_cycle);
-
-    // Multiplication
-    t1 = get_absolute_time();
-    for (int i = 0; i < loop_count; i++) {
-        f_mult = f1 * f2;
-    }
-    t2 = get_absolute_time();
-    elapsed_us = to_us_since_boot(t2) - to_us_since_boot(t1);
-    elapsed_cycles = elapsed_us * freq_mhz;
-    single_cycle = elapsed_cycles / loop_count;  // Average cycle per operation
-    printf("Time to multiply %d times: %llu us (%llu cycles, %llu for a single cycle)\n", loop_count, elapsed_us, elapsed_cycles, single_cycle);
-
-    // Division
-    t1 = get_absolute_time();
-    for (int i = 0; i < loop_count; i++) {
-        f_div = f1 / f2;
-    }
-    t2 = get_absolute_time();
-    elapsed_us = to_us_since_boot(t2) - to_us_since_boot(t1);
-    elapsed_cycles = elapsed_us * freq_mhz;
-    single_cycle = elapsed_cycles / loop_count;  // Average cycle per operation
-    printf("Time to divide %d times: %llu us (%llu cycles, %llu for a single cycle)\n", loop_count, elapsed_us, elapsed_cycles, single_cycle);
-
-    // Print result examples
-    printf("\nResults:\n");
-    printf("%f + %f = %f\n", f1, f2, f_add);
-    printf("%f - %f = %f\n", f1, f2, f_sub);
-    printf("%f * %f = %f\n", f1, f2, f_mult);
-    printf("%f / %f = %f\n", f1, f2, f_div);
+    kernels_inputs(f1, f2);
+    ubench_t bench;
+    ubench_init(&bench, BENCH_TRIALS, BENCH_WARMUP);
+    ubench_csv(&bench, kernels, num_kernels);
 
     printf("\n\n");
 
     printf("Starting sine wave generation...\n");
     
     // -------------------------------------------------------------------------
-    // Prepare one full cycle of the sine wave samples (1000 floats).
+    // Encode one full cycle of the sine wave (1000 samples) into
+    // external RAM from address 0, as ready-to-send DAC words.
     // The sine values are computed over 0 to 2*PI.
     // The computed sine (in the range -1 to 1) is normalized to 0 to 1,
-    // then scaled by 3.3 to represent voltage.
-    float sine_wave_samples[NUM_SAMPLES];
-    for (int i = 0; i < NUM_SAMPLES; i++) {
-        float phase = (2.0f * M_PI * i) / NUM_SAMPLES;
-        float sample = ((sinf(phase) + 1.0f) / 2.0f) * 3.3f; // scale to 0-3.3V
-        sine_wave_samples[i] = sample;
-    }
-    
-    // -------------------------------------------------------------------------
-    // Write the 1000 float samples into external RAM.
-    // Use the WRITE command (0x02) followed by a 16-bit address (we start at 0).
+    // then scaled by 3.3 to represent voltage, and that voltage is turned
+    // into its DAC command word here, once, not while playing.
+    // A block's worth at a time goes through the first playback buffer.
     // In sequential mode the address automatically increments.
-    uint8_t header[3];
-    header[0] = SRAM_WRITE;
-    header[1] = 0x00;  // high address byte (starting address 0x0000)
-    header[2] = 0x00;  // low address byte
-    
-    cs_select(PIN_RAM_CS);
-    // Send the header (command + starting address).
-    spi_write_blocking(SPI_PORT, header, 3);
-    // Send the sample data. Each float is 4 bytes.
-    spi_write_blocking(SPI_PORT, (uint8_t *)sine_wave_samples, NUM_SAMPLES * sizeof(float));
-    cs_deselect(PIN_RAM_CS);
+    uint8_t *encoded = (uint8_t *)block[0];
+    for (int i = 0; i < NUM_SAMPLES; i += BLOCK_SAMPLES) {
+        int n = NUM_SAMPLES - i < BLOCK_SAMPLES ? NUM_SAMPLES - i : BLOCK_SAMPLES;
+        for (int k = 0; k < n; k++) {
+            float phase = (2.0f * M_PI * (i + k)) / NUM_SAMPLES;
+            float sample = ((sinf(phase) + 1.0f) / 2.0f) * 3.3f; // scale to 0-3.3V
+            dacword_store(encoded + 2 * k, dacword_volts(DACWORD_A, sample));
+        }
+        sram_write(&sram, 2 * i, encoded, 2 * n);
+    }
     
     printf("Loaded %d sine wave samples into external RAM.\n", NUM_SAMPLES);
     
     // -------------------------------------------------------------------------
-    // Playback loop:
-    // In each loop iteration, read one float from external RAM, convert it for the DAC,
-    // transmit the DAC command, and delay 1 ms.
-    // This produces a 1 Hz sine wave output.
-    int sample_index = 0;
+    // Playback:
+    // The SRAM is read a block at a time into two buffers by DMA, and
+    // another DMA channel sends them to the DAC at SAMPLE_RATE_HZ, looping
+    // over the 1000 samples. This produces a 100 Hz sine wave output.
+    // No float math and nothing per sample: the words go out as they are.
+    if (!sramplay_init(&player, &sram, &dac, SAMPLE_RATE_HZ)) {
+        printf("DAC too slow for %d samples/s\n", SAMPLE_RATE_HZ);
+    }
+    sramplay_wave_t sine_wave = { 0, NUM_SAMPLES, 0, 0 };
+    sramplay_start(&player, &sine_wave, block[0], block[1], BLOCK_SAMPLES);
+
+    // -------------------------------------------------------------------------
+    // From here it all happens in the DMA interrupt. The loop takes
+    // waveforms over USB (upload.h, tools/wavupload.py) into the rest of
+    // the SRAM, the sine being wave 0, and once a second prints the SRAM
+    // read rate while reading, against the SPI clock's bytes a second.
+    upload_init(&upload, &player, &sine_wave, player.rate_hz, usb_write);
+    uint32_t last_bytes = 0, last_us = 0;
+    absolute_time_t next = make_timeout_time_ms(1000);
     while (true) {
-        // Prepare read header for external SRAM:
-        // Use the READ command (0x03) and a 16-bit address. The address is sample_index * 4.
-        uint8_t read_header[3];
-        read_header[0] = SRAM_READ;
-        uint16_t address = sample_index * sizeof(float);
-        read_header[1] = (address >> 8) & 0xFF;
-        read_header[2] = address & 0xFF;
-        
-        float sample;
-        cs_select(PIN_RAM_CS);
-        // Send header then read 4 bytes (the float)
-        spi_write_blocking(SPI_PORT, read_header, 3);
-        spi_read_blocking(SPI_PORT, 0, (uint8_t *)&sample, sizeof(float));
-        cs_deselect(PIN_RAM_CS);
-        
-        // Convert the float (0-3.3V) from SRAM to a 10-bit DAC value.
-        // Normalize by dividing by 3.3 and multiply by 1023.
-        float normalized = sample / 3.3f;
-        if (normalized > 1.0f) normalized = 1.0f;
-        if (normalized < 0.0f) normalized = 0.0f;
-        uint16_t dac_val = (uint16_t)(normalized * 1023);
-        
-        // Build DAC command word for channel A.
-        // Command word format: (0b0111 << 12) | (dac_val << 2).
-        uint16_t command_word = (0b0111 << 12) | (dac_val << 2);
-        uint8_t dac_data[2];
-        dac_data[0] = (command_word >> 8) & 0xFF;
-        dac_data[1] = command_word & 0xFF;
-        
-        // Send the DAC command via SPI.
-        cs_select(PIN_DAC_CS);
-        spi_write_blocking(SPI_PORT, dac_data, 2);
-        cs_deselect(PIN_DAC_CS);
-        
-        // Move to the next sample; wrap around after one full cycle.
-        sample_index = (sample_index + 1) % NUM_SAMPLES;
-        
-        // Wait for 1 ms.
-        sleep_ms(1);
+        int c = getchar_timeout_us(1000);
+        while (c >= 0) {
+            uint8_t byte = (uint8_t)c;
+            upload_bytes(&upload, &byte, 1);
+            c = getchar_timeout_us(0);
+        }
+        if (!time_reached(next)) {
+            continue;
+        }
+        next = delayed_by_ms(next, 1000);
+        uint32_t bytes = player.read_bytes - last_bytes, us = player.read_us - last_us;
+        last_bytes += bytes;
+        last_us += us;
+        printf("wave %d, %u samples/s, %u blocks, %u late; SRAM reads %.2f MB/s of %.2f MB/s\n", upload_playing(&upload),
+               (unsigned)player.rate_hz, (unsigned)player.blocks, (unsigned)player.late,
+               us ? (float)bytes / us : 0.0f, sram.baud / 8 / 1e6f);
     }
     
     return 0;
@@ -0,0 +1,107 @@
+// The benchmark kernels, see kernels.h
+
+#include <string.h>
+#include <math.h>
+#include "kernels.h"
+
+static volatile struct {
+    float fa, fb, root;
+    double da, db;
+    int32_t ia, ib, qa, qb;
+    int64_t la, lb;
+} in;
+
+static uint32_t src[256], dst[256];
+
+void kernels_inputs(float a, float b) {
+    in.fa = a;
+    in.fb = b;
+    in.root = fabsf(a); // sqrtf of a negative goes the slow way, to set errno
+    in.da = a;
+    in.db = b;
+    in.ia = (int32_t)(a * 1000);
+    in.ib = (int32_t)(b * 1000) ? (int32_t)(b * 1000) : 1;
+    in.qa = (int32_t)(a * 65536);
+    in.qb = (int32_t)(b * 65536);
+    // a dividend that needs all 64 bits
+    in.la = (int64_t)in.ia * 1000000007;
+    in.lb = in.ib;
+    for (int i = 0; i < 256; i++) {
+        src[i] = (uint32_t)i * 0x01010101u;
+    }
+}
+
+static void empty(uint32_t n) {
+    uint32_t a = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        UBENCH_REPEAT8(UBENCH_KEEP(a);)
+    }
+}
+
+// 8 independent r = expr an iteration, the operands as good as new each time
+#define KERNEL(fn, type, keep, a0, b0, expr)                    \
+    static void fn(uint32_t n) {                                \
+        type a = a0, b = b0, r;                                 \
+        for (uint32_t i = 0; i < n; i++) {                      \
+            UBENCH_REPEAT8(keep(a); keep(b); r = expr; keep(r);) \
+        }                                                       \
+    }
+
+KERNEL(f32_add, float, UBENCH_KEEP_F, in.fa, in.fb, a + b)
+KERNEL(f32_sub, float, UBENCH_KEEP_F, in.fa, in.fb, a - b)
+KERNEL(f32_mul, float, UBENCH_KEEP_F, in.fa, in.fb, a * b)
+KERNEL(f32_div, float, UBENCH_KEEP_F, in.fa, in.fb, a / b)
+KERNEL(f32_sinf, float, UBENCH_KEEP_F, in.fa, in.fb, sinf(a))
+KERNEL(f32_sqrtf, float, UBENCH_KEEP_F, in.root, in.fb, sqrtf(a))
+KERNEL(f64_add, double, UBENCH_KEEP, in.da, in.db, a + b)
+KERNEL(f64_mul, double, UBENCH_KEEP, in.da, in.db, a * b)
+KERNEL(f64_div, double, UBENCH_KEEP, in.da, in.db, a / b)
+KERNEL(i32_add, int32_t, UBENCH_KEEP, in.ia, in.ib, a + b)
+KERNEL(i32_mul, int32_t, UBENCH_KEEP, in.ia, in.ib, a * b)
+KERNEL(i32_div, int32_t, UBENCH_KEEP, in.ia, in.ib, a / b)
+KERNEL(i64_add, int64_t, UBENCH_KEEP, in.la, in.lb, a + b)
+KERNEL(i64_mul, int64_t, UBENCH_KEEP, in.la, in.lb, a * b)
+KERNEL(i64_div, int64_t, UBENCH_KEEP, in.la, in.lb, a / b)
+// Q16.16 product, and a Q15 sample scaled and rounded as dds.c does it
+KERNEL(q16_mul, int32_t, UBENCH_KEEP, in.qa, in.qb, (int32_t)((int64_t)a * b >> 16))
+KERNEL(q15_scale, int32_t, UBENCH_KEEP, in.qa >> 1, in.ib & 511, 512 + ((a * b + 16384) >> 15))
+
+static void copy_32(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        UBENCH_KEEP_MEM(src);
+        memcpy(dst, src, 32);
+        UBENCH_KEEP_MEM(dst);
+    }
+}
+
+static void copy_1k(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        UBENCH_KEEP_MEM(src);
+        memcpy(dst, src, sizeof(dst));
+        UBENCH_KEEP_MEM(dst);
+    }
+}
+
+const ubench_case_t kernels[] = {
+    { "loop", empty, 1, 256 },
+    { "float add", f32_add, 8, 256 },
+    { "float sub", f32_sub, 8, 256 },
+    { "float mul", f32_mul, 8, 256 },
+    { "float div", f32_div, 8, 256 },
+    { "sinf", f32_sinf, 8, 64 },
+    { "sqrtf", f32_sqrtf, 8, 256 },
+    { "double add", f64_add, 8, 256 },
+    { "double mul", f64_mul, 8, 256 },
+    { "double div", f64_div, 8, 256 },
+    { "int32 add", i32_add, 8, 256 },
+    { "int32 mul", i32_mul, 8, 256 },
+    { "int32 div", i32_div, 8, 256 },
+    { "int64 add", i64_add, 8, 256 },
+    { "int64 mul", i64_mul, 8, 256 },
+    { "int64 div", i64_div, 8, 64 },
+    { "q16.16 mul", q16_mul, 8, 256 },
+    { "q15 scale", q15_scale, 8, 256 },
+    { "memcpy 32 B", copy_32, 1, 256 },
+    { "memcpy 1 KB", copy_1k, 1, 64 },
+};
+const int num_kernels = sizeof(kernels) / sizeof(kernels[0]);
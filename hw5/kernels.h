@@ -0,0 +1,18 @@
+#ifndef KERNELS_H__
+#define KERNELS_H__
+
+// What hw5 times with ubench.h: float, double, 32 and 64-bit integer and
+// fixed point arithmetic, sinf, sqrtf and memcpy. kernels[0] is the empty
+// loop the others are measured against.
+
+#include "ubench.h"
+
+extern const ubench_case_t kernels[];
+extern const int num_kernels;
+
+// the operands, from outside so the compiler can't know them: the floats
+// as they are and, scaled by 1000, the integers, and in Q16.16 the fixed
+// point. A zero divisor is made 1.
+void kernels_inputs(float a, float b);
+
+#endif
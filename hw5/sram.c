@@ -0,0 +1,92 @@
+// 23K256 SRAM, see sram.h
+
+#include "pico/stdlib.h"
+#include "hardware/spi.h"
+#include "hardware/dma.h"
+#include "sram.h"
+
+// chip-select with a little settling either side
+static inline void cs_select(uint cs_pin) {
+    asm volatile("nop \n nop \n nop");
+    gpio_put(cs_pin, 0);
+    asm volatile("nop \n nop \n nop");
+}
+
+static inline void cs_deselect(uint cs_pin) {
+    asm volatile("nop \n nop \n nop");
+    gpio_put(cs_pin, 1);
+    asm volatile("nop \n nop \n nop");
+}
+
+static void header(sram_t *s, uint8_t op, uint32_t addr) {
+    uint8_t h[3] = { op, (uint8_t)(addr >> 8 & 0x7F), (uint8_t)addr };
+    cs_select(s->pin_cs);
+    // waits until it's all out and leaves the rx FIFO empty
+    spi_write_blocking(s->spi, h, sizeof(h));
+}
+
+bool sram_init(sram_t *s, spi_inst_t *spi, uint pin_cs, uint32_t baud) {
+    s->spi = spi;
+    s->pin_cs = pin_cs;
+    s->busy = false;
+    spi_set_format(spi, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+    s->baud = spi_set_baudrate(spi, baud);
+
+    uint8_t mode[2] = { SRAM_WRMR, SRAM_SEQUENTIAL };
+    cs_select(pin_cs);
+    spi_write_blocking(spi, mode, 2);
+    cs_deselect(pin_cs);
+    mode[0] = SRAM_RDMR;
+    cs_select(pin_cs);
+    spi_write_blocking(spi, mode, 1);
+    spi_read_blocking(spi, 0, &mode[1], 1);
+    cs_deselect(pin_cs);
+
+    s->tx = dma_claim_unused_channel(true);
+    s->rx = dma_claim_unused_channel(true);
+    return (mode[1] & 0xC0) == SRAM_SEQUENTIAL;
+}
+
+void sram_write(sram_t *s, uint32_t addr, const void *src, uint32_t len) {
+    header(s, SRAM_WRITE, addr);
+    spi_write_blocking(s->spi, src, len);
+    cs_deselect(s->pin_cs);
+}
+
+void sram_read(sram_t *s, uint32_t addr, void *dst, uint32_t len) {
+    header(s, SRAM_READ, addr);
+    spi_read_blocking(s->spi, 0, dst, len);
+    cs_deselect(s->pin_cs);
+}
+
+void sram_read_start(sram_t *s, uint32_t addr, void *dst, uint32_t len) {
+    static const uint8_t zero = 0;
+    header(s, SRAM_READ, addr);
+    s->busy = true;
+
+    dma_channel_config c = dma_channel_get_default_config(s->rx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_dreq(&c, spi_get_dreq(s->spi, false));
+    dma_channel_configure(s->rx, &c, dst, &spi_get_hw(s->spi)->dr, len, false);
+
+    c = dma_channel_get_default_config(s->tx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, spi_get_dreq(s->spi, true));
+    dma_channel_configure(s->tx, &c, &spi_get_hw(s->spi)->dr, &zero, len, false);
+
+    // both at once, so rx is ready for the first byte
+    dma_start_channel_mask(1u << s->rx | 1u << s->tx);
+}
+
+void sram_read_finish(sram_t *s) {
+    if (!s->busy) {
+        return;
+    }
+    dma_channel_wait_for_finish_blocking(s->rx);
+    cs_deselect(s->pin_cs);
+    s->busy = false;
+}
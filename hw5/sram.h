@@ -0,0 +1,57 @@
+#ifndef SRAM_H__
+#define SRAM_H__
+
+// The 23K256 32 KB SPI SRAM, in sequential mode.
+//
+// In sequential mode a READ or WRITE goes on for as long as CS stays low,
+// the address counting up by itself, and after 0x7FFF it carries on at
+// 0x0000. So a transfer is one 3-byte header and then any number of bytes,
+// and one that runs past the end of the chip wraps to the start with
+// nothing to do here: addresses are taken modulo 32 KB.
+//
+// Reads can go by DMA: sram_read_start() sends the header from the CPU,
+// then one channel clocks out dummy bytes while another takes the data
+// into memory, and CS stays low until sram_read_finish(). At 20 MHz a
+// 1 KB read is about 410 us of clock and just over a microsecond of header.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/spi.h"
+#include "hardware/dma.h"
+
+#define SRAM_SIZE  32768
+#define SRAM_WRITE 0x02
+#define SRAM_READ  0x03
+#define SRAM_WRMR  0x01
+#define SRAM_RDMR  0x05
+#define SRAM_SEQUENTIAL 0x40
+
+typedef struct {
+    spi_inst_t *spi;
+    uint pin_cs;
+    uint32_t baud;        // as the SPI block divides it
+    int tx, rx;           // DMA channels
+    volatile bool busy;   // a DMA read has CS low
+} sram_t;
+
+// spi set up with MISO, SCK and MOSI, pin_cs a plain output. Switches to
+// 8-bit mode 0 at baud (the 23K256 takes up to 20 MHz), puts the chip in
+// sequential mode and claims two DMA channels. False if the mode doesn't
+// read back, which is usually the wiring.
+bool sram_init(sram_t *s, spi_inst_t *spi, uint pin_cs, uint32_t baud);
+
+// blocking, with the CPU
+void sram_write(sram_t *s, uint32_t addr, const void *src, uint32_t len);
+void sram_read(sram_t *s, uint32_t addr, void *dst, uint32_t len);
+
+// len bytes from addr into dst by DMA. The rx channel (s->rx) finishes
+// last, its interrupt can be enabled to hear about it; either way
+// sram_read_finish() has to come after, to raise CS.
+void sram_read_start(sram_t *s, uint32_t addr, void *dst, uint32_t len);
+static inline bool sram_read_done(const sram_t *s) {
+    return !dma_channel_is_busy(s->rx);
+}
+// waits for the read if it's still going
+void sram_read_finish(sram_t *s);
+
+#endif
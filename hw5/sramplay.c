@@ -0,0 +1,324 @@
+// SRAM to DAC playback by DMA, see sramplay.h
+
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include "sramplay.h"
+
+// the one playing, for the interrupt
+static sramplay_t *playing;
+
+// how far num / den of sys is from hz, times den
+static uint64_t off(uint64_t num, uint64_t den, uint32_t hz, uint32_t sys) {
+    uint64_t a = num * sys, b = den * hz;
+    return a > b ? a - b : b - a;
+}
+
+// num / den of clk_sys as close to hz as 16 bits each allow, and the rate
+// that gives. The continued fraction of hz / sys gives the closest there
+// is for each size of den: the last one that fits, or the one between it
+// and the one before that takes den up to the limit.
+static uint32_t fraction(uint32_t hz, uint16_t *num, uint16_t *den) {
+    uint32_t sys = clock_get_hz(clk_sys);
+    uint64_t n0 = 0, d0 = 1, n1 = 1, d1 = 0;
+    uint64_t p = hz < sys ? hz : sys, q = sys;
+    while (q) {
+        uint64_t a = p / q;
+        if (d0 + a * d1 > 0xFFFF) {
+            uint64_t t = (0xFFFF - d0) / d1;
+            uint64_t n = n0 + t * n1, d = d0 + t * d1;
+            if (off(n, d, hz, sys) * d1 < off(n1, d1, hz, sys) * d) {
+                n1 = n;
+                d1 = d;
+            }
+            break;
+        }
+        uint64_t n = n0 + a * n1, d = d0 + a * d1;
+        n0 = n1;
+        d0 = d1;
+        n1 = n;
+        d1 = d;
+        uint64_t r = p - a * q;
+        p = q;
+        q = r;
+    }
+    if (n1 == 0) {
+        // under the slowest it goes
+        n1 = 1;
+        d1 = 0xFFFF;
+    }
+    *num = (uint16_t)n1;
+    *den = (uint16_t)d1;
+    return (uint32_t)((uint64_t)sys * n1 / d1);
+}
+
+bool sramplay_init(sramplay_t *p, sram_t *sram, dacpio_t *dac, uint32_t rate_hz) {
+    p->sram = sram;
+    p->dac = dac;
+    p->running = false;
+    p->timer = dma_claim_unused_timer(true);
+    p->data = dma_claim_unused_channel(true);
+    p->pace = dma_claim_unused_channel(true);
+    p->length = dma_claim_unused_channel(true);
+    p->reload = dma_claim_unused_channel(true);
+    p->rate_hz = p->read_hz = fraction(rate_hz, &p->rate_num, &p->rate_den);
+    dma_timer_set_fraction(p->timer, p->rate_num, p->rate_den);
+    return dacpio_max_rate(dac) >= p->rate_hz;
+}
+
+static void set_wave(sramplay_t *p, const sramplay_wave_t *w) {
+    uint32_t words = w->words ? w->words : 1;
+    uint32_t end = w->loop_end && w->loop_end <= words ? w->loop_end : words;
+    p->start = w->start % SRAM_SIZE;
+    p->loop_end = 2 * end;
+    p->loop_start = w->loop_start < end ? 2 * w->loop_start : 0;
+    p->at = 0;
+}
+
+static bool changes_rate(const sramplay_t *p) {
+    return p->next_num != p->rate_num || p->next_den != p->rate_den;
+}
+
+// Bytes from here to the loop end the queued wave takes over at. With a
+// new rate the block before it ends there, and one under half a block
+// would leave the next too little time to be read, so that loop end goes
+// by for a later one.
+static void arm_switch(sramplay_t *p) {
+    uint32_t to = p->loop_end - p->at;
+    if (changes_rate(p)) {
+        while (to < p->samples) {
+            to += p->loop_end - p->loop_start;
+        }
+    }
+    p->to_switch = to;
+}
+
+// the next part of the block being filled, as far as the loop end
+static void read_part(sramplay_t *p) {
+    bool armed = p->switching && p->to_switch;
+    uint32_t n = p->loop_end - p->at;
+    if (n > p->rest) {
+        n = p->rest;
+    }
+    sram_read_start(p->sram, (p->start + p->at) % SRAM_SIZE, (uint8_t *)p->buffer[p->filling] + p->filled, n);
+    p->at += n;
+    p->filled += n;
+    p->rest -= n;
+    if (armed) {
+        p->to_switch -= n;
+    }
+    if (p->at < p->loop_end) {
+        return;
+    }
+    if (!armed || p->to_switch) {
+        p->at = p->loop_start;
+        return;
+    }
+    // the queued wave carries on from here, a new rate from the next block
+    set_wave(p, &p->next_wave);
+    p->rate_num = p->next_num;
+    p->rate_den = p->next_den;
+    p->read_hz = p->next_rate;
+    p->switching = false;
+    p->switches++;
+}
+
+static void fill(sramplay_t *p, int which) {
+    uint32_t block = p->samples * sizeof(uint16_t);
+    p->filling = which;
+    p->filled = 0;
+    p->rest = block;
+    if (p->switching) {
+        if (!p->to_switch) {
+            arm_switch(p);
+        }
+        // a new rate can't start mid-block: end on the switch, in this
+        // block or, if that would leave too little for the last one, in
+        // two halves
+        if (changes_rate(p)) {
+            if (p->to_switch <= block) {
+                p->rest = p->to_switch;
+            } else if (p->to_switch < 2 * block) {
+                p->rest = p->to_switch / 2 & ~1u;
+            }
+        }
+    }
+    p->fractions[which] = (uint32_t)p->rate_num << 16 | p->rate_den;
+    p->hz[which] = p->read_hz;
+    p->read_t0 = time_us_32();
+    read_part(p);
+}
+
+// a part has landed: CS up, then the next part, or the block is ready
+static void read_done(sramplay_t *p) {
+    sram_read_finish(p->sram);
+    if (p->rest) {
+        read_part(p);
+        return;
+    }
+    p->read_us += time_us_32() - p->read_t0;
+    p->read_bytes += p->filled;
+    p->counts[p->filling] = p->filled / sizeof(uint16_t);
+    p->filling = -1;
+    if (p->queued >= 0) {
+        int q = p->queued;
+        p->queued = -1;
+        fill(p, q);
+    }
+}
+
+static void __isr play_irq(void) {
+    sramplay_t *p = playing;
+    if (!p) {
+        return;
+    }
+    if (dma_channel_get_irq0_status(p->sram->rx)) {
+        dma_channel_acknowledge_irq0(p->sram->rx);
+        read_done(p);
+    }
+    if (dma_channel_get_irq0_status(p->data)) {
+        dma_channel_acknowledge_irq0(p->data);
+        // the chain has already started the other buffer, at its rate
+        int done = p->blocks & 1;
+        p->blocks++;
+        p->rate_hz = p->hz[p->blocks & 1];
+        if (p->filling >= 0) {
+            // which is still being read, so this one waits its turn
+            p->late++;
+            p->queued = done;
+        } else {
+            fill(p, done);
+        }
+    }
+}
+
+// one word a trigger, from a ring of two, then chain_to (itself for none)
+static void chain_word(int ch, volatile void *to, const volatile void *from, int chain_to) {
+    dma_channel_config c = dma_channel_get_default_config(ch);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_ring(&c, false, 3);
+    channel_config_set_chain_to(&c, chain_to);
+    dma_channel_configure(ch, &c, to, from, 1, false);
+}
+
+void sramplay_start(sramplay_t *p, const sramplay_wave_t *wave, uint16_t *buffer0, uint16_t *buffer1,
+                    uint32_t samples) {
+    sramplay_stop(p);
+    set_wave(p, wave);
+    p->samples = samples;
+    p->buffer[0] = buffer0;
+    p->buffer[1] = buffer1;
+    p->queued = -1;
+    p->switching = false;
+    p->blocks = p->late = p->switches = 0;
+    p->read_bytes = p->read_us = 0;
+
+    // the first two by hand, before there's an interrupt
+    for (int b = 0; b < 2; b++) {
+        fill(p, b);
+        while (p->filling >= 0) {
+            dma_channel_wait_for_finish_blocking(p->sram->rx);
+            read_done(p);
+        }
+    }
+    p->next[0] = buffer0;
+    p->next[1] = buffer1;
+    p->rate_hz = p->hz[0];
+
+    dma_channel_config c = dma_channel_get_default_config(p->data);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, dma_get_timer_dreq(p->timer));
+    channel_config_set_chain_to(&c, p->pace);
+    // big-endian in the SRAM
+    channel_config_set_bswap(&c, true);
+    dma_channel_configure(p->data, &c, dacpio_fifo(p->dac), buffer0, p->counts[0], false);
+
+    // the second buffer's fraction, count and address, then the first's,
+    // from the rings of two: the next block's before its first sample
+    chain_word(p->pace, &dma_hw->timer[p->timer], &p->fractions[1], p->length);
+    chain_word(p->length, &dma_hw->ch[p->data].transfer_count, &p->counts[1], p->reload);
+    chain_word(p->reload, &dma_hw->ch[p->data].al3_read_addr_trig, &p->next[1], p->reload);
+
+    playing = p;
+    dma_channel_set_irq0_enabled(p->data, true);
+    dma_channel_set_irq0_enabled(p->sram->rx, true);
+    irq_add_shared_handler(DMA_IRQ_0, play_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+    p->running = true;
+    dma_channel_start(p->data);
+}
+
+void sramplay_queue(sramplay_t *p, const sramplay_wave_t *wave, uint32_t rate_hz) {
+    uint16_t num, den;
+    uint32_t rate = p->rate_hz;
+    if (rate_hz) {
+        rate = fraction(rate_hz, &num, &den);
+    }
+    uint32_t save = save_and_disable_interrupts();
+    if (!rate_hz) {
+        // whatever the playing one ends up at
+        num = p->rate_num;
+        den = p->rate_den;
+        rate = p->read_hz;
+    }
+    p->next_wave = *wave;
+    p->next_num = num;
+    p->next_den = den;
+    p->next_rate = rate;
+    p->switching = true;
+    p->to_switch = 0;
+    restore_interrupts(save);
+}
+
+void sramplay_stop(sramplay_t *p) {
+    if (!p->running) {
+        return;
+    }
+    // the chain could restart the data channel between the aborts, so it
+    // goes first and again after
+    for (int pass = 0; pass < 2; pass++) {
+        dma_channel_abort(p->pace);
+        dma_channel_abort(p->length);
+        dma_channel_abort(p->reload);
+        dma_channel_abort(p->data);
+    }
+    dma_channel_set_irq0_enabled(p->data, false);
+    dma_channel_set_irq0_enabled(p->sram->rx, false);
+    irq_remove_handler(DMA_IRQ_0, play_irq);
+    playing = NULL;
+    // a read cut short still has CS low
+    dma_channel_abort(p->sram->tx);
+    dma_channel_abort(p->sram->rx);
+    sram_read_finish(p->sram);
+    p->running = false;
+}
+
+// with interrupts off and no read going, so the interrupt can't start one
+static uint32_t gap(sramplay_t *p) {
+    while (true) {
+        uint32_t save = save_and_disable_interrupts();
+        if (!p->running || p->filling < 0) {
+            return save;
+        }
+        restore_interrupts(save);
+        tight_loop_contents();
+    }
+}
+
+void sramplay_write(sramplay_t *p, uint32_t addr, const void *src, uint32_t len) {
+    uint32_t save = gap(p);
+    sram_write(p->sram, addr, src, len);
+    restore_interrupts(save);
+}
+
+void sramplay_read(sramplay_t *p, uint32_t addr, void *dst, uint32_t len) {
+    uint32_t save = gap(p);
+    sram_read(p->sram, addr, dst, len);
+    restore_interrupts(save);
+}
@@ -0,0 +1,105 @@
+#ifndef SRAMPLAY_H__
+#define SRAMPLAY_H__
+
+// Playback from the SRAM to the DAC by DMA, through two buffers.
+//
+// One DMA channel writes a buffer's DAC words into the PIO's FIFO, paced
+// by a DMA timer at the sample rate, then chains to a second one that
+// points it at the other buffer, from a two-entry ring, so the output
+// never waits on the CPU. When a buffer has gone out, the DMA interrupt
+// starts a sequential read of the next block of the SRAM into it, and when
+// that lands raises CS, so the SRAM is read in long runs, a 3-byte header
+// a block, not a header a sample.
+//
+// The samples are DAC command words, big-endian (dacword.h), so a block
+// goes from the SRAM to the DAC untouched: the playing channel swaps the
+// bytes, and the interrupt only starts reads and ends them. A wave plays
+// from its start to its loop end, then from its loop start to the loop end
+// again and again. A block that runs past the loop end is two reads, the
+// rest of it and then from the loop start; past the end of the chip the
+// chip wraps by itself.
+//
+// A queued wave takes over where the playing one reaches its loop end, so
+// the last sample of one is followed by the first of the other. At the
+// same rate that's in the middle of a block. A new rate has to start on a
+// block, so the block before it is cut short at the loop end, and each
+// buffer carries its length and timer fraction: two more channels, chained
+// between the playing one and the reload, write them into the data
+// channel's transfer count and the DMA timer, so the old wave's samples all
+// go at the old rate and the new one's at the new. A loop end less than
+// half a block away is passed over for the next one, so the short block is
+// never too short for the one after it to be read.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sram.h"
+#include "dacpio.h"
+
+typedef struct {
+    uint32_t start;                   // byte address of the first word
+    uint32_t words;
+    uint32_t loop_start, loop_end;    // words from start, loop_end 0 for words
+} sramplay_wave_t;
+
+typedef struct {
+    // for each buffer, read by the channels that start it, which wrap on
+    // these 8 byte boundaries: the words, the timer fraction, the address
+    uint32_t counts[2] __attribute__((aligned(8)));
+    uint32_t fractions[2] __attribute__((aligned(8)));
+    const uint16_t *next[2] __attribute__((aligned(8)));
+    uint32_t hz[2];
+    sram_t *sram;
+    dacpio_t *dac;
+    // data plays a buffer, then pace sets the timer, length the count and
+    // reload the address, which starts data again
+    int timer, data, pace, length, reload;
+    volatile uint32_t rate_hz;    // playing, as the timer divides clk_sys
+
+    // the wave being read, in bytes from its start, and its rate
+    uint32_t start, loop_start, loop_end;
+    uint16_t rate_num, rate_den;
+    uint32_t read_hz;
+    uint32_t at;                  // next byte to read
+    uint32_t samples;             // a block
+    uint16_t *buffer[2];
+    // the read in progress: which buffer (-1 none), and what's left after
+    // this part; queued is a buffer waiting for it to finish
+    int filling, queued;
+    uint32_t filled, rest;
+
+    // the wave to take over at a loop end, and its timer fraction
+    sramplay_wave_t next_wave;
+    uint16_t next_num, next_den;
+    uint32_t next_rate;
+    volatile bool switching;
+    uint32_t to_switch;           // bytes to go to it, 0 not worked out yet
+
+    volatile uint32_t blocks;     // buffers played
+    volatile uint32_t late;       // a buffer came round again before its read was done
+    volatile uint32_t switches;   // queued waves taken over
+    volatile uint32_t read_bytes, read_us; // header to CS high, for the bandwidth
+    uint32_t read_t0;
+    bool running;
+} sramplay_t;
+
+// Claims a DMA timer and four channels. rate_hz is rounded to what the timer
+// can divide clk_sys into; false if the DAC can't send that many words.
+bool sramplay_init(sramplay_t *p, sram_t *sram, dacpio_t *dac, uint32_t rate_hz);
+
+// Plays wave, samples words a block, each buffer holding a block. The
+// first two blocks are read before it starts; from then on it's all in
+// DMA_IRQ_0.
+void sramplay_start(sramplay_t *p, const sramplay_wave_t *wave, uint16_t *buffer0, uint16_t *buffer1,
+                    uint32_t samples);
+// wave from the playing one's next loop end, at rate_hz (0 for the same
+// rate). Replaces one already queued.
+void sramplay_queue(sramplay_t *p, const sramplay_wave_t *wave, uint32_t rate_hz);
+void sramplay_stop(sramplay_t *p);
+
+// The SRAM while it plays: these wait for a gap between the player's
+// reads and hold off interrupts while they run, about 110 us for 256
+// bytes at 20 MHz, against the 2.5 ms a buffer lasts at 100 kHz.
+void sramplay_write(sramplay_t *p, uint32_t addr, const void *src, uint32_t len);
+void sramplay_read(sramplay_t *p, uint32_t addr, void *dst, uint32_t len);
+
+#endif
@@ -0,0 +1,237 @@
+#!/usr/bin/env python3
+# Upload a waveform to hw5 over USB, into its SRAM, while it plays.
+#
+#   python3 wavupload.py PORT --info
+#   python3 wavupload.py PORT --wave 1 --at 2048 --rate 50000 volts.csv [--loop 100:900] [--play]
+#   python3 wavupload.py PORT --wave 2 --at 4096 --rate 20000 --sine 400 --play
+#   python3 wavupload.py PORT --play-wave 1
+#
+# The samples are volts, 0 to 3.3, one per line (the first column of a
+# CSV), or --sine N for one cycle of N samples. They are encoded the way
+# dacword_volts() does, into the DAC's big-endian command words, and sent
+# UPLOAD_WRITE_WORDS at a time to word address --at. A CRC of what landed
+# in the SRAM is checked against what was sent. Then the wave is defined
+# with its rate and loop (words from its start; the whole of it by
+# default), and with --play the device switches to it where the playing
+# wave next reaches its loop end. The device won't let a write land on the
+# wave that's playing, so to change a wave without a glitch upload the new
+# one somewhere else and play that. The packet layout is in upload.h.
+#
+# PORT is the serial device (/dev/ttyACM0 and the like); pyserial is used
+# if it's there, otherwise the port is opened raw with termios.
+
+import argparse
+import math
+import os
+import struct
+import sys
+import time
+
+INFO, WRITE, DEFINE, PLAY, CHECK = 1, 2, 3, 4, 5
+ANSWER, BROKEN = 0x80, 0xFF
+STATUS = ['ok', 'bad length', 'bad argument', 'unknown command', 'bad packet', 'in use']
+WRITE_WORDS = 128
+SRAM_WORDS = 16384
+
+
+def crc16(data):
+    # CRC-16/CCITT-FALSE, as upload_crc16()
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def cobs(data):
+    out = bytearray([0])
+    code_at, code = 0, 1
+    for b in data:
+        if b == 0:
+            out[code_at] = code
+            code_at, code = len(out), 1
+            out.append(0)
+            continue
+        out.append(b)
+        code += 1
+        if code == 0xFF:
+            out[code_at] = code
+            code_at, code = len(out), 1
+            out.append(0)
+    out[code_at] = code
+    out.append(0)
+    return bytes(out)
+
+
+def uncobs(frame):
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(frame):
+            return None
+        out += frame[i:i + code - 1]
+        i += code - 1
+        if code < 0xFF and i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+class Port:
+    def __init__(self, path):
+        try:
+            import serial
+            self.serial = serial.Serial(path, timeout=0.05)
+            self.fd = None
+        except ImportError:
+            import termios
+            import tty
+            self.serial = None
+            self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+            tty.setraw(self.fd)
+            attrs = termios.tcgetattr(self.fd)
+            attrs[3] &= ~termios.ECHO
+            termios.tcsetattr(self.fd, termios.TCSANOW, attrs)
+        self.pending = bytearray()
+
+    def write(self, data):
+        if self.serial:
+            self.serial.write(data)
+        else:
+            os.write(self.fd, data)
+
+    def read(self):
+        if self.serial:
+            return self.serial.read(256)
+        import select
+        if select.select([self.fd], [], [], 0.05)[0]:
+            return os.read(self.fd, 256)
+        return b''
+
+    def packet(self, timeout):
+        # the next one with a good CRC; text printed in between is dropped
+        end = time.monotonic() + timeout
+        while time.monotonic() < end:
+            while b'\0' in self.pending:
+                frame, _, self.pending = self.pending.partition(b'\0')
+                payload = uncobs(bytes(frame)) if frame else None
+                if payload and len(payload) >= 4 and crc16(payload[:-2]) == struct.unpack('<H', payload[-2:])[0]:
+                    return payload[:-2]
+            self.pending += self.read()
+        return None
+
+
+class Device:
+    def __init__(self, path):
+        self.port = Port(path)
+
+    def command(self, type, args=b'', tries=3):
+        payload = bytes([type]) + args
+        packet = cobs(payload + struct.pack('<H', crc16(payload)))
+        for _ in range(tries):
+            self.port.write(packet)
+            answer = self.port.packet(1.0)
+            if answer is None or answer[0] == BROKEN:
+                continue
+            if answer[0] != type | ANSWER:
+                continue
+            if answer[1] != 0:
+                raise SystemExit('command %d: %s' % (type, STATUS[answer[1]] if answer[1] < len(STATUS) else answer[1]))
+            return answer[2:]
+        raise SystemExit('command %d: no answer' % type)
+
+    def info(self):
+        a = self.command(INFO)
+        version, sram, write, waves, playing, rate, blocks, late = struct.unpack('<BHHBBIII', a)
+        return dict(version=version, sram_words=sram, write_words=write, waves=waves, playing=playing,
+                    rate=rate, blocks=blocks, late=late)
+
+    def write(self, at, words):
+        for i in range(0, len(words), WRITE_WORDS):
+            chunk = words[i:i + WRITE_WORDS]
+            self.command(WRITE, struct.pack('<H', at + i) + b''.join(struct.pack('>H', w) for w in chunk))
+
+    def check(self, at, count):
+        return struct.unpack('<H', self.command(CHECK, struct.pack('<HH', at, count)))[0]
+
+    def define(self, wave, at, count, loop_start, loop_end, rate):
+        self.command(DEFINE, struct.pack('<BHHHHI', wave, at, count, loop_start, loop_end, rate))
+
+    def play(self, wave):
+        self.command(PLAY, bytes([wave]))
+
+
+def dac_word(volts, channel):
+    # dacword_volts()
+    normalized = min(max(volts / 3.3, 0.0), 1.0)
+    return (0xF000 if channel else 0x7000) | (int(normalized * 1023 + 0.5) & 0x3FF) << 2
+
+
+def read_volts(path):
+    volts = []
+    with open(path) as f:
+        for line in f:
+            field = line.split(',')[0].strip()
+            if not field or field.startswith('#'):
+                continue
+            try:
+                volts.append(float(field))
+            except ValueError:
+                pass  # a header
+    return volts
+
+
+def main():
+    ap = argparse.ArgumentParser(description='upload a waveform to hw5')
+    ap.add_argument('port')
+    ap.add_argument('file', nargs='?', help='volts, one a line')
+    ap.add_argument('--sine', type=int, metavar='N', help='one cycle of a sine in N samples instead of a file')
+    ap.add_argument('--info', action='store_true')
+    ap.add_argument('--wave', type=int, default=1, help='which of the waves to define, not 0 (the built-in sine)')
+    ap.add_argument('--at', type=int, default=2048, help='word address in the SRAM')
+    ap.add_argument('--rate', type=int, default=100000, help='samples a second')
+    ap.add_argument('--loop', help='loop_start:loop_end in words from the start of the wave')
+    ap.add_argument('--channel', choices='ab', default='a')
+    ap.add_argument('--play', action='store_true', help='switch to it once uploaded')
+    ap.add_argument('--play-wave', type=int, metavar='WAVE', help='only switch to a wave already defined')
+    args = ap.parse_intermixed_args()
+
+    dev = Device(args.port)
+    if args.info:
+        for k, v in dev.info().items():
+            print('%s: %s' % (k, v))
+        return
+    if args.play_wave is not None:
+        dev.play(args.play_wave)
+        return
+
+    if args.sine:
+        volts = [(math.sin(2 * math.pi * i / args.sine) + 1) / 2 * 3.3 for i in range(args.sine)]
+    elif args.file:
+        volts = read_volts(args.file)
+    else:
+        ap.error('a file of volts or --sine N')
+    if not volts or args.at + len(volts) > SRAM_WORDS:
+        sys.exit('%d samples at %d: the SRAM holds %d words' % (len(volts), args.at, SRAM_WORDS))
+    loop_start, loop_end = (int(x) for x in args.loop.split(':')) if args.loop else (0, 0)
+
+    words = [dac_word(v, args.channel == 'b') for v in volts]
+    t0 = time.monotonic()
+    dev.write(args.at, words)
+    seconds = time.monotonic() - t0
+    sent = crc16(b''.join(struct.pack('>H', w) for w in words))
+    landed = dev.check(args.at, len(words))
+    if landed != sent:
+        sys.exit('CRC of the SRAM is %04x, sent %04x' % (landed, sent))
+    print('%d samples to word %d in %.2f s, %.0f samples/s, CRC %04x' %
+          (len(words), args.at, seconds, len(words) / seconds if seconds else 0, sent))
+    dev.define(args.wave, args.at, len(words), loop_start, loop_end, args.rate)
+    if args.play:
+        dev.play(args.wave)
+        print('wave %d playing from its next loop end, %d samples/s' % (args.wave, args.rate))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,136 @@
+// Cycle counting microbenchmarks, see ubench.h
+
+#include <stdio.h>
+#include <math.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/systick.h"
+#if PICO_RP2350 && defined(__ARM_ARCH_8M_MAIN__)
+#include "hardware/structs/m33.h"
+#define HAVE_DWT 1
+#else
+#define HAVE_DWT 0
+#endif
+#include "ubench.h"
+
+static bool dwt_start(void) {
+#if HAVE_DWT
+    m33_hw->demcr |= M33_DEMCR_TRCENA_BITS;
+    if (m33_hw->dwt_ctrl & M33_DWT_CTRL_NOCYCCNT_BITS) {
+        return false;
+    }
+    m33_hw->dwt_cyccnt = 0;
+    m33_hw->dwt_ctrl |= M33_DWT_CTRL_CYCCNTENA_BITS;
+    // it can be there and still not count, from the non-secure side
+    uint32_t c0 = m33_hw->dwt_cyccnt;
+    for (volatile int i = 0; i < 4; i++) {
+    }
+    return m33_hw->dwt_cyccnt != c0;
+#else
+    return false;
+#endif
+}
+
+ubench_counter_t ubench_init(ubench_t *u, int trials, int warmup) {
+    u->clk_hz = clock_get_hz(clk_sys);
+    u->trials = trials < 1 ? 1 : trials > UBENCH_MAX_TRIALS ? UBENCH_MAX_TRIALS : trials;
+    u->warmup = warmup < 0 ? 0 : warmup;
+    u->loop_cycles = 0;
+    if (dwt_start()) {
+        u->counter = UBENCH_DWT;
+        u->mask = 0xFFFFFFFF;
+    } else {
+        systick_hw->rvr = 0x00FFFFFF;
+        systick_hw->cvr = 0;
+        systick_hw->csr = 0x5; // enable, processor clock
+        u->counter = UBENCH_SYSTICK;
+        u->mask = 0x00FFFFFF;
+    }
+    return u->counter;
+}
+
+const char *ubench_counter_name(ubench_counter_t counter) {
+    return counter == UBENCH_DWT ? "dwt" : "systick";
+}
+
+uint32_t ubench_cycles(const ubench_t *u) {
+#if HAVE_DWT
+    if (u->counter == UBENCH_DWT) {
+        return m33_hw->dwt_cyccnt;
+    }
+#endif
+    // SysTick counts down
+    return ~systick_hw->cvr & u->mask;
+}
+
+static uint32_t trial(const ubench_t *u, const ubench_case_t *c, uint32_t n) {
+    uint32_t save = save_and_disable_interrupts();
+    uint32_t c0 = ubench_cycles(u);
+    c->run(n);
+    uint32_t c1 = ubench_cycles(u);
+    restore_interrupts(save);
+    return (c1 - c0) & u->mask;
+}
+
+void ubench_run(const ubench_t *u, const ubench_case_t *c, ubench_result_t *r) {
+    uint32_t iters = c->iters ? c->iters : 1;
+    for (int i = 0; i < u->warmup; i++) {
+        trial(u, c, 0);
+        trial(u, c, iters);
+    }
+    // the fixed part is the least the loop run 0 times ever takes
+    uint32_t full[UBENCH_MAX_TRIALS], base = UINT32_MAX;
+    for (int i = 0; i < u->trials; i++) {
+        uint32_t b = trial(u, c, 0);
+        if (b < base) base = b;
+        full[i] = trial(u, c, iters);
+    }
+
+    float cycles[UBENCH_MAX_TRIALS], sum = 0;
+    int n = u->trials;
+    for (int i = 0; i < n; i++) {
+        float v = ((float)(full[i] > base ? full[i] - base : 0) / iters - u->loop_cycles) / c->ops;
+        // in order as they come, there are only a few
+        int k = i;
+        for (; k > 0 && cycles[k - 1] > v; k--) {
+            cycles[k] = cycles[k - 1];
+        }
+        cycles[k] = v;
+        sum += v;
+    }
+    float mean = sum / n, var = 0;
+    for (int i = 0; i < n; i++) {
+        var += (cycles[i] - mean) * (cycles[i] - mean);
+    }
+    r->min = cycles[0];
+    r->median = n & 1 ? cycles[n / 2] : (cycles[n / 2 - 1] + cycles[n / 2]) / 2;
+    r->stddev = n > 1 ? sqrtf(var / (n - 1)) : 0;
+}
+
+void ubench_calibrate(ubench_t *u, const ubench_case_t *empty, ubench_result_t *r) {
+    u->loop_cycles = 0;
+    ubench_run(u, empty, r);
+    u->loop_cycles = r->median;
+}
+
+static void csv_row(const ubench_t *u, const ubench_case_t *c, const ubench_result_t *r) {
+    printf("%s,%u,%u,%.2f,%.2f,%.3f,%.1f\n", c->name, (unsigned)c->ops, (unsigned)c->iters,
+           r->median, r->min, r->stddev, r->median * 1e9f / u->clk_hz);
+}
+
+void ubench_csv(ubench_t *u, const ubench_case_t *cases, int n) {
+    ubench_result_t r;
+    printf("# %s counter, %u Hz, %d trials after %d warmup\n", ubench_counter_name(u->counter),
+           (unsigned)u->clk_hz, u->trials, u->warmup);
+    printf("case,ops,iterations,median_cycles,min_cycles,stddev_cycles,median_ns\n");
+    if (n < 1) {
+        return;
+    }
+    ubench_calibrate(u, &cases[0], &r);
+    csv_row(u, &cases[0], &r);
+    for (int i = 1; i < n; i++) {
+        ubench_run(u, &cases[i], &r);
+        csv_row(u, &cases[i], &r);
+    }
+}
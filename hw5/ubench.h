@@ -0,0 +1,80 @@
+#ifndef UBENCH_H__
+#define UBENCH_H__
+
+// Cycle counts of short kernels, on the board.
+//
+// The count comes from the Cortex-M33's DWT cycle counter, or from SysTick
+// (24 bits at the processor clock) where there's no DWT. A trial runs a
+// kernel's loop n times with interrupts off. The same loop run 0 times is
+// taken off, so the call, the counter reads and the kernel's setup drop
+// out, then the empty loop's cycles an iteration (ubench_calibrate()), and
+// what's left is divided by the operations an iteration does. The first
+// few trials warm the XIP cache and aren't kept. The median is the number
+// to quote; the min is the cost with nothing in the way.
+//
+// A kernel passes its operands and results through UBENCH_KEEP(), an
+// empty asm the compiler has to assume reads and changes the value. So
+// nothing is folded, hoisted out of the loop or thrown away, and nothing
+// extra is emitted either. Operations that are kept one by one like that
+// are independent, so a row is the cost of one in a stream of them.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define UBENCH_MAX_TRIALS 63
+
+// the value is read and may have changed, in whichever register it's in
+#if defined(__arm__) && defined(__ARM_FP)
+#define UBENCH_KEEP(x) __asm volatile("" : "+r"(x))
+#define UBENCH_KEEP_F(x) __asm volatile("" : "+t"(x))
+#elif defined(__arm__)
+#define UBENCH_KEEP(x) __asm volatile("" : "+r"(x))
+#define UBENCH_KEEP_F(x) __asm volatile("" : "+r"(x))
+#else
+#define UBENCH_KEEP(x) __asm volatile("" : "+m"(x))
+#define UBENCH_KEEP_F(x) __asm volatile("" : "+m"(x))
+#endif
+// memory through p is read and may have changed
+#define UBENCH_KEEP_MEM(p) __asm volatile("" : : "r"(p) : "memory")
+
+#define UBENCH_REPEAT8(s) s s s s s s s s
+
+typedef enum { UBENCH_DWT, UBENCH_SYSTICK } ubench_counter_t;
+
+typedef struct {
+    const char *name;
+    void (*run)(uint32_t n); // the kernel's loop, n iterations
+    uint16_t ops;            // operations an iteration
+    uint16_t iters;          // iterations a trial, under 2^24 cycles for SysTick
+} ubench_case_t;
+
+// cycles an operation over the kept trials
+typedef struct {
+    float median, min, stddev;
+} ubench_result_t;
+
+typedef struct {
+    ubench_counter_t counter;
+    uint32_t mask;      // of the count, it wraps at 2^32 or 2^24
+    uint32_t clk_hz;
+    int trials, warmup;
+    float loop_cycles;  // the empty loop's, an iteration
+} ubench_t;
+
+// starts the DWT counter, or SysTick if the DWT counter isn't there or
+// doesn't move. trials up to UBENCH_MAX_TRIALS.
+ubench_counter_t ubench_init(ubench_t *u, int trials, int warmup);
+const char *ubench_counter_name(ubench_counter_t counter);
+// cycles now, counting up, within u->mask
+uint32_t ubench_cycles(const ubench_t *u);
+
+// times empty, a loop of UBENCH_KEEP()s and nothing else with ops 1, as
+// what every later case's iterations cost before their operations
+void ubench_calibrate(ubench_t *u, const ubench_case_t *empty, ubench_result_t *r);
+void ubench_run(const ubench_t *u, const ubench_case_t *c, ubench_result_t *r);
+
+// calibrates on cases[0], runs the rest and prints a CSV row for each,
+// after a # line with the counter and clock and a header, to stdout
+void ubench_csv(ubench_t *u, const ubench_case_t *cases, int n);
+
+#endif
@@ -0,0 +1,252 @@
+// waveform upload over USB, see upload.h
+
+#include <string.h>
+#include "upload.h"
+
+static uint8_t *put16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t v) {
+    p = put16(p, (uint16_t)v);
+    return put16(p, (uint16_t)(v >> 16));
+}
+
+static uint16_t get16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return get16(p) | (uint32_t)get16(p + 2) << 16;
+}
+
+// CRC-16/CCITT-FALSE: polynomial 0x1021, starts at 0xFFFF, a nibble at a
+// time from a 16 entry table
+static const uint16_t crc_nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+static uint16_t crc_add(uint16_t crc, const uint8_t *data, size_t len) {
+    while (len--) {
+        uint8_t b = *data++;
+        crc = (uint16_t)(crc << 4 ^ crc_nibble[(crc >> 12) ^ (b >> 4)]);
+        crc = (uint16_t)(crc << 4 ^ crc_nibble[(crc >> 12) ^ (b & 0x0F)]);
+    }
+    return crc;
+}
+
+uint16_t upload_crc16(const uint8_t *data, size_t len) {
+    return crc_add(0xFFFF, data, len);
+}
+
+static void answer(upload_t *u, uint8_t type, uint8_t status, const uint8_t *more, size_t n) {
+    uint8_t payload[32], packet[40];
+    payload[0] = type;
+    payload[1] = status;
+    if (n) {
+        memcpy(payload + 2, more, n);
+    }
+    put16(payload + 2 + n, upload_crc16(payload, 2 + n));
+    // COBS: each code byte is one more than the run of non-zero bytes after
+    // it, the payload is short enough never to need a 0xFF run
+    size_t code_at = 1, o = 2;
+    uint8_t code = 1;
+    packet[0] = 0;
+    for (size_t i = 0; i < 4 + n; i++) {
+        if (payload[i] == 0) {
+            packet[code_at] = code;
+            code_at = o++;
+            code = 1;
+        } else {
+            packet[o++] = payload[i];
+            code++;
+        }
+    }
+    packet[code_at] = code;
+    packet[o++] = 0;
+    u->write(packet, o);
+}
+
+// frame decoded in place, false if it doesn't hold together
+static bool uncobs(uint8_t *frame, size_t len, size_t *out) {
+    size_t i = 0, o = 0;
+    while (i < len) {
+        uint8_t code = frame[i++];
+        if (code == 0 || i + code - 1 > len) {
+            return false;
+        }
+        for (int k = 1; k < code; k++) {
+            frame[o++] = frame[i++];
+        }
+        if (code < 0xFF && i < len) {
+            frame[o++] = 0;
+        }
+    }
+    *out = o;
+    return true;
+}
+
+static bool overlaps(const upload_t *u, int n, uint32_t addr, uint32_t words) {
+    if (n < 0) {
+        return false;
+    }
+    uint32_t start = u->wave[n].wave.start / 2, end = start + u->wave[n].wave.words;
+    return addr < end && start < addr + words;
+}
+
+// the player took the queued wave over since it was queued
+static void catch_up(upload_t *u) {
+    if (u->queued >= 0 && u->player->switches != u->switches) {
+        u->playing = u->queued;
+        u->queued = -1;
+    }
+}
+
+int upload_playing(upload_t *u) {
+    catch_up(u);
+    return u->playing;
+}
+
+static void info(upload_t *u) {
+    uint8_t more[19], *p = more;
+    *p++ = UPLOAD_VERSION;
+    p = put16(p, UPLOAD_SRAM_WORDS);
+    p = put16(p, UPLOAD_WRITE_WORDS);
+    *p++ = UPLOAD_WAVES;
+    *p++ = (uint8_t)u->playing;
+    p = put32(p, u->player->rate_hz);
+    p = put32(p, u->player->blocks);
+    p = put32(p, u->player->late);
+    answer(u, UPLOAD_INFO | UPLOAD_ANSWER, UPLOAD_OK, more, (size_t)(p - more));
+}
+
+static uint8_t write_words(upload_t *u, const uint8_t *args, size_t n) {
+    if (n < 4 || n % 2 || (n - 2) / 2 > UPLOAD_WRITE_WORDS) {
+        return UPLOAD_BAD_LENGTH;
+    }
+    uint32_t addr = get16(args), words = (uint32_t)(n - 2) / 2;
+    if (addr + words > UPLOAD_SRAM_WORDS) {
+        return UPLOAD_BAD_ARGUMENT;
+    }
+    if (overlaps(u, u->playing, addr, words) || overlaps(u, u->queued, addr, words)) {
+        return UPLOAD_IN_USE;
+    }
+    sramplay_write(u->player, 2 * addr, args + 2, 2 * words);
+    return UPLOAD_OK;
+}
+
+static uint8_t define(upload_t *u, const uint8_t *args, size_t n) {
+    if (n != 13) {
+        return UPLOAD_BAD_LENGTH;
+    }
+    uint8_t w = args[0];
+    sramplay_wave_t wave = { 2 * (uint32_t)get16(args + 1), get16(args + 3), get16(args + 5), get16(args + 7) };
+    uint32_t rate = get32(args + 9);
+    uint32_t end = wave.loop_end ? wave.loop_end : wave.words;
+    if (w >= UPLOAD_WAVES || w == u->playing || w == u->queued || wave.words == 0 ||
+        wave.start / 2 + wave.words > UPLOAD_SRAM_WORDS || end > wave.words || wave.loop_start >= end ||
+        rate == 0 || rate > dacpio_max_rate(u->player->dac)) {
+        return UPLOAD_BAD_ARGUMENT;
+    }
+    u->wave[w].defined = true;
+    u->wave[w].wave = wave;
+    u->wave[w].rate_hz = rate;
+    return UPLOAD_OK;
+}
+
+static uint8_t play(upload_t *u, const uint8_t *args, size_t n) {
+    if (n != 1) {
+        return UPLOAD_BAD_LENGTH;
+    }
+    uint8_t w = args[0];
+    if (w >= UPLOAD_WAVES || !u->wave[w].defined) {
+        return UPLOAD_BAD_ARGUMENT;
+    }
+    u->switches = u->player->switches;
+    u->queued = w;
+    sramplay_queue(u->player, &u->wave[w].wave, u->wave[w].rate_hz);
+    return UPLOAD_OK;
+}
+
+static void check(upload_t *u, const uint8_t *args, size_t n) {
+    if (n != 4) {
+        answer(u, UPLOAD_CHECK | UPLOAD_ANSWER, UPLOAD_BAD_LENGTH, NULL, 0);
+        return;
+    }
+    uint32_t addr = get16(args), words = get16(args + 2);
+    if (addr + words > UPLOAD_SRAM_WORDS) {
+        answer(u, UPLOAD_CHECK | UPLOAD_ANSWER, UPLOAD_BAD_ARGUMENT, NULL, 0);
+        return;
+    }
+    uint16_t crc = 0xFFFF;
+    uint8_t chunk[64];
+    for (uint32_t at = 2 * addr, left = 2 * words; left;) {
+        uint32_t k = left < sizeof(chunk) ? left : sizeof(chunk);
+        sramplay_read(u->player, at, chunk, k);
+        crc = crc_add(crc, chunk, k);
+        at += k;
+        left -= k;
+    }
+    uint8_t more[2];
+    put16(more, crc);
+    answer(u, UPLOAD_CHECK | UPLOAD_ANSWER, UPLOAD_OK, more, 2);
+}
+
+static void command(upload_t *u, uint8_t *p, size_t n) {
+    if (n < 3 || upload_crc16(p, n - 2) != get16(p + n - 2)) {
+        u->errors++;
+        answer(u, UPLOAD_BROKEN, UPLOAD_BAD_PACKET, NULL, 0);
+        return;
+    }
+    u->commands++;
+    catch_up(u);
+    uint8_t type = p[0];
+    const uint8_t *args = p + 1;
+    n -= 3;
+    switch (type) {
+    case UPLOAD_INFO:   info(u); return;
+    case UPLOAD_CHECK:  check(u, args, n); return;
+    case UPLOAD_WRITE:  answer(u, type | UPLOAD_ANSWER, write_words(u, args, n), NULL, 0); return;
+    case UPLOAD_DEFINE: answer(u, type | UPLOAD_ANSWER, define(u, args, n), NULL, 0); return;
+    case UPLOAD_PLAY:   answer(u, type | UPLOAD_ANSWER, play(u, args, n), NULL, 0); return;
+    default:            answer(u, type | UPLOAD_ANSWER, UPLOAD_UNKNOWN, NULL, 0); return;
+    }
+}
+
+void upload_init(upload_t *u, sramplay_t *player, const sramplay_wave_t *playing, uint32_t rate_hz,
+                 upload_write_t write) {
+    memset(u, 0, sizeof(*u));
+    u->player = player;
+    u->write = write;
+    u->wave[0].defined = true;
+    u->wave[0].wave = *playing;
+    u->wave[0].rate_hz = rate_hz;
+    u->playing = 0;
+    u->queued = -1;
+}
+
+void upload_bytes(upload_t *u, const uint8_t *bytes, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (bytes[i] != 0) {
+            if (u->len < sizeof(u->frame)) {
+                u->frame[u->len++] = bytes[i];
+            } else {
+                u->overflow = true;
+            }
+            continue;
+        }
+        // a zero ends a frame; two in a row are nothing
+        size_t n;
+        if (u->overflow || (u->len && !uncobs(u->frame, u->len, &n))) {
+            u->errors++;
+            answer(u, UPLOAD_BROKEN, UPLOAD_BAD_PACKET, NULL, 0);
+        } else if (u->len) {
+            command(u, u->frame, n);
+        }
+        u->len = 0;
+        u->overflow = false;
+    }
+}
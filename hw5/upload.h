@@ -0,0 +1,93 @@
+#ifndef UPLOAD_H__
+#define UPLOAD_H__
+
+// Waveforms over USB into the SRAM, while it plays.
+//
+// The host sends commands and the device answers each one, one at a time.
+// Both ways a packet is a payload, its CRC-16/CCITT-FALSE (little-endian)
+// and COBS framing with a 0x00 at the end; the device puts a 0x00 in front
+// of its answers too, so text printed between them doesn't run into a
+// packet. Numbers are little-endian, samples are what the SRAM holds: DAC
+// command words, big-endian (dacword.h), encoded on the host.
+//
+//   INFO   01                                  answer: version u8, SRAM words u16,
+//                                              write words u16, waves u8, playing u8,
+//                                              rate u32, blocks u32, late u32
+//   WRITE  02 addr u16, words...               up to UPLOAD_WRITE_WORDS at word addr
+//   DEFINE 03 wave u8, start u16, words u16,   a wave: where it is, its loop (words
+//             loop_start u16, loop_end u16,    from start, loop_end 0 for the end)
+//             rate u32                         and its sample rate
+//   PLAY   04 wave u8                          switch to it at the playing one's loop end
+//   CHECK  05 addr u16, words u16              answer: crc u16 of those bytes of SRAM
+//
+// Every answer is the command with 0x80 set, a status byte, then anything
+// more. A packet that fails its CRC or framing is answered with type 0xFF.
+// Writes go straight through to the SRAM, a packet at a time, so an upload
+// of any size takes the same RAM. A write over the wave that's playing, or
+// the one waiting to, is refused, so the way to change a wave without a
+// glitch is to write another one somewhere else and PLAY it.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sramplay.h"
+
+#define UPLOAD_VERSION     1
+#define UPLOAD_WAVES       8
+#define UPLOAD_WRITE_WORDS 128
+#define UPLOAD_SRAM_WORDS  (SRAM_SIZE / 2)
+
+enum {
+    UPLOAD_INFO = 0x01,
+    UPLOAD_WRITE = 0x02,
+    UPLOAD_DEFINE = 0x03,
+    UPLOAD_PLAY = 0x04,
+    UPLOAD_CHECK = 0x05,
+    UPLOAD_ANSWER = 0x80,
+    UPLOAD_BROKEN = 0xFF,
+};
+
+enum {
+    UPLOAD_OK,
+    UPLOAD_BAD_LENGTH,    // the payload isn't the size the command takes
+    UPLOAD_BAD_ARGUMENT,  // out of the SRAM, no such wave, a loop the wrong way round
+    UPLOAD_UNKNOWN,       // no such command
+    UPLOAD_BAD_PACKET,    // CRC or framing
+    UPLOAD_IN_USE,        // the write would land on a wave that's playing
+};
+
+// largest payload, a WRITE, plus the CRC, then COBS and the two zeros
+#define UPLOAD_PAYLOAD_MAX (3 + 2 * UPLOAD_WRITE_WORDS + 2)
+#define UPLOAD_PACKET_MAX  (UPLOAD_PAYLOAD_MAX + UPLOAD_PAYLOAD_MAX / 254 + 3)
+
+typedef void (*upload_write_t)(const uint8_t *bytes, size_t len);
+
+typedef struct {
+    bool defined;
+    sramplay_wave_t wave;
+    uint32_t rate_hz;
+} upload_wave_t;
+
+typedef struct {
+    sramplay_t *player;
+    upload_write_t write;
+    upload_wave_t wave[UPLOAD_WAVES];
+    int playing, queued;          // waves, -1 for one that wasn't defined here
+    uint32_t switches;            // the player's, when queued was set
+    uint8_t frame[UPLOAD_PACKET_MAX];
+    size_t len;
+    bool overflow;                // the frame was too long, drop it at its end
+    uint32_t commands, errors;
+} upload_t;
+
+// player is already playing playing, at rate_hz, which becomes wave 0;
+// write sends the answers
+void upload_init(upload_t *u, sramplay_t *player, const sramplay_wave_t *playing, uint32_t rate_hz,
+                 upload_write_t write);
+// bytes as they arrive, any amount
+void upload_bytes(upload_t *u, const uint8_t *bytes, size_t len);
+// the wave playing now
+int upload_playing(upload_t *u);
+uint16_t upload_crc16(const uint8_t *data, size_t len);
+
+#endif
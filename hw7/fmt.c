@@ -0,0 +1,93 @@
+// number formatting without printf, see fmt.h
+
+#include "fmt.h"
+
+static const uint32_t pow10[10] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+};
+
+void fmt_begin(fmt_t *f, char *buf, int cap) {
+    f->buf = buf;
+    f->cap = cap;
+    f->len = 0;
+    if (cap > 0) buf[0] = '\0';
+}
+
+void fmt_char(fmt_t *f, char c) {
+    if (f->len + 1 < f->cap) {
+        f->buf[f->len++] = c;
+        f->buf[f->len] = '\0';
+    }
+}
+
+void fmt_str(fmt_t *f, const char *s) {
+    while (*s && f->len + 1 < f->cap) f->buf[f->len++] = *s++;
+    if (f->cap > 0) f->buf[f->len] = '\0';
+}
+
+// digits[n..] padded to width, then appended
+static void put(fmt_t *f, const char *digits, int n, int size, int width) {
+    for (int pad = width - (size - n); pad > 0; pad--) fmt_char(f, ' ');
+    while (n < size && f->len + 1 < f->cap) f->buf[f->len++] = digits[n++];
+    if (f->cap > 0) f->buf[f->len] = '\0';
+}
+
+// |v| with a point before the last `decimals` digits, filled from the end
+static int digits_of(char *end, uint32_t mag, int decimals) {
+    char *p = end;
+    for (int i = 0; i <= decimals || mag; i++) {
+        if (i == decimals && i) *--p = '.';
+        *--p = '0' + mag % 10;
+        mag /= 10;
+    }
+    return end - p;
+}
+
+void fmt_uint(fmt_t *f, uint32_t v, int width) {
+    char digits[12];
+    int n = sizeof(digits) - digits_of(digits + sizeof(digits), v, 0);
+    put(f, digits, n, sizeof(digits), width);
+}
+
+void fmt_fixed(fmt_t *f, int32_t v, int decimals, int width) {
+    char digits[16];
+    if (decimals < 0) decimals = 0;
+    if (decimals > 9) decimals = 9;
+    uint32_t mag = v < 0 ? -(uint32_t)v : (uint32_t)v;
+    int n = sizeof(digits) - digits_of(digits + sizeof(digits), mag, decimals);
+    if (v < 0) digits[--n] = '-';
+    put(f, digits, n, sizeof(digits), width);
+}
+
+void fmt_int(fmt_t *f, int32_t v, int width) {
+    fmt_fixed(f, v, 0, width);
+}
+
+void fmt_float(fmt_t *f, float v, int decimals, int width) {
+    if (decimals < 0) decimals = 0;
+    if (decimals > 9) decimals = 9;
+    float scaled = v * (float)pow10[decimals];
+    int32_t q;
+    if (scaled >= 2147483520.0f) {
+        q = INT32_MAX;
+    } else if (scaled <= -2147483520.0f) {
+        q = -INT32_MAX;
+    } else if (scaled != scaled) {
+        q = 0; // NaN
+    } else {
+        q = (int32_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+    }
+    fmt_fixed(f, q, decimals, width);
+}
+
+void fmt_hex(fmt_t *f, uint32_t v, int digits) {
+    static const char hex[] = "0123456789abcdef";
+    char out[8];
+    int n = sizeof(out);
+    if (digits > 8) digits = 8;
+    do {
+        out[--n] = hex[v & 0xF];
+        v >>= 4;
+    } while (v || (int)sizeof(out) - n < digits);
+    put(f, out, n, sizeof(out), 0);
+}
@@ -0,0 +1,43 @@
+#ifndef FMT_H__
+#define FMT_H__
+
+// Number formatting without printf.
+//
+// A fmt_t appends to a caller's buffer, a piece at a time, and always
+// leaves it NUL terminated; whatever doesn't fit is dropped. There are no
+// varargs, no heap and no float printf to link in. Integer and fixed point
+// formatting is a divide by 10 per digit, and floats are scaled to fixed
+// point once and then printed the same way.
+//
+//   char line[24];
+//   fmt_t f;
+//   fmt_begin(&f, line, sizeof(line));
+//   fmt_str(&f, "fps ");
+//   fmt_fixed(&f, fps_x10, 1, 0);     // "fps 59.8"
+//
+// `width` right aligns a number with spaces to at least that many
+// characters, 0 for none.
+
+#include <stdint.h>
+
+typedef struct {
+    char *buf;
+    int cap;  // buffer size, including the NUL
+    int len;
+} fmt_t;
+
+void fmt_begin(fmt_t *f, char *buf, int cap);
+void fmt_char(fmt_t *f, char c);
+void fmt_str(fmt_t *f, const char *s);
+void fmt_uint(fmt_t *f, uint32_t v, int width);
+void fmt_int(fmt_t *f, int32_t v, int width);
+// v / 10^decimals, decimals 0..9: fmt_fixed(f, -1234, 2, 0) is "-12.34"
+void fmt_fixed(fmt_t *f, int32_t v, int decimals, int width);
+// rounded to decimals places, clamped to what int32_t fixed point holds
+void fmt_float(fmt_t *f, float v, int decimals, int width);
+// zero padded to at least digits hex digits, no 0x
+void fmt_hex(fmt_t *f, uint32_t v, int digits);
+
+static inline int fmt_len(const fmt_t *f) { return f->len; }
+
+#endif
@@ -7,6 +7,7 @@
 
 #include "ssd1306.h"
 #include "font.h"
+#include "fmt.h"
 
 // -- pin assignments
 #define SDA_PIN            12
@@ -77,7 +78,10 @@ int main() {
         // 4) read ADC and print
         uint16_t raw = adc_read();  // 0–4095
         char adc_msg[32];
-        sprintf(adc_msg, "ADC1 = %u", raw);
+        fmt_t f;
+        fmt_begin(&f, adc_msg, sizeof(adc_msg));
+        fmt_str(&f, "ADC1 = ");
+        fmt_uint(&f, raw, 0);
         ssd1306_drawMessage(0, 0, adc_msg);
 
         // 5) timestamp after drawMessage → compute FPS
@@ -87,7 +91,9 @@ int main() {
 
         // 6) draw FPS on bottom (y=24)
         char fps_msg[32];
-        sprintf(fps_msg, "FPS = %u", fps);
+        fmt_begin(&f, fps_msg, sizeof(fps_msg));
+        fmt_str(&f, "FPS = ");
+        fmt_uint(&f, fps, 0);
         ssd1306_drawMessage(0, 24, fps_msg);
 
         // 7) small delay to control sample rate